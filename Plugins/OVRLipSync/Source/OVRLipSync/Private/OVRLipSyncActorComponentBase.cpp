@@ -22,13 +22,25 @@
  ******************************************************************************/
 
 #include "OVRLipSyncActorComponentBase.h"
+#include "OVRLipSyncLOD.h"
 #include "OVRLipSyncModule.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 
 #if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
 DEFINE_LOG_CATEGORY(LogOvrLipSync);
 #endif
 
+DECLARE_CYCLE_STAT(TEXT("Assign Morph Targets"), STAT_OVRLipSyncAssignMorphTargets, STATGROUP_OVRLipSync);
+
+namespace
+{
+// How often the automatic level of detail is picked, screen sizes change slowly next to the frame rate.
+constexpr float LODUpdateInterval = 0.25f;
+} // namespace
+
 // Sets default values for this component's properties
 UOVRLipSyncActorComponentBase::UOVRLipSyncActorComponentBase() { Visemes.Init(0.0f, VisemeNames.Num()); }
 
@@ -41,28 +53,158 @@ const float UOVRLipSyncActorComponentBase::GetLaughterScore() const { return Lau
 void UOVRLipSyncActorComponentBase::AssignVisemesToMorphTargets(USkeletalMeshComponent *Mesh,
 																const TArray<FString> &InMorphTargetNames)
 {
-	auto MorphTargetNames = InMorphTargetNames.Num() > 0 ? InMorphTargetNames : VisemeNames;
+	SCOPE_CYCLE_COUNTER(STAT_OVRLipSyncAssignMorphTargets);
 	if (Mesh == nullptr)
 	{
-		Mesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+		// Searched for once, then the bound mesh is used for as long as it exists.
+		Mesh = MorphTargetBinding.IsBound() ? MorphTargetBinding.GetMesh()
+											: GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
 	}
 	if (Mesh == nullptr)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Mesh is NULL"));
 		return;
 	}
-	for (int cnt = 0; cnt < MorphTargetNames.Num(); cnt++)
+	if (LOD == EOVRLipSyncLOD::Off && !bUpdateAllMorphTargets)
+	{
+		// The neutral pose is already set.
+		return;
+	}
+	MorphTargetBinding.Bind(Mesh, InMorphTargetNames.Num() > 0 ? InMorphTargetNames : VisemeNames);
+	// Visemes the level of detail does not use stay at the 0 they were set to when it changed.
+	MorphTargetBinding.Apply(Visemes, LOD, bUpdateAllMorphTargets, MorphTargetEpsilon);
+	bUpdateAllMorphTargets = false;
+}
+
+void UOVRLipSyncActorComponentBase::SetLOD(EOVRLipSyncLOD NewLOD)
+{
+	if (NewLOD == LOD)
+	{
+		return;
+	}
+	const EOVRLipSyncLOD OldLOD = LOD;
+	LOD = NewLOD;
+	bUpdateAllMorphTargets = true;
+	MorphTargetBinding.ResetAppliedWeights();
+	OnLODChanged(OldLOD);
+}
+
+void UOVRLipSyncActorComponentBase::OnLODChanged(EOVRLipSyncLOD OldLOD)
+{
+	if (LOD == EOVRLipSyncLOD::Off)
+	{
+		InitNeutralPose();
+	}
+}
+
+void UOVRLipSyncActorComponentBase::ApplyLODToVisemes()
+{
+	if (LOD != EOVRLipSyncLOD::Full && Visemes.Num() >= FOVRLipSyncFrameData::NumVisemes)
+	{
+		OVRLipSyncLOD::ReduceVisemes(LOD, Visemes.GetData());
+		if (LOD >= EOVRLipSyncLOD::Jaw)
+		{
+			LaughterScore = 0.0f;
+		}
+	}
+}
+
+void UOVRLipSyncActorComponentBase::TickComponent(float DeltaTime, ELevelTick TickType,
+												  FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (!bAutomaticLOD)
+	{
+		return;
+	}
+	SinceLODUpdate += DeltaTime;
+	if (SinceLODUpdate < LODUpdateInterval)
+	{
+		return;
+	}
+	SinceLODUpdate = 0.0f;
+
+	// Without a local view, such as on a server, nothing is rendered to tell what is seen, and nothing is lost by
+	// keeping every viseme.
+	float ScreenSize = 1.0f;
+	if (!GetScreenSize(ScreenSize))
+	{
+		SetLOD(EOVRLipSyncLOD::Full);
+		return;
+	}
+	// Characters nobody sees are not analysed at all, however close they are.
+	const AActor *Owner = GetOwner();
+	if (Owner && !Owner->WasRecentlyRendered(OffScreenTime))
+	{
+		SetLOD(EOVRLipSyncLOD::Off);
+		return;
+	}
+	SetLOD(PickLOD(ScreenSize));
+}
+
+bool UOVRLipSyncActorComponentBase::GetScreenSize(float &OutScreenSize) const
+{
+	const AActor *Owner = GetOwner();
+	const USceneComponent *Root = Owner ? Owner->GetRootComponent() : nullptr;
+	const UWorld *World = GetWorld();
+	if (!Root || !World)
+	{
+		return false;
+	}
+	const FBoxSphereBounds &Bounds = Root->Bounds;
+	float ScreenSize = 0.0f;
+	bool bHasView = false;
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
 	{
-		Mesh->SetMorphTarget(FName(*MorphTargetNames[cnt]), Visemes[cnt]);
+		const APlayerController *PlayerController = Iterator->Get();
+		if (!PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+		{
+			continue;
+		}
+		const APlayerCameraManager *Camera = PlayerController->PlayerCameraManager;
+		const float Distance = FVector::Dist(Camera->GetCameraLocation(), Bounds.Origin);
+		const float HalfWidth = Distance * FMath::Tan(FMath::DegreesToRadians(Camera->GetFOVAngle() * 0.5f));
+		// The diameter of the bounds over the width of the view at their distance, as mesh LOD screen sizes are.
+		ScreenSize = FMath::Max(ScreenSize, Bounds.SphereRadius / FMath::Max(HalfWidth, KINDA_SMALL_NUMBER));
+		bHasView = true;
 	}
+	OutScreenSize = ScreenSize;
+	return bHasView;
+}
+
+EOVRLipSyncLOD UOVRLipSyncActorComponentBase::PickLOD(float ScreenSize) const
+{
+	// Staying at the current level or going coarser takes falling below a threshold by the hysteresis, going finer
+	// takes passing it by as much.
+	const auto Threshold = [this](EOVRLipSyncLOD Level, float ScreenSizeThreshold) {
+		return ScreenSizeThreshold * (Level >= LOD ? 1.0f - LODHysteresis : 1.0f + LODHysteresis);
+	};
+	if (ScreenSize >= Threshold(EOVRLipSyncLOD::Full, FullLODScreenSize))
+	{
+		return EOVRLipSyncLOD::Full;
+	}
+	if (ScreenSize >= Threshold(EOVRLipSyncLOD::Reduced, ReducedLODScreenSize))
+	{
+		return EOVRLipSyncLOD::Reduced;
+	}
+	return EOVRLipSyncLOD::Jaw;
 }
 
 void UOVRLipSyncActorComponentBase::InitNeutralPose()
 {
-	if (LaughterScore == 0.0f && Visemes[0] == 1.0f)
+	// Every viseme is checked, as dequantized frames can hold sil at 1 with others still open.
+	bool bNeutral = LaughterScore == 0.0f && Visemes[0] == 1.0f;
+	for (int32 Viseme = 1; bNeutral && Viseme < Visemes.Num(); ++Viseme)
+	{
+		bNeutral = Visemes[Viseme] == 0.0f;
+	}
+	if (bNeutral)
 	{
 		return;
 	}
+	// Returning to neutral usually comes with a reset of whatever else drives the mesh, such as its animation instance,
+	// so the pose is written in full.
+	MorphTargetBinding.ResetAppliedWeights();
 
 	LaughterScore = 0.0f;
 	Visemes[0] = 1.0f;
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncAmplitudeProvider.h"
+#include "OVRLipSync.h"
+
+namespace
+{
+
+// The loudness the mouth starts to open at, and is fully open at, in dB below full scale.
+constexpr float ClosedLevel = -50.0f;
+constexpr float OpenLevel = -15.0f;
+
+// Below the first frequency voiced audio is all ou, above the second all aa.
+constexpr float RoundFrequency = 400.0f;
+constexpr float OpenFrequency = 900.0f;
+
+// Above the first frequency audio starts to read as a fricative, above the second it is all FF.
+constexpr float FricativeFrequency = 1500.0f;
+constexpr float HissFrequency = 4000.0f;
+
+// The ratio of peak to RMS a plosive burst starts at, and is certain at.
+constexpr float BurstCrest = 5.0f;
+constexpr float SharpBurstCrest = 10.0f;
+
+struct FFrameLevels
+{
+	float Rms = 0.0f;
+	float Peak = 0.0f;
+	/** The energy of the first difference of the samples over their energy, 4 sin^2(pi f / SampleRate) for a tone. */
+	float Tilt = 0.0f;
+};
+
+/** Measures samples four at a time. Samples[-1] must be the sample before the first. */
+FFrameLevels MeasureLevels(const float *Samples, int32 Num)
+{
+	VectorRegister4Float SumOfSquares = VectorZeroFloat();
+	VectorRegister4Float SumOfDifferences = VectorZeroFloat();
+	VectorRegister4Float Peak = VectorZeroFloat();
+	int32 Index = 0;
+	for (; Index + 4 <= Num; Index += 4)
+	{
+		const VectorRegister4Float Sample = VectorLoad(Samples + Index);
+		const VectorRegister4Float Difference = VectorSubtract(Sample, VectorLoad(Samples + Index - 1));
+		SumOfSquares = VectorMultiplyAdd(Sample, Sample, SumOfSquares);
+		SumOfDifferences = VectorMultiplyAdd(Difference, Difference, SumOfDifferences);
+		Peak = VectorMax(Peak, VectorAbs(Sample));
+	}
+	float Squares[4], Differences[4], Peaks[4];
+	VectorStore(SumOfSquares, Squares);
+	VectorStore(SumOfDifferences, Differences);
+	VectorStore(Peak, Peaks);
+	float Energy = Squares[0] + Squares[1] + Squares[2] + Squares[3];
+	float DifferenceEnergy = Differences[0] + Differences[1] + Differences[2] + Differences[3];
+	float PeakMagnitude = FMath::Max(FMath::Max(Peaks[0], Peaks[1]), FMath::Max(Peaks[2], Peaks[3]));
+	for (; Index < Num; ++Index)
+	{
+		const float Difference = Samples[Index] - Samples[Index - 1];
+		Energy += Samples[Index] * Samples[Index];
+		DifferenceEnergy += Difference * Difference;
+		PeakMagnitude = FMath::Max(PeakMagnitude, FMath::Abs(Samples[Index]));
+	}
+
+	FFrameLevels Levels;
+	if (Num > 0 && Energy > UE_SMALL_NUMBER)
+	{
+		Levels.Rms = FMath::Sqrt(Energy / Num);
+		Levels.Peak = PeakMagnitude;
+		Levels.Tilt = DifferenceEnergy / Energy;
+	}
+	return Levels;
+}
+
+/** Where 0 to 1 a value is between two others, clamped. */
+float Ramp(float Value, float From, float To) { return FMath::Clamp((Value - From) / (To - From), 0.0f, 1.0f); }
+
+void Smooth(float &Score, float Target, float AttackAlpha, float ReleaseAlpha)
+{
+	Score += (Target - Score) * (Target > Score ? AttackAlpha : ReleaseAlpha);
+}
+
+} // namespace
+
+void FOVRLipSyncAmplitudeProvider::ProcessFrame(const int16 *Samples, int32 NumFrames, bool bStereo,
+												int32 SampleRate, float *OutVisemes)
+{
+	if (NumFrames <= 0 || SampleRate <= 0)
+	{
+		GetVisemes(OutVisemes);
+		return;
+	}
+
+	// Mixed down and converted in one loop the compiler vectorizes, keeping the last sample for the next frame.
+	const float LastSample = Mono.Num() > 0 ? Mono.Last() : 0.0f;
+	Mono.SetNumUninitialized(NumFrames + 1);
+	Mono[0] = LastSample;
+	float *Frame = Mono.GetData() + 1;
+	if (bStereo)
+	{
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			Frame[Index] = ((float)Samples[2 * Index] + (float)Samples[2 * Index + 1]) * (0.5f / 32768.0f);
+		}
+	}
+	else
+	{
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			Frame[Index] = (float)Samples[Index] * (1.0f / 32768.0f);
+		}
+	}
+	const FFrameLevels Levels = MeasureLevels(Frame, NumFrames);
+
+	// The tilt read as the frequency of the tone it would be, so the thresholds hold at any sample rate.
+	const float Frequency = SampleRate / UE_PI * FMath::Asin(FMath::Min(FMath::Sqrt(Levels.Tilt) * 0.5f, 1.0f));
+	const float Level = 20.0f * FMath::LogX(10.0f, FMath::Max(Levels.Rms, 1e-5f));
+	const float Open = Ramp(Level, ClosedLevel, OpenLevel);
+	const float Hiss = Ramp(Frequency, FricativeFrequency, HissFrequency);
+	const float Burst = Levels.Rms > 0.0f ? Ramp(Levels.Peak / Levels.Rms, BurstCrest, SharpBurstCrest) : 0.0f;
+
+	// Of how far the mouth opens, a hiss is FF, a burst PP, and the voiced rest aa or ou by how dark it is.
+	const float TargetFF = Open * Hiss;
+	const float TargetPP = Open * (1.0f - Hiss) * Burst;
+	const float Voiced = Open - TargetFF - TargetPP;
+	const float Round = Ramp(Frequency, OpenFrequency, RoundFrequency);
+
+	const float FrameSeconds = (float)NumFrames / SampleRate;
+	const float AttackAlpha = AttackTime > 0.0f ? 1.0f - FMath::Exp(-FrameSeconds / AttackTime) : 1.0f;
+	const float ReleaseAlpha = ReleaseTime > 0.0f ? 1.0f - FMath::Exp(-FrameSeconds / ReleaseTime) : 1.0f;
+	Smooth(Aa, Voiced * (1.0f - Round), AttackAlpha, ReleaseAlpha);
+	Smooth(Ou, Voiced * Round, AttackAlpha, ReleaseAlpha);
+	Smooth(FF, TargetFF, AttackAlpha, ReleaseAlpha);
+	Smooth(PP, TargetPP, AttackAlpha, ReleaseAlpha);
+	GetVisemes(OutVisemes);
+}
+
+void FOVRLipSyncAmplitudeProvider::GetVisemes(float *OutVisemes) const
+{
+	FMemory::Memzero(OutVisemes, FOVRLipSyncFrameData::NumVisemes * sizeof(float));
+	OutVisemes[ovrLipSyncViseme_aa] = Aa;
+	OutVisemes[ovrLipSyncViseme_ou] = Ou;
+	OutVisemes[ovrLipSyncViseme_FF] = FF;
+	OutVisemes[ovrLipSyncViseme_PP] = PP;
+	OutVisemes[ovrLipSyncViseme_sil] = FMath::Max(1.0f - (Aa + PP + FF + Ou), 0.0f);
+}
+
+void FOVRLipSyncAmplitudeProvider::Reset()
+{
+	Mono.Reset();
+	Aa = PP = FF = Ou = 0.0f;
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncModule.h"
+
+FOVRLipSyncContextPool &FOVRLipSyncContextPool::Get()
+{
+	static FOVRLipSyncContextPool Pool;
+	return Pool;
+}
+
+bool FOVRLipSyncContextPool::InitializeLibrary(int32 SampleRate, int32 BufferSize)
+{
+	FScopeLock Lock(&Mutex);
+	const TPair<int32, int32> Configuration(SampleRate, BufferSize);
+	if (InitializedConfigurations.Contains(Configuration))
+	{
+		return true;
+	}
+
+#if !PLATFORM_ANDROID
+	auto pluginsDir = FPaths::ProjectPluginsDir();
+	auto libDir = FPaths::Combine(pluginsDir, TEXT("OVRLipSync"), TEXT("ThirdParty"), TEXT("Lib"),
+								  FPlatformProcess::GetBinariesSubdirectory());
+	TArray<char> libDirChar(libDir.GetCharArray());
+	auto rc = ovrLipSync_InitializeEx(SampleRate, BufferSize, libDirChar.GetData());
+#else
+	auto rc = ovrLipSync_Initialize(SampleRate, BufferSize);
+#endif
+	if (rc != ovrLipSyncSuccess)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("Can't initialize ovrLipSync: %d"), rc);
+		return false;
+	}
+	InitializedConfigurations.Add(Configuration);
+	return true;
+}
+
+FOVRLipSyncContextPool::FContextPtr FOVRLipSyncContextPool::Acquire(const FOVRLipSyncContextKey &Key)
+{
+	{
+		FScopeLock Lock(&Mutex);
+		if (TArray<FContextPtr> *Idle = IdleContexts.Find(Key))
+		{
+			if (Idle->Num() > 0)
+			{
+				return Idle->Pop(false);
+			}
+		}
+	}
+	return Create(Key);
+}
+
+FOVRLipSyncContextPool::FContextPtr FOVRLipSyncContextPool::TryAcquire(const FOVRLipSyncContextKey &Key)
+{
+	FScopeLock Lock(&Mutex);
+	TArray<FContextPtr> *Idle = IdleContexts.Find(Key);
+	return Idle && Idle->Num() > 0 ? Idle->Pop(false) : nullptr;
+}
+
+FOVRLipSyncContextPool::FContextPtr FOVRLipSyncContextPool::Create(const FOVRLipSyncContextKey &Key)
+{
+	// Creating a context loads its model, which is slow, so it is done without holding the lock.
+	FContextPtr Context = MakeShared<UOVRLipSyncContextWrapper, ESPMode::ThreadSafe>(
+		Key.Provider, Key.SampleRate, Key.BufferSize, Key.ModelPath, Key.bAccelerate);
+
+	FScopeLock Lock(&Mutex);
+	Contexts.RemoveAllSwap([](const TWeakPtr<UOVRLipSyncContextWrapper, ESPMode::ThreadSafe> &Weak)
+						   { return !Weak.IsValid(); });
+	Contexts.Add(Context);
+	return Context;
+}
+
+void FOVRLipSyncContextPool::Prewarm(const FOVRLipSyncContextKey &Key)
+{
+	FScopeLock Lock(&Mutex);
+	const TArray<FContextPtr> *Idle = IdleContexts.Find(Key);
+	if (bShuttingDown || (Idle && Idle->Num() > 0) || Prewarming.Contains(Key))
+	{
+		return;
+	}
+	Prewarming.Add(Key);
+	PrewarmTasks.RemoveAllSwap([](const UE::Tasks::FTask &Task) { return Task.IsCompleted(); });
+	PrewarmTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Key]()
+	{
+		FContextPtr Context = Create(Key);
+		{
+			FScopeLock Lock(&Mutex);
+			Prewarming.Remove(Key);
+		}
+		Release(Key, MoveTemp(Context));
+	}, UE::Tasks::ETaskPriority::BackgroundNormal));
+}
+
+void FOVRLipSyncContextPool::Release(const FOVRLipSyncContextKey &Key, FContextPtr Context)
+{
+	if (!Context || !Context->IsValid())
+	{
+		return;
+	}
+	Context->Reset();
+
+	FScopeLock Lock(&Mutex);
+	IdleContexts.FindOrAdd(Key).Add(MoveTemp(Context));
+}
+
+int32 FOVRLipSyncContextPool::GetFrameDelay(const FOVRLipSyncContextKey &Key)
+{
+	{
+		FScopeLock Lock(&Mutex);
+		if (const int32 *FrameDelay = FrameDelays.Find(Key))
+		{
+			return *FrameDelay;
+		}
+	}
+
+	// The delay is a property of the model, so 10 ms of mono silence measures it for any channel count.
+	FContextPtr Context = Acquire(Key);
+	float LaughterScore = 0.0f;
+	int32_t FrameDelayInMs = 0;
+	TArray<float> Visemes;
+	TArray<int16_t> Samples;
+	Samples.SetNumZeroed(FMath::Max(Key.SampleRate / 100, 1));
+	Context->ProcessFrame(Samples.GetData(), Samples.Num(), Visemes, LaughterScore, FrameDelayInMs);
+	// A context standing in for a provider the host lacks would report its own delay under the wrong key.
+	const bool bMeasured = Context->IsValid() && Context->GetProvider() == Key.Provider;
+	Release(Key, MoveTemp(Context));
+
+	if (bMeasured)
+	{
+		FScopeLock Lock(&Mutex);
+		FrameDelays.Add(Key, FrameDelayInMs);
+	}
+	return FrameDelayInMs;
+}
+
+void FOVRLipSyncContextPool::Shutdown()
+{
+	TArray<UE::Tasks::FTask> Tasks;
+	{
+		FScopeLock Lock(&Mutex);
+		bShuttingDown = true;
+		Tasks = MoveTemp(PrewarmTasks);
+	}
+	UE::Tasks::Wait(Tasks);
+
+	// Borrowed contexts are destroyed too, their users keep a wrapper which no longer does anything.
+	TArray<FContextPtr> LiveContexts;
+	{
+		FScopeLock Lock(&Mutex);
+		for (const TWeakPtr<UOVRLipSyncContextWrapper, ESPMode::ThreadSafe> &Weak : Contexts)
+		{
+			if (FContextPtr Context = Weak.Pin())
+			{
+				LiveContexts.Add(MoveTemp(Context));
+			}
+		}
+		Contexts.Empty();
+		IdleContexts.Empty();
+		Prewarming.Empty();
+		FrameDelays.Empty();
+		InitializedConfigurations.Empty();
+	}
+	for (const FContextPtr &Context : LiveContexts)
+	{
+		Context->Destroy();
+	}
+
+	FScopeLock Lock(&Mutex);
+	bShuttingDown = false;
+}
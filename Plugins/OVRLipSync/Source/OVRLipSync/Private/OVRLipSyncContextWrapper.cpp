@@ -22,6 +22,7 @@
  ******************************************************************************/
 
 #include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncContextPool.h"
 #include "OVRLipSyncModule.h"
 
 #include <Core.h>
@@ -42,34 +43,80 @@ ovrLipSyncContextProvider UOVRLipSyncContextWrapper::ContextProviderFromProvider
 	}
 }
 
-UOVRLipSyncContextWrapper::UOVRLipSyncContextWrapper(ovrLipSyncContextProvider ProviderKind, int SampleRate,
+UOVRLipSyncContextWrapper::UOVRLipSyncContextWrapper(OVRLipSyncProviderKind ProviderKind, int InSampleRate,
 													 int BufferSize, FString ModelPath, bool EnableAcceleration)
+	: Provider(ProviderKind), SampleRate(InSampleRate)
 {
-#if !PLATFORM_ANDROID
-	auto pluginsDir = FPaths::ProjectPluginsDir();
-	auto libDir = FPaths::Combine(pluginsDir, TEXT("OVRLipSync"), TEXT("ThirdParty"), TEXT("Lib"),
-								  FPlatformProcess::GetBinariesSubdirectory());
-	TArray<char> libDirChar(libDir.GetCharArray());
-	auto rc = ovrLipSync_InitializeEx(SampleRate, BufferSize, libDirChar.GetData());
-#else
-	auto rc = ovrLipSync_Initialize(SampleRate, BufferSize);
-#endif
-	if (rc != ovrLipSyncSuccess)
+	if (Provider == OVRLipSyncProviderKind::Amplitude)
+	{
+		AmplitudeProvider = MakeUnique<FOVRLipSyncAmplitudeProvider>();
+		return;
+	}
+	// The library is initialized once per configuration, however many contexts are created.
+	if (!FOVRLipSyncContextPool::Get().InitializeLibrary(SampleRate, BufferSize))
 	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("Can't initialize ovrLipSync: %d"), rc);
+		UE_LOG(LogOvrLipSync, Warning, TEXT("Falling back to the amplitude provider"));
+		Provider = OVRLipSyncProviderKind::Amplitude;
+		AmplitudeProvider = MakeUnique<FOVRLipSyncAmplitudeProvider>();
 		return;
 	}
-	rc = ModelPath.IsEmpty()
-			 ? ovrLipSync_CreateContextEx(&LipSyncContext, ProviderKind, SampleRate, EnableAcceleration)
-			 : ovrLipSync_CreateContextWithModelFile(&LipSyncContext, ProviderKind, TCHAR_TO_ANSI(*ModelPath),
+	const ovrLipSyncContextProvider ContextProvider = ContextProviderFromProviderKind(ProviderKind);
+	auto rc = ModelPath.IsEmpty()
+			 ? ovrLipSync_CreateContextEx(&LipSyncContext, ContextProvider, SampleRate, EnableAcceleration)
+			 : ovrLipSync_CreateContextWithModelFile(&LipSyncContext, ContextProvider, TCHAR_TO_ANSI(*ModelPath),
 													 SampleRate, EnableAcceleration);
 	if (rc != ovrLipSyncSuccess)
 	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("Can't create ovrLipSync context: %d"), rc);
+		UE_LOG(LogOvrLipSync, Error, TEXT("Can't create ovrLipSync context: %d, falling back to the amplitude provider"),
+			   rc);
+		LipSyncContext = 0;
+		Provider = OVRLipSyncProviderKind::Amplitude;
+		AmplitudeProvider = MakeUnique<FOVRLipSyncAmplitudeProvider>();
 	}
 }
 
-UOVRLipSyncContextWrapper::~UOVRLipSyncContextWrapper() { ovrLipSync_DestroyContext(LipSyncContext); }
+UOVRLipSyncContextWrapper::~UOVRLipSyncContextWrapper() { Destroy(); }
+
+void UOVRLipSyncContextWrapper::Destroy()
+{
+	FWriteScopeLock Lock(ContextLock);
+	WaitForAsync();
+	if (LipSyncContext)
+	{
+		ovrLipSync_DestroyContext(LipSyncContext);
+		LipSyncContext = 0;
+	}
+}
+
+void UOVRLipSyncContextWrapper::WaitForAsync() const
+{
+	// The library calls back within a frame of analysis, so this never waits long.
+	while (PendingAsync.load() > 0)
+	{
+		FPlatformProcess::Sleep(0.0f);
+	}
+}
+
+void UOVRLipSyncContextWrapper::Reset()
+{
+	// A frame still in flight would call back into whoever borrows the context next.
+	WaitForAsync();
+	AsyncCallback = nullptr;
+	if (AmplitudeProvider)
+	{
+		AmplitudeProvider->Reset();
+	}
+	FReadScopeLock Lock(ContextLock);
+	if (!LipSyncContext)
+	{
+		return;
+	}
+	auto rc = ovrLipSync_ResetContext(LipSyncContext);
+	if (rc != ovrLipSyncSuccess)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to reset context: %d"), rc);
+	}
+}
 
 void UOVRLipSyncContextWrapper::ProcessFrame(const int16_t *AudioBuffer, int AudioBufferSize, TArray<float> &Visemes,
 											 float &LaughterScore, int32_t &FrameDelay, bool Stereo)
@@ -78,6 +125,18 @@ void UOVRLipSyncContextWrapper::ProcessFrame(const int16_t *AudioBuffer, int Aud
 	{
 		Visemes.SetNumZeroed(ovrLipSyncViseme_Count);
 	}
+	if (AmplitudeProvider)
+	{
+		AmplitudeProvider->ProcessFrame(AudioBuffer, AudioBufferSize, Stereo, SampleRate, Visemes.GetData());
+		LaughterScore = 0.0f;
+		FrameDelay = 0;
+		return;
+	}
+	FReadScopeLock Lock(ContextLock);
+	if (!LipSyncContext)
+	{
+		return;
+	}
 	ovrLipSyncFrame frame = {};
 	frame.visemes = Visemes.GetData();
 	frame.visemesLength = Visemes.Num();
@@ -93,43 +152,64 @@ void UOVRLipSyncContextWrapper::ProcessFrame(const int16_t *AudioBuffer, int Aud
 	FrameDelay = frame.frameDelay;
 }
 
-namespace
-{
-void ProcessFrameCallback(void *opaque, const ovrLipSyncFrame *pFrame, ovrLipSyncResult result)
+void UOVRLipSyncContextWrapper::ProcessFrameCallback(void *opaque, const ovrLipSyncFrame *pFrame,
+													 ovrLipSyncResult result)
 {
+	auto wrapper = reinterpret_cast<UOVRLipSyncContextWrapper *>(opaque);
 	if (result != ovrLipSyncSuccess)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Async prediction failed: %d"), result);
-		return;
 	}
-	auto wrapper = reinterpret_cast<UOVRLipSyncContextWrapper *>(opaque);
-	TArray<float> Visemes(pFrame->visemes, pFrame->visemesLength);
-	wrapper->InvokeAsyncCallback(Visemes, pFrame->laughterScore);
+	else
+	{
+		// Passed on as the library hands it over, copying it is up to the callback.
+		wrapper->InvokeAsyncCallback(*pFrame);
+	}
+	// Last, the wrapper may be reset or destroyed as soon as this is seen.
+	wrapper->PendingAsync--;
 }
-} // namespace
 
 void UOVRLipSyncContextWrapper::SetAsyncCallback(const AsyncCallbackType &Callback) { AsyncCallback = Callback; }
 
-void UOVRLipSyncContextWrapper::InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore)
+void UOVRLipSyncContextWrapper::InvokeAsyncCallback(const ovrLipSyncFrame &Frame)
 {
 	if (!AsyncCallback)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Trying invoke unintialized async callback"));
 		return;
 	}
-	AsyncCallback(Visemes, LaughterScore);
-	UE_LOG(LogOvrLipSync, Display, TEXT("Invoked Async Callback with %d visemes and laughter score %f"), Visemes.Num(), LaughterScore);
+	AsyncCallback(Frame);
+	UE_LOG(LogOvrLipSync, Verbose, TEXT("Invoked Async Callback with %d visemes and laughter score %f"),
+		   Frame.visemesLength, Frame.laughterScore);
 }
 
 void UOVRLipSyncContextWrapper::ProcessFrameAsync(const int16_t *AudioBuffer, int AudioBufferSize, bool Stereo)
 {
+	if (AmplitudeProvider)
+	{
+		// Cheaper than handing the audio to another thread.
+		float Visemes[ovrLipSyncViseme_Count];
+		AmplitudeProvider->ProcessFrame(AudioBuffer, AudioBufferSize, Stereo, SampleRate, Visemes);
+		ovrLipSyncFrame Frame = {};
+		Frame.visemes = Visemes;
+		Frame.visemesLength = ovrLipSyncViseme_Count;
+		InvokeAsyncCallback(Frame);
+		return;
+	}
+	FReadScopeLock Lock(ContextLock);
+	if (!LipSyncContext)
+	{
+		return;
+	}
+	PendingAsync++;
 	auto rc = ovrLipSync_ProcessFrameAsync(
 		LipSyncContext, AudioBuffer, AudioBufferSize,
 		Stereo ? ovrLipSyncAudioDataType_S16_Stereo : ovrLipSyncAudioDataType_S16_Mono, ProcessFrameCallback, this);
 	if (rc != ovrLipSyncSuccess)
 	{
+		PendingAsync--;
 		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to start async prediction: %d"), rc);
 		return;
 	}
-	UE_LOG(LogOvrLipSync, Display, TEXT("Successful async prediction: %d"), rc);
+	UE_LOG(LogOvrLipSync, Verbose, TEXT("Successful async prediction: %d"), rc);
 }
@@ -0,0 +1,420 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncFrame.h"
+#include "OVRLipSyncModule.h"
+#include "Algo/BinarySearch.h"
+#include "Serialization/CustomVersion.h"
+
+namespace
+{
+struct FOVRLipSyncFrameSequenceVersion
+{
+	enum Type
+	{
+		// An array of FOVRLipSyncFrame, one allocation per frame
+		BeforeCustomVersionWasAdded = 0,
+		// FOVRLipSyncFrameData
+		PackedFrames,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+};
+
+const FGuid FOVRLipSyncFrameSequenceVersion::GUID(0x6A1C93E2, 0x4F0B4D57, 0x9E3A71C8, 0x2B5D04F6);
+FCustomVersionRegistration GRegisterOVRLipSyncFrameSequenceVersion(FOVRLipSyncFrameSequenceVersion::GUID,
+																	FOVRLipSyncFrameSequenceVersion::LatestVersion,
+																	TEXT("OVRLipSyncFrameSequenceVer"));
+
+uint32 Quantize(float Score, uint32 MaxValue)
+{
+	return (uint32)FMath::RoundToInt(FMath::Clamp(Score, 0.0f, 1.0f) * MaxValue);
+}
+
+// Whether a frame is stored as the neutral pose, full silence and nothing else, at the stored precision.
+bool IsNeutral(const float *Scores, uint32 MaxValue)
+{
+	if (Quantize(Scores[0], MaxValue) != MaxValue)
+	{
+		return false;
+	}
+	for (int32 Score = 1; Score < FOVRLipSyncFrameData::NumScores; ++Score)
+	{
+		if (Quantize(Scores[Score], MaxValue) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+} // namespace
+
+void FOVRLipSyncFrameData::Reset()
+{
+	NumFrames = 0;
+	NumStored = 0;
+	PlaneStride = 0;
+	Planes.Reset();
+	NeutralRuns.Reset();
+}
+
+void FOVRLipSyncFrameData::Pack(const float *Scores, int32 InNumFrames, EOVRLipSyncScoreQuantization Quantization)
+{
+	Reset();
+	Append(Scores, InNumFrames, Quantization);
+}
+
+void FOVRLipSyncFrameData::ReservePlanes(int32 NumToStore)
+{
+	if (NumToStore <= PlaneStride)
+	{
+		return;
+	}
+	const int32 NewStride = PlaneStride > 0 ? FMath::Max(NumToStore, PlaneStride * 2) : NumToStore;
+	TArray<uint8> NewPlanes;
+	NewPlanes.SetNumUninitialized(NumScores * NewStride * BytesPerScore);
+	for (int32 Score = 0; Score < NumScores && NumStored > 0; ++Score)
+	{
+		FMemory::Memcpy(NewPlanes.GetData() + Score * NewStride * BytesPerScore,
+						Planes.GetData() + Score * PlaneStride * BytesPerScore, NumStored * BytesPerScore);
+	}
+	Planes = MoveTemp(NewPlanes);
+	PlaneStride = NewStride;
+}
+
+void FOVRLipSyncFrameData::Append(const float *Scores, int32 NumNewFrames, EOVRLipSyncScoreQuantization Quantization)
+{
+	if (NumNewFrames <= 0)
+	{
+		return;
+	}
+	if (NumFrames == 0)
+	{
+		BytesPerScore = Quantization == EOVRLipSyncScoreQuantization::Bits16 ? 2 : 1;
+	}
+	const uint32 MaxValue = BytesPerScore == 2 ? MAX_uint16 : MAX_uint8;
+
+	int32 NumNewStored = 0;
+	for (int32 Frame = 0; Frame < NumNewFrames; ++Frame)
+	{
+		if (!IsNeutral(Scores + Frame * NumScores, MaxValue))
+		{
+			NumNewStored++;
+		}
+	}
+	ReservePlanes(NumStored + NumNewStored);
+
+	uint16 *Planes16 = reinterpret_cast<uint16 *>(Planes.GetData());
+	for (int32 Frame = 0; Frame < NumNewFrames; ++Frame)
+	{
+		const float *FrameScores = Scores + Frame * NumScores;
+		if (IsNeutral(FrameScores, MaxValue))
+		{
+			if (NeutralRuns.Num() > 0 && NeutralRuns.Last().End == NumFrames)
+			{
+				NeutralRuns.Last().End++;
+			}
+			else
+			{
+				NeutralRuns.Add({ NumFrames, NumFrames + 1, NumStored });
+			}
+		}
+		else
+		{
+			for (int32 Score = 0; Score < NumScores; ++Score)
+			{
+				const int32 Index = Score * PlaneStride + NumStored;
+				if (BytesPerScore == 2)
+				{
+					Planes16[Index] = (uint16)Quantize(FrameScores[Score], MaxValue);
+				}
+				else
+				{
+					Planes[Index] = (uint8)Quantize(FrameScores[Score], MaxValue);
+				}
+			}
+			NumStored++;
+		}
+		NumFrames++;
+	}
+}
+
+void FOVRLipSyncFrameData::Append(const FOVRLipSyncFrameData &Other)
+{
+	if (Other.NumFrames == 0)
+	{
+		return;
+	}
+	if (NumFrames == 0)
+	{
+		BytesPerScore = Other.BytesPerScore;
+	}
+	if (Other.BytesPerScore != BytesPerScore)
+	{
+		TArray<float> Scores;
+		Scores.SetNumUninitialized(Other.NumFrames * NumScores);
+		for (int32 Frame = 0; Frame < Other.NumFrames; ++Frame)
+		{
+			Other.DecodeFrame(Frame, Scores.GetData() + Frame * NumScores);
+		}
+		Append(Scores.GetData(), Other.NumFrames, GetQuantization());
+		return;
+	}
+
+	ReservePlanes(NumStored + Other.NumStored);
+	for (int32 Score = 0; Score < NumScores && Other.NumStored > 0; ++Score)
+	{
+		FMemory::Memcpy(Planes.GetData() + (Score * PlaneStride + NumStored) * BytesPerScore,
+						Other.Planes.GetData() + Score * Other.PlaneStride * BytesPerScore, Other.NumStored * BytesPerScore);
+	}
+	for (const FNeutralRun &OtherRun : Other.NeutralRuns)
+	{
+		const FNeutralRun Run = { OtherRun.Start + NumFrames, OtherRun.End + NumFrames, OtherRun.StoredBefore + NumStored };
+		if (NeutralRuns.Num() > 0 && NeutralRuns.Last().End == Run.Start)
+		{
+			NeutralRuns.Last().End = Run.End;
+		}
+		else
+		{
+			NeutralRuns.Add(Run);
+		}
+	}
+	NumFrames += Other.NumFrames;
+	NumStored += Other.NumStored;
+}
+
+void FOVRLipSyncFrameData::DecodeFrame(int32 Index, float *OutScores) const
+{
+	check(Index >= 0 && Index < NumFrames);
+
+	// The stored frame is Index less the neutral frames before it, found from the last run starting at or before it.
+	int32 Stored = Index;
+	const int32 Run = Algo::UpperBoundBy(NeutralRuns, Index, &FNeutralRun::Start) - 1;
+	if (Run >= 0)
+	{
+		const FNeutralRun &NeutralRun = NeutralRuns[Run];
+		if (Index < NeutralRun.End)
+		{
+			OutScores[0] = 1.0f;
+			FMemory::Memzero(OutScores + 1, sizeof(float) * (NumScores - 1));
+			return;
+		}
+		Stored = NeutralRun.StoredBefore + (Index - NeutralRun.End);
+	}
+
+	if (BytesPerScore == 2)
+	{
+		const uint16 *Planes16 = reinterpret_cast<const uint16 *>(Planes.GetData());
+		for (int32 Score = 0; Score < NumScores; ++Score)
+		{
+			OutScores[Score] = Planes16[Score * PlaneStride + Stored] * (1.0f / MAX_uint16);
+		}
+	}
+	else
+	{
+		for (int32 Score = 0; Score < NumScores; ++Score)
+		{
+			OutScores[Score] = Planes[Score * PlaneStride + Stored] * (1.0f / MAX_uint8);
+		}
+	}
+}
+
+void FOVRLipSyncFrameData::SampleFrame(float Position, EOVRLipSyncInterpolation Interpolation, float *OutScores) const
+{
+	const int32 Frame = FMath::Clamp(FMath::FloorToInt32(Position), 0, NumFrames - 1);
+	if (Interpolation == EOVRLipSyncInterpolation::Nearest || NumFrames == 1)
+	{
+		DecodeFrame(Frame, OutScores);
+		return;
+	}
+
+	const float Alpha = FMath::Clamp(Position - Frame, 0.0f, 1.0f);
+	float Next[NumScores];
+	DecodeFrame(Frame, OutScores);
+	DecodeFrame(FMath::Min(Frame + 1, NumFrames - 1), Next);
+	if (Interpolation == EOVRLipSyncInterpolation::Linear)
+	{
+		for (int32 Score = 0; Score < NumScores; ++Score)
+		{
+			OutScores[Score] += (Next[Score] - OutScores[Score]) * Alpha;
+		}
+		return;
+	}
+
+	// Catmull-Rom, the ends repeat the first and last frames. Clamped as it overshoots around sharp changes.
+	float Previous[NumScores];
+	float After[NumScores];
+	DecodeFrame(FMath::Max(Frame - 1, 0), Previous);
+	DecodeFrame(FMath::Min(Frame + 2, NumFrames - 1), After);
+	const float Alpha2 = Alpha * Alpha;
+	const float Alpha3 = Alpha2 * Alpha;
+	for (int32 Score = 0; Score < NumScores; ++Score)
+	{
+		const float P0 = Previous[Score];
+		const float P1 = OutScores[Score];
+		const float P2 = Next[Score];
+		const float P3 = After[Score];
+		const float Value = 0.5f * (2.0f * P1 + (P2 - P0) * Alpha + (2.0f * P0 - 5.0f * P1 + 4.0f * P2 - P3) * Alpha2 +
+									(3.0f * P1 - P0 - 3.0f * P2 + P3) * Alpha3);
+		OutScores[Score] = FMath::Clamp(Value, 0.0f, 1.0f);
+	}
+}
+
+bool FOVRLipSyncFrameData::AreRunsValid() const
+{
+	int32 NumNeutral = 0;
+	int32 PreviousEnd = 0;
+	for (const FNeutralRun &NeutralRun : NeutralRuns)
+	{
+		if (NeutralRun.Start < PreviousEnd || NeutralRun.End <= NeutralRun.Start || NeutralRun.End > NumFrames ||
+			NeutralRun.StoredBefore != NeutralRun.Start - NumNeutral)
+		{
+			return false;
+		}
+		NumNeutral += NeutralRun.End - NeutralRun.Start;
+		PreviousEnd = NeutralRun.End;
+	}
+	return NumStored + NumNeutral == NumFrames;
+}
+
+void FOVRLipSyncFrameData::Serialize(FArchive &Ar)
+{
+	Ar << NumFrames;
+	Ar << NumStored;
+	Ar << BytesPerScore;
+	if (Ar.IsSaving() && PlaneStride != NumStored)
+	{
+		// Appended to, the planes are saved without their spare capacity.
+		TArray<uint8> Compact;
+		Compact.SetNumUninitialized(NumScores * NumStored * BytesPerScore);
+		for (int32 Score = 0; Score < NumScores; ++Score)
+		{
+			FMemory::Memcpy(Compact.GetData() + Score * NumStored * BytesPerScore,
+							Planes.GetData() + Score * PlaneStride * BytesPerScore, NumStored * BytesPerScore);
+		}
+		Compact.BulkSerialize(Ar);
+	}
+	else
+	{
+		Planes.BulkSerialize(Ar);
+	}
+	if (Ar.IsLoading())
+	{
+		PlaneStride = NumStored;
+	}
+
+	int32 NumRuns = NeutralRuns.Num();
+	Ar << NumRuns;
+	if (Ar.IsLoading())
+	{
+		// There is never more than a run per frame, anything else is not allocated.
+		if (NumRuns < 0 || NumRuns > NumFrames || Ar.IsError())
+		{
+			UE_LOG(LogOvrLipSync, Error, TEXT("FOVRLipSyncFrameData::Serialize: %d neutral runs in %d frames are corrupt"),
+				   NumRuns, NumFrames);
+			Ar.SetError();
+			*this = FOVRLipSyncFrameData();
+			return;
+		}
+		NeutralRuns.SetNumUninitialized(NumRuns);
+	}
+	for (FNeutralRun &NeutralRun : NeutralRuns)
+	{
+		Ar << NeutralRun.Start;
+		Ar << NeutralRun.End;
+		Ar << NeutralRun.StoredBefore;
+	}
+
+	// DecodeFrame trusts the runs to index the planes, so frames which do not add up are dropped.
+	if (Ar.IsLoading() &&
+		(Ar.IsError() || (BytesPerScore != 1 && BytesPerScore != 2) || NumStored < 0 ||
+		 Planes.Num() != NumScores * NumStored * BytesPerScore || !AreRunsValid()))
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("FOVRLipSyncFrameData::Serialize: %d frames with %d bytes of scores are corrupt"),
+			   NumFrames, Planes.Num());
+		*this = FOVRLipSyncFrameData();
+	}
+}
+
+void UOVRLipSyncFrameSequence::SetFrames(const float *Scores, int32 NumFrames)
+{
+	Frames.Pack(Scores, NumFrames, Quantization);
+}
+
+void UOVRLipSyncFrameSequence::AppendFrames(const float *Scores, int32 NumFrames)
+{
+	Frames.Append(Scores, NumFrames, Quantization);
+}
+
+void UOVRLipSyncFrameSequence::AppendFrames(const FOVRLipSyncFrameData &InFrames)
+{
+	if (Frames.Num() == 0)
+	{
+		Quantization = InFrames.GetQuantization();
+	}
+	Frames.Append(InFrames);
+}
+
+void UOVRLipSyncFrameSequence::DecodeFrame(int32 Index, TArray<float> &OutVisemes, float &OutLaughterScore) const
+{
+	float Scores[FOVRLipSyncFrameData::NumScores];
+	Frames.DecodeFrame(Index, Scores);
+	OutVisemes.SetNumUninitialized(FOVRLipSyncFrameData::NumVisemes);
+	FMemory::Memcpy(OutVisemes.GetData(), Scores, sizeof(float) * FOVRLipSyncFrameData::NumVisemes);
+	OutLaughterScore = Scores[FOVRLipSyncFrameData::NumVisemes];
+}
+
+bool UOVRLipSyncFrameSequence::Sample(float Time, EOVRLipSyncInterpolation Interpolation, TArray<float> &OutVisemes,
+									  float &OutLaughterScore) const
+{
+	const float Position = Time * FrameRate;
+	if (Position < 0.0f || Position >= Frames.Num())
+	{
+		return false;
+	}
+	float Scores[FOVRLipSyncFrameData::NumScores];
+	Frames.SampleFrame(Position, Interpolation, Scores);
+	OutVisemes.SetNumUninitialized(FOVRLipSyncFrameData::NumVisemes);
+	FMemory::Memcpy(OutVisemes.GetData(), Scores, sizeof(float) * FOVRLipSyncFrameData::NumVisemes);
+	OutLaughterScore = Scores[FOVRLipSyncFrameData::NumVisemes];
+	return true;
+}
+
+void UOVRLipSyncFrameSequence::Serialize(FArchive &Ar)
+{
+	Ar.UsingCustomVersion(FOVRLipSyncFrameSequenceVersion::GUID);
+	Super::Serialize(Ar);
+
+	if (Ar.IsLoading() && Ar.CustomVer(FOVRLipSyncFrameSequenceVersion::GUID) < FOVRLipSyncFrameSequenceVersion::PackedFrames)
+	{
+		// Saved one frame at a time, pack what the tagged properties loaded.
+		TArray<float> Scores;
+		Scores.SetNumZeroed(FrameSequence.Num() * FOVRLipSyncFrameData::NumScores);
+		for (int32 Frame = 0; Frame < FrameSequence.Num(); ++Frame)
+		{
+			const FOVRLipSyncFrame &OldFrame = FrameSequence[Frame];
+			float *FrameScores = Scores.GetData() + Frame * FOVRLipSyncFrameData::NumScores;
+			const int32 NumVisemes = FMath::Min(OldFrame.VisemeScores.Num(), FOVRLipSyncFrameData::NumVisemes);
+			FMemory::Memcpy(FrameScores, OldFrame.VisemeScores.GetData(), sizeof(float) * NumVisemes);
+			FrameScores[FOVRLipSyncFrameData::NumVisemes] = OldFrame.LaughterScore;
+		}
+		SetFrames(Scores.GetData(), FrameSequence.Num());
+		FrameSequence.Empty();
+		return;
+	}
+
+	// The frames hold no references, and are counted by GetResourceSizeEx, so only archives that keep data pack them.
+	if (Ar.IsObjectReferenceCollector() || Ar.IsCountingMemory())
+	{
+		return;
+	}
+	Frames.Serialize(Ar);
+}
+
+void UOVRLipSyncFrameSequence::GetResourceSizeEx(FResourceSizeEx &CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Frames.GetAllocatedSize());
+}
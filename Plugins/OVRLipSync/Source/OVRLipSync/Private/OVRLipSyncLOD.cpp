@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncLOD.h"
+
+namespace
+{
+enum EViseme : int32
+{
+	Sil,
+	PP,
+	FF,
+	TH,
+	DD,
+	Kk,
+	CH,
+	SS,
+	Nn,
+	RR,
+	Aa,
+	E,
+	Ih,
+	Oh,
+	Ou,
+};
+
+// The viseme each viseme is folded into at Reduced, by the shape of the mouth.
+constexpr int32 ReducedVisemes[FOVRLipSyncFrameData::NumVisemes] = {
+	Sil, PP, FF, FF, DD, DD, SS, SS, DD, DD, Aa, E, E, Oh, Ou,
+};
+
+// The loudness the jaw starts to open at, and is fully open at, in dB below full scale.
+constexpr float JawClosedLevel = -50.0f;
+constexpr float JawOpenLevel = -15.0f;
+} // namespace
+
+bool OVRLipSyncLOD::IsVisemeUsed(EOVRLipSyncLOD LOD, int32 Viseme)
+{
+	switch (LOD)
+	{
+	case EOVRLipSyncLOD::Full:
+		return true;
+	case EOVRLipSyncLOD::Reduced:
+		return ReducedVisemes[Viseme] == Viseme;
+	case EOVRLipSyncLOD::Jaw:
+		return Viseme == Sil || Viseme == Aa;
+	default:
+		return Viseme == Sil;
+	}
+}
+
+void OVRLipSyncLOD::ReduceVisemes(EOVRLipSyncLOD LOD, float *Visemes)
+{
+	switch (LOD)
+	{
+	case EOVRLipSyncLOD::Full:
+		return;
+	case EOVRLipSyncLOD::Reduced:
+		for (int32 Viseme = 0; Viseme < FOVRLipSyncFrameData::NumVisemes; ++Viseme)
+		{
+			if (ReducedVisemes[Viseme] != Viseme)
+			{
+				Visemes[ReducedVisemes[Viseme]] = FMath::Min(Visemes[ReducedVisemes[Viseme]] + Visemes[Viseme], 1.0f);
+				Visemes[Viseme] = 0.0f;
+			}
+		}
+		return;
+	case EOVRLipSyncLOD::Jaw:
+		// Whatever is not silence opens the jaw.
+		SetJawOpen(1.0f - Visemes[Sil], Visemes);
+		return;
+	default:
+		SetJawOpen(0.0f, Visemes);
+		return;
+	}
+}
+
+void OVRLipSyncLOD::SetJawOpen(float JawOpen, float *Visemes)
+{
+	JawOpen = FMath::Clamp(JawOpen, 0.0f, 1.0f);
+	FMemory::Memzero(Visemes, FOVRLipSyncFrameData::NumVisemes * sizeof(float));
+	Visemes[Sil] = 1.0f - JawOpen;
+	Visemes[Aa] = JawOpen;
+}
+
+float FOVRLipSyncJawEnvelope::Process(const int16 *Samples, int32 NumSamples, float FrameSeconds)
+{
+	double SumOfSquares = 0.0;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		SumOfSquares += (double)Samples[Sample] * Samples[Sample];
+	}
+	const float Rms = NumSamples > 0 ? (float)FMath::Sqrt(SumOfSquares / NumSamples) / 32768.0f : 0.0f;
+	const float Level = 20.0f * FMath::LogX(10.0f, FMath::Max(Rms, 1e-5f));
+	const float Target = FMath::Clamp((Level - JawClosedLevel) / (JawOpenLevel - JawClosedLevel), 0.0f, 1.0f);
+
+	const float TimeConstant = Target > JawOpen ? AttackTime : ReleaseTime;
+	const float Alpha = TimeConstant > 0.0f ? 1.0f - FMath::Exp(-FrameSeconds / TimeConstant) : 1.0f;
+	JawOpen += (Target - JawOpen) * Alpha;
+	return JawOpen;
+}
@@ -25,7 +25,8 @@
 
 #include "AndroidPermissionCallbackProxy.h"
 #include "AndroidPermissionFunctionLibrary.h"
-#include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncLiveCapture.h"
 #include "OVRLipSyncModule.h"
 #include "VoiceModule.h"
 
@@ -37,30 +38,58 @@
 #endif
 
 
+UOVRLipSyncActorComponent::UOVRLipSyncActorComponent()
+{
+	// Ticking starts with capture.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+// Defined here, where FOVRLipSyncLiveCapture is complete.
+UOVRLipSyncActorComponent::~UOVRLipSyncActorComponent() = default;
+
 // Called when the game starts
 void UOVRLipSyncActorComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	LipSyncContext =
-		MakeShared<UOVRLipSyncContextWrapper>(UOVRLipSyncContextWrapper::ContextProviderFromProviderKind(ProviderKind),
-											  SampleRate,
-														   BufferSize, FString(), EnableHardwareAcceleration);
-	LipSyncContext->SetAsyncCallback([this](const TArray<float> &NewVisemes, float NewLaughterScore) {
-		Visemes = NewVisemes;
-		LaughterScore = NewLaughterScore;
-		OnVisemesReady.Broadcast();
-	});
+	ContextKey.Provider = ProviderKind;
+	ContextKey.SampleRate = SampleRate;
+	ContextKey.BufferSize = BufferSize;
+	ContextKey.bAccelerate = EnableHardwareAcceleration;
+	FOVRLipSyncContextPool::Get().Prewarm(ContextKey);
 }
 
 void UOVRLipSyncActorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Stop();
-	LipSyncContext = nullptr;
 
 	Super::EndPlay(EndPlayReason);
 }
 
+bool UOVRLipSyncActorComponent::AcquireContext()
+{
+	LipSyncContext = FOVRLipSyncContextPool::Get().TryAcquire(ContextKey);
+	if (!LipSyncContext)
+	{
+		// Taken by another component, or still being created.
+		FOVRLipSyncContextPool::Get().Prewarm(ContextKey);
+		return false;
+	}
+	// Only copied here, the scores are shown and broadcast by TickComponent on the game thread.
+	LipSyncContext->SetAsyncCallback(
+		[this](const ovrLipSyncFrame &Frame) { FedVisemes.Publish(Frame, FPlatformTime::Seconds()); });
+	return true;
+}
+
+void UOVRLipSyncActorComponent::ReleaseContext()
+{
+	if (LipSyncContext)
+	{
+		FOVRLipSyncContextPool::Get().Release(ContextKey, MoveTemp(LipSyncContext));
+	}
+}
+
 void UOVRLipSyncActorComponent::Start()
 {
 	if (VoiceCapture)
@@ -120,85 +149,94 @@ void UOVRLipSyncActorComponent::StartVoiceCapture()
 	}
 
 	VoiceCapture->Start();
-	auto &TimerManager = GetWorld()->GetTimerManager();
-	TimerManager.SetTimer(VoiceCaptureTimer, this, &UOVRLipSyncActorComponent::OnVoiceCaptureTimer,
-						  VoiceCaptureTimerRate, true);
+	// Read on a thread of its own, so visemes keep coming every 10 ms through game thread hitches.
+	Capture = MakeUnique<FOVRLipSyncLiveCapture>(VoiceCapture.ToSharedRef(), ContextKey);
+	Capture->SetLOD(LOD);
+	if (!Capture->StartThread())
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("Can't create the voice capture thread."));
+		Capture = nullptr;
+		VoiceCapture->Stop();
+		VoiceCapture = nullptr;
+		return;
+	}
+	SetComponentTickEnabled(true);
 }
 
 void UOVRLipSyncActorComponent::FeedAudio(const TArray<uint8> &VoiceData)
 {
-	if (!LipSyncContext)
+	if (!HasBegunPlay())
+	{
+		return;
+	}
+	// Ticks from the first audio fed until Stop, to show what the context analyses and to pick the level of detail.
+	if (!IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+	if (LOD == EOVRLipSyncLOD::Off)
 	{
 		return;
 	}
-
 	auto *ShortData = reinterpret_cast<const int16 *>(VoiceData.GetData());
 	auto ShortDataSize = VoiceData.Num() / 2;
+	if (LOD == EOVRLipSyncLOD::Jaw)
+	{
+		// Cheap enough to follow right here, without the context.
+		Visemes.SetNumUninitialized(FOVRLipSyncFrameData::NumVisemes);
+		OVRLipSyncLOD::SetJawOpen(JawEnvelope.Process(ShortData, ShortDataSize, (float)ShortDataSize / SampleRate),
+								  Visemes.GetData());
+		LaughterScore = 0.0f;
+		OnVisemesReady.Broadcast();
+		return;
+	}
+
+	// The context is borrowed until Stop, so it is only held while audio is being fed. Audio fed before one is ready
+	// is not analysed.
+	if (!LipSyncContext && !AcquireContext())
+	{
+		return;
+	}
 	LipSyncContext->ProcessFrameAsync(ShortData, ShortDataSize);
 }
 
 void UOVRLipSyncActorComponent::Stop()
 {
+	ReleaseContext();
+	SetComponentTickEnabled(false);
 	if (!VoiceCapture)
 	{
 		return;
 	}
 
-	auto &TimerManager = GetWorld()->GetTimerManager();
-	TimerManager.ClearTimer(VoiceCaptureTimer);
+	// The thread reads VoiceCapture until it is joined.
+	Capture = nullptr;
 	VoiceCapture->Stop();
 	VoiceCapture = nullptr;
 
 	InitNeutralPose();
 }
 
-// Called every VoiceCaptureTimerRate seconds (10ms) to process audio data
-void UOVRLipSyncActorComponent::OnVoiceCaptureTimer()
+void UOVRLipSyncActorComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+											 FActorComponentTickFunction *ThisTickFunction)
 {
-	if (!VoiceCapture || !VoiceCapture.IsValid())
-	{
-		return;
-	}
-
-	uint32 AvailableVoiceData = 0;
-	auto CaptureState = VoiceCapture->GetCaptureState(AvailableVoiceData);
-	if (CaptureState == EVoiceCaptureState::NoData)
-	{
-		return;
-	}
-	if (CaptureState == EVoiceCaptureState::UnInitialized)
-	{
-		if (!VoiceCapture->Init("", SampleRate, 1) || !VoiceCapture->Start())
-		{
-			UE_LOG(LogOvrLipSync, Log, TEXT("Unsuccessfully tried to restart VoiceCapture."));
-			return;
-		}
-		UE_LOG(LogOvrLipSync, Log, TEXT("Restarted VoiceCapture."));
-		return;
-	}
-	if (CaptureState != EVoiceCaptureState::Ok)
-	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("Invalid capture state: %s"), EVoiceCaptureState::ToString(CaptureState));
-		return;
-	}
-	if (AvailableVoiceData == 0)
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	// Only the latest frame is shown, the ones analysed before it since the last tick are already out of date.
+	bool bNewVisemes = Capture && Capture->GetLatestVisemes(Visemes, LaughterScore);
+	bNewVisemes |= FedVisemes.Read(Visemes, LaughterScore);
+	if (bNewVisemes)
 	{
-		return;
+		// Frames analysed before the level of detail changed may still arrive.
+		ApplyLODToVisemes();
+		OnVisemesReady.Broadcast();
 	}
+}
 
-	TArray<uint8> VoiceData;
-	uint32 VoiceDataCaptured;
-	VoiceData.SetNumUninitialized(AvailableVoiceData);
-
-	CaptureState = VoiceCapture->GetVoiceData(VoiceData.GetData(), VoiceData.Num(), VoiceDataCaptured);
-	if (CaptureState != EVoiceCaptureState::Ok || VoiceDataCaptured == 0)
+void UOVRLipSyncActorComponent::OnLODChanged(EOVRLipSyncLOD OldLOD)
+{
+	if (Capture)
 	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to get voice data: %s DataCaptured=%d"),
-			   EVoiceCaptureState::ToString(CaptureState), VoiceDataCaptured);
-		return;
+		Capture->SetLOD(LOD);
 	}
-	VoiceData.SetNum(VoiceDataCaptured);
-	FeedAudio(VoiceData);
+	Super::OnLODChanged(OldLOD);
 }
-
-const float UOVRLipSyncActorComponent::VoiceCaptureTimerRate = .01f;
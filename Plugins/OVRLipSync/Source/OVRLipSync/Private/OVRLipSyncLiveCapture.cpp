@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncLiveCapture.h"
+#include "HAL/RunnableThread.h"
+#include "OVRLipSyncModule.h"
+#include "VoiceModule.h"
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Live Mouth Latency (ms)"), STAT_OVRLipSyncLiveLatency, STATGROUP_OVRLipSync);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Live Frame Jitter (ms)"), STAT_OVRLipSyncLiveJitter, STATGROUP_OVRLipSync);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Dropped Audio (ms)"), STAT_OVRLipSyncLiveDroppedMs, STATGROUP_OVRLipSync);
+
+namespace
+{
+// The length of an analysis frame.
+constexpr double FrameSeconds = 0.01;
+// The seconds of audio the ring holds, only filled if analysis falls behind the microphone.
+constexpr int32 RingFrames = 100;
+// How often the device is polled, half a frame so frames are cut within 5 ms of being captured.
+constexpr float PollInterval = 0.005f;
+} // namespace
+
+FOVRLipSyncLiveCapture::FOVRLipSyncLiveCapture(TSharedRef<IVoiceCapture> InVoiceCapture,
+											   const FOVRLipSyncContextKey &InContextKey)
+	: VoiceCapture(InVoiceCapture), ContextKey(InContextKey)
+{
+	FrameBytes = FMath::Max(ContextKey.SampleRate / 100, 1) * sizeof(int16);
+	FrameDelayInMs = FOVRLipSyncContextPool::Get().GetFrameDelay(ContextKey);
+	Ring.SetNumUninitialized(FrameBytes * RingFrames);
+	DeviceBuffer.SetNumUninitialized(Ring.Num());
+}
+
+FOVRLipSyncLiveCapture::~FOVRLipSyncLiveCapture()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+bool FOVRLipSyncLiveCapture::StartThread()
+{
+	Thread = FRunnableThread::Create(this, TEXT("OVRLipSyncLiveCapture"), 0, TPri_Highest);
+	return Thread != nullptr;
+}
+
+void FOVRLipSyncLiveCapture::Stop() { bStopping = true; }
+
+uint32 FOVRLipSyncLiveCapture::Run()
+{
+	FOVRLipSyncContextPool::FContextPtr Context = FOVRLipSyncContextPool::Get().Acquire(ContextKey);
+	EVoiceCaptureState::Type LoggedState = EVoiceCaptureState::Ok;
+	while (!bStopping)
+	{
+		uint32 AvailableBytes = 0;
+		const EVoiceCaptureState::Type State = VoiceCapture->GetCaptureState(AvailableBytes);
+		if (State == EVoiceCaptureState::UnInitialized)
+		{
+			if (!VoiceCapture->Init(FString(), ContextKey.SampleRate, 1) || !VoiceCapture->Start())
+			{
+				UE_LOG(LogOvrLipSync, Log, TEXT("Unsuccessfully tried to restart VoiceCapture."));
+			}
+			else
+			{
+				UE_LOG(LogOvrLipSync, Log, TEXT("Restarted VoiceCapture."));
+				ResetTimeline();
+			}
+		}
+		else if (State == EVoiceCaptureState::Ok)
+		{
+			if (AvailableBytes > 0)
+			{
+				ReadCapturedAudio(AvailableBytes);
+			}
+		}
+		else if (State != EVoiceCaptureState::NoData && State != LoggedState)
+		{
+			// Logged once, not every poll.
+			UE_LOG(LogOvrLipSync, Error, TEXT("Invalid capture state: %s"), EVoiceCaptureState::ToString(State));
+		}
+		LoggedState = State;
+
+		AnalyseFrames(*Context);
+		FPlatformProcess::Sleep(PollInterval);
+	}
+	FOVRLipSyncContextPool::Get().Release(ContextKey, MoveTemp(Context));
+	return 0;
+}
+
+void FOVRLipSyncLiveCapture::ReadCapturedAudio(uint32 AvailableBytes)
+{
+	if ((uint32)DeviceBuffer.Num() < AvailableBytes)
+	{
+		// Only after the thread stalls for longer than the ring holds, the buffer keeps its size from then on.
+		DeviceBuffer.SetNumUninitialized(AvailableBytes);
+	}
+	uint32 CapturedBytes = 0;
+	const EVoiceCaptureState::Type State =
+		VoiceCapture->GetVoiceData(DeviceBuffer.GetData(), DeviceBuffer.Num(), CapturedBytes);
+	if (State != EVoiceCaptureState::Ok || CapturedBytes == 0)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to get voice data: %s DataCaptured=%d"),
+			   EVoiceCaptureState::ToString(State), CapturedBytes);
+		return;
+	}
+
+	const uint8 *Data = DeviceBuffer.GetData();
+	int32 Bytes = (int32)CapturedBytes & ~1;
+	if (TimelineStart == 0.0)
+	{
+		// Taken to have just been captured, which only offsets the lag, not its deviation.
+		TimelineStart = FPlatformTime::Seconds() - (double)Bytes / (sizeof(int16) * ContextKey.SampleRate);
+	}
+	int32 DroppedBytes = 0;
+	if (RingCount + Bytes > Ring.Num())
+	{
+		// The oldest whole frames make room first, so frames still start on a frame of the ring.
+		const int32 WholeFrameBytes = RingCount - RingCount % FrameBytes;
+		DroppedBytes = FMath::Min(FMath::DivideAndRoundUp(RingCount + Bytes - Ring.Num(), FrameBytes) * FrameBytes,
+								  WholeFrameBytes);
+		RingRead = (RingRead + DroppedBytes) % Ring.Num();
+		RingCount -= DroppedBytes;
+		if (RingCount + Bytes > Ring.Num())
+		{
+			// More than the ring holds arrived at once, only the newest of it is kept.
+			DroppedBytes += RingCount;
+			RingRead = 0;
+			RingCount = 0;
+			if (Bytes > Ring.Num())
+			{
+				DroppedBytes += Bytes - Ring.Num();
+				Data += Bytes - Ring.Num();
+				Bytes = Ring.Num();
+			}
+		}
+	}
+	if (DroppedBytes > 0)
+	{
+		// Still part of the timeline, the audio after it was captured that much later.
+		ConsumedBytes += DroppedBytes;
+		INC_DWORD_STAT_BY(STAT_OVRLipSyncLiveDroppedMs, DroppedBytes * 1000 / (sizeof(int16) * ContextKey.SampleRate));
+	}
+
+	const int32 Write = (RingRead + RingCount) % Ring.Num();
+	const int32 BeforeEnd = FMath::Min(Bytes, Ring.Num() - Write);
+	FMemory::Memcpy(Ring.GetData() + Write, Data, BeforeEnd);
+	FMemory::Memcpy(Ring.GetData(), Data + BeforeEnd, Bytes - BeforeEnd);
+	RingCount += Bytes;
+}
+
+void FOVRLipSyncLiveCapture::AnalyseFrames(UOVRLipSyncContextWrapper &Context)
+{
+	while (RingCount >= FrameBytes)
+	{
+		const EOVRLipSyncLOD NewLOD = LOD;
+		if (NewLOD != FrameLOD)
+		{
+			FramesSinceAnalysed = 0;
+			FrameLOD = NewLOD;
+		}
+
+		const int16 *Samples = reinterpret_cast<const int16 *>(Ring.GetData() + RingRead);
+		const int32 NumSamples = FrameBytes / sizeof(int16);
+		ConsumedBytes += FrameBytes;
+		switch (FrameLOD)
+		{
+		case EOVRLipSyncLOD::Full:
+		case EOVRLipSyncLOD::Reduced:
+			// At Reduced the frames in between are skipped, the model is cheaper to run less often than smaller.
+			if (FrameLOD == EOVRLipSyncLOD::Full || FramesSinceAnalysed++ % OVRLipSyncLOD::ReducedAnalysisStride == 0)
+			{
+				int32_t FrameDelay = 0;
+				Context.ProcessFrame(Samples, NumSamples, FrameVisemes, FrameLaughterScore, FrameDelay);
+				OVRLipSyncLOD::ReduceVisemes(FrameLOD, FrameVisemes.GetData());
+				PublishFrame();
+			}
+			break;
+		case EOVRLipSyncLOD::Jaw:
+			FrameVisemes.SetNumUninitialized(FOVRLipSyncFrameData::NumVisemes);
+			OVRLipSyncLOD::SetJawOpen(JawEnvelope.Process(Samples, NumSamples, FrameSeconds), FrameVisemes.GetData());
+			FrameLaughterScore = 0.0f;
+			PublishFrame();
+			break;
+		default:
+			// Off, the audio is read so the ring does not overflow, and dropped.
+			break;
+		}
+		RingRead = (RingRead + FrameBytes) % Ring.Num();
+		RingCount -= FrameBytes;
+	}
+}
+
+void FOVRLipSyncLiveCapture::ResetTimeline()
+{
+	TimelineStart = 0.0;
+	ConsumedBytes = 0;
+	MeanLag = 0.0;
+	Jitter = 0.0;
+}
+
+void FOVRLipSyncLiveCapture::PublishFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+	// Against the audio rather than the previous frame, so frames cut together from one device read are as late as
+	// their audio makes them and no later. The microphone is taken to deliver its sample rate in real time, the slow
+	// mean absorbs any drift between its clock and this one.
+	const double Lag = Now - TimelineStart - (double)ConsumedBytes / (sizeof(int16) * ContextKey.SampleRate);
+	if (MeanLag == 0.0)
+	{
+		MeanLag = Lag;
+	}
+	MeanLag += (Lag - MeanLag) / 256.0;
+	Jitter += (FMath::Abs(Lag - MeanLag) - Jitter) / 16.0;
+	SET_FLOAT_STAT(STAT_OVRLipSyncLiveJitter, Jitter * 1000.0);
+
+	FOVRLipSyncVisemeFrame &Frame = Latest.BeginWrite();
+	Frame.NumVisemes = FMath::Min(FrameVisemes.Num(), (int32)ovrLipSyncViseme_Count);
+	FMemory::Memcpy(Frame.Visemes, FrameVisemes.GetData(), Frame.NumVisemes * sizeof(float));
+	Frame.LaughterScore = FrameLaughterScore;
+	Frame.AnalysedAt = Now;
+	Frame.BufferedSeconds = (double)RingCount / (sizeof(int16) * ContextKey.SampleRate);
+	Latest.EndWrite();
+}
+
+bool FOVRLipSyncLiveCapture::GetLatestVisemes(TArray<float> &OutVisemes, float &OutLaughterScore)
+{
+	const FOVRLipSyncVisemeFrame *Frame = Latest.Read();
+	if (!Frame)
+	{
+		return false;
+	}
+	OutVisemes.SetNumUninitialized(Frame->NumVisemes);
+	FMemory::Memcpy(OutVisemes.GetData(), Frame->Visemes, Frame->NumVisemes * sizeof(float));
+	OutLaughterScore = Frame->LaughterScore;
+
+	// From the newest audio of the frame being captured to the face showing it, as far as the plugin can tell: the
+	// audio captured after it, the delay of the model, and the wait for the game thread.
+	const double Latency =
+		(FPlatformTime::Seconds() - Frame->AnalysedAt) + Frame->BufferedSeconds + FrameDelayInMs / 1000.0;
+	SET_FLOAT_STAT(STAT_OVRLipSyncLiveLatency, Latency * 1000.0);
+	return true;
+}
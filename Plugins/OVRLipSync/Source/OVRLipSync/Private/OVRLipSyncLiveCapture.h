@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "OVRLipSyncConstants.h"
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncLOD.h"
+#include "OVRLipSyncVisemeState.h"
+#include <atomic>
+
+class IVoiceCapture;
+class FRunnableThread;
+
+/**
+ * Captures microphone audio on its own thread and analyses it 10 ms at a time, so visemes arrive at the rate the audio
+ * does however long game thread frames take. Audio is copied into a ring allocated up front, and frames are cut from
+ * it as soon as there is enough for one.
+ */
+class FOVRLipSyncLiveCapture : public FRunnable
+{
+public:
+	/**
+	 * @param InVoiceCapture The started mono capture device, read only by the capture thread until this is destroyed.
+	 * @param InContextKey The context frames are analysed with, borrowed for as long as the thread runs.
+	 */
+	FOVRLipSyncLiveCapture(TSharedRef<IVoiceCapture> InVoiceCapture, const FOVRLipSyncContextKey &InContextKey);
+	// Stops the thread and waits for it.
+	virtual ~FOVRLipSyncLiveCapture();
+
+	// Starts the capture thread, returning false if it could not be created.
+	bool StartThread();
+
+	/**
+	 * Gets the scores of the latest frame analysed, and updates the live latency stat. Called on the game thread.
+	 * @returns false, leaving the outputs alone, if no frame was analysed since the last call.
+	 */
+	bool GetLatestVisemes(TArray<float> &OutVisemes, float &OutLaughterScore);
+
+	/** Sets how frames are analysed from the next one on. Called on the game thread. */
+	void SetLOD(EOVRLipSyncLOD NewLOD) { LOD = NewLOD; }
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	// Moves what the device has captured into the ring, dropping the oldest frames if the ring is full.
+	void ReadCapturedAudio(uint32 AvailableBytes);
+	// Analyses every whole frame in the ring.
+	void AnalyseFrames(UOVRLipSyncContextWrapper &Context);
+	// Hands the scores of the frame just analysed to the game thread.
+	void PublishFrame();
+	// Starts the audio timeline the jitter is measured against over.
+	void ResetTimeline();
+
+	TSharedRef<IVoiceCapture> VoiceCapture;
+	FOVRLipSyncContextKey ContextKey;
+	FRunnableThread *Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+	std::atomic<EOVRLipSyncLOD> LOD{ EOVRLipSyncLOD::Full };
+
+	// Only touched by the capture thread.
+	int32 FrameBytes = 0; ///< 10 ms of 16 bit mono audio.
+	int32 FrameDelayInMs = 0;
+	TArray<uint8> Ring; ///< A whole number of frames, read a frame at a time, so no frame wraps around its end.
+	int32 RingRead = 0; ///< The byte the oldest captured audio starts at, always the start of a frame.
+	int32 RingCount = 0; ///< The bytes of captured audio in the ring.
+	TArray<uint8> DeviceBuffer; ///< What the device hands over, which it only does in one piece.
+	TArray<float> FrameVisemes;
+	float FrameLaughterScore = 0.0f;
+	double TimelineStart = 0.0; ///< When the first audio captured was, 0 until some is.
+	int64 ConsumedBytes = 0; ///< The audio captured since TimelineStart that was analysed, skipped or dropped.
+	double MeanLag = 0.0; ///< The smoothed seconds between audio being captured and its frame being analysed.
+	double Jitter = 0.0; ///< The smoothed deviation of that lag from MeanLag, in seconds.
+	EOVRLipSyncLOD FrameLOD = EOVRLipSyncLOD::Full; ///< The level of detail of the last frame.
+	int32 FramesSinceAnalysed = 0; ///< At Reduced, the frames skipped since the last one analysed.
+	FOVRLipSyncJawEnvelope JawEnvelope;
+
+	// Handed from the capture thread to the game thread.
+	FOVRLipSyncVisemeState Latest;
+};
@@ -23,12 +23,18 @@
 #include "OVRLipSyncModule.h"
 
 #include "Modules/ModuleManager.h"
+#include "OVRLipSyncContextPool.h"
 #include "OVRLipSync.h"
 
 class FOVRLipSyncModule : public IModuleInterface
 {
 public:
-	void ShutdownModule() override { ovrLipSync_Shutdown(); }
+	void ShutdownModule() override
+	{
+		// Pooled contexts must go before the library does.
+		FOVRLipSyncContextPool::Get().Shutdown();
+		ovrLipSync_Shutdown();
+	}
 };
 
 IMPLEMENT_MODULE(FOVRLipSyncModule, OVRLipSync);
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncMorphTargetBinding.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "OVRLipSyncLOD.h"
+
+namespace
+{
+// Never within any epsilon of a score, so the first Apply after binding writes every weight.
+constexpr float UnappliedWeight = TNumericLimits<float>::Max();
+} // namespace
+
+void FOVRLipSyncMorphTargetBinding::Bind(USkeletalMeshComponent *InMesh, const TArray<FString> &MorphTargetNames)
+{
+	USkeletalMesh *Asset = InMesh ? InMesh->GetSkeletalMeshAsset() : nullptr;
+	// The names are always compared, as an array edited in place keeps its address. There are only a few short ones.
+	if (Mesh.Get() == InMesh && BoundAsset.Get() == Asset && BoundNames == MorphTargetNames)
+	{
+		return;
+	}
+	Mesh = InMesh;
+	BoundAsset = Asset;
+	BoundNames = MorphTargetNames;
+	MorphTargets.Reset(MorphTargetNames.Num());
+	for (const FString &Name : MorphTargetNames)
+	{
+		MorphTargets.Add(FName(*Name));
+	}
+	AppliedWeights.Init(UnappliedWeight, MorphTargets.Num());
+}
+
+void FOVRLipSyncMorphTargetBinding::Unbind()
+{
+	Mesh.Reset();
+	BoundAsset.Reset();
+	BoundNames.Reset();
+	MorphTargets.Reset();
+	AppliedWeights.Reset();
+}
+
+void FOVRLipSyncMorphTargetBinding::ResetAppliedWeights()
+{
+	for (float &Weight : AppliedWeights)
+	{
+		Weight = UnappliedWeight;
+	}
+}
+
+int32 FOVRLipSyncMorphTargetBinding::Apply(const TArray<float> &Weights, EOVRLipSyncLOD LOD, bool bAllVisemes,
+											float Epsilon)
+{
+	USkeletalMeshComponent *BoundMesh = Mesh.Get();
+	if (!BoundMesh)
+	{
+		return 0;
+	}
+	int32 NumWritten = 0;
+	const int32 NumMorphTargets = FMath::Min(MorphTargets.Num(), Weights.Num());
+	for (int32 Viseme = 0; Viseme < NumMorphTargets; ++Viseme)
+	{
+		if (!bAllVisemes && !OVRLipSyncLOD::IsVisemeUsed(LOD, Viseme))
+		{
+			continue;
+		}
+		if (FMath::Abs(Weights[Viseme] - AppliedWeights[Viseme]) <= Epsilon)
+		{
+			continue;
+		}
+		BoundMesh->SetMorphTarget(MorphTargets[Viseme], Weights[Viseme]);
+		AppliedWeights[Viseme] = Weights[Viseme];
+		++NumWritten;
+	}
+	return NumWritten;
+}
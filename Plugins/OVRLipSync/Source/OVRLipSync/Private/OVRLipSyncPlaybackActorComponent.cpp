@@ -24,6 +24,19 @@
 #include "OVRLipSyncPlaybackActorComponent.h"
 #include "OVRLipSyncModule.h"
 
+namespace
+{
+// The longest the playback position runs on without a percent callback, so a paused or stalled sound freezes the face.
+constexpr double MaxExtrapolation = 0.25;
+} // namespace
+
+UOVRLipSyncPlaybackActorComponent::UOVRLipSyncPlaybackActorComponent()
+{
+	// Ticking starts with playback.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
 UAudioComponent *UOVRLipSyncPlaybackActorComponent::FindAutoplayAudioComponent() const
 {
 	TArray<UAudioComponent *> AudioComponents;
@@ -71,24 +84,66 @@ void UOVRLipSyncPlaybackActorComponent::OnAudioPlaybackPercent(const UAudioCompo
 		InitNeutralPose();
 		return;
 	}
-	auto PlayPos = SoundWave->Duration * Percent;
-	auto IntPos = static_cast<unsigned>(PlayPos * 100);
-	if (IntPos >= Sequence->Num())
+	ReportedPlaybackTime = SoundWave->Duration * Percent;
+	ReportedAt = FPlatformTime::Seconds();
+	bPlaybackClockValid = true;
+	if (LOD != EOVRLipSyncLOD::Off)
 	{
-		InitNeutralPose();
-		return;
+		SampleSequence(GetPlaybackTime());
 	}
-	const auto &Frame = (*Sequence)[IntPos];
-	LaughterScore = Frame.LaughterScore;
-	Visemes = Frame.VisemeScores;
-	OnVisemesReady.Broadcast();
 }
 
 void UOVRLipSyncPlaybackActorComponent::OnAudioPlaybackFinished(UAudioComponent *) { 
+	bPlaybackClockValid = false;
 	InitNeutralPose(); 
 }
 
+void UOVRLipSyncPlaybackActorComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+													  FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	// Off screen the face stays neutral, nothing is sampled.
+	if (!Sequence || LOD == EOVRLipSyncLOD::Off)
+	{
+		return;
+	}
+	const double PlaybackTime = GetPlaybackTime();
+	if (PlaybackTime < 0.0)
+	{
+		return;
+	}
+	SampleSequence(PlaybackTime);
+}
+
+double UOVRLipSyncPlaybackActorComponent::GetPlaybackTime() const
+{
+	if (!bPlaybackClockValid)
+	{
+		return -1.0;
+	}
+	const double Pitch = AudioComponent ? AudioComponent->PitchMultiplier : 1.0;
+	const double Elapsed = FMath::Min(FPlatformTime::Seconds() - ReportedAt, MaxExtrapolation);
+	return ReportedPlaybackTime + Elapsed * Pitch;
+}
+
+void UOVRLipSyncPlaybackActorComponent::SampleSequence(double PlaybackTime)
+{
+	if (!Sequence->Sample((float)PlaybackTime, Interpolation, Visemes, LaughterScore))
+	{
+		InitNeutralPose();
+		return;
+	}
+	ApplyLODToVisemes();
+	OnVisemesReady.Broadcast();
+}
+
 void UOVRLipSyncPlaybackActorComponent::Start(UAudioComponent *InAudioComponent, UOVRLipSyncFrameSequence *InSequence)
+{
+	Attach(InAudioComponent, InSequence);
+	AudioComponent->Play();
+}
+
+void UOVRLipSyncPlaybackActorComponent::Attach(UAudioComponent *InAudioComponent, UOVRLipSyncFrameSequence *InSequence)
 {
 	AudioComponent = InAudioComponent;
 	if (InSequence)
@@ -99,7 +154,8 @@ void UOVRLipSyncPlaybackActorComponent::Start(UAudioComponent *InAudioComponent,
 		this, &UOVRLipSyncPlaybackActorComponent::OnAudioPlaybackPercent);
 	PlaybackFinishedHandle = AudioComponent->OnAudioFinishedNative.AddUObject(
 		this, &UOVRLipSyncPlaybackActorComponent::OnAudioPlaybackFinished);
-	AudioComponent->Play();
+	bPlaybackClockValid = false;
+	SetComponentTickEnabled(true);
 }
 
 void UOVRLipSyncPlaybackActorComponent::Stop()
@@ -111,10 +167,13 @@ void UOVRLipSyncPlaybackActorComponent::Stop()
 	AudioComponent->OnAudioPlaybackPercentNative.Remove(PlaybackPercentHandle);
 	AudioComponent->OnAudioFinishedNative.Remove(PlaybackFinishedHandle);
 	AudioComponent = nullptr;
+	bPlaybackClockValid = false;
 	InitNeutralPose();
 }
 
 void UOVRLipSyncPlaybackActorComponent::SetPlaybackSequence(UOVRLipSyncFrameSequence *InSequence)
 {
 	Sequence = InSequence;
+	// The position reported for the previous sequence does not apply to this one.
+	bPlaybackClockValid = false;
 }
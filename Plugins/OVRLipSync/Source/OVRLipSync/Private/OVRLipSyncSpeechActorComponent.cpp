@@ -2,86 +2,137 @@
 
 
 #include "OVRLipSyncSpeechActorComponent.h"
-#include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncLOD.h"
 #include "OVRLipSyncModule.h"
+#include "OVRLipSyncVisemeMapping.h"
 
 
-USoundWave *UOVRLipSyncSpeechActorComponent::ByteArrayToSoundWave(const TArray<uint8> &DataArray)
+namespace
 {
+struct FCookSettings
+{
+	int32 ChunkSampleSize;
+	int32 ChunkSize;
+	int32 FrameOffset;
+	bool bStereo;
+	EOVRLipSyncScoreQuantization Quantization;
+	FOVRLipSyncContextKey ContextKey;
+	EOVRLipSyncLOD LOD; ///< Never Off. At Jaw no context is needed.
+};
 
-	USoundWave *SoundWave = NewObject<USoundWave>(USoundWave::StaticClass());
-	if (!ensure(SoundWave))
-	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:ByteArrayToSoundWave: SoundWave could not be created."));
-		return nullptr;
-	}
-
-	const uint32 Num = DataArray.Num();
-	SoundWave->Duration = ((double)Num * (double)NumChannels) / (double)SampleRate;
-
-	SoundWave->SetSampleRate(SampleRate / 2);
-	SoundWave->NumChannels = NumChannels;
-	SoundWave->SoundGroup = ESoundGroup::SOUNDGROUP_Voice;
-	SoundWave->Volume = (double)Volume / 100.0;
-	SoundWave->RawPCMDataSize = Num * sizeof(uint8);
-	SoundWave->RawPCMData = (uint8 *)FMemory::Malloc(Num * sizeof(uint8));
-	FMemory::Memcpy(SoundWave->RawPCMData, DataArray.GetData(), Num * sizeof(uint8));
+// Off only says nobody sees the character now, the utterance may well play once someone does. Jaw costs no context,
+// so an utterance fed while Off is cooked at Jaw rather than left without frames.
+EOVRLipSyncLOD GetCookLOD(EOVRLipSyncLOD LOD) { return LOD == EOVRLipSyncLOD::Off ? EOVRLipSyncLOD::Jaw : LOD; }
 
-	return SoundWave;
+FCookSettings MakeCookSettings(int32 ChunkSampleSize, int32 ChunkSize, int32 FrameOffset, bool bStereo,
+							   EOVRLipSyncScoreQuantization Quantization, const FOVRLipSyncContextKey &ContextKey,
+							   EOVRLipSyncLOD LOD)
+{
+	// Only the model delays the visemes. At Reduced it sees one frame in ReducedAnalysisStride, so its delay in frames
+	// takes that many times as long.
+	const int32 LODFrameOffset = LOD == EOVRLipSyncLOD::Full	  ? FrameOffset
+								 : LOD == EOVRLipSyncLOD::Reduced ? FrameOffset * OVRLipSyncLOD::ReducedAnalysisStride
+																  : 0;
+	return { ChunkSampleSize, ChunkSize, LODFrameOffset, bStereo, Quantization, ContextKey, GetCookLOD(LOD) };
 }
 
-void UOVRLipSyncSpeechActorComponent::CookAudioData(const TArray<uint8> &PCMData)
+FOVRLipSyncContextPool::FContextPtr AcquireCookContext(const FCookSettings &Settings)
 {
-	TArray<int16> PCMData16(reinterpret_cast<const int16 *>(PCMData.GetData()), PCMData.Num() / 2);
-	int32 PCMDataSize = PCMData16.Num();
-	const int16 *PCMDataInt16 = PCMData16.GetData();
-
-	UOVRLipSyncFrameSequence *NewSequence = NewObject<UOVRLipSyncFrameSequence>();
+	return Settings.LOD < EOVRLipSyncLOD::Jaw ? FOVRLipSyncContextPool::Get().Acquire(Settings.ContextKey) : nullptr;
+}
 
-	if (!LipSyncContext)
+void ReleaseCookContext(const FCookSettings &Settings, FOVRLipSyncContextPool::FContextPtr Context)
+{
+	if (Context)
 	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("LipSyncContext is NULL"));
-		return;
+		FOVRLipSyncContextPool::Get().Release(Settings.ContextKey, MoveTemp(Context));
 	}
+}
 
-	float NewLaughterScore = 0.0f;
+/**
+ * Runs the lip sync context over an utterance 10 ms at a time, as much of it as the level of detail of the settings
+ * needs. Called on the cooking pipe.
+ * OnWindow gets the frames analysed since the last call, every WindowFrames frames and once more at the end, with
+ * the number of samples of the utterance they cover so far.
+ */
+void AnalyseAudioData(UOVRLipSyncContextWrapper *LipSyncContext, const TArray<uint8> &PCMData, const FCookSettings &Settings,
+					  int32 WindowFrames, const std::atomic<bool> &bCancelled,
+					  TFunctionRef<void(TArray<float> &Scores, int32 CoveredSamples, bool bLast)> OnWindow)
+{
+	const int16 *PCMDataInt16 = reinterpret_cast<const int16 *>(PCMData.GetData());
+	const int32 PCMDataSize = PCMData.Num() / sizeof(int16);
 
+	TArray<float> Scores;
+	Scores.Reserve((FMath::Min(PCMDataSize / Settings.ChunkSize, WindowFrames) + 1) * FOVRLipSyncFrameData::NumScores);
+	int32 NumFrames = 0;
+
+	float NewLaughterScore = 0.0f;
+	int32_t FrameDelayInMs = 0;
 	TArray<float> NewVisemes;
 
 	TArray<int16> samples;
-	samples.SetNumZeroed(ChunkSize);
+	samples.SetNumZeroed(Settings.ChunkSize);
+	FOVRLipSyncJawEnvelope JawEnvelope;
 
-	for (int32 Offset = 0; Offset < PCMDataSize + FrameOffset; Offset += ChunkSize)
+	int32 Chunk = 0;
+	for (int32 Offset = 0; Offset < PCMDataSize + Settings.FrameOffset; Offset += Settings.ChunkSize, ++Chunk)
 	{
+		const int16 *ChunkData = samples.GetData();
 		const int32 RemainingSamples = PCMDataSize - Offset;
-		if (RemainingSamples >= ChunkSize)
+		if (RemainingSamples >= Settings.ChunkSize)
 		{
-			LipSyncContext->ProcessFrame(PCMDataInt16 + Offset, ChunkSampleSize, NewVisemes, NewLaughterScore,
-										 FrameDelayInMs, bStereo);
+			ChunkData = PCMDataInt16 + Offset;
 		}
 		else
 		{
-			if (RemainingSamples > 0)
-			{
-				memcpy(samples.GetData(), PCMDataInt16 + Offset, sizeof(int16) * RemainingSamples);
-				memset(samples.GetData() + RemainingSamples, 0, ChunkSize - RemainingSamples);
-			}
-			else
+			// Pad the last chunk, and flush the context's delay, with silence.
+			const int32 Copied = FMath::Max(RemainingSamples, 0);
+			if (Copied > 0)
 			{
-				memset(samples.GetData(), 0, ChunkSize);
+				FMemory::Memcpy(samples.GetData(), PCMDataInt16 + Offset, sizeof(int16) * Copied);
 			}
-			LipSyncContext->ProcessFrame(samples.GetData(), ChunkSampleSize, NewVisemes, NewLaughterScore,
-										 FrameDelayInMs, bStereo);
+			FMemory::Memzero(samples.GetData() + Copied, sizeof(int16) * (Settings.ChunkSize - Copied));
+		}
+
+		if (Settings.LOD == EOVRLipSyncLOD::Jaw)
+		{
+			NewVisemes.SetNumUninitialized(FOVRLipSyncFrameData::NumVisemes);
+			OVRLipSyncLOD::SetJawOpen(JawEnvelope.Process(ChunkData, Settings.ChunkSize, 0.01f), NewVisemes.GetData());
+			NewLaughterScore = 0.0f;
+		}
+		else if (Settings.LOD == EOVRLipSyncLOD::Full || Chunk % OVRLipSyncLOD::ReducedAnalysisStride == 0)
+		{
+			// At Reduced the chunks in between keep the scores of the one before.
+			LipSyncContext->ProcessFrame(ChunkData, Settings.ChunkSampleSize, NewVisemes, NewLaughterScore,
+										 FrameDelayInMs, Settings.bStereo);
+		}
+
+		if (Offset >= Settings.FrameOffset)
+		{
+			const int32 Frame = Scores.AddZeroed(FOVRLipSyncFrameData::NumScores);
+			FMemory::Memcpy(&Scores[Frame], NewVisemes.GetData(),
+							sizeof(float) * FMath::Min(NewVisemes.Num(), FOVRLipSyncFrameData::NumVisemes));
+			OVRLipSyncLOD::ReduceVisemes(Settings.LOD, &Scores[Frame]);
+			Scores[Frame + FOVRLipSyncFrameData::NumVisemes] = NewLaughterScore;
+			NumFrames++;
 		}
 
-		if (Offset >= FrameOffset)
+		const bool bLast = Offset + Settings.ChunkSize >= PCMDataSize + Settings.FrameOffset;
+		if (bLast || Scores.Num() / FOVRLipSyncFrameData::NumScores >= WindowFrames)
 		{
-			NewSequence->Add(NewVisemes, NewLaughterScore);
+			OnWindow(Scores, bLast ? PCMDataSize : FMath::Min(NumFrames * Settings.ChunkSize, PCMDataSize), bLast);
+			Scores.Reset();
+		}
+		if (bCancelled)
+		{
+			return;
 		}
 	}
-	lipSyncData.Enqueue(TPair<UOVRLipSyncFrameSequence *, TArray<int16>>(NewSequence, PCMData16));
 }
 
+} // namespace
+
 UOVRLipSyncSpeechActorComponent::UOVRLipSyncSpeechActorComponent(const FObjectInitializer &ObjectInitializer)
 	: UOVRLipSyncPlaybackActorComponent()
 {
@@ -99,120 +150,256 @@ void UOVRLipSyncSpeechActorComponent::BeginPlay()
 	Super::BeginPlay();
 
 	bStereo = NumChannels > 1;
-	ChunkSampleSize = (SampleRate/2) / 100; // Scaled down by 100Hz
+	ChunkSampleSize = SampleRate / 100; // 10 ms frames
 	ChunkSize = NumChannels * ChunkSampleSize;
 
-	LipSyncContext = MakeShared<UOVRLipSyncContextWrapper>(UOVRLipSyncContextWrapper::ContextProviderFromProviderKind(ProviderKind), SampleRate,
-		BufferSize, FString(), EnableHardwareAcceleration);
-
-	float InLaughterScore = 0.0f;
-	TArray<float> InVisemes;
-	TArray<int16_t> samples;
-	samples.SetNumZeroed(ChunkSize);
-	LipSyncContext->ProcessFrame(samples.GetData(), ChunkSampleSize, InVisemes, InLaughterScore, FrameDelayInMs, bStereo);
-	FrameOffset = (int32_t)(FrameDelayInMs * (SampleRate / 2) / 1000 * NumChannels);
+	// Contexts are borrowed from the pool while an utterance is analysed, the delay is measured once for all of them.
+	ContextKey.Provider = ProviderKind;
+	ContextKey.SampleRate = SampleRate;
+	ContextKey.BufferSize = BufferSize;
+	ContextKey.bAccelerate = EnableHardwareAcceleration;
+	FrameDelayInMs = FOVRLipSyncContextPool::Get().GetFrameDelay(ContextKey);
+	FrameOffset = (int32_t)(FrameDelayInMs * SampleRate / 1000 * NumChannels);
 
-	bIsSpeaking = false;
+	SpeechWave = NewObject<UOVRLipSyncSpeechSoundWave>(this);
+	SpeechWave->SetSampleRate(SampleRate);
+	SpeechWave->NumChannels = NumChannels;
+	SpeechWave->Volume = (double)Volume / 100.0;
+	SpeechSequence = NewObject<UOVRLipSyncFrameSequence>(this);
+	// A frame per chunk of audio, exactly, so the frames stay on the samples however many utterances are queued.
+	SpeechSequence->FrameRate = (float)SampleRate / ChunkSampleSize;
+	QueuedFrames = 0;
+	SequenceStartFrame = 0;
 }
 
 void UOVRLipSyncSpeechActorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	LipSyncContext = nullptr;
-	lipSyncData.Empty();
-	VoiceAudioData.Empty();
+	// Skip whatever has not started cooking without waiting for it. Anything still cooked goes to the old queue, and
+	// play that begins again gets a new one.
+	CookedSpeech->bCancelled = true;
+	CookedSpeech = MakeShared<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe>();
+	if (AudioComponent && AudioComponent->GetSound() == SpeechWave)
+	{
+		AudioComponent->Stop();
+	}
+	SpeechWave = nullptr;
+	SpeechSequence = nullptr;
 	Super::EndPlay(EndPlayReason);
 }
 
+bool UOVRLipSyncSpeechActorComponent::IsReadyForFinishDestroy()
+{
+	return Super::IsReadyForFinishDestroy() && !CookPipe.HasWork();
+}
+
 void UOVRLipSyncSpeechActorComponent::InitializeAudio(UAudioComponent *InAudioComponent)
 {
 	if (!InAudioComponent)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:InitializeAudio: AudioComponent cannot be NULL"));
+		return;
+	}
+	if (!SpeechWave)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:InitializeAudio: Called before BeginPlay"));
+		return;
 	}
-	TArray<uint8> EmptyByteAudio;
-	EmptyByteAudio.Init(0, 1024);
-	InAudioComponent->SetSound(ByteArrayToSoundWave(EmptyByteAudio));
-	InAudioComponent->OnAudioFinished.AddDynamic(this, &UOVRLipSyncSpeechActorComponent::OnAudioPlaybackFinished);
-	InAudioComponent->OnAudioPlaybackPercent.AddDynamic(this, &UOVRLipSyncSpeechActorComponent::OnAudioPercentPlayedUpdated);
-	Start(InAudioComponent, NULL);
+	// The sound is never replaced, and plays once speech is queued on it.
+	InAudioComponent->SetSound(SpeechWave);
+	Attach(InAudioComponent, SpeechSequence);
 }
 
-void UOVRLipSyncSpeechActorComponent::OnAudioPercentPlayedUpdated(const USoundWave* PlayingSoundWave, const float PlaybackPercent) {
-	if (FMath::IsNearlyEqual(1.0f, PlaybackPercent))
+// Called every frame
+void UOVRLipSyncSpeechActorComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+									   FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	PumpSpeech();
+}
+
+void UOVRLipSyncSpeechActorComponent::FeedAudio(const TArray<uint8>& VoiceData)
+{
+	if (!SpeechWave)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:FeedAudio: Called before BeginPlay"));
+		return;
+	}
+	if (bStreaming)
+	{
+		StreamAudio(VoiceData);
+		return;
+	}
+
+	const FCookSettings Settings =
+		MakeCookSettings(ChunkSampleSize, ChunkSize, FrameOffset, bStereo, Quantization, ContextKey, LOD);
+	TSharedRef<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe> Cooked = CookedSpeech;
+	CookPipe.Launch(TEXT("OVRLipSyncCookAudioData"), [Cooked, Settings, PCMData = VoiceData]() mutable
 	{
-		if (lipSyncData.IsEmpty())
+		if (Cooked->bCancelled)
 		{
-			bIsSpeaking = false;
-			OnAudioPlaybackFinished();
+			return;
 		}
-		else
+		// The whole utterance is one window, packed once at the end.
+		FOVRLipSyncCookedSpeech Speech;
+		FOVRLipSyncContextPool::FContextPtr Context = AcquireCookContext(Settings);
+		AnalyseAudioData(Context.Get(), PCMData, Settings, MAX_int32, Cooked->bCancelled,
+			[&Speech, &Settings](TArray<float> &Scores, int32 CoveredSamples, bool bLast)
 		{
-			TryResumePlayback();
+			Speech.Frames.Pack(Scores.GetData(), Scores.Num() / FOVRLipSyncFrameData::NumScores, Settings.Quantization);
+		});
+		ReleaseCookContext(Settings, MoveTemp(Context));
+		Speech.PCMData = MoveTemp(PCMData);
+		Cooked->Speech.Enqueue(MoveTemp(Speech));
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
+}
+
+void UOVRLipSyncSpeechActorComponent::StreamAudio(const TArray<uint8>& VoiceData)
+{
+	const FCookSettings Settings =
+		MakeCookSettings(ChunkSampleSize, ChunkSize, FrameOffset, bStereo, Quantization, ContextKey, LOD);
+	const int32 WindowFrames = FMath::Max(FMath::CeilToInt32(StreamingLookahead * SampleRate / ChunkSampleSize), 1);
+	TSharedRef<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe> Cooked = CookedSpeech;
+	CookPipe.Launch(TEXT("OVRLipSyncStreamAudioData"), [Cooked, Settings, WindowFrames, PCMData = VoiceData]()
+	{
+		if (Cooked->bCancelled)
+		{
+			return;
 		}
-	}
+		// Each window is handed over with the audio it covers, so audio never plays ahead of its visemes.
+		int32 Released = 0;
+		FOVRLipSyncContextPool::FContextPtr Context = AcquireCookContext(Settings);
+		AnalyseAudioData(Context.Get(), PCMData, Settings, WindowFrames, Cooked->bCancelled,
+			[&Cooked, &PCMData, &Released, &Settings](TArray<float> &Scores, int32 CoveredSamples, bool bLast)
+		{
+			FOVRLipSyncCookedSpeech Window;
+			Window.Frames.Pack(Scores.GetData(), Scores.Num() / FOVRLipSyncFrameData::NumScores, Settings.Quantization);
+			Window.PCMData.Append(PCMData.GetData() + Released * sizeof(int16), (CoveredSamples - Released) * sizeof(int16));
+			Window.bLast = bLast;
+			Released = CoveredSamples;
+			Cooked->Speech.Enqueue(MoveTemp(Window));
+		});
+		ReleaseCookContext(Settings, MoveTemp(Context));
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
 }
 
-void UOVRLipSyncSpeechActorComponent::OnAudioPlaybackFinished()
+void UOVRLipSyncSpeechActorComponent::FeedAudioWithVisemes(const TArray<uint8>& VoiceData, const TArray<int32>& VisemeIds,
+														   const TArray<float>& VisemeTimes)
 {
-	if (lipSyncData.IsEmpty())
+	if (!SpeechWave)
 	{
-		Sequence = nullptr;
-		InitNeutralPose();
+		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:FeedAudioWithVisemes: Called before BeginPlay"));
+		return;
 	}
+	const float Duration = (float)VoiceData.Num() / (sizeof(int16) * NumChannels * SampleRate);
+	// Built at the rate of the sequence they are appended to, so they keep to the audio at any sample rate.
+	const float FrameRate = SpeechSequence->FrameRate;
+	const EOVRLipSyncLOD CookLOD = GetCookLOD(LOD);
+	const float AttackTime = VisemeAttackTime;
+	const float ReleaseTime = VisemeReleaseTime;
+	const EOVRLipSyncScoreQuantization FrameQuantization = Quantization;
+	TArray<FOVRLipSyncVisemeBlend> Mapping = VisemeMapping;
+	TSharedRef<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe> Cooked = CookedSpeech;
+	// Queued on the cooking pipe anyway, so it plays in order with utterances fed to FeedAudio.
+	CookPipe.Launch(TEXT("OVRLipSyncBuildVisemeFrames"),
+		[Cooked, Duration, FrameRate, CookLOD, AttackTime, ReleaseTime, FrameQuantization, Mapping = MoveTemp(Mapping),
+		 PCMData = VoiceData, VisemeIds, VisemeTimes]() mutable
+	{
+		if (Cooked->bCancelled)
+		{
+			return;
+		}
+		FOVRLipSyncCookedSpeech Speech;
+		OVRLipSyncVisemeMapping::BuildFrames(VisemeIds, VisemeTimes, Duration, FrameRate, AttackTime, ReleaseTime,
+											 FrameQuantization, Mapping, CookLOD, Speech.Frames);
+		Speech.PCMData = MoveTemp(PCMData);
+		Cooked->Speech.Enqueue(MoveTemp(Speech));
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
 }
 
-// Called every frame
-void UOVRLipSyncSpeechActorComponent::TickComponent(float DeltaTime, ELevelTick TickType,
-									   FActorComponentTickFunction *ThisTickFunction)
+void UOVRLipSyncSpeechActorComponent::PumpSpeech()
 {
-	if (!VoiceAudioData.IsEmpty())
+	// Speech cooked before the audio component is initialized waits for it.
+	if (!AudioComponent || AudioComponent->GetSound() != SpeechWave)
+	{
+		return;
+	}
+
+	FOVRLipSyncCookedSpeech Speech;
+	bool bQueued = false;
+	while (CookedSpeech->Speech.Dequeue(Speech))
 	{
-		if (VoiceLock.TryLock())
+		// Both are taken without copying the cooked buffers, the frames a plane at a time.
+		SpeechSequence->AppendFrames(Speech.Frames);
+		QueueSpeechAudio(MoveTemp(Speech.PCMData));
+		if (Speech.bLast)
 		{
-			while (!VoiceAudioData.IsEmpty())
-			{
-				TArray<uint8> sound;
-				if (VoiceAudioData.Dequeue(sound))
-				{
-					CookAudioData(sound);
-				}
-			}
-			VoiceLock.Unlock();
-		} 
+			AlignSpeech();
+		}
+		bQueued = true;
+	}
+	if (bQueued)
+	{
+		if (!AudioComponent->IsPlaying())
+		{
+			AudioComponent->Play();
+		}
+		return;
 	}
 
-	if (!lipSyncData.IsEmpty() && !bIsSpeaking)
+	// Once all of it has played the frames are dropped, so the sequence only ever holds the speech queued since the
+	// component last fell silent, and the sound stops until there is more.
+	if (SpeechSequence->Num() > 0 && SpeechWave->GetPlayedFrames(AudioComponent->PitchMultiplier) >= QueuedFrames)
 	{
-		TryResumePlayback();
+		SpeechSequence->SetFrames(FOVRLipSyncFrameData());
+		SequenceStartFrame = QueuedFrames;
+		AudioComponent->Stop();
+		InitNeutralPose();
 	}
 }
 
-void UOVRLipSyncSpeechActorComponent::FeedAudio(const TArray<uint8>& VoiceData)
+void UOVRLipSyncSpeechActorComponent::AlignSpeech()
 {
-	if (!LipSyncContext)
+	const int64 SequenceFrames = QueuedFrames - SequenceStartFrame;
+	const int32 MissingFrames = (int32)(FMath::DivideAndRoundUp(SequenceFrames, (int64)ChunkSampleSize) - SpeechSequence->Num());
+	if (MissingFrames > 0)
 	{
-		UE_LOG(LogOvrLipSync, Error, TEXT("UOVRLipSyncSpeechActorComponent:FeedAudio: LipSyncContext is NULL"));
-		return;
+		// The rest of the audio is played in the neutral pose.
+		TArray<float> Neutral;
+		Neutral.SetNumZeroed(MissingFrames * FOVRLipSyncFrameData::NumScores);
+		for (int32 Frame = 0; Frame < MissingFrames; ++Frame)
+		{
+			Neutral[Frame * FOVRLipSyncFrameData::NumScores] = 1.0f;
+		}
+		SpeechSequence->AppendFrames(Neutral.GetData(), MissingFrames);
 	}
-	VoiceAudioData.Enqueue(VoiceData);
+	// The last frame covers a whole chunk, whatever of it the audio does not is played as silence.
+	const int32 MissingAudio = (int32)((int64)SpeechSequence->Num() * ChunkSampleSize - SequenceFrames);
+	if (MissingAudio > 0)
+	{
+		TArray<uint8> Silence;
+		Silence.SetNumZeroed(MissingAudio * NumChannels * sizeof(int16));
+		QueueSpeechAudio(MoveTemp(Silence));
+	}
+}
+
+void UOVRLipSyncSpeechActorComponent::QueueSpeechAudio(TArray<uint8> &&PCMData)
+{
+	QueuedFrames += PCMData.Num() / (sizeof(int16) * NumChannels);
+	SpeechWave->QueuePCMData(MoveTemp(PCMData));
 }
 
-void UOVRLipSyncSpeechActorComponent::TryResumePlayback() {
-	if (!lipSyncData.IsEmpty())
+double UOVRLipSyncSpeechActorComponent::GetPlaybackTime() const
+{
+	if (!SpeechWave || Sequence != SpeechSequence)
 	{
-		if (PlaybackLock.TryLock())
-		{
-			TPair<UOVRLipSyncFrameSequence *, TArray<int16>> newLipSyncSequence;
-			if (lipSyncData.Dequeue(newLipSyncSequence))
-			{
-				TArray<uint8> AudioData(reinterpret_cast<const uint8 *>(newLipSyncSequence.Value.GetData()),
-										newLipSyncSequence.Value.Num() * 2);
-				SetPlaybackSequence(newLipSyncSequence.Key);				
-				AudioComponent->SetSound(ByteArrayToSoundWave(AudioData));
-				AudioComponent->Play();
-				bIsSpeaking = true;
-			}
-			PlaybackLock.Unlock();
-		}
+		return Super::GetPlaybackTime();
 	}
-}
\ No newline at end of file
+	if (SpeechSequence->Num() == 0)
+	{
+		return -1.0;
+	}
+	// The sound plays silence when it runs out of speech, so the position is counted in samples rather than time.
+	const double Pitch = AudioComponent ? AudioComponent->PitchMultiplier : 1.0;
+	return (double)(SpeechWave->GetPlayedFrames(Pitch) - SequenceStartFrame) / SampleRate;
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncSpeechSoundWave.h"
+
+UOVRLipSyncSpeechSoundWave::UOVRLipSyncSpeechSoundWave(const FObjectInitializer &ObjectInitializer)
+	: USoundWaveProcedural(ObjectInitializer)
+{
+	// Playback percent is reported against this, the length is unknown as utterances keep being queued.
+	Duration = INDEFINITELY_LOOPING_DURATION;
+	SoundGroup = ESoundGroup::SOUNDGROUP_Voice;
+	bLooping = false;
+	bCanProcessAsync = true;
+	bProcedural = true;
+}
+
+void UOVRLipSyncSpeechSoundWave::QueuePCMData(TArray<uint8> &&PCMData)
+{
+	if (PCMData.Num() > 0)
+	{
+		PendingPCMData.Enqueue(MoveTemp(PCMData));
+	}
+}
+
+int32 UOVRLipSyncSpeechSoundWave::OnGeneratePCMAudio(TArray<uint8> &OutAudio, int32 NumSamples)
+{
+	// The queued buffers are served in place, so the only copy of an utterance is into the renderer.
+	const int32 BytesWanted = NumSamples * sizeof(int16);
+	int32 BytesWritten = 0;
+	while (BytesWritten < BytesWanted)
+	{
+		if (PlayingOffset == PlayingPCMData.Num())
+		{
+			if (!PendingPCMData.Dequeue(PlayingPCMData))
+			{
+				break;
+			}
+			PlayingOffset = 0;
+		}
+		const int32 Bytes = FMath::Min(BytesWanted - BytesWritten, PlayingPCMData.Num() - PlayingOffset);
+		OutAudio.Append(PlayingPCMData.GetData() + PlayingOffset, Bytes);
+		PlayingOffset += Bytes;
+		BytesWritten += Bytes;
+	}
+
+	const int32 Frames = BytesWritten / (sizeof(int16) * FMath::Max(NumChannels, 1));
+	{
+		UE::TScopeLock Lock(GeneratedLock);
+		GeneratedFrames += Frames;
+		RecentBuffers[RecentIndex] = { Frames, FPlatformTime::Seconds() };
+		RecentIndex = (RecentIndex + 1) % RecentBuffers.Num();
+	}
+	// Returning fewer samples than asked for plays silence for the rest.
+	return BytesWritten / sizeof(int16);
+}
+
+int64 UOVRLipSyncSpeechSoundWave::GetPlayedFrames(double Pitch) const
+{
+	UE::TScopeLock Lock(GeneratedLock);
+	// The renderer asks for a buffer as it starts playing one, so the buffer playing is the one handed over
+	// BuffersAhead callbacks ago, and it plays out over the time since the latest callback.
+	int64 NotPlayed = 0;
+	for (const FGeneratedBuffer &Buffer : RecentBuffers)
+	{
+		NotPlayed += Buffer.Frames;
+	}
+	const FGeneratedBuffer &Playing = RecentBuffers[RecentIndex];
+	const FGeneratedBuffer &Latest = RecentBuffers[(RecentIndex + BuffersAhead) % RecentBuffers.Num()];
+	const double Elapsed = FPlatformTime::Seconds() - Latest.At;
+	const int64 PlayedOfPlaying = FMath::Clamp((int64)(Elapsed * SampleRate * Pitch), (int64)0, (int64)Playing.Frames);
+	return GeneratedFrames - NotPlayed + PlayedOfPlaying;
+}
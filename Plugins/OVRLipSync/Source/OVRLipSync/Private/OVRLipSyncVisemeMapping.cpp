@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncVisemeMapping.h"
+#include "OVRLipSync.h"
+#include "OVRLipSyncLOD.h"
+#include "OVRLipSyncModule.h"
+
+static_assert(OVRLipSyncVisemeMapping::NumVisemes == ovrLipSyncViseme_Count, "Frames must hold a score per viseme");
+
+namespace
+{
+struct FVisemeWeight
+{
+	ovrLipSyncViseme Viseme;
+	float Weight;
+};
+
+struct FSapiViseme
+{
+	FVisemeWeight Weights[2];
+};
+
+// The OVRLipSync visemes making up each SAPI viseme. Unused second weights are 0.
+constexpr FSapiViseme SapiVisemes[OVRLipSyncVisemeMapping::NumSapiVisemes] = {
+	{{{ovrLipSyncViseme_sil, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}}, // 0: silence
+	{{{ovrLipSyncViseme_aa, 0.6f}, {ovrLipSyncViseme_E, 0.4f}}},	// 1: ae, ax, ah
+	{{{ovrLipSyncViseme_aa, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 2: aa
+	{{{ovrLipSyncViseme_oh, 0.8f}, {ovrLipSyncViseme_aa, 0.2f}}},	// 3: ao
+	{{{ovrLipSyncViseme_E, 0.7f}, {ovrLipSyncViseme_ou, 0.3f}}},	// 4: ey, eh, uh
+	{{{ovrLipSyncViseme_RR, 0.7f}, {ovrLipSyncViseme_E, 0.3f}}},	// 5: er
+	{{{ovrLipSyncViseme_ih, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 6: y, iy, ih, ix
+	{{{ovrLipSyncViseme_ou, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 7: w, uw
+	{{{ovrLipSyncViseme_oh, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 8: ow
+	{{{ovrLipSyncViseme_aa, 0.6f}, {ovrLipSyncViseme_ou, 0.4f}}},	// 9: aw
+	{{{ovrLipSyncViseme_oh, 0.6f}, {ovrLipSyncViseme_ih, 0.4f}}},	// 10: oy
+	{{{ovrLipSyncViseme_aa, 0.6f}, {ovrLipSyncViseme_ih, 0.4f}}},	// 11: ay
+	{{{ovrLipSyncViseme_sil, 0.6f}, {ovrLipSyncViseme_aa, 0.4f}}},	// 12: h
+	{{{ovrLipSyncViseme_RR, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 13: r
+	{{{ovrLipSyncViseme_nn, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 14: l
+	{{{ovrLipSyncViseme_SS, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 15: s, z
+	{{{ovrLipSyncViseme_CH, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 16: sh, ch, jh, zh
+	{{{ovrLipSyncViseme_TH, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 17: th, dh
+	{{{ovrLipSyncViseme_FF, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 18: f, v
+	{{{ovrLipSyncViseme_DD, 0.7f}, {ovrLipSyncViseme_nn, 0.3f}}},	// 19: d, t, n
+	{{{ovrLipSyncViseme_kk, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 20: k, g, ng
+	{{{ovrLipSyncViseme_PP, 1.0f}, {ovrLipSyncViseme_sil, 0.0f}}},	// 21: p, b, m
+};
+
+// Sets the scores a viseme ID moves towards.
+void GetTarget(int32 Id, TConstArrayView<FOVRLipSyncVisemeBlend> Mapping, float *OutTarget)
+{
+	FMemory::Memzero(OutTarget, sizeof(float) * OVRLipSyncVisemeMapping::NumVisemes);
+	if (Mapping.Num() > 0)
+	{
+		if (Id < 0 || Id >= Mapping.Num())
+		{
+			OutTarget[ovrLipSyncViseme_sil] = 1.0f;
+			return;
+		}
+		const TArray<float> &Scores = Mapping[Id].Scores;
+		FMemory::Memcpy(OutTarget, Scores.GetData(),
+						sizeof(float) * FMath::Min(Scores.Num(), (int32)OVRLipSyncVisemeMapping::NumVisemes));
+		return;
+	}
+	const FSapiViseme &Viseme = SapiVisemes[(Id >= 0 && Id < OVRLipSyncVisemeMapping::NumSapiVisemes) ? Id : 0];
+	for (const FVisemeWeight &Weight : Viseme.Weights)
+	{
+		OutTarget[Weight.Viseme] += Weight.Weight;
+	}
+}
+
+// The fraction of the way to the target covered in one frame, for a time constant.
+float GetSmoothing(float TimeConstant, float FrameRate)
+{
+	if (TimeConstant <= 0.0f)
+	{
+		return 1.0f;
+	}
+	return 1.0f - FMath::Exp(-1.0f / (TimeConstant * FrameRate));
+}
+} // namespace
+
+void OVRLipSyncVisemeMapping::BuildFrames(const TArray<int32> &VisemeIds, const TArray<float> &VisemeTimes,
+										  float Duration, float FrameRate, float AttackTime, float ReleaseTime,
+										  EOVRLipSyncScoreQuantization Quantization,
+										  TConstArrayView<FOVRLipSyncVisemeBlend> Mapping, EOVRLipSyncLOD LOD,
+										  FOVRLipSyncFrameData &OutFrames)
+{
+	if (VisemeIds.Num() != VisemeTimes.Num())
+	{
+		UE_LOG(LogOvrLipSync, Warning,
+			   TEXT("OVRLipSyncVisemeMapping::BuildFrames: %d viseme IDs but %d times, ignoring the extra ones"),
+			   VisemeIds.Num(), VisemeTimes.Num());
+	}
+	const int32 NumCues = FMath::Min(VisemeIds.Num(), VisemeTimes.Num());
+	const int32 NumFrames = FMath::CeilToInt32(FMath::Max(Duration, 0.0f) * FrameRate);
+	TArray<float> FrameScores;
+	FrameScores.SetNumZeroed(NumFrames * FOVRLipSyncFrameData::NumScores);
+
+	const float Attack = GetSmoothing(AttackTime, FrameRate);
+	const float Release = GetSmoothing(ReleaseTime, FrameRate);
+
+	float Scores[NumVisemes] = {1.0f};
+	float Target[NumVisemes] = {1.0f};
+	int32 NextCue = 0;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const float Time = (float)Frame / FrameRate;
+		if (NextCue < NumCues && VisemeTimes[NextCue] <= Time)
+		{
+			// Visemes shorter than a frame are skipped, the last one starting by this frame wins.
+			while (NextCue + 1 < NumCues && VisemeTimes[NextCue + 1] <= Time)
+			{
+				NextCue++;
+			}
+			GetTarget(VisemeIds[NextCue++], Mapping, Target);
+		}
+
+		// Laughter is never reported by synthesizers and stays 0.
+		float *NewFrame = FrameScores.GetData() + Frame * FOVRLipSyncFrameData::NumScores;
+		for (int32 Viseme = 0; Viseme < NumVisemes; ++Viseme)
+		{
+			const float Delta = Target[Viseme] - Scores[Viseme];
+			Scores[Viseme] += Delta * (Delta > 0.0f ? Attack : Release);
+			NewFrame[Viseme] = Scores[Viseme];
+		}
+		// Folded like analysed frames, after smoothing so the held scores stay whole.
+		OVRLipSyncLOD::ReduceVisemes(LOD, NewFrame);
+	}
+	OutFrames.Pack(FrameScores.GetData(), NumFrames, Quantization);
+}
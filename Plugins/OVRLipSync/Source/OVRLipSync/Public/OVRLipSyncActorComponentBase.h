@@ -25,6 +25,8 @@ limitations under the License.
 
 #include "Components/ActorComponent.h"
 #include "CoreMinimal.h"
+#include "OVRLipSyncConstants.h"
+#include "OVRLipSyncMorphTargetBinding.h"
 #include "OVRLipSyncActorComponentBase.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOVRLipSyncVisemesDataReadyDelegate);
@@ -52,16 +54,79 @@ public:
 					  AutoCreateRefTerm = "MorphTargetNames"))
 	void AssignVisemesToMorphTargets(USkeletalMeshComponent *Mesh, const TArray<FString> &MorphTargetNames);
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync",
+			  Meta = (ClampMin = "0.0", ClampMax = "0.1",
+					  Tooltip = "How much a viseme score has to change for AssignVisemesToMorphTargets to set its "
+								"morph target again"))
+	float MorphTargetEpsilon = 0.002f;
+
 	UPROPERTY(BlueprintAssignable, Category = "LipSync",
 			  Meta = (Tooltip = "Event triggered when new prediction is ready"))
 	FOVRLipSyncVisemesDataReadyDelegate OnVisemesReady;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync|LOD",
+			  Meta = (Tooltip = "Pick the level of detail from how large the owner is on screen. Otherwise it is only "
+								"changed by SetLOD, such as from a significance manager"))
+	bool bAutomaticLOD = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync|LOD",
+			  Meta = (EditCondition = "bAutomaticLOD", ClampMin = "0.0", ClampMax = "2.0",
+					  Tooltip = "Screen size of the owner's bounds from which every viseme is analysed"))
+	float FullLODScreenSize = 0.25f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync|LOD",
+			  Meta = (EditCondition = "bAutomaticLOD", ClampMin = "0.0", ClampMax = "2.0",
+					  Tooltip = "Screen size of the owner's bounds from which fewer visemes are analysed, below it "
+								"only the jaw follows the audio"))
+	float ReducedLODScreenSize = 0.08f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync|LOD",
+			  Meta = (EditCondition = "bAutomaticLOD", ClampMin = "0.0", ClampMax = "0.9",
+					  Tooltip = "Fraction a screen size has to pass a threshold by to change the level of detail, so "
+								"characters near one do not flip between levels"))
+	float LODHysteresis = 0.15f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync|LOD",
+			  Meta = (EditCondition = "bAutomaticLOD", ClampMin = "0.0",
+					  Tooltip = "Seconds the owner is not rendered for before lip sync is turned off. "
+								"Without local players, such as on a server, it is never turned off"))
+	float OffScreenTime = 0.5f;
+
+	UFUNCTION(BlueprintCallable, Category = "LipSync|LOD", Meta = (Tooltip = "Sets the level of detail"))
+	void SetLOD(EOVRLipSyncLOD NewLOD);
+
+	UFUNCTION(BlueprintPure, Category = "LipSync|LOD", Meta = (Tooltip = "Returns the level of detail"))
+	EOVRLipSyncLOD GetLOD() const { return LOD; }
+
 protected:
+	// Picks the level of detail, when it is automatic
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+							   FActorComponentTickFunction *ThisTickFunction) override;
+	// Called when the level of detail changes, after LOD is set
+	virtual void OnLODChanged(EOVRLipSyncLOD OldLOD);
+	// Folds Visemes into the ones the level of detail uses, before they are broadcast
+	void ApplyLODToVisemes();
+
 	// Set component internal state to a neutral pose
 	void InitNeutralPose();
 
+	EOVRLipSyncLOD LOD = EOVRLipSyncLOD::Full;
+
 	float LaughterScore = 0;
 	TArray<float> Visemes;
 
 	static const TArray<FString> VisemeNames;
+
+private:
+	// Gets the largest fraction of the screen width the owner's bounds cover in the views of local players, returning
+	// false if there are none
+	bool GetScreenSize(float &OutScreenSize) const;
+	// Picks the level of detail for a screen size, keeping to the current one within LODHysteresis of a threshold
+	EOVRLipSyncLOD PickLOD(float ScreenSize) const;
+
+	float SinceLODUpdate = 0.0f;
+	// The mesh and morph targets AssignVisemesToMorphTargets last set, and the weights it set them to
+	FOVRLipSyncMorphTargetBinding MorphTargetBinding;
+	// Set when the level of detail changes, so the next morph target update sets the visemes it no longer uses to 0
+	bool bUpdateAllMorphTargets = false;
 };
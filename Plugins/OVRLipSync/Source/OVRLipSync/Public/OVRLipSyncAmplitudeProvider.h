@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSyncFrame.h"
+
+/**
+ * Lip sync without a model: the loudness of each frame of audio opens the mouth, and where its energy sits in the
+ * spectrum picks between sil, aa, PP, FF and ou. Costs one vectorized pass over the samples per frame, keeps no state
+ * outside the instance and can run on any thread, so it stands in for the library on hosts too slow for it and on
+ * platforms it is missing from.
+ */
+class OVRLIPSYNC_API FOVRLipSyncAmplitudeProvider
+{
+public:
+	/** The time constant in seconds of a viseme rising. */
+	float AttackTime = 0.03f;
+	/** The time constant in seconds of a viseme falling. */
+	float ReleaseTime = 0.08f;
+
+	/**
+	 * Moves the viseme scores towards a frame of audio.
+	 * @param Samples 16 bit samples, interleaved if stereo.
+	 * @param NumFrames The number of samples of each channel.
+	 * @param bStereo Whether the samples are interleaved stereo, which is analysed mixed down to mono.
+	 * @param SampleRate The sample rate of the audio.
+	 * @param OutVisemes FOVRLipSyncFrameData::NumVisemes scores. sil, aa, PP, FF and ou are set, the rest are 0.
+	 */
+	void ProcessFrame(const int16 *Samples, int32 NumFrames, bool bStereo, int32 SampleRate, float *OutVisemes);
+
+	/** Returns to the neutral pose, as if no audio had been processed. */
+	void Reset();
+
+private:
+	void GetVisemes(float *OutVisemes) const;
+
+	/** The frame mixed down to mono, after the last sample of the previous frame. */
+	TArray<float> Mono;
+	/** The smoothed scores of aa, PP, FF and ou. sil is whatever they leave. */
+	float Aa = 0.0f;
+	float PP = 0.0f;
+	float FF = 0.0f;
+	float Ou = 0.0f;
+};
@@ -9,5 +9,18 @@ enum class OVRLipSyncProviderKind : uint8
 	Original = 0 UMETA(DisplayName = "Original"),
 	Enhanced = 1 UMETA(DisplayName = "Enhanced"),
 	EnhancedWithLaughter = 2 UMETA(DisplayName = "Enhanced with Laughter"),
+	Amplitude = 3 UMETA(DisplayName = "Amplitude",
+						ToolTip = "No model, the loudness and brightness of the audio drive sil, aa, PP, FF and ou. "
+								  "For slow hosts, and used wherever the library is missing"),
 };
 
+
+/** How much work goes into the lip sync of a character, from the most to the least. */
+UENUM(BlueprintType)
+enum class EOVRLipSyncLOD : uint8
+{
+	Full = 0 UMETA(DisplayName = "Full", ToolTip = "Every viseme, analysed 100 times a second"),
+	Reduced = 1 UMETA(DisplayName = "Reduced", ToolTip = "Fewer visemes, analysed less often"),
+	Jaw = 2 UMETA(DisplayName = "Jaw", ToolTip = "Only the jaw opening, following the loudness of the audio"),
+	Off = 3 UMETA(DisplayName = "Off", ToolTip = "Nothing analysed, the face stays in the neutral pose"),
+};
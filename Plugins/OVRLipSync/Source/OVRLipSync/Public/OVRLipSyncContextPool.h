@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSyncContextWrapper.h"
+#include "Tasks/Task.h"
+
+/** What a context is created with. Pooled contexts are only handed to users asking for the same. */
+struct OVRLIPSYNC_API FOVRLipSyncContextKey
+{
+	OVRLipSyncProviderKind Provider = OVRLipSyncProviderKind::Enhanced;
+	int32 SampleRate = 48000;
+	int32 BufferSize = 4096;
+	FString ModelPath; ///< Empty for the model built into the library.
+	bool bAccelerate = true;
+
+	bool operator==(const FOVRLipSyncContextKey &Other) const
+	{
+		return Provider == Other.Provider && SampleRate == Other.SampleRate && BufferSize == Other.BufferSize &&
+			   ModelPath == Other.ModelPath && bAccelerate == Other.bAccelerate;
+	}
+
+	friend uint32 GetTypeHash(const FOVRLipSyncContextKey &Key)
+	{
+		uint32 Hash = HashCombine(GetTypeHash((int32)Key.Provider), GetTypeHash(Key.SampleRate));
+		Hash = HashCombine(Hash, GetTypeHash(Key.BufferSize));
+		Hash = HashCombine(Hash, GetTypeHash(Key.ModelPath));
+		return HashCombine(Hash, GetTypeHash(Key.bAccelerate));
+	}
+};
+
+/**
+ * Owns the ovrLipSync contexts of the module, and the amplitude providers standing in for them, shared by every
+ * component and the editor. The library is initialized once per sample rate and buffer size, and returned contexts
+ * are reset and kept for the next user rather than destroyed, so there are only ever as many contexts as users
+ * analysing audio at the same time. Thread safe.
+ */
+class OVRLIPSYNC_API FOVRLipSyncContextPool
+{
+public:
+	using FContextPtr = TSharedPtr<UOVRLipSyncContextWrapper, ESPMode::ThreadSafe>;
+
+	static FOVRLipSyncContextPool &Get();
+
+	/**
+	 * Initializes the library for a sample rate and buffer size, unless it already is.
+	 * @returns Whether the library is initialized.
+	 */
+	bool InitializeLibrary(int32 SampleRate, int32 BufferSize);
+
+	/**
+	 * Borrows a context in its initial state, creating one if none is idle.
+	 * @param Key What the context is created with.
+	 * @returns The context, to be given back to Release once the audio it analyses ends.
+	 */
+	FContextPtr Acquire(const FOVRLipSyncContextKey &Key);
+
+	/**
+	 * Borrows an idle context in its initial state, never creating one, for callers which must not load a model.
+	 * @param Key What the context is created with.
+	 * @returns The context, to be given back to Release, or null if none is idle.
+	 */
+	FContextPtr TryAcquire(const FOVRLipSyncContextKey &Key);
+
+	/**
+	 * Creates a context on a background task, unless one is idle or being created already, so a later TryAcquire
+	 * finds one.
+	 * @param Key What the context is created with.
+	 */
+	void Prewarm(const FOVRLipSyncContextKey &Key);
+
+	/**
+	 * Gives back a context borrowed from Acquire. It is reset for the next user, or dropped if it could not be created.
+	 * @param Key The key it was acquired with.
+	 * @param Context The context, which the caller must not use afterwards.
+	 */
+	void Release(const FOVRLipSyncContextKey &Key, FContextPtr Context);
+
+	/**
+	 * Gets the delay in milliseconds of the visemes of a context behind its audio. Measured the first time it is asked
+	 * for a configuration, by priming a context with silence.
+	 */
+	int32 GetFrameDelay(const FOVRLipSyncContextKey &Key);
+
+	/**
+	 * Destroys every context, idle or borrowed, once its frames in flight are called back. Borrowed ones do nothing
+	 * from then on. Called when the module shuts down the library.
+	 */
+	void Shutdown();
+
+private:
+	// Creates a context and keeps track of it for Shutdown.
+	FContextPtr Create(const FOVRLipSyncContextKey &Key);
+
+	FCriticalSection Mutex;
+	TArray<TWeakPtr<UOVRLipSyncContextWrapper, ESPMode::ThreadSafe>> Contexts; ///< Every context created, idle or borrowed.
+	TSet<FOVRLipSyncContextKey> Prewarming; ///< The keys a context is being created for by Prewarm.
+	TArray<UE::Tasks::FTask> PrewarmTasks;
+	bool bShuttingDown = false;
+	TSet<TPair<int32, int32>> InitializedConfigurations; ///< The sample rates and buffer sizes the library is initialized for.
+	TMap<FOVRLipSyncContextKey, TArray<FContextPtr>> IdleContexts;
+	TMap<FOVRLipSyncContextKey, int32> FrameDelays;
+};
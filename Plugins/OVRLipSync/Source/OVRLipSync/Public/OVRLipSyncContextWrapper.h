@@ -23,28 +23,51 @@
 
 #pragma once
 #include "CoreMinimal.h"
+#include "OVRLipSyncAmplitudeProvider.h"
 #include "OVRLipSyncConstants.h"
 #include "OVRLipSync.h"
 
 class OVRLIPSYNC_API UOVRLipSyncContextWrapper
 {
 public:
-	UOVRLipSyncContextWrapper(ovrLipSyncContextProvider Provider, int SampleRate = 48000, int BufferSize = 4096,
+	// Falls back to the amplitude provider if the library or the context can't be created
+	UOVRLipSyncContextWrapper(OVRLipSyncProviderKind Provider, int SampleRate = 48000, int BufferSize = 4096,
 							  FString ModelPath = FString(), bool Accelerate = true);
 	~UOVRLipSyncContextWrapper();
 
+	// Whether the context was created
+	bool IsValid() const { return LipSyncContext != 0 || AmplitudeProvider.IsValid(); }
+	// The provider the visemes come from, which is Amplitude after a fall back
+	OVRLipSyncProviderKind GetProvider() const { return Provider; }
+	// Returns the context to its initial state, as if no audio had been processed, and drops the async callback once
+	// the frames in flight have been called back
+	void Reset();
+	// Destroys the library context once the frames in flight have been called back. Processing does nothing
+	// afterwards, and the wrapper is not valid. For shutting the library down under contexts still borrowed.
+	void Destroy();
+
 	void ProcessFrame(const int16_t *Data, int DataSize, TArray<float> &Visemes, float &LaughterScore,
 					  int32_t &FrameDelay, bool Stereo = false);
 
-	// Async processing
-	using AsyncCallbackType = TFunction<void(const TArray<float> &Visemes, float LaughterScore)>;
+	// Async processing. The callback runs on a thread of the library, or on the calling thread for the amplitude
+	// provider, and the frame is only valid during the call.
+	using AsyncCallbackType = TFunction<void(const ovrLipSyncFrame &Frame)>;
 	void SetAsyncCallback(const AsyncCallbackType &AsyncCallback);
-	void InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore);
+	void InvokeAsyncCallback(const ovrLipSyncFrame &Frame);
 	void ProcessFrameAsync(const int16_t *Data, int DataSize, bool Stereo = false);
 
 	static ovrLipSyncContextProvider ContextProviderFromProviderKind(OVRLipSyncProviderKind Kind);
 
 private:
+	// Blocks until every frame handed to the library asynchronously has been called back
+	void WaitForAsync() const;
+	static void ProcessFrameCallback(void *opaque, const ovrLipSyncFrame *pFrame, ovrLipSyncResult result);
+
 	AsyncCallbackType AsyncCallback;
+	std::atomic<int32> PendingAsync{ 0 }; ///< Frames handed to ovrLipSync_ProcessFrameAsync not yet called back.
+	FRWLock ContextLock; ///< Read locked while LipSyncContext is used, write locked while it is destroyed.
+	OVRLipSyncProviderKind Provider;
+	int SampleRate;
 	ovrLipSyncContext LipSyncContext = 0;
+	TUniquePtr<FOVRLipSyncAmplitudeProvider> AmplitudeProvider;
 };
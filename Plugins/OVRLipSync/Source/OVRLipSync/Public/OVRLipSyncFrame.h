@@ -26,6 +26,7 @@
 #include "CoreMinimal.h"
 #include "OVRLipSyncFrame.generated.h"
 
+/** A single frame of viseme scores. Only used to load sequences saved before frames were packed. */
 USTRUCT()
 struct OVRLIPSYNC_API FOVRLipSyncFrame
 {
@@ -43,14 +44,174 @@ struct OVRLIPSYNC_API FOVRLipSyncFrame
 	}
 };
 
+UENUM()
+enum class EOVRLipSyncScoreQuantization : uint8
+{
+	Bits8 = 0 UMETA(DisplayName = "8 bit"),
+	Bits16 = 1 UMETA(DisplayName = "16 bit"),
+};
+
+UENUM()
+enum class EOVRLipSyncInterpolation : uint8
+{
+	Nearest = 0 UMETA(DisplayName = "Nearest", ToolTip = "Hold each frame until the next one"),
+	Linear = 1 UMETA(DisplayName = "Linear"),
+	Cubic = 2 UMETA(DisplayName = "Cubic", ToolTip = "Catmull-Rom through the four nearest frames"),
+};
+
+/**
+ * The frames of a sequence, packed. Each score channel (the 15 visemes, then laughter) is one contiguous plane of
+ * quantized scores, and stretches of frames in the neutral pose are stored as runs rather than as scores.
+ */
+struct OVRLIPSYNC_API FOVRLipSyncFrameData
+{
+	static constexpr int32 NumVisemes = 15;
+	static constexpr int32 NumScores = NumVisemes + 1; ///< The visemes and the laughter score.
+
+	/**
+	 * Replaces the frames.
+	 * @param Scores NumScores floats per frame, the visemes followed by the laughter score.
+	 * @param InNumFrames The number of frames.
+	 * @param Quantization The precision scores are stored at.
+	 */
+	void Pack(const float *Scores, int32 InNumFrames, EOVRLipSyncScoreQuantization Quantization);
+
+	/**
+	 * Adds frames after the existing ones. Planes grow geometrically, so a sequence can be built a few frames at a time.
+	 * @param Scores NumScores floats per frame, the visemes followed by the laughter score.
+	 * @param NumNewFrames The number of frames.
+	 * @param Quantization The precision scores are stored at. Ignored unless there are no frames yet.
+	 */
+	void Append(const float *Scores, int32 NumNewFrames, EOVRLipSyncScoreQuantization Quantization);
+
+	/**
+	 * Adds packed frames after the existing ones. Stored scores are copied a plane at a time when both are packed at
+	 * the same precision, and unpacked and packed again otherwise.
+	 * @param Other The frames to add.
+	 */
+	void Append(const FOVRLipSyncFrameData &Other);
+
+	/**
+	 * Gets the scores of a frame without allocating.
+	 * @param Index The frame, must be less than Num().
+	 * @param OutScores Receives NumScores floats, the visemes followed by the laughter score.
+	 */
+	void DecodeFrame(int32 Index, float *OutScores) const;
+
+	/**
+	 * Gets the scores between frames without allocating.
+	 * @param Position The fractional frame, must be at least 0 and less than Num().
+	 * @param Interpolation How the neighbouring frames are blended.
+	 * @param OutScores Receives NumScores floats, the visemes followed by the laughter score.
+	 */
+	void SampleFrame(float Position, EOVRLipSyncInterpolation Interpolation, float *OutScores) const;
+
+	int32 Num() const { return NumFrames; }
+	EOVRLipSyncScoreQuantization GetQuantization() const
+	{
+		return BytesPerScore == 2 ? EOVRLipSyncScoreQuantization::Bits16 : EOVRLipSyncScoreQuantization::Bits8;
+	}
+	SIZE_T GetAllocatedSize() const { return Planes.GetAllocatedSize() + NeutralRuns.GetAllocatedSize(); }
+	void Reset();
+
+	void Serialize(FArchive &Ar);
+
+private:
+	struct FNeutralRun
+	{
+		int32 Start; ///< The first frame of the run.
+		int32 End; ///< The frame after the run.
+		int32 StoredBefore; ///< The number of stored frames before Start.
+	};
+
+	// Makes room for a number of stored frames in every plane.
+	void ReservePlanes(int32 NumToStore);
+	// Whether the runs are sorted, within the frames and account for every frame that is not stored.
+	bool AreRunsValid() const;
+
+	int32 NumFrames = 0;
+	int32 NumStored = 0; ///< The frames which are not in a neutral run, the used length of each plane.
+	int32 PlaneStride = 0; ///< The allocated length of each plane, NumStored unless frames were appended.
+	int32 BytesPerScore = 1;
+	TArray<uint8> Planes; ///< NumScores planes of PlaneStride scores each.
+	TArray<FNeutralRun> NeutralRuns; ///< Sorted by Start.
+};
+
 UCLASS(BlueprintType)
 class OVRLIPSYNC_API UOVRLipSyncFrameSequence : public UObject
 {
 	GENERATED_BODY()
 public:
+	/** Frames of sequences saved before they were packed. Emptied as they are loaded. */
 	UPROPERTY()
 	TArray<FOVRLipSyncFrame> FrameSequence;
-	unsigned Num() const { return FrameSequence.Num(); }
-	void Add(const TArray<float> &Visemes, float LaughterScore) { FrameSequence.Emplace(Visemes, LaughterScore); }
-	const FOVRLipSyncFrame &operator[](unsigned idx) const { return FrameSequence[idx]; }
+
+	/** The number of frames per second of audio. */
+	UPROPERTY(VisibleAnywhere, Category = "LipSync")
+	float FrameRate = 100.0f;
+
+	/** The precision the scores are stored at. */
+	UPROPERTY(VisibleAnywhere, Category = "LipSync")
+	EOVRLipSyncScoreQuantization Quantization = EOVRLipSyncScoreQuantization::Bits8;
+
+#if WITH_EDITORONLY_DATA
+	/** The hash of the imported audio the sequence was baked from, so it is only baked again once the audio changes. */
+	UPROPERTY(VisibleAnywhere, Category = "LipSync|Bake")
+	FString SourceAudioHash;
+
+	/** What the sequence was baked with: the provider, the model and the frame rate. */
+	UPROPERTY(VisibleAnywhere, Category = "LipSync|Bake")
+	FString BakeSettings;
+#endif
+
+	unsigned Num() const { return Frames.Num(); }
+
+	/**
+	 * Replaces the frames with packed ones.
+	 * @param Scores FOVRLipSyncFrameData::NumScores floats per frame, the visemes followed by the laughter score.
+	 * @param NumFrames The number of frames.
+	 */
+	void SetFrames(const float *Scores, int32 NumFrames);
+	/**
+	 * Adds frames after the existing ones, for sequences built while their audio plays.
+	 * @param Scores FOVRLipSyncFrameData::NumScores floats per frame, the visemes followed by the laughter score.
+	 * @param NumFrames The number of frames.
+	 */
+	void AppendFrames(const float *Scores, int32 NumFrames);
+	/**
+	 * Adds packed frames after the existing ones.
+	 * @param InFrames The frames to add, taking their precision if there are no frames yet.
+	 */
+	void AppendFrames(const FOVRLipSyncFrameData &InFrames);
+
+	void SetFrames(FOVRLipSyncFrameData &&InFrames)
+	{
+		Quantization = InFrames.GetQuantization();
+		Frames = MoveTemp(InFrames);
+	}
+
+	/**
+	 * Gets the scores of a frame. Reuses the allocation of OutVisemes.
+	 * @param Index The frame, must be less than Num().
+	 * @param OutVisemes Receives the viseme scores.
+	 * @param OutLaughterScore Receives the laughter score.
+	 */
+	void DecodeFrame(int32 Index, TArray<float> &OutVisemes, float &OutLaughterScore) const;
+
+	/**
+	 * Gets the scores at a time, blending the neighbouring frames. Reuses the allocation of OutVisemes.
+	 * @param Time The seconds from the start of the audio.
+	 * @param Interpolation How the neighbouring frames are blended.
+	 * @param OutVisemes Receives the viseme scores.
+	 * @param OutLaughterScore Receives the laughter score.
+	 * @returns false, leaving the outputs alone, if Time is outside the sequence.
+	 */
+	bool Sample(float Time, EOVRLipSyncInterpolation Interpolation, TArray<float> &OutVisemes,
+				float &OutLaughterScore) const;
+
+	virtual void Serialize(FArchive &Ar) override;
+	virtual void GetResourceSizeEx(FResourceSizeEx &CumulativeResourceSize) override;
+
+private:
+	FOVRLipSyncFrameData Frames;
 };
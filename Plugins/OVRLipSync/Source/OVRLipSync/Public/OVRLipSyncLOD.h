@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSyncConstants.h"
+#include "OVRLipSyncFrame.h"
+
+/**
+ * What each lip sync level of detail keeps of the visemes. Reduced folds the 15 visemes into the 9 that look most
+ * different, Jaw into how far open the jaw is, shown as a blend of sil and aa, and Off into the neutral pose.
+ */
+namespace OVRLipSyncLOD
+{
+	/** At Reduced, one 10 ms frame in this many is analysed and the scores are held in between. */
+	constexpr int32 ReducedAnalysisStride = 2;
+
+	/** Whether a viseme can have a score at a level of detail, the rest are always 0. */
+	OVRLIPSYNC_API bool IsVisemeUsed(EOVRLipSyncLOD LOD, int32 Viseme);
+
+	/**
+	 * Folds viseme scores into the visemes a level of detail uses. Scores already folded are left as they are.
+	 * @param Visemes FOVRLipSyncFrameData::NumVisemes scores.
+	 */
+	OVRLIPSYNC_API void ReduceVisemes(EOVRLipSyncLOD LOD, float *Visemes);
+
+	/**
+	 * Sets viseme scores to a jaw opening, with every other viseme at 0.
+	 * @param Visemes FOVRLipSyncFrameData::NumVisemes scores.
+	 */
+	OVRLIPSYNC_API void SetJawOpen(float JawOpen, float *Visemes);
+} // namespace OVRLipSyncLOD
+
+/**
+ * Follows the loudness of audio as a jaw opening, for characters too far away to be worth analysing. Costs a pass
+ * over the samples per frame.
+ */
+struct OVRLIPSYNC_API FOVRLipSyncJawEnvelope
+{
+	/** The time constant in seconds of the jaw opening. */
+	float AttackTime = 0.02f;
+	/** The time constant in seconds of the jaw closing. */
+	float ReleaseTime = 0.08f;
+
+	/** How far open the jaw is, 0 to 1. */
+	float JawOpen = 0.0f;
+
+	/**
+	 * Moves the jaw towards the loudness of a frame of audio.
+	 * @param Samples 16 bit samples, interleaved if there is more than one channel.
+	 * @param NumSamples The number of samples, of all channels.
+	 * @param FrameSeconds The seconds of audio the frame covers.
+	 * @returns The jaw opening after the frame.
+	 */
+	float Process(const int16 *Samples, int32 NumSamples, float FrameSeconds);
+};
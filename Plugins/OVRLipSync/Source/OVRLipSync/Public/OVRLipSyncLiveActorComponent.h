@@ -24,12 +24,15 @@
 #pragma once
 
 #include "OVRLipSyncActorComponentBase.h"
-#include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncLOD.h"
+#include "OVRLipSyncVisemeState.h"
 #include "OVRLipSyncConstants.h"
 #include "OVRLipSyncLiveActorComponent.generated.h"
 
 class IVoiceCapture;
 class UOVRLipSyncContextWrapper;
+class FOVRLipSyncLiveCapture;
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class OVRLIPSYNC_API UOVRLipSyncActorComponent : public UOVRLipSyncActorComponentBase
@@ -37,6 +40,9 @@ class OVRLIPSYNC_API UOVRLipSyncActorComponent : public UOVRLipSyncActorComponen
 	GENERATED_BODY()
 
 public:
+	UOVRLipSyncActorComponent();
+	~UOVRLipSyncActorComponent();
+
 	UPROPERTY(EditAnywhere, Category = "LipSync|Live")
 	int32 SampleRate = 48000;
 
@@ -67,16 +73,29 @@ protected:
 	virtual void BeginPlay() override;
 	// Called when the game ends
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
-
-	UFUNCTION()
-	void OnVoiceCaptureTimer();
+	// Shows the latest visemes of the capture thread
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+							   FActorComponentTickFunction *ThisTickFunction) override;
+	// Hands the level of detail to the capture thread
+	virtual void OnLODChanged(EOVRLipSyncLOD OldLOD) override;
 
 private:
-	TSharedPtr<UOVRLipSyncContextWrapper> LipSyncContext;
+	FOVRLipSyncContextKey ContextKey;
+	// Borrowed from the pool by the first audio fed after Start, and given back by Stop. Prewarmed at BeginPlay, so
+	// borrowing it never loads a model on the game thread
+	FOVRLipSyncContextPool::FContextPtr LipSyncContext;
+	// Filled by the async callback of LipSyncContext on a thread of the library, and read by TickComponent
+	FOVRLipSyncVisemeState FedVisemes;
+	// Follows the audio fed at the Jaw level of detail
+	FOVRLipSyncJawEnvelope JawEnvelope;
+
+	// Borrows an idle context, returning false if none is ready yet
+	bool AcquireContext();
+	void ReleaseContext();
 
 	TSharedPtr<IVoiceCapture> VoiceCapture;
-	FTimerHandle VoiceCaptureTimer;
-	static const float VoiceCaptureTimerRate;
+	// Reads VoiceCapture and analyses what it captures on its own thread, while capturing
+	TUniquePtr<FOVRLipSyncLiveCapture> Capture;
 
 	void StartVoiceCapture();
 };
@@ -28,4 +28,6 @@
 DECLARE_LOG_CATEGORY_EXTERN(LogOvrLipSync, Log, All);
 #else
 OVRLIPSYNC_API DECLARE_LOG_CATEGORY_EXTERN(LogOvrLipSync, Log, All);
-#endif
\ No newline at end of file
+#endif
+
+DECLARE_STATS_GROUP(TEXT("OVRLipSync"), STATGROUP_OVRLipSync, STATCAT_Advanced);
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSyncConstants.h"
+
+class USkeletalMesh;
+class USkeletalMeshComponent;
+
+/**
+ * The morph targets of a skeletal mesh that viseme scores are written to. The mesh and the names are resolved when
+ * bound rather than every frame. Weights are remembered as applied, so only the ones that moved are written and a
+ * frame where none did costs no call into the mesh at all.
+ */
+class OVRLIPSYNC_API FOVRLipSyncMorphTargetBinding
+{
+public:
+	/**
+	 * Binds to a mesh, unless already bound to it, showing the same skeletal mesh, with the same names. Rebinding
+	 * writes every weight again.
+	 * @param Mesh The mesh whose morph targets are set.
+	 * @param MorphTargetNames The morph target of each viseme, in viseme order.
+	 */
+	void Bind(USkeletalMeshComponent *Mesh, const TArray<FString> &MorphTargetNames);
+
+	/** Forgets the mesh, so the next Bind resolves everything again. */
+	void Unbind();
+
+	/**
+	 * Forgets the weights written, so the next Apply writes every weight again. For when the morph targets may have
+	 * been set by something else, such as the mesh clearing them or its animation instance being reinitialized.
+	 */
+	void ResetAppliedWeights();
+
+	/** Whether bound to a mesh that still exists. */
+	bool IsBound() const { return Mesh.IsValid(); }
+
+	/** Gets the mesh bound to, or null. */
+	USkeletalMeshComponent *GetMesh() const { return Mesh.Get(); }
+
+	/**
+	 * Writes the weights that moved by more than Epsilon since they were last written, in one pass.
+	 * @param Weights The score of each viseme.
+	 * @param LOD Visemes the level of detail does not use are left as they are, unless bAllVisemes.
+	 * @param bAllVisemes Whether to write the visemes the level of detail does not use as well.
+	 * @param Epsilon How much a weight has to move to be written again.
+	 * @returns The number of morph targets written.
+	 */
+	int32 Apply(const TArray<float> &Weights, EOVRLipSyncLOD LOD, bool bAllVisemes, float Epsilon);
+
+private:
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+	/** The skeletal mesh the component showed when bound, as setting another one clears the morph targets. */
+	TWeakObjectPtr<USkeletalMesh> BoundAsset;
+	/** The names bound with, to tell whether a Bind changes them without resolving them again. */
+	TArray<FString> BoundNames;
+	TArray<FName> MorphTargets;
+	/** The weight last written to each morph target. */
+	TArray<float> AppliedWeights;
+};
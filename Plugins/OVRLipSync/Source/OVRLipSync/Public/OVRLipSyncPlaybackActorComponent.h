@@ -35,9 +35,14 @@ class OVRLIPSYNC_API UOVRLipSyncPlaybackActorComponent : public UOVRLipSyncActor
 	GENERATED_BODY()
 
 public:
+	UOVRLipSyncPlaybackActorComponent();
+
 	UPROPERTY(EditAnywhere, Meta = (Tooltip = "LipSync Sequence to be played"))
 	UOVRLipSyncFrameSequence *Sequence;
 
+	UPROPERTY(EditAnywhere, Category = "LipSync", Meta = (Tooltip = "How visemes are blended between the frames of the sequence"))
+	EOVRLipSyncInterpolation Interpolation = EOVRLipSyncInterpolation::Linear;
+
 	UPROPERTY(BlueprintReadonly)
 	UAudioComponent *AudioComponent;
 
@@ -54,6 +59,8 @@ public:
 protected:
 	// Returns audio Component associated with the same
 	UAudioComponent *FindAutoplayAudioComponent() const;
+	// Follows AudioComponent without playing it, for components which start and stop their sound themselves
+	void Attach(UAudioComponent *InAudioComponent, UOVRLipSyncFrameSequence *InSequence);
 	// Audio Component callbacks
 	void OnAudioPlaybackPercent(const UAudioComponent *, const USoundWave *, float Percent);
 	void OnAudioPlaybackFinished(UAudioComponent *);
@@ -61,8 +68,23 @@ protected:
 	virtual void BeginPlay() override;
 	// Called when the game ends
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// Gets the playback position of the sequence in seconds, extrapolated from the last percent callback, or -1 before
+	// the first one. Overridden by components whose sound knows its position better than the percent callbacks.
+	virtual double GetPlaybackTime() const;
+	// Samples the sequence at the extrapolated playback position
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+							   FActorComponentTickFunction *ThisTickFunction) override;
 
 private:
+	// Sets the visemes to the sequence at a playback position
+	void SampleSequence(double PlaybackTime);
+
 	FDelegateHandle PlaybackPercentHandle;
 	FDelegateHandle PlaybackFinishedHandle;
+
+	// The audio position reported by the last percent callback, and when it arrived. Playback positions between
+	// callbacks are extrapolated from these, so visemes move every frame rather than once per audio buffer.
+	double ReportedPlaybackTime = 0.0;
+	double ReportedAt = 0.0;
+	bool bPlaybackClockValid = false;
 };
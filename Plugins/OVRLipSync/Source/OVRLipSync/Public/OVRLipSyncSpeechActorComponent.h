@@ -2,14 +2,34 @@
 
 #pragma once
 
-#include "Misc/SpinLock.h"
+#include "Containers/Queue.h"
 #include "OVRLipSyncPlaybackActorComponent.h"
-#include "OVRLipSyncContextWrapper.h"
-#include "Sound/SoundWaveProcedural.h"
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncSpeechSoundWave.h"
+#include "OVRLipSyncVisemeMapping.h"
+#include "Tasks/Pipe.h"
 #include "OVRLipSyncSpeechActorComponent.generated.h"
 
 // DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnVisemesEvent, const TArray<float>&, visemes, float, laughter);
 
+/** An utterance, or when streaming a window of one, cooked on the worker pipe and ready to be played. */
+struct FOVRLipSyncCookedSpeech
+{
+	FOVRLipSyncFrameData Frames;
+	TArray<uint8> PCMData; ///< The audio the frames cover.
+	bool bLast = true; ///< Whether this ends an utterance.
+};
+
+/**
+ * The hand-off from the cooking pipe to the game thread. Shared with the tasks so an utterance still cooking
+ * when the component ends play has somewhere to go.
+ */
+struct FOVRLipSyncCookedQueue
+{
+	TQueue<FOVRLipSyncCookedSpeech, EQueueMode::Spsc> Speech; ///< Produced by the pipe, which runs one task at a time, consumed by the game thread.
+	std::atomic<bool> bCancelled{ false }; ///< Set when the component ends play, so queued tasks skip their work. Never cleared, the component starts a new queue instead.
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class OVRLIPSYNC_API UOVRLipSyncSpeechActorComponent : public UOVRLipSyncPlaybackActorComponent
 {
@@ -37,13 +57,43 @@ public:
 	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ToolTip = "Enable hardware acceleration on supported platforms"))
 	bool EnableHardwareAcceleration = true;
 
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ClampMin = "0.0", ClampMax = "0.5", ToolTip = "Seconds for viseme scores fed by FeedAudioWithVisemes to rise"))
+	float VisemeAttackTime = 0.03f;
+
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ClampMin = "0.0", ClampMax = "0.5", ToolTip = "Seconds for viseme scores fed by FeedAudioWithVisemes to fall"))
+	float VisemeReleaseTime = 0.06f;
+
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ToolTip = "The OVRLipSync visemes each viseme ID fed to FeedAudioWithVisemes is shown as, indexed by ID. Empty for the 22 SAPI visemes"))
+	TArray<FOVRLipSyncVisemeBlend> VisemeMapping;
+
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ToolTip = "Precision the viseme scores of each utterance are stored at"))
+	EOVRLipSyncScoreQuantization Quantization = EOVRLipSyncScoreQuantization::Bits8;
+
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ToolTip = "Start playing audio fed to FeedAudio as soon as its first window is analysed, rather than once all of it is"))
+	bool bStreaming = false;
+
+	UPROPERTY(EditAnywhere, Category = "LipSync|Speech", Meta = (ClampMin = "0.01", ClampMax = "1.0", EditCondition = "bStreaming", ToolTip = "Seconds of audio analysed ahead of playback when streaming, on top of the delay of the lip sync model"))
+	float StreamingLookahead = 0.1f;
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
 							   FActorComponentTickFunction *ThisTickFunction) override;
 
+	/**
+	 * Queues audio for cooking into visemes on a worker thread. It plays on the game thread once cooked, right after
+	 * the audio queued before it, so long utterances never stall a frame. When streaming, it plays once
+	 * StreamingLookahead of it is cooked and the rest is analysed while it plays.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "LipSync|Speech", Meta = (ToolTip = "Feed AudioBuffer containing packaged mono 16-bit signed integer PCM values"))
 	void FeedAudio(const TArray<uint8>& AudioData);
 
+	/**
+	 * Queues audio whose visemes are already known, such as synthesized speech, building the sequence from the
+	 * viseme timeline instead of analysing the audio. The IDs are mapped by VisemeMapping, or are the 22 SAPI visemes.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "LipSync|Speech", Meta = (ToolTip = "Feed AudioBuffer containing packaged mono 16-bit signed integer PCM values, with the viseme IDs and their start times in seconds"))
+	void FeedAudioWithVisemes(const TArray<uint8>& AudioData, const TArray<int32>& VisemeIds, const TArray<float>& VisemeTimes);
+
 	UFUNCTION(BlueprintCallable, Category = "LipSync|Speech", Meta = (ToolTip = "Initialize Audio"))
 	void InitializeAudio(UAudioComponent * InAudioComponent);
 
@@ -54,9 +104,10 @@ protected:
 	virtual void BeginPlay() override;
 	// Called when the game ends
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason);
-
-	UFUNCTION(BlueprintCallable, Category = "LipSync|Audio")
-	USoundWave *ByteArrayToSoundWave(const TArray<uint8> &DataArray);
+	// Waits for the cooking pipe to run out of tasks, which must happen before it is destroyed
+	virtual bool IsReadyForFinishDestroy() override;
+	// Gets the playback position in SpeechSequence from the samples SpeechWave has played, or -1 while it is empty
+	virtual double GetPlaybackTime() const override;
 
 private:
 	int32_t ChunkSampleSize;
@@ -64,22 +115,31 @@ private:
 	int32_t FrameOffset = 0;
 	int32_t FrameDelayInMs = 0;
 	bool bStereo = false;
-	bool bIsSpeaking = false;
 
 
 
-	TSharedPtr<UOVRLipSyncContextWrapper> LipSyncContext;
-	TQueue<TArray<uint8>> VoiceAudioData;
- 	TQueue<TPair<UOVRLipSyncFrameSequence *, TArray<int16>>> lipSyncData;
-	void CookAudioData(const TArray<uint8>& PCMData);
-	void TryResumePlayback();
+	FOVRLipSyncContextKey ContextKey; ///< The contexts utterances are analysed with, borrowed from the pool for each one.
+	TSharedRef<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe> CookedSpeech = MakeShared<FOVRLipSyncCookedQueue, ESPMode::ThreadSafe>();
+	// Utterances are cooked one at a time, in order, each with a context borrowed for just as long as it is analysed.
+	UE::Tasks::FPipe CookPipe{ TEXT("OVRLipSyncCookPipe") };
+
+	// Analyses audio a window at a time on the cooking pipe.
+	void StreamAudio(const TArray<uint8>& VoiceData);
+	// Queues what was cooked since the last tick on SpeechWave and SpeechSequence.
+	void PumpSpeech();
+	// Pads whichever of the audio and the frames of the utterance just queued is shorter, so the next one starts on
+	// a frame.
+	void AlignSpeech();
+	void QueueSpeechAudio(TArray<uint8> &&PCMData);
 
-	UFUNCTION()
-	void OnAudioPlaybackFinished();
-	UFUNCTION()
-	void OnAudioPercentPlayedUpdated(const USoundWave *PlayingSoundWave, const float PlaybackPercent);
+	// Every utterance plays on this one sound, so there is no gap or new sound between utterances. It is started when
+	// speech is queued and stopped once all of it has played, so no voice is spent playing silence.
+	UPROPERTY(Transient)
+	UOVRLipSyncSpeechSoundWave *SpeechWave;
+	// The frames of the utterances queued on SpeechWave, emptied whenever it has played them all.
+	UPROPERTY(Transient)
+	UOVRLipSyncFrameSequence *SpeechSequence;
+	int64 QueuedFrames = 0; ///< The frames of audio queued on SpeechWave.
+	int64 SequenceStartFrame = 0; ///< The frame of SpeechWave the first frame of SpeechSequence plays at.
 
-	UE::FSpinLock VoiceLock;
-	UE::FSpinLock PlaybackLock;
-		
 };
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Misc/SpinLock.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "OVRLipSyncSpeechSoundWave.generated.h"
+
+/**
+ * A sound that plays every utterance of a speech component back to back. Utterances are handed to it as they are
+ * cooked and played out without gaps. It never finishes by itself, the component stops it once everything queued has
+ * played and starts it again for the next utterance.
+ */
+UCLASS()
+class OVRLIPSYNC_API UOVRLipSyncSpeechSoundWave : public USoundWaveProcedural
+{
+	GENERATED_BODY()
+
+public:
+	UOVRLipSyncSpeechSoundWave(const FObjectInitializer &ObjectInitializer);
+
+	/**
+	 * Queues 16 bit PCM audio after what is already queued, taking the buffer without copying it. Called on the game thread.
+	 * @param PCMData Interleaved samples of NumChannels channels.
+	 */
+	void QueuePCMData(TArray<uint8> &&PCMData);
+
+	/**
+	 * Gets the number of frames of queued audio played so far, a frame being one sample of every channel. Counted on
+	 * the audio render thread, so it stops while the sound is paused or starved, and estimated between its callbacks.
+	 * Audio handed to the renderer waits behind the buffers the mixer has queued, so it is only counted once they
+	 * have played.
+	 * @param Pitch The pitch multiplier the sound is played at.
+	 */
+	int64 GetPlayedFrames(double Pitch) const;
+
+	virtual int32 OnGeneratePCMAudio(TArray<uint8> &OutAudio, int32 NumSamples) override;
+
+private:
+	TQueue<TArray<uint8>, EQueueMode::Spsc> PendingPCMData; ///< Queued by the game thread, played by the audio render thread.
+	TArray<uint8> PlayingPCMData; ///< The buffer being played, only touched by the audio render thread.
+	int32 PlayingOffset = 0; ///< The bytes of PlayingPCMData played.
+
+	/** The buffers the mixer keeps queued behind the one playing, MAX_BUFFERS_QUEUED less the one playing. */
+	static constexpr int32 BuffersAhead = 2;
+
+	/** What one callback handed to the renderer. */
+	struct FGeneratedBuffer
+	{
+		int32 Frames = 0;
+		double At = 0.0; ///< When the callback ran.
+	};
+
+	mutable UE::FSpinLock GeneratedLock; ///< Guards the counters below, which are read together.
+	int64 GeneratedFrames = 0; ///< The frames of queued audio handed to the renderer.
+	TStaticArray<FGeneratedBuffer, BuffersAhead + 1> RecentBuffers; ///< The last callbacks, oldest at RecentIndex.
+	int32 RecentIndex = 0;
+};
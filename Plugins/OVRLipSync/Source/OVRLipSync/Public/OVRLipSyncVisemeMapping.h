@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSyncConstants.h"
+#include "OVRLipSyncFrame.h"
+#include "OVRLipSyncVisemeMapping.generated.h"
+
+/** The OVRLipSync visemes one viseme ID of a speech synthesizer is shown as. */
+USTRUCT(BlueprintType)
+struct OVRLIPSYNC_API FOVRLipSyncVisemeBlend
+{
+	GENERATED_BODY()
+
+	/** The score of each OVRLipSync viseme, in the order sil, PP, FF, TH, DD, kk, CH, SS, nn, RR, aa, E, ih, oh, ou. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LipSync")
+	TArray<float> Scores;
+};
+
+/**
+ * Turns viseme events reported by a speech synthesizer into the score curves OVRLipSync produces from audio,
+ * so synthesized speech can be lip synced without running the audio through the lip sync context.
+ * Each viseme ID is mapped to a blend of the 15 OVRLipSync visemes. Without a mapping of their own, IDs are taken to
+ * be the 22 Microsoft SAPI visemes (SPVISEMES, 0 silence to 21 p, b, m). The IDs RSGame reports are not documented in
+ * rsgame.h, so a voice reporting another set needs its own mapping.
+ */
+namespace OVRLipSyncVisemeMapping
+{
+	/** The number of SAPI visemes, IDs at or above this count as silence. */
+	constexpr int32 NumSapiVisemes = 22;
+
+	/** The number of viseme scores in each frame, ovrLipSyncViseme_Count. */
+	constexpr int32 NumVisemes = FOVRLipSyncFrameData::NumVisemes;
+
+	/**
+	 * Builds the frames of a sequence from a viseme timeline. Each score moves towards the scores of the current
+	 * viseme exponentially, rising with the attack time and falling with the release time.
+	 * @param VisemeIds The viseme IDs, in time order.
+	 * @param VisemeTimes The seconds from the start of the audio at which each viseme starts.
+	 * @param Duration The seconds of audio the frames cover.
+	 * @param FrameRate The frames per second of the sequence the frames are appended to.
+	 * @param AttackTime The time constant in seconds of rising scores, 0 to jump.
+	 * @param ReleaseTime The time constant in seconds of falling scores, 0 to jump.
+	 * @param Quantization The precision the frames are packed at.
+	 * @param Mapping The blend each viseme ID is shown as, indexed by ID, IDs past its end count as silence. Empty for
+	 * the SAPI visemes.
+	 * @param LOD The level of detail the frames are folded into, as analysed frames are. Not Off.
+	 * @param OutFrames Receives one frame per 1 / FrameRate seconds.
+	 */
+	OVRLIPSYNC_API void BuildFrames(const TArray<int32> &VisemeIds, const TArray<float> &VisemeTimes, float Duration,
+									float FrameRate, float AttackTime, float ReleaseTime,
+									EOVRLipSyncScoreQuantization Quantization,
+									TConstArrayView<FOVRLipSyncVisemeBlend> Mapping, EOVRLipSyncLOD LOD,
+									FOVRLipSyncFrameData &OutFrames);
+} // namespace OVRLipSyncVisemeMapping
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OVRLipSync.h"
+#include <atomic>
+
+/** The scores of one analysed frame, sized for every viseme so it is filled in place. */
+struct FOVRLipSyncVisemeFrame
+{
+	float Visemes[ovrLipSyncViseme_Count] = {};
+	int32 NumVisemes = 0;
+	float LaughterScore = 0.0f;
+	double AnalysedAt = 0.0;	  ///< FPlatformTime::Seconds() when the frame was analysed.
+	double BufferedSeconds = 0.0; ///< The audio already captured after the frame, still waiting to be analysed.
+};
+
+/**
+ * Hands the latest analysed frame from the thread analysing audio to the thread showing it, without locks or
+ * allocations. A triple buffer: the writer fills a frame of its own and swaps it with the spare, the reader swaps the
+ * spare with its own frame only if the writer published one since, so neither ever waits on the other and the reader
+ * always gets the newest frame whole. Frames published between two reads are skipped.
+ * One writer and one reader at a time.
+ */
+class FOVRLipSyncVisemeState
+{
+public:
+	/** Gets the frame to fill, owned by the writer until Publish. */
+	FOVRLipSyncVisemeFrame &BeginWrite() { return Frames[WriteIndex]; }
+
+	/** Fills the frame to write with the scores of the ovrLipSync frame, and publishes it. */
+	void Publish(const ovrLipSyncFrame &Frame, double AnalysedAt, double BufferedSeconds = 0.0)
+	{
+		FOVRLipSyncVisemeFrame &Out = BeginWrite();
+		Out.NumVisemes = FMath::Min((int32)Frame.visemesLength, (int32)ovrLipSyncViseme_Count);
+		FMemory::Memcpy(Out.Visemes, Frame.visemes, Out.NumVisemes * sizeof(float));
+		Out.LaughterScore = Frame.laughterScore;
+		Out.AnalysedAt = AnalysedAt;
+		Out.BufferedSeconds = BufferedSeconds;
+		EndWrite();
+	}
+
+	/** Publishes the frame filled since BeginWrite, making it the one the next read gets. */
+	void EndWrite()
+	{
+		// Release makes the filled frame visible to the reader that acquires the spare.
+		WriteIndex = (uint8)(Spare.exchange((uint8)(WriteIndex | NewBit), std::memory_order_acq_rel) & IndexMask);
+	}
+
+	/**
+	 * Gets the newest frame published since the last read.
+	 * @returns The frame, owned by the reader until its next call, or nullptr if nothing new was published.
+	 */
+	const FOVRLipSyncVisemeFrame *Read()
+	{
+		if ((Spare.load(std::memory_order_relaxed) & NewBit) == 0)
+		{
+			return nullptr;
+		}
+		ReadIndex = (uint8)(Spare.exchange(ReadIndex, std::memory_order_acq_rel) & IndexMask);
+		return &Frames[ReadIndex];
+	}
+
+	/**
+	 * Copies the newest frame published since the last read into a component's scores.
+	 * @returns false, leaving the outputs alone, if nothing new was published.
+	 */
+	bool Read(TArray<float> &OutVisemes, float &OutLaughterScore)
+	{
+		const FOVRLipSyncVisemeFrame *Frame = Read();
+		if (!Frame)
+		{
+			return false;
+		}
+		// Only allocates the first time, when the scores are still empty.
+		OutVisemes.SetNumUninitialized(Frame->NumVisemes);
+		FMemory::Memcpy(OutVisemes.GetData(), Frame->Visemes, Frame->NumVisemes * sizeof(float));
+		OutLaughterScore = Frame->LaughterScore;
+		return true;
+	}
+
+private:
+	static constexpr uint8 IndexMask = 3;
+	static constexpr uint8 NewBit = 4;
+
+	FOVRLipSyncVisemeFrame Frames[3];
+	uint8 WriteIndex = 0;		   ///< Only touched by the writer.
+	uint8 ReadIndex = 1;		   ///< Only touched by the reader.
+	std::atomic<uint8> Spare{ 2 }; ///< The index of the frame neither owns, and NewBit if it was published since the last read.
+};
@@ -34,6 +34,7 @@ public class OVRLipSyncEditor : ModuleRules
           "Core",
           "CoreUObject",
           "Engine",
+          "Json",
           "OVRLipSync",
           "Slate",
           "SlateCore",
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncBakeCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "OVRLipSyncBatchBaker.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/SavePackage.h"
+
+namespace
+{
+
+// How often the commandlet loads sound waves and writes the sequences baked so far, while the rest bake.
+constexpr float WritePollInterval = 0.01f;
+// The sound waves checked and baked between garbage collections, which free them and the sequences saved.
+constexpr int32 BatchSize = 64;
+
+// Whether the sequence of a sound wave was baked from its current audio with the same settings.
+bool IsSequenceUpToDate(IAssetRegistry &AssetRegistry, const FAssetData &SoundWaveAsset, const FString &BakeSettings)
+{
+	const FSoftObjectPath SequencePath = FOVRLipSyncBatchBaker::GetSequencePath(SoundWaveAsset);
+	if (!AssetRegistry.GetAssetByObjectPath(SequencePath).IsValid())
+	{
+		return false;
+	}
+	auto SoundWave = Cast<USoundWave>(SoundWaveAsset.GetAsset());
+	auto Sequence = Cast<UOVRLipSyncFrameSequence>(SequencePath.TryLoad());
+	return SoundWave && Sequence && Sequence->BakeSettings == BakeSettings &&
+		   Sequence->SourceAudioHash == FOVRLipSyncBatchBaker::GetSourceAudioHash(*SoundWave);
+}
+
+bool SaveSequence(UOVRLipSyncFrameSequence *Sequence)
+{
+	UPackage *Package = Sequence->GetPackage();
+	const FString Filename =
+		FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	SaveArgs.Error = GWarn;
+	return UPackage::SavePackage(Package, Sequence, *Filename, SaveArgs);
+}
+
+TArray<TSharedPtr<FJsonValue>> ToJsonStrings(const TArray<FString> &Strings)
+{
+	TArray<TSharedPtr<FJsonValue>> Values;
+	for (const FString &String : Strings)
+	{
+		Values.Add(MakeShared<FJsonValueString>(String));
+	}
+	return Values;
+}
+
+} // namespace
+
+UOVRLipSyncBakeCommandlet::UOVRLipSyncBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Bakes the lip-sync sequences of the sound waves under a path whose audio changed.");
+	HelpUsage = TEXT("-run=OVRLipSyncBake -Path=/Game/Dialogue [-OfflineModel] [-Force] [-Report=<file>.json]");
+}
+
+int32 UOVRLipSyncBakeCommandlet::Main(const FString &Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	const FString *Path = ParamValues.Find(TEXT("Path"));
+	if (!Path)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+	const bool bUseOfflineModel = Switches.Contains(TEXT("OfflineModel"));
+	const bool bForce = Switches.Contains(TEXT("Force"));
+	const FString ReportPath =
+		ParamValues.Contains(TEXT("Report"))
+			? ParamValues[TEXT("Report")]
+			: FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("OVRLipSync"), TEXT("LipSyncBakeReport.json"));
+	const double StartTime = FPlatformTime::Seconds();
+
+	IAssetRegistry &AssetRegistry =
+		FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+	FARFilter Filter;
+	Filter.PackagePaths.Add(FName(**Path));
+	Filter.bRecursivePaths = true;
+	Filter.ClassPaths.Add(USoundWave::StaticClass()->GetClassPathName());
+	Filter.bRecursiveClasses = true;
+	TArray<FAssetData> SoundWaveAssets;
+	AssetRegistry.GetAssets(Filter, SoundWaveAssets);
+
+	const FString BakeSettings = FOVRLipSyncBatchBaker::GetBakeSettings(bUseOfflineModel);
+	UE_LOG(LogTemp, Display, TEXT("Checking %d sound waves under %s, baking those out of date."), SoundWaveAssets.Num(),
+		   **Path);
+
+	TArray<TSharedPtr<FJsonValue>> Baked;
+	TArray<FString> Skipped;
+	TArray<FString> Failed;
+	for (int32 BatchStart = 0; BatchStart < SoundWaveAssets.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchEnd = FMath::Min(BatchStart + BatchSize, SoundWaveAssets.Num());
+		TArray<FAssetData> SoundWavesToBake;
+		for (int32 Index = BatchStart; Index < BatchEnd; ++Index)
+		{
+			const FAssetData &SoundWaveAsset = SoundWaveAssets[Index];
+			if (!bForce && IsSequenceUpToDate(AssetRegistry, SoundWaveAsset, BakeSettings))
+			{
+				Skipped.Add(SoundWaveAsset.GetObjectPathString());
+			}
+			else
+			{
+				SoundWavesToBake.Add(SoundWaveAsset);
+			}
+		}
+
+		TSet<FString> BakedSoundWaves;
+		{
+			FOVRLipSyncBatchBaker Baker(SoundWavesToBake, bUseOfflineModel);
+			Baker.OnSequenceBaked.BindLambda([&](const FAssetData &SoundWaveAsset, UOVRLipSyncFrameSequence *Sequence) {
+				const FString SoundWavePath = SoundWaveAsset.GetObjectPathString();
+				BakedSoundWaves.Add(SoundWavePath);
+				if (!SaveSequence(Sequence))
+				{
+					UE_LOG(LogTemp, Error, TEXT("Can't save %s"), *Sequence->GetPathName());
+					Failed.Add(SoundWavePath);
+					return;
+				}
+				TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+				Entry->SetStringField(TEXT("soundWave"), SoundWavePath);
+				Entry->SetStringField(TEXT("sequence"), Sequence->GetPathName());
+				Entry->SetNumberField(TEXT("frames"), Sequence->Num());
+				Entry->SetStringField(TEXT("audioHash"), Sequence->SourceAudioHash);
+				Baked.Add(MakeShared<FJsonValueObject>(Entry));
+			});
+			// A commandlet has the machine to itself, so every core the task system has is used.
+			Baker.Start(TNumericLimits<int32>::Max());
+			while (!Baker.IsDone())
+			{
+				// Nothing else ticks the loading of the sound waves in a commandlet.
+				ProcessAsyncLoading(true, false, WritePollInterval);
+				Baker.WriteResults(WritePollInterval);
+				FPlatformProcess::Sleep(WritePollInterval);
+			}
+		}
+		for (const FAssetData &SoundWaveAsset : SoundWavesToBake)
+		{
+			if (!BakedSoundWaves.Contains(SoundWaveAsset.GetObjectPathString()))
+			{
+				Failed.Add(SoundWaveAsset.GetObjectPathString());
+			}
+		}
+		// Everything the batch loaded is saved or not needed again.
+		CollectGarbage(RF_NoFlags);
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("path"), *Path);
+	Report->SetStringField(TEXT("bakeSettings"), BakeSettings);
+	Report->SetNumberField(TEXT("seconds"), FPlatformTime::Seconds() - StartTime);
+	Report->SetArrayField(TEXT("baked"), Baked);
+	Report->SetArrayField(TEXT("skipped"), ToJsonStrings(Skipped));
+	Report->SetArrayField(TEXT("failed"), ToJsonStrings(Failed));
+	FString ReportJson;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportJson));
+	if (!FFileHelper::SaveStringToFile(ReportJson, *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Can't write the report to %s"), *ReportPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Baked %d, skipped %d and failed %d lip-sync sequences, reported in %s"),
+		   Baked.Num(), Skipped.Num(), Failed.Num(), *ReportPath);
+	return Failed.Num() > 0 ? 1 : 0;
+}
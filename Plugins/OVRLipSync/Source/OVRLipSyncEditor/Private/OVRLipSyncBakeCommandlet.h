@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OVRLipSyncBakeCommandlet.generated.h"
+
+/**
+ * Bakes the lip-sync sequences of every sound wave under a path, on every core, and saves them.
+ * Sound waves whose sequence was baked from the same audio with the same settings are skipped, unless -Force is given.
+ * Writes a JSON report of the sequences baked, skipped and failed.
+ *
+ * UnrealEditor-Cmd Project.uproject -run=OVRLipSyncBake -Path=/Game/Dialogue [-OfflineModel] [-Force]
+ *     [-Report=Saved/LipSyncBake.json]
+ *
+ * Returns 0 if every sound wave was baked and saved, or skipped.
+ */
+UCLASS()
+class UOVRLipSyncBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOVRLipSyncBakeCommandlet();
+
+	virtual int32 Main(const FString &Params) override;
+};
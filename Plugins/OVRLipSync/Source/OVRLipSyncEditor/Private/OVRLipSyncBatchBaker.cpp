@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OVRLipSyncBatchBaker.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "IO/IoHash.h"
+#include "HAL/FileManager.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/SecureHash.h"
+#include "OVRLipSyncContextPool.h"
+#include "Tasks/Task.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+
+// Compute LipSync sequence frames at 100 times a second rate
+constexpr auto LipSyncSequenceUpateFrequency = 100;
+constexpr auto LipSyncSequenceDuration = 1.0f / LipSyncSequenceUpateFrequency;
+
+FString GetOfflineModelPath()
+{
+	return FPaths::Combine(FPaths::ProjectPluginsDir(), TEXT("OVRLipSync"), TEXT("OfflineModel"),
+						   TEXT("ovrlipsync_offline_model.pb"));
+}
+
+// Hashes the files the model is read from: the offline model, or the library the built-in model is compiled into.
+FString GetModelHash(bool bUseOfflineModel)
+{
+	TArray<FString> ModelFiles;
+	if (bUseOfflineModel)
+	{
+		ModelFiles.Add(GetOfflineModelPath());
+	}
+	else
+	{
+		const FString LibraryDirectory = FPaths::Combine(FPaths::ProjectPluginsDir(), TEXT("OVRLipSync"),
+														 TEXT("ThirdParty"), TEXT("Lib"),
+														 FPlatformProcess::GetBinariesSubdirectory());
+		IFileManager::Get().FindFiles(ModelFiles, *LibraryDirectory, nullptr);
+		ModelFiles.Sort();
+		for (FString &ModelFile : ModelFiles)
+		{
+			ModelFile = FPaths::Combine(LibraryDirectory, ModelFile);
+		}
+	}
+	FString Hash;
+	for (const FString &ModelFile : ModelFiles)
+	{
+		const FMD5Hash FileHash = FMD5Hash::HashFile(*ModelFile);
+		Hash += FileHash.IsValid() ? LexToString(FileHash) : TEXT("Missing");
+	}
+	return Hash;
+}
+
+UOVRLipSyncFrameSequence *CreateSequenceAsset(const FAssetData &SoundWaveAsset, FOVRLipSyncFrameData &&Frames)
+{
+	const FSoftObjectPath SequencePath = FOVRLipSyncBatchBaker::GetSequencePath(SoundWaveAsset);
+	auto SequencePackage = CreatePackage(*SequencePath.GetLongPackageName());
+	auto Sequence = NewObject<UOVRLipSyncFrameSequence>(SequencePackage, *SequencePath.GetAssetName(),
+														RF_Public | RF_Standalone);
+	Sequence->SetFrames(MoveTemp(Frames));
+
+	FAssetRegistryModule::AssetCreated(Sequence);
+	Sequence->MarkPackageDirty();
+	return Sequence;
+}
+
+} // namespace
+
+FOVRLipSyncBatchBaker::FOVRLipSyncBatchBaker(const TArray<FAssetData> &InSoundWaveAssets, bool bInUseOfflineModel)
+	: SoundWaveAssets(InSoundWaveAssets), bUseOfflineModel(bInUseOfflineModel)
+{
+	Quantization = GetDefault<UOVRLipSyncFrameSequence>()->Quantization;
+	BakeSettings = GetBakeSettings(bUseOfflineModel);
+	SourceAudioHashes.SetNum(SoundWaveAssets.Num());
+}
+
+FString FOVRLipSyncBatchBaker::GetBakeSettings(bool bUseOfflineModel)
+{
+	// The model files are hashed rather than named, so replacing one bakes its sequences again. The quantization is
+	// the default new sequences are packed at, so changing it bakes them again too.
+	return FString::Printf(TEXT("Provider=%d;Model=%s:%s;FrameRate=%d;Quantization=%d"),
+						   (int32)FOVRLipSyncContextKey().Provider, bUseOfflineModel ? TEXT("Offline") : TEXT("Builtin"),
+						   *GetModelHash(bUseOfflineModel), LipSyncSequenceUpateFrequency,
+						   (int32)GetDefault<UOVRLipSyncFrameSequence>()->Quantization);
+}
+
+FSoftObjectPath FOVRLipSyncBatchBaker::GetSequencePath(const FAssetData &SoundWaveAsset)
+{
+	return FSoftObjectPath(FString::Printf(TEXT("%s_LipSyncSequence.%s_LipSyncSequence"),
+										   *SoundWaveAsset.PackageName.ToString(), *SoundWaveAsset.AssetName.ToString()));
+}
+
+FString FOVRLipSyncBatchBaker::GetSourceAudioHash(const USoundWave &SoundWave)
+{
+	// The hash the editor already keeps of the imported audio, so the audio itself is not loaded.
+	return LexToString(SoundWave.RawData.GetPayloadId());
+}
+
+FOVRLipSyncBatchBaker::~FOVRLipSyncBatchBaker()
+{
+	Cancel();
+	// The load callbacks refer to the baker, so the few loads in flight are finished rather than left to call back.
+	TArray<int32> Requests;
+	LoadRequests.GenerateValueArray(Requests);
+	if (Requests.Num() > 0)
+	{
+		FlushAsyncLoading(Requests);
+	}
+	UE::Tasks::Wait(Bakes);
+}
+
+void FOVRLipSyncBatchBaker::Start(int32 MaxWorkers)
+{
+	MaxInFlight = FMath::Max(
+		FMath::Min3(FPlatformMisc::NumberOfWorkerThreadsToSpawn(), MaxWorkers, SoundWaveAssets.Num()), 1);
+	LoadNextSoundWaves();
+}
+
+void FOVRLipSyncBatchBaker::Cancel() { bCancelled = true; }
+
+void FOVRLipSyncBatchBaker::LoadNextSoundWaves()
+{
+	while (!bCancelled && NumInFlight < MaxInFlight && NextSoundWave < SoundWaveAssets.Num())
+	{
+		const int32 Index = NextSoundWave++;
+		++NumInFlight;
+		// Called back from the game thread's async loading tick, never from inside this call, even when loaded already.
+		auto OnLoaded = FLoadPackageAsyncDelegate::CreateLambda(
+			[this, Index](const FName &, UPackage *, EAsyncLoadingResult::Type Result)
+			{ OnSoundWaveLoaded(Index, Result == EAsyncLoadingResult::Succeeded); });
+		LoadRequests.Add(Index, LoadPackageAsync(SoundWaveAssets[Index].PackageName.ToString(), MoveTemp(OnLoaded)));
+	}
+}
+
+void FOVRLipSyncBatchBaker::OnSoundWaveLoaded(int32 Index, bool bLoaded)
+{
+	LoadRequests.Remove(Index);
+	const FAssetData &SoundWaveAsset = SoundWaveAssets[Index];
+	USoundWave *SoundWave = bLoaded ? Cast<USoundWave>(SoundWaveAsset.FastGetAsset(false)) : nullptr;
+	if (!SoundWave)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Can't load %s"), *SoundWaveAsset.GetObjectPathString());
+		Baked.Enqueue({ Index, false });
+		return;
+	}
+	if (bCancelled)
+	{
+		--NumInFlight;
+		return;
+	}
+	SourceAudioHashes[Index] = GetSourceAudioHash(*SoundWave);
+
+	// Kept loaded until the game thread takes the result, the task only reads it.
+	auto Bake = [this, Index, Referenced = TStrongObjectPtr<USoundWave>(SoundWave)]() mutable
+	{
+		FBakedSoundWave Result;
+		Result.Index = Index;
+		Result.bBaked = BakeSoundWave(Index, *Referenced, Result.Frames);
+		Result.SoundWave = MoveTemp(Referenced);
+		Baked.Enqueue(MoveTemp(Result));
+	};
+	Bakes.RemoveAllSwap([](const UE::Tasks::FTask &Task) { return Task.IsCompleted(); });
+	Bakes.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Bake), UE::Tasks::ETaskPriority::BackgroundNormal));
+}
+
+bool FOVRLipSyncBatchBaker::BakeSoundWave(int32 Index, USoundWave &SoundWave, FOVRLipSyncFrameData &OutFrames)
+{
+	const FAssetData &SoundWaveAsset = SoundWaveAssets[Index];
+
+	// The imported wave is parsed here rather than decompressed by the audio device, which would need every sound the
+	// editor plays stopped and can only be done on the game thread.
+	TArray<uint8> RawPCMData;
+	uint32 SampleRate = 0;
+	uint16 NumChannels = 0;
+	if (!SoundWave.GetImportedSoundWaveData(RawPCMData, SampleRate, NumChannels) || SampleRate == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Can't read the imported audio of %s"), *SoundWaveAsset.GetObjectPathString());
+		return false;
+	}
+	if (NumChannels < 1 || NumChannels > 2)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Can't process %s: only mono and stereo streams are supported"),
+			   *SoundWaveAsset.GetObjectPathString());
+		return false;
+	}
+
+	FOVRLipSyncContextKey ContextKey;
+	ContextKey.SampleRate = SampleRate;
+	ContextKey.ModelPath = bUseOfflineModel ? GetOfflineModelPath() : FString();
+	int32_t FrameDelayInMs = FOVRLipSyncContextPool::Get().GetFrameDelay(ContextKey);
+	// Given back to the pool however the bake ends, so the next sound wave of the worker reuses it.
+	FOVRLipSyncContextPool::FContextPtr PooledContext = FOVRLipSyncContextPool::Get().Acquire(ContextKey);
+	ON_SCOPE_EXIT
+	{
+		FOVRLipSyncContextPool::Get().Release(ContextKey, MoveTemp(PooledContext));
+	};
+	if (!PooledContext->IsValid())
+	{
+		return false;
+	}
+	if (PooledContext->GetProvider() != ContextKey.Provider)
+	{
+		// The bake settings would claim a model the sequence was not baked with.
+		UE_LOG(LogTemp, Error, TEXT("Can't bake %s without the ovrLipSync library"),
+			   *SoundWaveAsset.GetObjectPathString());
+		return false;
+	}
+	UOVRLipSyncContextWrapper &context = *PooledContext;
+
+	const int32 PCMDataSize = RawPCMData.Num() / sizeof(int16_t);
+	const int16_t *PCMData = reinterpret_cast<const int16_t *>(RawPCMData.GetData());
+	const int32 ChunkSizeSamples = static_cast<int32>(SampleRate * LipSyncSequenceDuration);
+	const int32 ChunkSize = NumChannels * ChunkSizeSamples;
+	const int32 FrameOffset = (int32)(FrameDelayInMs * SampleRate / 1000 * NumChannels);
+
+	float LaughterScore = 0.0f;
+	TArray<float> Visemes;
+	TArray<float> Scores;
+	Scores.Reserve((PCMDataSize / ChunkSize + 1) * FOVRLipSyncFrameData::NumScores);
+
+	TArray<int16_t> samples;
+	samples.SetNumUninitialized(ChunkSize);
+
+	for (int32 offs = 0; offs < PCMDataSize + FrameOffset; offs += ChunkSize)
+	{
+		if (bCancelled)
+		{
+			return false;
+		}
+		const int16_t *Chunk = samples.GetData();
+		const int32 remainingSamples = PCMDataSize - offs;
+		if (remainingSamples >= ChunkSize)
+		{
+			Chunk = PCMData + offs;
+		}
+		else
+		{
+			// The end of the audio, and the frames the delay keeps after it, are padded with silence.
+			const int32 CopiedSamples = FMath::Max(remainingSamples, 0);
+			if (CopiedSamples > 0)
+			{
+				FMemory::Memcpy(samples.GetData(), PCMData + offs, sizeof(int16_t) * CopiedSamples);
+			}
+			FMemory::Memzero(samples.GetData() + CopiedSamples, sizeof(int16_t) * (ChunkSize - CopiedSamples));
+		}
+		context.ProcessFrame(Chunk, ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
+
+		if (offs >= FrameOffset)
+		{
+			const int Frame = Scores.AddZeroed(FOVRLipSyncFrameData::NumScores);
+			FMemory::Memcpy(&Scores[Frame], Visemes.GetData(),
+							sizeof(float) * FMath::Min(Visemes.Num(), FOVRLipSyncFrameData::NumVisemes));
+			Scores[Frame + FOVRLipSyncFrameData::NumVisemes] = LaughterScore;
+		}
+	}
+	// Packed here, so the game thread only has to move the frames into the asset.
+	OutFrames.Pack(Scores.GetData(), Scores.Num() / FOVRLipSyncFrameData::NumScores, Quantization);
+	return true;
+}
+
+void FOVRLipSyncBatchBaker::WriteResults(double TimeBudget)
+{
+	const double EndTime = FPlatformTime::Seconds() + TimeBudget;
+	FBakedSoundWave Result;
+	do
+	{
+		if (!Baked.Dequeue(Result))
+		{
+			break;
+		}
+		// Only the frames are needed from here, the next sound wave can take its place.
+		Result.SoundWave.Reset();
+		--NumInFlight;
+		if (!Result.bBaked)
+		{
+			if (!bCancelled)
+			{
+				++NumFailed;
+			}
+			// Otherwise cut short, so neither baked nor failed.
+			continue;
+		}
+		const FAssetData &SoundWaveAsset = SoundWaveAssets[Result.Index];
+		UOVRLipSyncFrameSequence *Sequence = CreateSequenceAsset(SoundWaveAsset, MoveTemp(Result.Frames));
+		Sequence->SourceAudioHash = SourceAudioHashes[Result.Index];
+		Sequence->BakeSettings = BakeSettings;
+		++NumWritten;
+		OnSequenceBaked.ExecuteIfBound(SoundWaveAsset, Sequence);
+	} while (FPlatformTime::Seconds() < EndTime);
+	LoadNextSoundWaves();
+}
+
+bool FOVRLipSyncBatchBaker::IsDone() const
+{
+	return NumInFlight == 0 && (bCancelled || NextSoundWave == SoundWaveAssets.Num());
+}
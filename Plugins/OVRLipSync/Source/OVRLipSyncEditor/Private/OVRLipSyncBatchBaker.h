@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetRegistry/AssetData.h"
+#include "Containers/Queue.h"
+#include "OVRLipSyncFrame.h"
+#include "Sound/SoundWave.h"
+#include "Tasks/Task.h"
+#include "UObject/StrongObjectPtr.h"
+#include <atomic>
+
+/**
+ * Bakes the lip-sync sequences of many sound waves at once. Sound waves are loaded in the background, only as many at a
+ * time as there are workers, and each is baked by a task of its own which reads its imported audio and analyses it with
+ * a context borrowed from the pool, so editor audio keeps playing. The sequence assets are created on the game thread
+ * by WriteResults, a few at a time, which also lets go of the sound waves they were baked from and loads the next ones,
+ * so the editor stays responsive and memory stays bounded however many sound waves there are.
+ */
+class FOVRLipSyncBatchBaker
+{
+public:
+	/** A sound wave analysed by a worker, waiting for its sequence asset to be created. */
+	struct FBakedSoundWave
+	{
+		int32 Index = INDEX_NONE; ///< Of the sound wave in the assets the baker was created with.
+		bool bBaked = false;	  ///< false if it could not be loaded, read or analysed.
+		FOVRLipSyncFrameData Frames;
+		TStrongObjectPtr<USoundWave> SoundWave; ///< Kept loaded until the game thread takes the result.
+	};
+
+	/** The workers Start uses by default. Each holds the whole audio of the sound wave it bakes. */
+	static constexpr int32 DefaultMaxWorkers = 8;
+
+	/** Called on the game thread with each sequence asset created, and the sound wave it was baked from. */
+	DECLARE_DELEGATE_TwoParams(FOnSequenceBaked, const FAssetData & /*SoundWaveAsset*/, UOVRLipSyncFrameSequence *);
+
+	/**
+	 * Nothing is loaded until Start. Game thread.
+	 * @param SoundWaveAssets The sound waves, each baked into a sequence next to it.
+	 * @param bUseOfflineModel Whether to analyse with the offline model rather than the one built into the library.
+	 */
+	FOVRLipSyncBatchBaker(const TArray<FAssetData> &SoundWaveAssets, bool bUseOfflineModel);
+	// Cancels the bake and waits for the sound waves being loaded and baked.
+	~FOVRLipSyncBatchBaker();
+
+	/**
+	 * Starts loading the first sound waves, each baked as soon as it is loaded. Game thread.
+	 * @param MaxWorkers The most sound waves loaded or baking at once, never more than the task system has threads for.
+	 */
+	void Start(int32 MaxWorkers = DefaultMaxWorkers);
+
+	/** Stops the workers at their next frame. Sound waves already baked are still written. */
+	void Cancel();
+
+	/**
+	 * Creates the sequence assets of the sound waves baked so far, and starts loading as many sound waves as were
+	 * written. Game thread, which must also be loading packages asynchronously.
+	 * @param TimeBudget The seconds to spend, at least one asset is created if one is waiting.
+	 */
+	void WriteResults(double TimeBudget);
+
+	/** Whether every sound wave started has been baked and written, or failed. */
+	bool IsDone() const;
+
+	/** The sound waves finished so far, written or failed, out of GetNumSoundWaves. */
+	int32 GetNumFinished() const { return NumWritten + NumFailed; }
+	int32 GetNumFailed() const { return NumFailed; }
+	int32 GetNumSoundWaves() const { return SoundWaveAssets.Num(); }
+	bool IsCancelled() const { return bCancelled; }
+
+	/**
+	 * Gets the settings sequences are baked with, stored in each to tell whether it needs baking again. Includes a hash
+	 * of the model files, so call once per bake rather than per sequence.
+	 */
+	static FString GetBakeSettings(bool bUseOfflineModel);
+
+	/** Gets the path of the sequence baked from a sound wave, next to it. */
+	static FSoftObjectPath GetSequencePath(const FAssetData &SoundWaveAsset);
+
+	/** Gets the hash of the imported audio of a sound wave, stored in the sequences baked from it. */
+	static FString GetSourceAudioHash(const USoundWave &SoundWave);
+
+	FOnSequenceBaked OnSequenceBaked;
+
+private:
+	// Starts loading sound waves until MaxInFlight are loading, baking or waiting to be written.
+	void LoadNextSoundWaves();
+	// Starts the bake of a sound wave once its package has loaded. Game thread.
+	void OnSoundWaveLoaded(int32 Index, bool bLoaded);
+	// Reads the imported audio of a sound wave and analyses it, returning false if it could not be.
+	bool BakeSoundWave(int32 Index, USoundWave &SoundWave, FOVRLipSyncFrameData &OutFrames);
+
+	TArray<FAssetData> SoundWaveAssets;
+	TArray<FString> SourceAudioHashes; ///< Taken as each sound wave loads.
+	bool bUseOfflineModel = false;
+	FString BakeSettings;
+	// The precision new sequences default to, which the frames are packed at.
+	EOVRLipSyncScoreQuantization Quantization = EOVRLipSyncScoreQuantization::Bits8;
+
+	TArray<UE::Tasks::FTask> Bakes;
+	std::atomic<bool> bCancelled{ false };
+	TQueue<FBakedSoundWave, EQueueMode::Mpsc> Baked;
+
+	// Only touched by the game thread.
+	int32 MaxInFlight = 0;
+	int32 NextSoundWave = 0;
+	int32 NumInFlight = 0; ///< Sound waves loading, baking or waiting to be written.
+	TMap<int32, int32> LoadRequests; ///< The async loading request of each sound wave being loaded, by index.
+	int32 NumWritten = 0;
+	int32 NumFailed = 0;
+};
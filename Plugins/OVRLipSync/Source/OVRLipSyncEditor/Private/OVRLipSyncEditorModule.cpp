@@ -22,153 +22,72 @@
  ******************************************************************************/
 #include "ContentBrowserModule.h"
 
-#include "AssetRegistry/AssetRegistryModule.h"
-#include "AudioDecompress.h"
-#include "AudioDevice.h"
-#include "Sound/SoundWave.h"
+#include "Containers/Ticker.h"
 #include "Engine.h"
 #include "Framework/Commands/UIAction.h"
 #include "Framework/MultiBox/MultiBoxBuilder.h"
-#include "Misc/EngineVersionComparison.h"
-#include "Misc/ScopedSlowTask.h"
+#include "Framework/Notifications/NotificationManager.h"
 #include "Modules/ModuleManager.h"
-#include "OVRLipSyncContextWrapper.h"
-#include "OVRLipSyncFrame.h"
+#include "OVRLipSyncBatchBaker.h"
 #include "Textures/SlateIcon.h"
+#include "Widgets/Notifications/SNotificationList.h"
 
 namespace
 {
 
-// Compute LipSync sequence frames at 100 times a second rate
-constexpr auto LipSyncSequenceUpateFrequency = 100;
-constexpr auto LipSyncSequenceDuration = 1.0f / LipSyncSequenceUpateFrequency;
+// The seconds a frame spent creating baked sequence assets, so the editor stays responsive while the rest bake.
+constexpr double BakeWriteBudget = 0.005;
 
-// Decompresses SoundWave object by initializing RawPCM data
-bool DecompressSoundWave(USoundWave *SoundWave)
+FText GetBakeProgressText(const FOVRLipSyncBatchBaker &Baker)
 {
-	if (SoundWave->RawPCMData)
-	{
-		return true;
-	}
-	auto AudioDevice = GEngine->GetMainAudioDevice();
-	if (!AudioDevice)
-	{
-		return false;
-	}
-
-	AudioDevice->StopAllSounds(true);
-	auto OriginalDecompressionType = SoundWave->DecompressionType;
-	SoundWave->DecompressionType = DTYPE_Native;
-	if (SoundWave->InitAudioResource(SoundWave->GetRuntimeFormat()))
-	{
-#if UE_VERSION_OLDER_THAN(4, 22, 0)
-		USoundWave::FAsyncAudioDecompress Decompress(SoundWave);
-#else
-		USoundWave::FAsyncAudioDecompress Decompress(SoundWave, MONO_PCM_BUFFER_SAMPLES);
-#endif
-		Decompress.StartSynchronousTask();
-	}
-	SoundWave->DecompressionType = OriginalDecompressionType;
-
-	return true;
+	return FText::Format(NSLOCTEXT("NSLT_OVRLipSyncPlugin", "GeneratingLipSyncSequences",
+								   "Generating LipSync sequences: {0} of {1}..."),
+						 FText::AsNumber(Baker.GetNumFinished()), FText::AsNumber(Baker.GetNumSoundWaves()));
 }
 
-bool OVRLipSyncProcessSoundWave(const FAssetData &SoundWaveAsset, bool UseOfflineModel = false)
+// Bakes the sound waves in the background, with a notification showing progress that can cancel the bake.
+void OVRLipSyncCreateSequence(const TArray<FAssetData> SelectedSoundAssets, bool UseOfflineModel = false)
 {
-	auto ObjectPath = SoundWaveAsset.GetSoftObjectPath().ToString();
-	auto SoundWave = FindObject<USoundWave>(NULL, *ObjectPath);
-	if (!SoundWave)
-	{
-		UE_LOG(LogTemp, Error, TEXT("Can't find %s"), *ObjectPath);
-		return false;
-	}
-	if (SoundWave->NumChannels > 2)
+	TSharedRef<FOVRLipSyncBatchBaker> Baker = MakeShared<FOVRLipSyncBatchBaker>(SelectedSoundAssets, UseOfflineModel);
+
+	FNotificationInfo Info(GetBakeProgressText(*Baker));
+	Info.bFireAndForget = false;
+	Info.ExpireDuration = 3.0f;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		NSLOCTEXT("NSLT_OVRLipSyncPlugin", "CancelLipSyncSequences", "Cancel"),
+		NSLOCTEXT("NSLT_OVRLipSyncPlugin", "CancelLipSyncSequences_Tooltip",
+				  "Stops generating, keeping the sequences already generated"),
+		FSimpleDelegate::CreateLambda([WeakBaker = TWeakPtr<FOVRLipSyncBatchBaker>(Baker)]() {
+			if (auto PinnedBaker = WeakBaker.Pin())
+			{
+				PinnedBaker->Cancel();
+			}
+		}),
+		SNotificationItem::CS_Pending));
+	TSharedPtr<SNotificationItem> Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Notification)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Can't process %s: only mono and stereo streams are supported"), *ObjectPath);
-		return false;
+		Notification->SetCompletionState(SNotificationItem::CS_Pending);
 	}
-	DecompressSoundWave(SoundWave);
-
-	auto SequenceName = FString::Printf(TEXT("%s_LipSyncSequence"), *SoundWaveAsset.AssetName.ToString());
-	auto SequencePath = FString::Printf(TEXT("%s_LipSyncSequence"), *SoundWaveAsset.PackageName.ToString());
-	auto SequencePackage = CreatePackage(*SequencePath);
-	auto Sequence = NewObject<UOVRLipSyncFrameSequence>(SequencePackage, *SequenceName, RF_Public | RF_Standalone);
-
-	auto NumChannels = SoundWave->NumChannels;
-	auto SampleRate = SoundWave->GetSampleRateForCurrentPlatform();
-	auto PCMDataSize = SoundWave->RawPCMDataSize / sizeof(int16_t);
-	auto PCMData = reinterpret_cast<int16_t *>(SoundWave->RawPCMData);
-	auto ChunkSizeSamples = static_cast<int>(SampleRate * LipSyncSequenceDuration);
-	auto ChunkSize = NumChannels * ChunkSizeSamples;
 
-	FString ModelPath = UseOfflineModel ? FPaths::Combine(FPaths::ProjectPluginsDir(), TEXT("OVRLipSync"),
-														  TEXT("OfflineModel"), TEXT("ovrlipsync_offline_model.pb"))
-										: FString();
-	UOVRLipSyncContextWrapper context(ovrLipSyncContextProvider_Enhanced, SampleRate, 4096, ModelPath);
-
-	float LaughterScore = 0.0f;
-	int32_t FrameDelayInMs = 0;
-	TArray<float> Visemes;
-
-	TArray<int16_t> samples;
-	samples.SetNumZeroed(ChunkSize);
-	context.ProcessFrame(samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
-
-	int FrameOffset = (int)(FrameDelayInMs * SampleRate / 1000 * NumChannels);
-
-	FScopedSlowTask SlowTask(PCMDataSize + FrameOffset,
-							 FText::Format(NSLOCTEXT("NSLT_OVRLipSyncPlugin", "GeneratingLipSyncSequence",
-													 "Generating LipSync sequence for {0}..."),
-										   FText::FromName(SoundWaveAsset.AssetName)));
-	SlowTask.MakeDialog();
-	for (int offs = 0; offs < PCMDataSize + FrameOffset; offs += ChunkSize)
-	{
-		int remainingSamples = PCMDataSize - offs;
-		if (remainingSamples >= ChunkSize)
+	Baker->Start();
+	// The ticker owns the baker until it is done, so it is destroyed on the game thread.
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Baker, Notification](float) {
+		Baker->WriteResults(BakeWriteBudget);
+		const bool bDone = Baker->IsDone();
+		if (Notification)
 		{
-			context.ProcessFrame(PCMData + offs, ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs,
-								 NumChannels > 1);
-		}
-		else
-		{
-			if (remainingSamples > 0)
+			Notification->SetText(GetBakeProgressText(*Baker));
+			if (bDone)
 			{
-				memcpy(samples.GetData(), PCMData + offs, sizeof(int16_t) * remainingSamples);
-				memset(samples.GetData() + remainingSamples, 0, ChunkSize - remainingSamples);
+				const bool bSucceeded = !Baker->IsCancelled() && Baker->GetNumFailed() == 0;
+				Notification->SetCompletionState(bSucceeded ? SNotificationItem::CS_Success
+															: SNotificationItem::CS_Fail);
+				Notification->ExpireAndFadeout();
 			}
-			else
-			{
-				memset(samples.GetData(), 0, ChunkSize);
-			}
-			context.ProcessFrame(samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs,
-								 NumChannels > 1);
-		}
-
-		SlowTask.EnterProgressFrame(ChunkSize);
-		if (SlowTask.ShouldCancel())
-		{
-			return false;
 		}
-		if (offs >= FrameOffset)
-		{
-			Sequence->Add(Visemes, LaughterScore);
-		}
-	}
-
-	FAssetRegistryModule::AssetCreated(Sequence);
-	Sequence->MarkPackageDirty();
-	return true;
-}
-
-void OVRLipSyncCreateSequence(const TArray<FAssetData> SelectedSoundAssets, bool UseOfflineModel = false)
-{
-	for (auto &SoundWaveAsset : SelectedSoundAssets)
-	{
-		if (!OVRLipSyncProcessSoundWave(SoundWaveAsset, UseOfflineModel))
-		{
-			break;
-		}
-	}
+		return !bDone;
+	}));
 }
 
 void OVRLipSyncContextMenuExtension(FMenuBuilder &MenuBuilder, const TArray<FAssetData> SelectedSoundWavesPath)
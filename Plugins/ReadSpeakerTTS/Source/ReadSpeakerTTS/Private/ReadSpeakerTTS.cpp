@@ -1,1559 +1,2672 @@
-// Copyright 2022 ReadSpeaker AB. All Rights Reserved.
-
-#include "ReadSpeakerTTS.h"
-#include <stdlib.h>
-#include <algorithm>
-#include <fstream>
-#include <regex>
-#include <sstream>
-#include <vector>
-#if PLATFORM_ANDROID
-#include <dlfcn.h>
-#endif
-#include "Async/Async.h"
-#include "AudioDevice.h"
-#include "Components/AudioComponent.h"
-#include "Core.h"
-#include "Interfaces/IPluginManager.h"
-#include "Kismet/GameplayStatics.h"
-#include "Misc/ScopeTryLock.h"
-#include "Modules/ModuleManager.h"
-#include "RenderCore.h"
-#include "SampleBuffer.h"
-#include "Sound/SampleBufferIO.h"
-#include "Sound/SoundSubmix.h"
-#include "Sound/SoundWaveProcedural.h"
-#include "Templates/Function.h"
-#if WITH_EDITOR
-#include "ClassIconFinder.h"
-#include "DetailLayoutBuilder.h"
-#include "Editor/EditorEngine.h"
-#include "IDetailCustomization.h"
-#include "LevelEditor.h"
-#include "PropertyEditing.h"
-#include "Runtime/Launch/Resources/Version.h"
-#include "Styling/SlateStyle.h"
-#include "Styling/SlateStyleRegistry.h"
-#include "Widgets/Docking/SDockTab.h"
-#include "Widgets/Input/SButton.h"
-#include "Widgets/Layout/SBox.h"
-#include "Widgets/Text/STextBlock.h"
-#endif
-#if PLATFORM_ANDROID
-#include "Android/AndroidApplication.h"
-#include "Android/AndroidJNI.h"
-#endif
-#if defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-#include "VTmem.h"
-#endif
-
-
-extern "C" {
-#include "rsgame.h"
-}
-
-DEFINE_LOG_CATEGORY(LogReadSpeakerTTS);
-
-FCriticalSection FReadSpeakerTTSModule::AndroidMutex;
-FOnPauseAll FReadSpeakerTTSModule::FOnPauseAllDelegate;
-FOnResumeAll FReadSpeakerTTSModule::FOnResumeAllDelegate;
-FOnInterruptAll FReadSpeakerTTSModule::FOnInterruptAllDelegate;
-static TArray<UTTSEngine*> Engines;
-
-
-
-#define LOCTEXT_NAMESPACE "FReadSpeakerTTSModule"
-
-#if WITH_EDITOR
-
-TSharedRef< IDetailCustomization > FTTSSpeakerCustomization::MakeInstance()
-{
-    return MakeShareable(new FTTSSpeakerCustomization);
-}
-
-void FTTSSpeakerCustomization::CustomizeDetails(IDetailLayoutBuilder& DetailBuilder)
-{
-    TArray< TWeakObjectPtr< UObject > > Objects;
-    DetailBuilder.GetObjectsBeingCustomized(Objects);
-
-    TSharedRef< IPropertyHandle > EngineIDProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, EngineID));
-    TSharedRef< IPropertyHandle > VolumeProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Volume));
-    TSharedRef< IPropertyHandle > PitchProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Pitch));
-    TSharedRef< IPropertyHandle > SpeedProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Speed));
-    TSharedRef< IPropertyHandle > PauseProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Pause));
-    TSharedRef< IPropertyHandle > CommaPauseProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, CommaPause));
-
-    DetailBuilder.HideProperty(EngineIDProp);
-
-    if (Objects.Num() != 1)
-    {
-        return;
-    }
-
-    TWeakObjectPtr<UTTSSpeaker> MyObject = Cast<UTTSSpeaker>(Objects[0].Get());
-    IDetailCategoryBuilder& Cat = DetailBuilder.EditCategory(TEXT("Characteristics"));
-
-    auto OnRegenerate = [&DetailBuilder]
-    {
-        DetailBuilder.ForceRefreshDetails();
-    };
-
-    Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker"))
-        .WholeRowContent()
-        [
-            SNew(SHorizontalBox)
-            + SHorizontalBox::Slot()
-        .VAlign(VAlign_Center)
-        [
-            SNew(STextBlock)
-            .Text(LOCTEXT("VoiceNameText", "Voice"))
-        ]
-    + SHorizontalBox::Slot()
-        [
-            SNew(STTSVoiceCombo).SpeechCharacteristics(MyObject).OnStateChanged_Lambda(OnRegenerate)
-        ]
-        ];
-
-    UTTSEngine* Engine = FReadSpeakerTTSModule::GetEngineByID(MyObject->EngineID);
-    if (Engine != NULL) {
-        FString EngineName = Engine->Name;
-        FString EngineType = Engine->Type;
-        FString EngineLang = Engine->Language;
-        FString EngineGender = Engine->Gender;
-
-        Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker")).WholeRowContent()
-            [
-                SNew(SVerticalBox)
-                + SVerticalBox::Slot().Padding(5)
-            [
-                SNew(SHorizontalBox)
-                + SHorizontalBox::Slot()[
-                    SNew(STextBlock).Text(FText::FromString("Name: " + EngineName))
-                ]
-            + SHorizontalBox::Slot()[
-                SNew(STextBlock).Text(FText::FromString("Type: " + EngineType))
-            ]
-            ]
-        + SVerticalBox::Slot().Padding(5)
-            [
-                SNew(SHorizontalBox)
-                + SHorizontalBox::Slot()[
-                    SNew(STextBlock).Text(FText::FromString("Language: " + EngineLang))
-                ]
-            + SHorizontalBox::Slot()[
-                SNew(STextBlock).Text(FText::FromString("Gender: " + EngineGender))
-            ]
-            ]
-            ];
-    }
-    
-
-    if (GEditor && !GEditor->PlayWorld) {
-        Cat.AddProperty(VolumeProp);
-        Cat.AddProperty(PitchProp);
-        Cat.AddProperty(SpeedProp);
-        Cat.AddProperty(PauseProp);
-        Cat.AddProperty(CommaPauseProp);
-
-        auto OnPreview = [MyObject]
-        {
-            if (MyObject.IsValid())
-            {
-                MyObject->Preview();
-            }
-            return FReply::Handled();
-        };
-
-
-        Cat.AddCustomRow(LOCTEXT("PreviewButton", "Preview"))
-            .WholeRowContent()
-            [
-                SNew(SButton)
-                .Text(LOCTEXT("PreviewButtonText", "Preview"))
-            .OnClicked_Lambda(OnPreview)
-            ];
-    }
-    else {
-        DetailBuilder.HideProperty(VolumeProp);
-        DetailBuilder.HideProperty(PitchProp);
-        DetailBuilder.HideProperty(SpeedProp);
-        DetailBuilder.HideProperty(PauseProp);
-        DetailBuilder.HideProperty(CommaPauseProp);
-
-        Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker")).WholeRowContent()
-            [
-                SNew(SVerticalBox)
-                + SVerticalBox::Slot().Padding(5)
-            [
-                SNew(SHorizontalBox)
-                + SHorizontalBox::Slot()[
-                    SNew(STextBlock).Text(FText::FromString("Exit Play Mode to customize Speaker properties."))
-                ]
-            ]
-            ];
-    }
-}
-
-void UTTSSpeaker::Preview() {
-    FReadSpeakerTTSModule::Init();
-    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
-    UTTSConverter* converter = NewObject<UTTSConverter>();
-    converter->Text = "I sound like this";
-    converter->Volume = Volume;
-    converter->Pitch = Pitch;
-    converter->Speed = Speed;
-    converter->Pause = Pause;
-    converter->CommaPause = CommaPause;
-    converter->TextType = TTSTextType::Normal;
-    converter->Engine = Engine;
-    converter->ConvertToBuffer();
-    USoundWaveProceduralTTS *SoundWave = NewObject<USoundWaveProceduralTTS>();
-    SoundWave->SetSampleRate(Engine->Sampling);
-    SoundWave->TTSData = converter->GetAudioData();
-    SoundWave->FillAudioQueue(converter->GetAudioData().Num());
-    UGameplayStatics::PlaySound2D(GEditor->GetEditorWorldContext().World(), SoundWave, 1, 1, 0);
-}
-#endif
-
-void FReadSpeakerTTSModule::StartupModule()
-{
-    FString BaseDir = IPluginManager::Get().FindPlugin("ReadSpeakerTTS")->GetBaseDir();
-
-    FString VTAPILibraryPath;
-    FString RSGameLibraryPath;
-
-#if PLATFORM_WINDOWS
-    VTAPILibraryPath = VTAPI_WIN64_LIB;
-    RSGameLibraryPath = RSGAME_WIN64_LIB;
-#elif PLATFORM_LINUX
-    VTAPILibraryPath = VTAPI_LINUX_LIB;
-    RSGameLibraryPath = RSGAME_LINUX_LIB;
-#elif defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
-    VTAPILibraryPath = VTAPI_PS5_LIBNAME;
-    RSGameLibraryPath = RSGAME_PS5_LIBNAME;
-#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
-    VTAPILibraryPath = VTAPI_PS4_LIB;
-    RSGameLibraryPath = RSGAME_PS4_LIB;
-#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
-    VTAPILibraryPath = VTAPI_XSX_LIB;
-    RSGameLibraryPath = RSGAME_XSX_LIB;
-#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-    VTAPILibraryPath = VTAPI_SWITCH_LIB;
-    RSGameLibraryPath = RSGAME_SWITCH_LIB;
-#elif PLATFORM_ANDROID
-    return;
-#endif
-
-#if !defined(PLATFORM_SWITCH) || (defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 0)
-    VTAPILibraryHandle = !VTAPILibraryPath.IsEmpty() ? FPlatformProcess::GetDllHandle(*VTAPILibraryPath) : nullptr;
-
-    if (!VTAPILibraryHandle)
-    {
-        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ThirdPartyLibraryError", "Failed to load VTAPI."));
-    }
-
-    RSGameLibraryHandle = !RSGameLibraryPath.IsEmpty() ? FPlatformProcess::GetDllHandle(*RSGameLibraryPath) : nullptr;
-
-    if (!RSGameLibraryHandle)
-    {
-        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ThirdPartyLibraryError", "Failed to load RSGame."));
-    }
-#endif
-
-#if WITH_EDITOR
-    auto& PropertyModule = FModuleManager::LoadModuleChecked< FPropertyEditorModule >("PropertyEditor");
-    PropertyModule.RegisterCustomClassLayout(
-        "TTSSpeaker",
-        FOnGetDetailCustomizationInstance::CreateStatic(&FTTSSpeakerCustomization::MakeInstance)
-    );
-    PropertyModule.NotifyCustomizationModuleChanged();
-
-    StyleSet->SetContentRoot(FPaths::EngineContentDir() / TEXT("Editor/Slate"));
-    StyleSet->SetCoreContentRoot(FPaths::EngineContentDir() / TEXT("Slate"));
-
-    FString IconPath = FPaths::Combine(*BaseDir, TEXT("Resources/ButtonIcon_40x.png"));
-
-    StyleSet->Set("ClassIcon.TTSSpeaker", new FSlateImageBrush(IconPath, FVector2D(16.0f, 16.0f)));
-
-    FSlateStyleRegistry::RegisterSlateStyle(StyleSet.Get());
-#endif
-}
-
-
-void FReadSpeakerTTSModule::ShutdownModule()
-{
-#if WITH_EDITOR
-    if (FModuleManager::Get().IsModuleLoaded("PropertyEditor"))
-    {
-        auto& PropertyModule = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
-        PropertyModule.UnregisterCustomClassLayout("SpeechCharacteristics");
-        PropertyModule.UnregisterCustomClassLayout("TTSSpeaker");
-    }
-    
-    FSlateStyleRegistry::UnRegisterSlateStyle(StyleSet.Get());
-    ensure(StyleSet.IsUnique());
-#endif
-
-    FPlatformProcess::FreeDllHandle(VTAPILibraryHandle);
-    FPlatformProcess::FreeDllHandle(RSGameLibraryHandle);
-    VTAPILibraryHandle = nullptr;
-    RSGameLibraryHandle = nullptr;
-}
-
-void FReadSpeakerTTSModule::GetEngines(TArray<UTTSEngine*> *EngineArr) {
-#if PLATFORM_ANDROID
-    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
-    {
-        static jmethodID GetEngineCountMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetEngineCountReadSpeaker", "()I", false);
-        static jmethodID GetEngineInfoOfIndexMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetEngineInfoOfIndexReadSpeaker", "(I)[Ljava/lang/String;", false);
-
-        int engineCount = FJavaWrapper::CallIntMethod(Env, FJavaWrapper::GameActivityThis, GetEngineCountMethod);
-        
-		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Number of installed engines is: %d"), engineCount);
-        
-        for (int i = 0; i < engineCount; i++) {
-            jint index = i;
-            jobjectArray arr = (jobjectArray)FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, GetEngineInfoOfIndexMethod, index);
-        
-            std::vector<FString> engineFields;
-            int fieldCount = Env->GetArrayLength(arr);
-            
-            for (int j = 0; j < fieldCount; j++) {
-                jstring obj = (jstring)Env->GetObjectArrayElement(arr, j);
-                const char* raw = Env->GetStringUTFChars(obj, 0);
-                FString fstr = FString(UTF8_TO_TCHAR(raw));
-				UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine field %d is %s"), j, *fstr);
-                engineFields.push_back(fstr);
-            }
-            
-            if (engineFields.size() < 4) {
-				UE_LOG(LogReadSpeakerTTS, Display, TEXT("Corrupted VT engine information"));
-            }
-            else {
-                RecieveEngineCallback((void*)EngineArr, TCHAR_TO_UTF8(*engineFields[0]), TCHAR_TO_UTF8(*engineFields[1]), TCHAR_TO_UTF8(*engineFields[2]), TCHAR_TO_UTF8(*engineFields[3]), TCHAR_TO_UTF8(*engineFields[4]), TCHAR_TO_UTF8(*engineFields[5]), FCString::Atoi(*engineFields[6]), FCString::Atoi(*engineFields[7]));
-            }
-        }
-    }
-#else
-    RSGame_GetEngines(&RecieveEngineCallback, (void*)EngineArr);
-#endif
-}
-
-void FReadSpeakerTTSModule::RecieveEngineCallback(void* context, char* speaker, char* type, char* language, char* gender, char* dbPath, char* version, int sampling, int channels) {
-    TArray<UTTSEngine*>* EngineArr = reinterpret_cast<TArray<UTTSEngine*>*>(context);
-    UTTSEngine* eng = NewObject<UTTSEngine>();
-    eng->AddToRoot();
-    eng->Name = speaker;
-    eng->Type = type;
-    eng->Language = language;
-    eng->Gender = gender;
-    eng->Version = version;
-    eng->Sampling = sampling;
-    eng->Channels = channels;
-    std::string niceName(speaker);
-    std::string niceType(type);
-    niceName[0] = std::toupper(niceName[0], std::locale());
-    niceType[0] = std::toupper(niceType[0], std::locale());
-    std::string niceID = std::string(niceName + " " + niceType);
-    eng->ID = niceID.c_str();
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* comp = Engines[i];
-        if (comp->Name.Equals(eng->Name) && comp->Type.Equals(eng->Type))
-            return;
-    }
-
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Found engine %s, %s, %s, %s, %s, %s, %d, %d"), UTF8_TO_TCHAR(speaker), UTF8_TO_TCHAR(type), UTF8_TO_TCHAR(language), UTF8_TO_TCHAR(gender), UTF8_TO_TCHAR(dbPath), UTF8_TO_TCHAR(version), sampling, channels);
-    EngineArr->Add(eng);
-}
-
-
-void FReadSpeakerTTSModule::RefreshVoiceEngineInstallations() {
-#if WITH_EDITOR
-#if defined(VTAPI_WIN64)
-    RSGame_CreateConfFile((char*)VTAPI_WIN64_DB, (char*)VTAPI_WIN64_DB);
-#endif
-#if defined(VTAPI_LINUX)
-    RSGame_CreateConfFile((char*)VTAPI_LINUX_DB, (char*)VTAPI_LINUX_DB);
-#endif
-#if defined(VTAPI_ANDROID)
-    RSGame_CreateConfFileCustom((char*)VTAPI_ANDROID_SOURCEDB, (char*)VTAPI_ANDROID_SOURCEDB, (char*)"");
-#endif
-#if defined(VTAPI_PS4)
-    RSGame_CreateConfFileCustom((char*)VTAPI_PS4_SOURCEDB, (char*)VTAPI_PS4_SOURCEDB, (char*)VTAPI_PS4_DB);
-#endif
-#if defined(VTAPI_PS5)
-    RSGame_CreateConfFileCustom((char*)VTAPI_PS5_SOURCEDB, (char*)VTAPI_PS5_SOURCEDB, (char*)VTAPI_PS5_DB);
-#endif
-#if defined(VTAPI_XSX)
-    RSGame_CreateConfFileCustom((char*)VTAPI_XSX_SOURCEDB, (char*)VTAPI_XSX_SOURCEDB, (char*)VTAPI_XSX_DB);
-#endif
-#if defined(VTAPI_SWITCH)
-    RSGame_CreateConfFileCustom((char*)VTAPI_SWITCH_SOURCEDB, (char*)VTAPI_SWITCH_SOURCEDB, (char*)VTAPI_SWITCH_DB);
-#endif
-#else
-#if PLATFORM_WINDOWS
-    RSGame_CreateConfFile((char*)VTAPI_WIN64_DB, (char*)VTAPI_WIN64_DB);
-#endif
-#if PLATFORM_LINUX
-    RSGame_CreateConfFile((char*)VTAPI_LINUX_DB, (char*)VTAPI_LINUX_DB);
-#endif
-#if PLATFORM_ANDROID
-    FReadSpeakerTTSModule::RefreshVoiceEngineInstallations_Android();
-#endif
-#endif
-}
-
-#if PLATFORM_ANDROID
-std::vector<std::string> StrSplit(std::string input, char delim) {
-    std::vector<std::string> result;
-
-    size_t pos_start = 0;
-    size_t pos_end;
-
-    std::string token;
-    std::vector<std::string> res;
-
-    while ((pos_end = input.find(delim, pos_start)) != std::string::npos) {
-        token = input.substr(pos_start, pos_end - pos_start);
-        pos_start = pos_end + 1;
-        res.push_back(token);
-    }
-
-    res.push_back(input.substr(pos_start));
-
-    return res;
-}
-#endif
-
-#if PLATFORM_ANDROID
-void RewriteCRLFAsLF(std::string inpath, std::string outpath) {
-
-    FString in = FString(UTF8_TO_TCHAR(inpath.c_str()));
-    FString out = FString(UTF8_TO_TCHAR(outpath.c_str()));
-
-    int c;
-
-    FILE* ifp = fopen(inpath.c_str(), "rb");
-    FILE* ofp = fopen(outpath.c_str(), "wb");
-
-    while ((c = getc(ifp)) != EOF) {
-        if (c == '\r') {
-            putc('\n', ofp);
-            c = getc(ifp);
-
-            if (c == EOF) break;
-            if (c == '\n') continue;
-
-        }
-        putc(c, ofp);
-    }
-
-    fclose(ifp);
-    fclose(ofp);
-}
-#endif
-
-#if PLATFORM_ANDROID
-void FReadSpeakerTTSModule::RefreshVoiceEngineInstallations_Android() {
-
-    extern FString GFilePathBase;
-    FString BaseDir = GFilePathBase;
-
-#if ENGINE_MAJOR_VERSION == 4
-    BaseDir += FString("/UE4Game/");
-#else
-    BaseDir += FString("/UnrealGame/");
-#endif
-
-    FString iniPath = VTAPI_ANDROID_DB(BaseDir);
-
-    FString vtPath = FPaths::Combine(*iniPath, TEXT("vtpath.ini"));
-    FString tmpPath = FPaths::Combine(*iniPath, TEXT("tmp.ini"));
-
-    std::ifstream file(TCHAR_TO_UTF8(*vtPath), std::ios_base::binary);
-    std::ofstream fileout(TCHAR_TO_UTF8(*tmpPath), std::ios_base::binary);
-
-    std::string line;
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string result;
-        if (std::getline(iss, result)) {
-            if (result.find("Path") != std::string::npos) {
-                int separatorindex = result.find(':');
-
-                std::string toAppend(TCHAR_TO_UTF8(*iniPath));
-                std::vector<std::string> frags = StrSplit(result, '/');
-                toAppend += "/" + frags[frags.size() - 3] + "/" + frags[frags.size() - 2];
-                std::string newLine = result.replace(separatorindex + 1, result.length(), toAppend);
-                FString NEWLINE(newLine.c_str());
-
-                fileout << newLine << "\n";
-            }
-            else {
-                fileout << result << "\n";
-            }
-        }
-    }
-
-    fileout.close();
-
-    if (file.bad()) {
-		UE_LOG(LogReadSpeakerTTS, Display, TEXT("IO Error"));
-        file.close();
-    }
-    else if (!file.eof()) {
-		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Format Error"));
-        file.close();
-    }
-    else {
-        file.close();
-
-        int ret = -1;
-        ret = std::remove(TCHAR_TO_UTF8(*vtPath));
-        if (ret != 0) {
-			UE_LOG(LogReadSpeakerTTS, Display, TEXT("Failed to remove file %d"), ret);
-        }
-
-        RewriteCRLFAsLF(std::string(TCHAR_TO_UTF8(*tmpPath)), std::string(TCHAR_TO_UTF8(*vtPath)));
-
-        ret = std::remove(TCHAR_TO_UTF8(*tmpPath));
-        if (ret != 0) {
-			UE_LOG(LogReadSpeakerTTS, Display, TEXT("Failed to remove file %d"), ret);
-        }
-    }
-}
-#endif
-
-READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngine(FString name, FString type)
-{
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Name.Equals(name) && eng->Type.Equals(type))
-            return eng;
-    }
-    return nullptr;
-}
-
-READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineByID(FString id)
-{
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->ID.Equals(id))
-            return eng;
-    }
-    return nullptr;
-}
-
-READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithLanguage(FString lang)
-{
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Language.Equals(lang))
-            return eng;
-    }
-    return nullptr;
-}
-
-READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithGender(FString gender)
-{
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Gender.Equals(gender))
-            return eng;
-    }
-    return nullptr;
-}
-
-READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithLanguageAndGender(FString lang, FString gender)
-{
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Language.Equals(lang) && eng->Gender.Equals(gender))
-            return eng;
-    }
-    return nullptr;
-}
-
-READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithLanguage(FString lang)
-{
-    TArray<UTTSEngine*> tmp;
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Language.Equals(lang))
-            tmp.Add(eng);
-    }
-    return tmp;
-}
-
-READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithGender(FString gender)
-{
-    TArray<UTTSEngine*> tmp;
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Gender.Equals(gender))
-            tmp.Add(eng);
-    }
-    return tmp;
-}
-
-READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithLanguageAndGender(FString lang, FString gender)
-{
-    TArray<UTTSEngine*> tmp;
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Language.Equals(lang) && eng->Gender.Equals(gender))
-            tmp.Add(eng);
-    }
-    return tmp;
-}
-
-READSPEAKERTTS_API TArray<FString> FReadSpeakerTTSModule::GetAvailableLanguages()
-{
-    TArray<FString> tmp;
-    for (int i = 0; i < Engines.Num(); i++) {
-        FString lang = Engines[i]->Language;
-        if (!tmp.Contains(lang))
-            tmp.Add(lang);
-    }
-    return tmp;
-}
-
-READSPEAKERTTS_API TArray<FString> FReadSpeakerTTSModule::GetAvailableGendersForLanguage(FString lang)
-{
-    TArray<FString> tmp;
-    for (int i = 0; i < Engines.Num(); i++) {
-        UTTSEngine* eng = Engines[i];
-        if (eng->Language.Equals(lang)) 
-        {
-            if (!tmp.Contains(eng->Gender))
-                tmp.Add(eng->Gender);
-        }
-    }
-    return tmp;
-}
-
-int FReadSpeakerTTSModule::LoadTTS(FString libPath, FString iniPath) {
-#if PLATFORM_ANDROID
-    return -1;
-#else
-    int ret = -1;
-    RSGAME_CONF_HANDLE conf_handle = RSGame_CreateConfHandle(TCHAR_TO_ANSI(*iniPath));
-    RSGAME_LIB_HANDLE lib_handle = RSGame_CreateLibHandle(TCHAR_TO_ANSI(*libPath));
-
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Conf_handle: %s, lib_hande: %s"), UTF8_TO_TCHAR(conf_handle), UTF8_TO_TCHAR(lib_handle));
-
-#if defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-    VT_initialize();
-    VT_ro_initialize();
-#endif
-
-#if (defined(PLATFORM_PS4) && PLATFORM_PS4 == 1) || (defined(PLATFORM_PS5) && PLATFORM_PS5 == 1)
-    ret = RSGame_InitializeSeparated(lib_handle, conf_handle);
-#else
-    ret = RSGame_Initialize(lib_handle, conf_handle);
-#endif
-
-    if (ret != 0) {
-		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Failed to load TTS modules at %s, return code: %d"), *libPath, ret);
-    }
-    else {
-        FString rsgame_version = FString(RSGame_GetVersion());
-        FString vtapi_version = FString(RSGame_GetVTAPIVersion());
-        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Initialized succesfully. RSGame version=%s, VTAPI version=%s"), *rsgame_version, *vtapi_version);
-    }
-    return ret;
-#endif
-}
-
-void FReadSpeakerTTSModule::ClearLastSession() {
-#if PLATFORM_ANDROID
-    return;
-#else
-    RSGame_Exit();
-#endif
-}
-
-int FReadSpeakerTTSModule::Init() {
-
-
-    FReadSpeakerTTSModule::RefreshVoiceEngineInstallations();
-
-#if PLATFORM_ANDROID
-
-    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
-    {
-        extern FString GFilePathBase;
-        FString BaseDir = GFilePathBase;
-
-#if ENGINE_MAJOR_VERSION == 4
-        BaseDir += FString("/UE4Game/")
-#else
-        BaseDir += FString("/UnrealGame/");
-#endif
-
-        FString iniPath = VTAPI_ANDROID_DB(BaseDir);
-        FString licPath = VTAPI_ANDROID_LICDIR(BaseDir);
-        
-		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Initializing for android using paths: %s, %s"), *iniPath, *licPath);
-
-        jstring iniPathFinal = Env->NewStringUTF(TCHAR_TO_UTF8(*iniPath));
-        jstring licPathFinal = Env->NewStringUTF(TCHAR_TO_UTF8(*licPath));
-
-        static jmethodID Method = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_InitReadSpeaker", "(Ljava/lang/String;Ljava/lang/String;Z)V", false);
-
-        FJavaWrapper::CallVoidMethod(Env, FJavaWrapper::GameActivityThis, Method, iniPathFinal, licPathFinal, true);
-
-        Engines = TArray<UTTSEngine*>();
-        FReadSpeakerTTSModule::GetEngines(&Engines);
-
-        return 0;
-    }
-    else {
-        return -1;
-    }
-#else
-
-    FString BaseDir = IPluginManager::Get().FindPlugin("ReadSpeakerTTS")->GetBaseDir();
-    int ret = -1;
-
-    FString LibraryPath;
-    FString DbPath;
-
-#if PLATFORM_WINDOWS
-    LibraryPath = VTAPI_WIN64_LIBDIR;
-    DbPath = VTAPI_WIN64_DB;
-#elif PLATFORM_LINUX
-    LibraryPath = VTAPI_LINUX_LIBDIR;
-    DbPath = VTAPI_LINUX_DB;
-#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
-    LibraryPath = VTAPI_PS4_LIBDIR;
-    DbPath = VTAPI_PS4_DB;
-#elif defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
-    LibraryPath = VTAPI_PS5_LIBDIR;
-    DbPath = VTAPI_PS5_DB;
-#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
-    LibraryPath = VTAPI_XSX_LIBDIR;
-    DbPath = VTAPI_XSX_DB;
-#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-    LibraryPath = VTAPI_SWITCH_LIBDIR;
-    DbPath = VTAPI_SWITCH_DB;
-#endif
-
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Loading TTS with path: %s and %s"), *LibraryPath, *DbPath);
-
-    ret = LoadTTS(LibraryPath, DbPath);
-
-    Engines = TArray<UTTSEngine*>();
-    FReadSpeakerTTSModule::GetEngines(&Engines);
-
-    return ret;
-#endif
-}
-
-void FReadSpeakerTTSModule::PauseAll() {
-    FOnPauseAllDelegate.Broadcast();
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----PAUSING ALL----"));
-}
-
-void FReadSpeakerTTSModule::ResumeAll() {
-    FOnResumeAllDelegate.Broadcast();
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----RESUMING ALL----"));
-}
-
-void FReadSpeakerTTSModule::InterruptAll() {
-    FOnInterruptAllDelegate.Broadcast();
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----INTERRUPTING ALL----"));
-}
-
-void FReadSpeakerTTSModule::BindSpeaker(UTTSSpeaker *speaker)
-{
-    FOnPauseAllDelegate.AddUObject(speaker, &UTTSSpeaker::PauseSpeaking);
-    FOnResumeAllDelegate.AddUObject(speaker, &UTTSSpeaker::ResumeSpeaking);
-    FOnInterruptAllDelegate.AddUObject(speaker, &UTTSSpeaker::InterruptSpeaking);
-}
-
-void FReadSpeakerTTSModule::UnbindSpeaker(UTTSSpeaker* speaker) {
-    FOnPauseAllDelegate.RemoveAll(speaker);
-    FOnResumeAllDelegate.RemoveAll(speaker);
-    FOnInterruptAllDelegate.RemoveAll(speaker);
-}
-
-#undef LOCTEXT_NAMESPACE
-
-IMPLEMENT_MODULE(FReadSpeakerTTSModule, ReadSpeakerTTS)
-
-UTTSEngine::UTTSEngine(const FObjectInitializer& ObjectInitializer) : UObject(ObjectInitializer) { }
-
-bool UTTSEngine::UseLicenseFile() {
-#if defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
-    return true;
-#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
-    return true;
-#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
-    return true;
-#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-    return true;
-#elif PLATFORM_WINDOWS
-    FILE* file;
-    if (errno_t err = fopen_s(&file, (char*)VTAPI_WIN64_LIC, "r") == 0) {
-        fclose(file);
-        return true;
-    }
-    else {
-        return false;
-    }
-#elif PLATFORM_LINUX
-    if (FILE* file = fopen((char*)VTAPI_WIN64_LIC, "r")) {
-        fclose(file);
-        return true;
-    }
-    else {
-        return false;
-    }
-#elif defined(PLATFORM_ANDROID) && PLATFORM_ANDROID == 1
-    return false;
-#else
-    return false;
-#endif
-}
-
-FString UTTSEngine::GetLicensePath() {
-#if defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
-    return VTAPI_PS5_LIC;
-#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
-    return VTAPI_PS4_LIC;
-#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
-    return VTAPI_XSX_LIC;
-#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
-    return VTAPI_SWITCH_LIC;
-#elif PLATFORM_WINDOWS
-    return VTAPI_WIN64_LIC;
-#elif PLATFORM_LINUX
-    return VTAPI_LINUX_LIC;
-#else
-    return "";
-#endif
-}
-
-int UTTSEngine::Acquire()
-{
-#if PLATFORM_ANDROID
-    return -1;
-#else
-    int ret = 0;
-    if (ReferenceCount == 0 && !KeepInMemory) {
-
-        if (UseLicenseFile()) {
-            ret = RSGame_LoadEngine_LicFile(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type), TCHAR_TO_ANSI(*GetLicensePath()));
-        }
-        else
-        {
-            ret = RSGame_LoadEngine(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type));
-        }
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to be acquired, return code %d"), *Name, ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was acquired"), *Name);
-        }
-    }
-    ReferenceCount++;
-    return ret;
-#endif
-}
-
-int UTTSEngine::Release()
-{
-#if PLATFORM_ANDROID
-    return -1;
-#else
-    int ret = 0;
-    ReferenceCount--;
-
-    if (ReferenceCount == 0 && !KeepInMemory) {
-        ret = RSGame_UnloadEngine(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type));
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to unload, return code %d"), *Name, ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was released"), *Name);
-        }
-    }
-    return ret;
-#endif
-}
-
-int UTTSEngine::LoadEngine()
-{
-#if PLATFORM_ANDROID
-    return -1;
-#else
-    {
-#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
-        FScopeLock ScopeLock = FScopeLock(&(this->EngineMutex));
-#else
-        FScopeLock(&(this->EngineMutex));
-#endif
-
-        int ret = -1;
-        if (ReferenceCount == 0) {
-
-            if (UseLicenseFile()) {
-                ret = RSGame_LoadEngine_LicFile(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type), TCHAR_TO_ANSI(*GetLicensePath()));
-            }
-            else
-            {
-                ret = RSGame_LoadEngine(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type));
-            }
-
-            if (ret != 0) {
-                UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed load, return code %d"), *Name, ret);
-            }
-            else {
-                UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was loaded"), *Name);
-            }
-        }
-        KeepInMemory = true;
-
-#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
-        ScopeLock.Unlock();
-#endif
-        return ret;
-    }
-#endif
-}
-
-int UTTSEngine::UnloadEngine()
-{
-#if PLATFORM_ANDROID
-    return -1;
-#else
-    {
-#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
-        FScopeLock ScopeLock = FScopeLock(&(this->EngineMutex));
-#else
-        FScopeLock(&(this->EngineMutex));
-#endif
-
-        int ret = -1;
-        if (ReferenceCount == 0) {
-            ret = RSGame_UnloadEngine(TCHAR_TO_UTF8(*Name), TCHAR_TO_UTF8(*Type));
-            if (ret != 0) {
-                UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to unload, return code %d"), *Name, ret);
-            }
-            else {
-                UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was unloaded"), *Name);
-            }
-        }
-        KeepInMemory = false;
-
-#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
-        ScopeLock.Unlock();
-#endif
-        return 0;
-    }
-#endif
-}
-
-READSPEAKERTTS_API FString UTTSEngine::GetID() {
-    return ID;
-}
-
-USoundWaveProceduralTTS::USoundWaveProceduralTTS(const FObjectInitializer& ObjectInitializer) : USoundWaveProcedural(ObjectInitializer)
-{
-    NumChannels = 1;
-    bCanProcessAsync = false;
-    bLooping = false;
-    SampleRate = 22050;
-    NumSamplesToGeneratePerCallback = 32768;
-    bProcedural = true;
-}
-
-void USoundWaveProceduralTTS::SetAudioData(TArray<int16> data) {
-    TTSData = data;
-    Length = CalculateAudioDuration();
-    RemainingDuration = Length;
-}
-
-double USoundWaveProceduralTTS::CalculateAudioDuration() {
-    return (double)((double)TTSData.Num() / ((double)TTSSampleRate / (double)NumChannels / ((double)TTSBitDepth / 16)));
-}
-
-void USoundWaveProceduralTTS::FillAudioQueue(int32 SamplesRequested)
-{
-    const int32 QueuedSamples = GetAvailableAudioByteCount() / sizeof(int16);
-    const int32 SamplesNeeded = SamplesRequested - QueuedSamples;
-
-    SampleData.Reset(SamplesNeeded);
-
-    for (int32 i = 0; i < SamplesNeeded && i < TTSData.Num(); ++i) {
-        int16 sample = TTSData[i];
-        SampleData.Add(sample);
-    }
-
-    QueueAudio((uint8*)(SampleData.GetData()), SampleData.Num() * sizeof(int16));
-}
-
-void USoundWaveProceduralTTS::SetSampleRate(int32 Sampling) {
-    SampleRate = Sampling;
-}
-
-UTTSConverter::UTTSConverter(const FObjectInitializer& ObjectInitializer) : UObject(ObjectInitializer) {
-    SoundWave = NewObject<USoundWaveProceduralTTS>();
-    SoundWave->AddToRoot();
-}
-
-void UTTSConverter::BeginDestroy() {
-    if (Task != NULL) {
-        Task->EnsureCompletion();
-    }
-    Super::BeginDestroy();
-}
-
-void UTTSConverter::audio_callback(void* context, char* data, int* length)
-{
-    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
-    converter->RecieveAudioCallback(data, length);
-}
-
-void UTTSConverter::word_callback(void* context, int* startPos, int* endPos, float* time, int* length) {
-    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
-    converter->RecieveWordCallback(startPos, endPos, time, length);
-}
-
-void UTTSConverter::viseme_callback(void* context, short* visemeId, float* time, int* length) {
-    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
-    converter->RecieveVisemeCallback(visemeId, time, length);
-}
-
-void UTTSConverter::mark_callback(void* context, char* markName, float* time, int* length) {
-    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
-    converter->RecieveMarkCallback(markName, time, length);
-}
-
-void UTTSConverter::ConvertToBufferAsync() {
-    Task = new FAsyncTask<FTTSSynthesizeTask>(TWeakObjectPtr<UTTSConverter>(this), false);
-    Task->StartBackgroundTask();
-}
-
-void UTTSConverter::ConvertToBufferAsync_SyncInfo() {
-    Task = new FAsyncTask<FTTSSynthesizeTask>(TWeakObjectPtr<UTTSConverter>(this), true);
-    Task->StartBackgroundTask();
-}
-
-void UTTSConverter::ConvertToBuffer()
-{
-    int ret = -1;
-
-#if PLATFORM_ANDROID
-    if (Engine == NULL) {
-		UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
-        return;
-    }
-
-    SoundWave->SetSampleRate(Engine->Sampling);
-
-    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
-    {
-        jmethodID TextToBufferMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_TextToBufferReadSpeaker", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;IIIIII)[B", false);
-
-        jstring text = Env->NewStringUTF(TCHAR_TO_UTF8(*Text));
-        jstring engName = Env->NewStringUTF(TCHAR_TO_UTF8(*(Engine->Name)));
-        jstring engType = Env->NewStringUTF(TCHAR_TO_UTF8(*(Engine->Type)));
-        
-        jbyteArray arr = (jbyteArray)FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, TextToBufferMethod, text, engName, engType, Volume, Pitch, Speed, Pause, CommaPause, (int)TextType);
-        
-        int count = Env->GetArrayLength(arr);
-        
-        jbyte* b = Env->GetByteArrayElements(arr, 0);
-        RecieveAudioCallback((char*)b, &count);
-    }
-#else
-    if (Engine == NULL) {
-        UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
-        return;
-    }
-    else {
-        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Synthesizing with voice %s"), *(Engine->ID));
-
-        ret = Engine->Acquire();
-
-        SoundWave->SetSampleRate(Engine->Sampling);
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Acquiring Engine %s failed, return code: %d"), *(Engine->ID), ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Acquiring Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
-        }
-
-        ret = RSGame_TextToBuffer(TCHAR_TO_UTF8(*Text), TCHAR_TO_UTF8(*Engine->Name), TCHAR_TO_UTF8(*Engine->Type), &audio_callback, Volume, Pitch, Speed, Pause, CommaPause, (int)TextType, (int)OutputFormat, (void*)this);
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("TextToBuffer failed Engine=%s, Text=%s, return code: %d"), *(Engine->ID), *Text, ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("TextToBuffer success"));
-        }
-
-        ret = Engine->Release();
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Release Engine %s failed, return code: %d"), *(Engine->ID), ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Releasing Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
-        }
-    }
-#endif
-
-    FinishedConverting = true;
-
-    // Report back to gamethread when done.
-    FFunctionGraphTask::CreateAndDispatchWhenReady([this]() {
-        OnConversionFinished.Broadcast();
-    }
-    , TStatId(), nullptr, ENamedThreads::GameThread);
-}
-
-void UTTSConverter::ConvertToBuffer_SyncInfo()
-{
-#if PLATFORM_ANDROID
-    UE_LOG(LogReadSpeakerTTS, Error, TEXT("SyncInfo not supported on Android."));
-    return;
-#else
-    int ret = -1;
-    if (Engine == NULL) {
-        UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
-        return;
-    }
-    else {
-        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Synthesizing with voice %s"), *(Engine->ID));
-
-        ret = Engine->Acquire();
-
-        SoundWave->SetSampleRate(Engine->Sampling);
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Acquiring Engine %s failed, return code: %d"), *(Engine->ID), ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Acquiring Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
-        }
-
-        ret = RSGame_TextToBuffer_SyncInfo(TCHAR_TO_UTF8(*Text), TCHAR_TO_UTF8(*Engine->Name), TCHAR_TO_UTF8(*Engine->Type), &audio_callback, &word_callback, &viseme_callback, &mark_callback, Volume, Pitch, Speed, Pause, CommaPause, (int)TextType, (int)OutputFormat, (void*)this);
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("TextToBuffer_SyncInfo failed Engine=%s, Text=%s, return code: %d"), *(Engine->ID), *Text, ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("TextToBuffer success"));
-        }
-
-        ret = Engine->Release();
-
-        if (ret != 0) {
-            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Release Engine %s failed, return code: %d"), *(Engine->ID), ret);
-        }
-        else {
-            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Releasing Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
-        }
-
-        FinishedConverting = true;
-
-        // Report back to gamethread when done.
-        FFunctionGraphTask::CreateAndDispatchWhenReady([this]() {
-            OnConversionFinished.Broadcast();
-        }
-        , TStatId(), nullptr, ENamedThreads::GameThread);
-    }
-#endif
-}
-
-void UTTSConverter::RecieveAudioCallback(char* data, int* length) {
-    TArray<int16> RecievedData;
-    RecievedData.Append((int16*)data, *length / sizeof(int16));
-    AudioData.Append(RecievedData);
-}
-
-void UTTSConverter::RecieveWordCallback(int* startPos, int* endPos, float* time, int* length) {
-    OnWord.Broadcast(*startPos, *endPos, *time);
-}
-
-void UTTSConverter::RecieveVisemeCallback(short* visemeId, float* time, int* length) {
-    AddVisemeToQueue(*visemeId, *time);
-    OnViseme.Broadcast(*visemeId, *time);
-}
-
-void UTTSConverter::RecieveMarkCallback(char* markName, float* time, int* length) {
-    OnMark.Broadcast(FString(markName), *time);
-}
-
-void UTTSConverter::AddVisemeToQueue(int visemeId, float timestamp) {
-    VisemeEvent viseme_event;
-    viseme_event.timestamp = timestamp;
-    viseme_event.viseme_id = visemeId;
-    SoundWave->VisemeEvents.Enqueue(viseme_event);
-}
-
-void UTTSConverter::ClearAudioData() {
-    AudioData.Empty();
-}
-TArray<int16> UTTSConverter::GetAudioData()
-{
-    if (FinishedConverting) {
-        return AudioData;
-    }
-    else {
-        return TArray<int16>();
-    }
-}
-
-void UTTSConverter::Play()
-{
-    SoundWave->TTSSampleRate = Engine->Sampling;
-    SoundWave->TTSBitDepth = OutputFormat == TTSOutputFormat::PCM16 ? 16 : 8;
-    SoundWave->SetAudioData(GetAudioData());
-    SoundWave->FillAudioQueue(GetAudioData().Num());;
-    if (AudioComponent->IsValidLowLevel()) {
-        AudioComponent->AdjustAttenuation(*SoundAttenuationSettings);
-        AudioComponent->Sound = SoundWave;
-        AudioComponent->Play(0.0f);
-    }
-    else {
-        UE_LOG(LogReadSpeakerTTS, Error, TEXT("No audio component set, set AudioComponent on UTTSConverter first."));
-    }
-    this->RemoveFromRoot();
-    SoundWave->RemoveFromRoot();
-}
-
-UTTSSpeaker::UTTSSpeaker(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer) {
-    PrimaryComponentTick.bCanEverTick = true;
-    PrimaryComponentTick.bStartWithTickEnabled = true;
-}
-
-void UTTSSpeaker::BeginPlay() {
-    FReadSpeakerTTSModule::BindSpeaker(this);
-    Super::BeginPlay();
-}
-
-void UTTSSpeaker::BeginDestroy() {
-    FReadSpeakerTTSModule::UnbindSpeaker(this);
-    Super::BeginDestroy();
-}
-
-void UTTSSpeaker::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
-    // Check if we are currently playing a sound, if we're not paused, reduce the remaining duration.
-    // If finished playing, broadcast it.
-    if (ThisAudioComponent != NULL && ThisAudioComponent->Sound != NULL && ThisAudioComponent->GetPlayState() == EAudioComponentPlayState::Playing) {
-        
-        USoundWaveProceduralTTS* CurrentSound = (USoundWaveProceduralTTS*)ThisAudioComponent->Sound;
-
-        CurrentSound->RemainingDuration -= DeltaTime;
-        float elapsed = CurrentSound->Length - CurrentSound->RemainingDuration;
-
-        VisemeEvent* top_event = CurrentSound->VisemeEvents.Peek();
-
-        if (top_event != nullptr && top_event->timestamp <= elapsed) {
-            VisemeEvent ev;
-            if (CurrentSound->VisemeEvents.Dequeue(ev)) {
-                CurrentVisemeID = ev.viseme_id;
-            }
-        }
-
-        if (CurrentSound->RemainingDuration <= 0) {
-            FinishedSpeaking();
-        }
-    }
-}
-
-void UTTSSpeaker::SetEngine(UTTSEngine* NewEngine) {
-    if (NewEngine != nullptr) {
-        Engine = NewEngine;
-        EngineID = NewEngine->ID;
-    }
-    else {
-        UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine was null"));
-    }
-}
-
-UTTSEngine* UTTSSpeaker::GetEngine()
-{
-    if (Engine == NULL || Engine->ID != EngineID) {
-        Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
-    }
-    return Engine;
-}
-
-void UTTSSpeaker::SetAudioComponent(UAudioComponent* AudioComponent) {
-    ThisAudioComponent = AudioComponent;
-}
-
-UAudioComponent* UTTSSpeaker::GetAudioComponent() {
-    return ThisAudioComponent;
-}
-
-void UTTSSpeaker::SetVolume(int NewVolume)
-{
-    Volume = NewVolume;
-}
-
-int UTTSSpeaker::GetVolume()
-{
-    return Volume;
-}
-
-void UTTSSpeaker::SetPitch(int NewPitch)
-{
-    Pitch = NewPitch;
-}
-
-int UTTSSpeaker::GetPitch()
-{
-    return Pitch;
-}
-
-void UTTSSpeaker::SetSpeed(int NewSpeed)
-{
-    Speed = NewSpeed;
-}
-
-int UTTSSpeaker::GetSpeed()
-{
-    return Speed;
-}
-
-void UTTSSpeaker::SetPause(int NewPause)
-{
-    Pause = NewPause;
-}
-
-int UTTSSpeaker::GetPause()
-{
-    return Pause;
-}
-
-void UTTSSpeaker::SetCommaPause(int NewCommaPause)
-{
-    CommaPause = NewCommaPause;
-}
-
-int UTTSSpeaker::GetCommaPause()
-{
-    return CommaPause;
-}
-
-int UTTSSpeaker::GetCurrentViseme() {
-    return CurrentVisemeID;
-}
-
-bool UTTSSpeaker::IsSpeaking() {
-    return ThisAudioComponent != NULL && ThisAudioComponent->Sound != NULL && ThisAudioComponent->GetPlayState() == EAudioComponentPlayState::Playing;
-}
-
-void UTTSSpeaker::StartedSpeaking() {
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("%s started speaking"), *(GetOwner()->GetName()));
-    FString SpokenText = Converter->Text;
-    TTSTextType Type = Converter->TextType;
-    OnSpeakingStarted.Broadcast(SpokenText, Type);
-}
-
-void UTTSSpeaker::FinishedSpeaking() {
-    UE_LOG(LogReadSpeakerTTS, Display, TEXT("%s finished speaking"), *(GetOwner()->GetName()));
-    
-    FString SpokenText = Converter->Text;
-    TTSTextType Type = Converter->TextType;
-    
-    if (Converter != NULL && Converter->IsValidLowLevel()) {
-        Converter = NULL;
-    }
-
-    ThisAudioComponent->Sound = NULL;
-
-    OnSpeakingFinished.Broadcast(SpokenText, Type);
-}
-
-void UTTSSpeaker::Say(FString text, TTSTextType textType)
-{
-    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
-
-    if (Engine == NULL) {
-        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Could not find requested engine: %s"), *EngineID);
-        return;
-    }
-
-    Converter = NewObject<UTTSConverter>();
-    Converter->Text = text;
-    Converter->Engine = Engine;
-    Converter->Volume = Volume;
-    Converter->Pitch = Pitch;
-    Converter->Speed = Speed;
-    Converter->Pause = Pause;
-    Converter->CommaPause = CommaPause;
-    Converter->TextType = textType;
-    Converter->OutputFormat = TTSOutputFormat::PCM16;
-    Converter->AudioComponent = ThisAudioComponent;
-    Converter->SoundAttenuationSettings = &SoundAttenuation;
-
-#if PLATFORM_ANDROID
-    Converter->ConvertToBuffer();
-#else
-    Converter->ConvertToBuffer_SyncInfo();
-#endif
-
-    Converter->Play();
-    StartedSpeaking();
-}
-
-void UTTSSpeaker::SayAsync(FString text, TTSTextType textType)
-{
-    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
-
-    if (Engine == NULL) {
-        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Could not find requested engine: %s"), *EngineID);
-        return;
-    }
-
-    Converter = NewObject<UTTSConverter>();
-    
-    Converter->AddToRoot();
-
-    Converter->Text = text;
-    Converter->Engine = Engine;
-    Converter->Volume = Volume;
-    Converter->Pitch = Pitch;
-    Converter->Speed = Speed;
-    Converter->Pause = Pause;
-    Converter->CommaPause = CommaPause;
-    Converter->TextType = textType;
-    Converter->OutputFormat = TTSOutputFormat::PCM16;
-    Converter->AudioComponent = ThisAudioComponent;
-    Converter->SoundAttenuationSettings = &SoundAttenuation;
-    
-    Converter->OnConversionFinished.AddDynamic(Converter, &UTTSConverter::Play);
-    Converter->OnConversionFinished.AddDynamic(this, &UTTSSpeaker::StartedSpeaking);
-
-#if PLATFORM_ANDROID
-    Converter->ConvertToBufferAsync();
-#else
-    Converter->ConvertToBufferAsync_SyncInfo();
-#endif
-}
-
-void UTTSSpeaker::PauseSpeaking() {
-    if (ThisAudioComponent != NULL && !ThisAudioComponent->bIsPaused) {
-        ThisAudioComponent->SetPaused(true);
-    }
-}
-
-void UTTSSpeaker::ResumeSpeaking() {
-    if (ThisAudioComponent != NULL && ThisAudioComponent->bIsPaused) {
-        ThisAudioComponent->SetPaused(false);
-    }
-}
-
-void UTTSSpeaker::InterruptSpeaking() {
-    if (ThisAudioComponent != NULL && ThisAudioComponent->IsPlaying()) {
-        ThisAudioComponent->Stop();
-    }
-}
-
-void UTTSObject::Init() {
-    FReadSpeakerTTSModule::Init();
-}
-
-UTTSEngine *UTTSObject::FindEngine(FString name, FString type) {
-    return FReadSpeakerTTSModule::GetEngine(name, type);
-}
-
-void UTTSObject::PauseAll() {
-    FReadSpeakerTTSModule::PauseAll();
-}
-
-void UTTSObject::ResumeAll() {
-    FReadSpeakerTTSModule::ResumeAll();
-}
-
-void UTTSObject::InterruptAll() {
-    FReadSpeakerTTSModule::InterruptAll();
-}
-
-#if WITH_EDITOR
-
-#define LOCTEXT_NAMESPACE "STTSVoiceCombo"
-
-void STTSVoiceCombo::Construct(const FArguments& InArgs)
-{
-    SpeechCharacteristics = InArgs._SpeechCharacteristics;
-    OnStateChanged = InArgs._OnStateChanged;
-    if (GEditor && !GEditor->PlayWorld) {
-        FReadSpeakerTTSModule::Init();
-    }
-    int current = 0;
-    if (SpeechCharacteristics == NULL)
-        return;
-
-    if (Engines.Num() > 0) {
-        for (int i = 0; i < Engines.Num(); i++) {
-            if (Engines[i]->ID == SpeechCharacteristics->EngineID) {
-                current = i;
-            }
-            Options.Add(MakeShareable(new FString(Engines[i]->ID)));
-        }
-
-
-        CurrentItem = Options[current];
-        SpeechCharacteristics->EngineID = *CurrentItem.Get();
-    }
-    else {
-        Options.Add(MakeShareable(new FString("No voices available")));
-        CurrentItem = Options[0];
-    }
-
-    ChildSlot
-        [
-            SNew(SComboBox<FComboItemType>)
-            .OptionsSource(&Options)
-            .OnSelectionChanged(this, &STTSVoiceCombo::OnSelectionChanged)
-            .OnGenerateWidget(this, &STTSVoiceCombo::MakeWidgetForOption)
-            .InitiallySelectedItem(CurrentItem)
-        [
-            SNew(STextBlock)
-            .Text(this, &STTSVoiceCombo::GetCurrentItemLabel)
-        ]
-        ];
-}
-
-TSharedRef<SWidget> STTSVoiceCombo::MakeWidgetForOption(FComboItemType InOption)
-{
-    return SNew(STextBlock).Text(FText::FromString(*InOption));
-}
-
-void STTSVoiceCombo::OnSelectionChanged(FComboItemType NewValue, ESelectInfo::Type)
-{
-    CurrentItem = NewValue;
-    TSharedPtr<FString> TheName = (TSharedPtr<FString>)CurrentItem;
-    FString IDString = *(TheName).Get();
-    if (SpeechCharacteristics != NULL) {
-        UTTSEngine* Engine = FReadSpeakerTTSModule::GetEngineByID(IDString);
-        SpeechCharacteristics->SetEngine(Engine);
-    }
-    else {
-        UE_LOG(LogTemp, Warning, TEXT("TTSSpeaker is NULL"));
-    }
-
-    OnStateChanged.ExecuteIfBound();
-}
-
-FText STTSVoiceCombo::GetCurrentItemLabel() const
-{
-    if (CurrentItem.IsValid())
-    {
-        return FText::FromString(*CurrentItem);
-    }
-
-    return LOCTEXT("InvalidComboEntryText", "<<Invalid option>>");
-}
+// Copyright 2022 ReadSpeaker AB. All Rights Reserved.
+
+#include "ReadSpeakerTTS.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <vector>
+#if PLATFORM_ANDROID
+#include <dlfcn.h>
+#endif
+#include "Async/Async.h"
+#include "AudioDevice.h"
+#include "Components/AudioComponent.h"
+#include "Core.h"
+#include "Interfaces/IPluginManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/ScopeTryLock.h"
+#include "Modules/ModuleManager.h"
+#include "Quartz/AudioMixerClockHandle.h"
+#include "RenderCore.h"
+#include "SampleBuffer.h"
+#include "Sound/SampleBufferIO.h"
+#include "Sound/SoundSubmix.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "Templates/Function.h"
+#include "TTSSampleConversion.h"
+#include "TTSSilenceDetection.h"
+#include "TTSSynthComponent.h"
+#if WITH_EDITOR
+#include "ClassIconFinder.h"
+#include "DetailLayoutBuilder.h"
+#include "Editor/EditorEngine.h"
+#include "IDetailCustomization.h"
+#include "LevelEditor.h"
+#include "PropertyEditing.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Styling/SlateStyle.h"
+#include "Styling/SlateStyleRegistry.h"
+#include "Widgets/Docking/SDockTab.h"
+#include "Widgets/Input/SButton.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Text/STextBlock.h"
+#endif
+#if PLATFORM_ANDROID
+#include "Android/AndroidApplication.h"
+#include "Android/AndroidJNI.h"
+#endif
+#if defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+#include "VTmem.h"
+#endif
+
+
+extern "C" {
+#include "rsgame.h"
+}
+
+DEFINE_LOG_CATEGORY(LogReadSpeakerTTS);
+
+FCriticalSection FReadSpeakerTTSModule::AndroidMutex;
+FOnPauseAll FReadSpeakerTTSModule::FOnPauseAllDelegate;
+FOnResumeAll FReadSpeakerTTSModule::FOnResumeAllDelegate;
+FOnInterruptAll FReadSpeakerTTSModule::FOnInterruptAllDelegate;
+TArray<UTTSConverter*> FReadSpeakerTTSModule::ConverterPool;
+FCriticalSection FReadSpeakerTTSModule::ConverterPoolMutex;
+FThreadSafeCounter FReadSpeakerTTSModule::BufferAllocationCount;
+TArray<UTTSConverter*> FReadSpeakerTTSModule::FinishedConverters;
+TArray<UTTSConverter*> FReadSpeakerTTSModule::DispatchingConverters;
+FCriticalSection FReadSpeakerTTSModule::FinishedConvertersMutex;
+TArray<FTTSUnderrunRecord> FReadSpeakerTTSModule::UnderrunRecords;
+FCriticalSection FReadSpeakerTTSModule::UnderrunRecordsMutex;
+TMap<FName, FTTSDspStageFactory> FReadSpeakerTTSModule::DspStageFactories;
+FCriticalSection FReadSpeakerTTSModule::DspStageFactoriesMutex;
+FThreadSafeCounter FReadSpeakerTTSModule::DspStageRegistryVersion;
+TMap<TTuple<FString, int32, int32, uint32>, float> FReadSpeakerTTSModule::LoudnessCache;
+FCriticalSection FReadSpeakerTTSModule::LoudnessCacheMutex;
+
+// The largest boost or cut loudness normalization applies, so near silent utterances are not blown up.
+static constexpr float MaxLoudnessCorrectionDb = 12.0f;
+static TArray<UTTSEngine*> Engines;
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Buffer Allocations"), STAT_TTSBufferAllocations, STATGROUP_ReadSpeakerTTS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Converters"), STAT_TTSPooledConverters, STATGROUP_ReadSpeakerTTS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Stream Underruns"), STAT_TTSUnderruns, STATGROUP_ReadSpeakerTTS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Stream Underrun Silence (ms)"), STAT_TTSUnderrunMs, STATGROUP_ReadSpeakerTTS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Stream Pre-roll (ms)"), STAT_TTSPreRollMs, STATGROUP_ReadSpeakerTTS);
+
+static FAutoConsoleCommand TTSAllocationsCommand(
+    TEXT("ReadSpeakerTTS.Allocations"),
+    TEXT("Prints the number of TTS buffer allocations since startup. Pass 'reset' to reset the counter."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("TTS buffer allocations: %d"), FReadSpeakerTTSModule::GetBufferAllocationCount());
+        if (Args.Num() > 0 && Args[0] == TEXT("reset")) {
+            FReadSpeakerTTSModule::ResetBufferAllocationCount();
+        }
+    })
+);
+
+static FAutoConsoleCommand TTSUnderrunsCommand(
+    TEXT("ReadSpeakerTTS.Underruns"),
+    TEXT("Prints the streamed playback underruns per speaker and voice since startup, with the current pre-roll. Pass 'reset' to clear them."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+        const TArray<FTTSUnderrunRecord> Records = FReadSpeakerTTSModule::GetUnderrunRecords();
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("TTS stream underruns: %d speaker/voice pairs"), Records.Num());
+        for (const FTTSUnderrunRecord& Record : Records) {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("  %s (%s): %d underruns, %.3f s of silence, pre-roll %.0f ms"), *Record.Speaker, *Record.EngineID, Record.Count, Record.Seconds, Record.PreRollSeconds * 1000.0f);
+        }
+        if (Args.Num() > 0 && Args[0] == TEXT("reset")) {
+            FReadSpeakerTTSModule::ResetUnderrunRecords();
+        }
+    })
+);
+
+// The longest silence held back while streaming in case it is trailing silence, longer pauses are written out.
+static constexpr float MaxHeldSilenceSeconds = 1.0f;
+
+/**
+ * Grows a buffer to hold at least Num elements, counting the allocation if it had to grow.
+ * Growth is geometric so a buffer stops reallocating once it has seen the longest utterance.
+ */
+template<typename T>
+static void ReserveTracked(TArray<T>& Buffer, int32 Num) {
+    if (Buffer.Max() < Num) {
+        Buffer.Reserve(FMath::Max(Num, Buffer.Max() * 2));
+        FReadSpeakerTTSModule::CountBufferAllocation();
+    }
+}
+
+
+
+#define LOCTEXT_NAMESPACE "FReadSpeakerTTSModule"
+
+#if WITH_EDITOR
+
+TSharedRef< IDetailCustomization > FTTSSpeakerCustomization::MakeInstance()
+{
+    return MakeShareable(new FTTSSpeakerCustomization);
+}
+
+void FTTSSpeakerCustomization::CustomizeDetails(IDetailLayoutBuilder& DetailBuilder)
+{
+    TArray< TWeakObjectPtr< UObject > > Objects;
+    DetailBuilder.GetObjectsBeingCustomized(Objects);
+
+    TSharedRef< IPropertyHandle > EngineIDProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, EngineID));
+    TSharedRef< IPropertyHandle > VolumeProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Volume));
+    TSharedRef< IPropertyHandle > PitchProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Pitch));
+    TSharedRef< IPropertyHandle > SpeedProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Speed));
+    TSharedRef< IPropertyHandle > PauseProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, Pause));
+    TSharedRef< IPropertyHandle > CommaPauseProp = DetailBuilder.GetProperty(GET_MEMBER_NAME_CHECKED(UTTSSpeaker, CommaPause));
+
+    DetailBuilder.HideProperty(EngineIDProp);
+
+    if (Objects.Num() != 1)
+    {
+        return;
+    }
+
+    TWeakObjectPtr<UTTSSpeaker> MyObject = Cast<UTTSSpeaker>(Objects[0].Get());
+    IDetailCategoryBuilder& Cat = DetailBuilder.EditCategory(TEXT("Characteristics"));
+
+    auto OnRegenerate = [&DetailBuilder]
+    {
+        DetailBuilder.ForceRefreshDetails();
+    };
+
+    Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker"))
+        .WholeRowContent()
+        [
+            SNew(SHorizontalBox)
+            + SHorizontalBox::Slot()
+        .VAlign(VAlign_Center)
+        [
+            SNew(STextBlock)
+            .Text(LOCTEXT("VoiceNameText", "Voice"))
+        ]
+    + SHorizontalBox::Slot()
+        [
+            SNew(STTSVoiceCombo).SpeechCharacteristics(MyObject).OnStateChanged_Lambda(OnRegenerate)
+        ]
+        ];
+
+    UTTSEngine* Engine = FReadSpeakerTTSModule::GetEngineByID(MyObject->EngineID);
+    if (Engine != NULL) {
+        FString EngineName = Engine->Name;
+        FString EngineType = Engine->Type;
+        FString EngineLang = Engine->Language;
+        FString EngineGender = Engine->Gender;
+
+        Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker")).WholeRowContent()
+            [
+                SNew(SVerticalBox)
+                + SVerticalBox::Slot().Padding(5)
+            [
+                SNew(SHorizontalBox)
+                + SHorizontalBox::Slot()[
+                    SNew(STextBlock).Text(FText::FromString("Name: " + EngineName))
+                ]
+            + SHorizontalBox::Slot()[
+                SNew(STextBlock).Text(FText::FromString("Type: " + EngineType))
+            ]
+            ]
+        + SVerticalBox::Slot().Padding(5)
+            [
+                SNew(SHorizontalBox)
+                + SHorizontalBox::Slot()[
+                    SNew(STextBlock).Text(FText::FromString("Language: " + EngineLang))
+                ]
+            + SHorizontalBox::Slot()[
+                SNew(STextBlock).Text(FText::FromString("Gender: " + EngineGender))
+            ]
+            ]
+            ];
+    }
+    
+
+    if (GEditor && !GEditor->PlayWorld) {
+        Cat.AddProperty(VolumeProp);
+        Cat.AddProperty(PitchProp);
+        Cat.AddProperty(SpeedProp);
+        Cat.AddProperty(PauseProp);
+        Cat.AddProperty(CommaPauseProp);
+
+        auto OnPreview = [MyObject]
+        {
+            if (MyObject.IsValid())
+            {
+                MyObject->Preview();
+            }
+            return FReply::Handled();
+        };
+
+
+        Cat.AddCustomRow(LOCTEXT("PreviewButton", "Preview"))
+            .WholeRowContent()
+            [
+                SNew(SButton)
+                .Text(LOCTEXT("PreviewButtonText", "Preview"))
+            .OnClicked_Lambda(OnPreview)
+            ];
+    }
+    else {
+        DetailBuilder.HideProperty(VolumeProp);
+        DetailBuilder.HideProperty(PitchProp);
+        DetailBuilder.HideProperty(SpeedProp);
+        DetailBuilder.HideProperty(PauseProp);
+        DetailBuilder.HideProperty(CommaPauseProp);
+
+        Cat.AddCustomRow(LOCTEXT("TTSSpeaker", "Speaker")).WholeRowContent()
+            [
+                SNew(SVerticalBox)
+                + SVerticalBox::Slot().Padding(5)
+            [
+                SNew(SHorizontalBox)
+                + SHorizontalBox::Slot()[
+                    SNew(STextBlock).Text(FText::FromString("Exit Play Mode to customize Speaker properties."))
+                ]
+            ]
+            ];
+    }
+}
+
+void UTTSSpeaker::Preview() {
+    FReadSpeakerTTSModule::Init();
+    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
+    UTTSConverter* converter = NewObject<UTTSConverter>();
+    converter->Text = "I sound like this";
+    converter->Volume = Volume;
+    converter->Pitch = Pitch;
+    converter->Speed = Speed;
+    converter->Pause = Pause;
+    converter->CommaPause = CommaPause;
+    converter->TextType = TTSTextType::Normal;
+    converter->Engine = Engine;
+    converter->ConvertToBuffer();
+    USoundWaveProceduralTTS *SoundWave = NewObject<USoundWaveProceduralTTS>();
+    SoundWave->SetSampleRate(Engine->Sampling);
+    TArray<int16> PreviewData;
+    converter->TakeAudioData(PreviewData);
+    SoundWave->SetAudioData(PreviewData);
+    UGameplayStatics::PlaySound2D(GEditor->GetEditorWorldContext().World(), SoundWave, 1, 1, 0);
+}
+#endif
+
+void FReadSpeakerTTSModule::StartupModule()
+{
+    // Registered before the platform checks, conversions on Android report back through it too.
+    DispatchTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FReadSpeakerTTSModule::DispatchConversionFinished));
+
+    FString BaseDir = IPluginManager::Get().FindPlugin("ReadSpeakerTTS")->GetBaseDir();
+
+    FString VTAPILibraryPath;
+    FString RSGameLibraryPath;
+
+#if PLATFORM_WINDOWS
+    VTAPILibraryPath = VTAPI_WIN64_LIB;
+    RSGameLibraryPath = RSGAME_WIN64_LIB;
+#elif PLATFORM_LINUX
+    VTAPILibraryPath = VTAPI_LINUX_LIB;
+    RSGameLibraryPath = RSGAME_LINUX_LIB;
+#elif defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
+    VTAPILibraryPath = VTAPI_PS5_LIBNAME;
+    RSGameLibraryPath = RSGAME_PS5_LIBNAME;
+#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
+    VTAPILibraryPath = VTAPI_PS4_LIB;
+    RSGameLibraryPath = RSGAME_PS4_LIB;
+#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
+    VTAPILibraryPath = VTAPI_XSX_LIB;
+    RSGameLibraryPath = RSGAME_XSX_LIB;
+#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+    VTAPILibraryPath = VTAPI_SWITCH_LIB;
+    RSGameLibraryPath = RSGAME_SWITCH_LIB;
+#elif PLATFORM_ANDROID
+    return;
+#endif
+
+#if !defined(PLATFORM_SWITCH) || (defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 0)
+    VTAPILibraryHandle = !VTAPILibraryPath.IsEmpty() ? FPlatformProcess::GetDllHandle(*VTAPILibraryPath) : nullptr;
+
+    if (!VTAPILibraryHandle)
+    {
+        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ThirdPartyLibraryError", "Failed to load VTAPI."));
+    }
+
+    RSGameLibraryHandle = !RSGameLibraryPath.IsEmpty() ? FPlatformProcess::GetDllHandle(*RSGameLibraryPath) : nullptr;
+
+    if (!RSGameLibraryHandle)
+    {
+        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ThirdPartyLibraryError", "Failed to load RSGame."));
+    }
+#endif
+
+#if WITH_EDITOR
+    auto& PropertyModule = FModuleManager::LoadModuleChecked< FPropertyEditorModule >("PropertyEditor");
+    PropertyModule.RegisterCustomClassLayout(
+        "TTSSpeaker",
+        FOnGetDetailCustomizationInstance::CreateStatic(&FTTSSpeakerCustomization::MakeInstance)
+    );
+    PropertyModule.NotifyCustomizationModuleChanged();
+
+    StyleSet->SetContentRoot(FPaths::EngineContentDir() / TEXT("Editor/Slate"));
+    StyleSet->SetCoreContentRoot(FPaths::EngineContentDir() / TEXT("Slate"));
+
+    FString IconPath = FPaths::Combine(*BaseDir, TEXT("Resources/ButtonIcon_40x.png"));
+
+    StyleSet->Set("ClassIcon.TTSSpeaker", new FSlateImageBrush(IconPath, FVector2D(16.0f, 16.0f)));
+
+    FSlateStyleRegistry::RegisterSlateStyle(StyleSet.Get());
+#endif
+}
+
+
+void FReadSpeakerTTSModule::ShutdownModule()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(DispatchTickerHandle);
+    {
+        FScopeLock ScopeLock(&FinishedConvertersMutex);
+        FinishedConverters.Empty();
+    }
+
+#if WITH_EDITOR
+    if (FModuleManager::Get().IsModuleLoaded("PropertyEditor"))
+    {
+        auto& PropertyModule = FModuleManager::LoadModuleChecked<FPropertyEditorModule>("PropertyEditor");
+        PropertyModule.UnregisterCustomClassLayout("SpeechCharacteristics");
+        PropertyModule.UnregisterCustomClassLayout("TTSSpeaker");
+    }
+    
+    FSlateStyleRegistry::UnRegisterSlateStyle(StyleSet.Get());
+    ensure(StyleSet.IsUnique());
+#endif
+
+    if (UObjectInitialized()) {
+        FScopeLock ScopeLock(&ConverterPoolMutex);
+        for (UTTSConverter* converter : ConverterPool) {
+            converter->RemoveFromRoot();
+            if (converter->SoundWave != NULL) {
+                converter->SoundWave->RemoveFromRoot();
+            }
+        }
+    }
+    ConverterPool.Empty();
+
+    {
+        FScopeLock ScopeLock(&DspStageFactoriesMutex);
+        DspStageFactories.Empty();
+    }
+
+    FPlatformProcess::FreeDllHandle(VTAPILibraryHandle);
+    FPlatformProcess::FreeDllHandle(RSGameLibraryHandle);
+    VTAPILibraryHandle = nullptr;
+    RSGameLibraryHandle = nullptr;
+}
+
+void FReadSpeakerTTSModule::GetEngines(TArray<UTTSEngine*> *EngineArr) {
+#if PLATFORM_ANDROID
+    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+    {
+        static jmethodID GetEngineCountMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetEngineCountReadSpeaker", "()I", false);
+        static jmethodID GetEngineInfoOfIndexMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetEngineInfoOfIndexReadSpeaker", "(I)[Ljava/lang/String;", false);
+
+        int engineCount = FJavaWrapper::CallIntMethod(Env, FJavaWrapper::GameActivityThis, GetEngineCountMethod);
+        
+		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Number of installed engines is: %d"), engineCount);
+        
+        for (int i = 0; i < engineCount; i++) {
+            jint index = i;
+            jobjectArray arr = (jobjectArray)FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, GetEngineInfoOfIndexMethod, index);
+        
+            std::vector<FString> engineFields;
+            int fieldCount = Env->GetArrayLength(arr);
+            
+            for (int j = 0; j < fieldCount; j++) {
+                jstring obj = (jstring)Env->GetObjectArrayElement(arr, j);
+                const char* raw = Env->GetStringUTFChars(obj, 0);
+                FString fstr = FString(UTF8_TO_TCHAR(raw));
+				UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine field %d is %s"), j, *fstr);
+                engineFields.push_back(fstr);
+            }
+            
+            if (engineFields.size() < 4) {
+				UE_LOG(LogReadSpeakerTTS, Display, TEXT("Corrupted VT engine information"));
+            }
+            else {
+                RecieveEngineCallback((void*)EngineArr, TCHAR_TO_UTF8(*engineFields[0]), TCHAR_TO_UTF8(*engineFields[1]), TCHAR_TO_UTF8(*engineFields[2]), TCHAR_TO_UTF8(*engineFields[3]), TCHAR_TO_UTF8(*engineFields[4]), TCHAR_TO_UTF8(*engineFields[5]), FCString::Atoi(*engineFields[6]), FCString::Atoi(*engineFields[7]));
+            }
+        }
+    }
+#else
+    RSGame_GetEngines(&RecieveEngineCallback, (void*)EngineArr);
+#endif
+}
+
+void FReadSpeakerTTSModule::RecieveEngineCallback(void* context, char* speaker, char* type, char* language, char* gender, char* dbPath, char* version, int sampling, int channels) {
+    TArray<UTTSEngine*>* EngineArr = reinterpret_cast<TArray<UTTSEngine*>*>(context);
+    UTTSEngine* eng = NewObject<UTTSEngine>();
+    eng->AddToRoot();
+    eng->Name = speaker;
+    eng->Type = type;
+    eng->NameUTF8.Append(speaker, FCStringAnsi::Strlen(speaker) + 1);
+    eng->TypeUTF8.Append(type, FCStringAnsi::Strlen(type) + 1);
+    eng->Language = language;
+    eng->Gender = gender;
+    eng->Version = version;
+    eng->Sampling = sampling;
+    eng->Channels = channels;
+    std::string niceName(speaker);
+    std::string niceType(type);
+    niceName[0] = std::toupper(niceName[0], std::locale());
+    niceType[0] = std::toupper(niceType[0], std::locale());
+    std::string niceID = std::string(niceName + " " + niceType);
+    eng->ID = niceID.c_str();
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* comp = Engines[i];
+        if (comp->Name.Equals(eng->Name) && comp->Type.Equals(eng->Type))
+            return;
+    }
+
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Found engine %s, %s, %s, %s, %s, %s, %d, %d"), UTF8_TO_TCHAR(speaker), UTF8_TO_TCHAR(type), UTF8_TO_TCHAR(language), UTF8_TO_TCHAR(gender), UTF8_TO_TCHAR(dbPath), UTF8_TO_TCHAR(version), sampling, channels);
+    EngineArr->Add(eng);
+}
+
+
+void FReadSpeakerTTSModule::RefreshVoiceEngineInstallations() {
+#if WITH_EDITOR
+#if defined(VTAPI_WIN64)
+    RSGame_CreateConfFile((char*)VTAPI_WIN64_DB, (char*)VTAPI_WIN64_DB);
+#endif
+#if defined(VTAPI_LINUX)
+    RSGame_CreateConfFile((char*)VTAPI_LINUX_DB, (char*)VTAPI_LINUX_DB);
+#endif
+#if defined(VTAPI_ANDROID)
+    RSGame_CreateConfFileCustom((char*)VTAPI_ANDROID_SOURCEDB, (char*)VTAPI_ANDROID_SOURCEDB, (char*)"");
+#endif
+#if defined(VTAPI_PS4)
+    RSGame_CreateConfFileCustom((char*)VTAPI_PS4_SOURCEDB, (char*)VTAPI_PS4_SOURCEDB, (char*)VTAPI_PS4_DB);
+#endif
+#if defined(VTAPI_PS5)
+    RSGame_CreateConfFileCustom((char*)VTAPI_PS5_SOURCEDB, (char*)VTAPI_PS5_SOURCEDB, (char*)VTAPI_PS5_DB);
+#endif
+#if defined(VTAPI_XSX)
+    RSGame_CreateConfFileCustom((char*)VTAPI_XSX_SOURCEDB, (char*)VTAPI_XSX_SOURCEDB, (char*)VTAPI_XSX_DB);
+#endif
+#if defined(VTAPI_SWITCH)
+    RSGame_CreateConfFileCustom((char*)VTAPI_SWITCH_SOURCEDB, (char*)VTAPI_SWITCH_SOURCEDB, (char*)VTAPI_SWITCH_DB);
+#endif
+#else
+#if PLATFORM_WINDOWS
+    RSGame_CreateConfFile((char*)VTAPI_WIN64_DB, (char*)VTAPI_WIN64_DB);
+#endif
+#if PLATFORM_LINUX
+    RSGame_CreateConfFile((char*)VTAPI_LINUX_DB, (char*)VTAPI_LINUX_DB);
+#endif
+#if PLATFORM_ANDROID
+    FReadSpeakerTTSModule::RefreshVoiceEngineInstallations_Android();
+#endif
+#endif
+}
+
+#if PLATFORM_ANDROID
+std::vector<std::string> StrSplit(std::string input, char delim) {
+    std::vector<std::string> result;
+
+    size_t pos_start = 0;
+    size_t pos_end;
+
+    std::string token;
+    std::vector<std::string> res;
+
+    while ((pos_end = input.find(delim, pos_start)) != std::string::npos) {
+        token = input.substr(pos_start, pos_end - pos_start);
+        pos_start = pos_end + 1;
+        res.push_back(token);
+    }
+
+    res.push_back(input.substr(pos_start));
+
+    return res;
+}
+#endif
+
+#if PLATFORM_ANDROID
+void RewriteCRLFAsLF(std::string inpath, std::string outpath) {
+
+    FString in = FString(UTF8_TO_TCHAR(inpath.c_str()));
+    FString out = FString(UTF8_TO_TCHAR(outpath.c_str()));
+
+    int c;
+
+    FILE* ifp = fopen(inpath.c_str(), "rb");
+    FILE* ofp = fopen(outpath.c_str(), "wb");
+
+    while ((c = getc(ifp)) != EOF) {
+        if (c == '\r') {
+            putc('\n', ofp);
+            c = getc(ifp);
+
+            if (c == EOF) break;
+            if (c == '\n') continue;
+
+        }
+        putc(c, ofp);
+    }
+
+    fclose(ifp);
+    fclose(ofp);
+}
+#endif
+
+#if PLATFORM_ANDROID
+void FReadSpeakerTTSModule::RefreshVoiceEngineInstallations_Android() {
+
+    extern FString GFilePathBase;
+    FString BaseDir = GFilePathBase;
+
+#if ENGINE_MAJOR_VERSION == 4
+    BaseDir += FString("/UE4Game/");
+#else
+    BaseDir += FString("/UnrealGame/");
+#endif
+
+    FString iniPath = VTAPI_ANDROID_DB(BaseDir);
+
+    FString vtPath = FPaths::Combine(*iniPath, TEXT("vtpath.ini"));
+    FString tmpPath = FPaths::Combine(*iniPath, TEXT("tmp.ini"));
+
+    std::ifstream file(TCHAR_TO_UTF8(*vtPath), std::ios_base::binary);
+    std::ofstream fileout(TCHAR_TO_UTF8(*tmpPath), std::ios_base::binary);
+
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string result;
+        if (std::getline(iss, result)) {
+            if (result.find("Path") != std::string::npos) {
+                int separatorindex = result.find(':');
+
+                std::string toAppend(TCHAR_TO_UTF8(*iniPath));
+                std::vector<std::string> frags = StrSplit(result, '/');
+                toAppend += "/" + frags[frags.size() - 3] + "/" + frags[frags.size() - 2];
+                std::string newLine = result.replace(separatorindex + 1, result.length(), toAppend);
+                FString NEWLINE(newLine.c_str());
+
+                fileout << newLine << "\n";
+            }
+            else {
+                fileout << result << "\n";
+            }
+        }
+    }
+
+    fileout.close();
+
+    if (file.bad()) {
+		UE_LOG(LogReadSpeakerTTS, Display, TEXT("IO Error"));
+        file.close();
+    }
+    else if (!file.eof()) {
+		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Format Error"));
+        file.close();
+    }
+    else {
+        file.close();
+
+        int ret = -1;
+        ret = std::remove(TCHAR_TO_UTF8(*vtPath));
+        if (ret != 0) {
+			UE_LOG(LogReadSpeakerTTS, Display, TEXT("Failed to remove file %d"), ret);
+        }
+
+        RewriteCRLFAsLF(std::string(TCHAR_TO_UTF8(*tmpPath)), std::string(TCHAR_TO_UTF8(*vtPath)));
+
+        ret = std::remove(TCHAR_TO_UTF8(*tmpPath));
+        if (ret != 0) {
+			UE_LOG(LogReadSpeakerTTS, Display, TEXT("Failed to remove file %d"), ret);
+        }
+    }
+}
+#endif
+
+READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngine(FString name, FString type)
+{
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Name.Equals(name) && eng->Type.Equals(type))
+            return eng;
+    }
+    return nullptr;
+}
+
+READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineByID(FString id)
+{
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->ID.Equals(id))
+            return eng;
+    }
+    return nullptr;
+}
+
+READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithLanguage(FString lang)
+{
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Language.Equals(lang))
+            return eng;
+    }
+    return nullptr;
+}
+
+READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithGender(FString gender)
+{
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Gender.Equals(gender))
+            return eng;
+    }
+    return nullptr;
+}
+
+READSPEAKERTTS_API UTTSEngine* FReadSpeakerTTSModule::GetEngineWithLanguageAndGender(FString lang, FString gender)
+{
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Language.Equals(lang) && eng->Gender.Equals(gender))
+            return eng;
+    }
+    return nullptr;
+}
+
+READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithLanguage(FString lang)
+{
+    TArray<UTTSEngine*> tmp;
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Language.Equals(lang))
+            tmp.Add(eng);
+    }
+    return tmp;
+}
+
+READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithGender(FString gender)
+{
+    TArray<UTTSEngine*> tmp;
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Gender.Equals(gender))
+            tmp.Add(eng);
+    }
+    return tmp;
+}
+
+READSPEAKERTTS_API TArray<UTTSEngine*> FReadSpeakerTTSModule::GetEnginesWithLanguageAndGender(FString lang, FString gender)
+{
+    TArray<UTTSEngine*> tmp;
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Language.Equals(lang) && eng->Gender.Equals(gender))
+            tmp.Add(eng);
+    }
+    return tmp;
+}
+
+READSPEAKERTTS_API TArray<FString> FReadSpeakerTTSModule::GetAvailableLanguages()
+{
+    TArray<FString> tmp;
+    for (int i = 0; i < Engines.Num(); i++) {
+        FString lang = Engines[i]->Language;
+        if (!tmp.Contains(lang))
+            tmp.Add(lang);
+    }
+    return tmp;
+}
+
+READSPEAKERTTS_API TArray<FString> FReadSpeakerTTSModule::GetAvailableGendersForLanguage(FString lang)
+{
+    TArray<FString> tmp;
+    for (int i = 0; i < Engines.Num(); i++) {
+        UTTSEngine* eng = Engines[i];
+        if (eng->Language.Equals(lang)) 
+        {
+            if (!tmp.Contains(eng->Gender))
+                tmp.Add(eng->Gender);
+        }
+    }
+    return tmp;
+}
+
+int FReadSpeakerTTSModule::LoadTTS(FString libPath, FString iniPath) {
+#if PLATFORM_ANDROID
+    return -1;
+#else
+    int ret = -1;
+    RSGAME_CONF_HANDLE conf_handle = RSGame_CreateConfHandle(TCHAR_TO_ANSI(*iniPath));
+    RSGAME_LIB_HANDLE lib_handle = RSGame_CreateLibHandle(TCHAR_TO_ANSI(*libPath));
+
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Conf_handle: %s, lib_hande: %s"), UTF8_TO_TCHAR(conf_handle), UTF8_TO_TCHAR(lib_handle));
+
+#if defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+    VT_initialize();
+    VT_ro_initialize();
+#endif
+
+#if (defined(PLATFORM_PS4) && PLATFORM_PS4 == 1) || (defined(PLATFORM_PS5) && PLATFORM_PS5 == 1)
+    ret = RSGame_InitializeSeparated(lib_handle, conf_handle);
+#else
+    ret = RSGame_Initialize(lib_handle, conf_handle);
+#endif
+
+    if (ret != 0) {
+		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Failed to load TTS modules at %s, return code: %d"), *libPath, ret);
+    }
+    else {
+        FString rsgame_version = FString(RSGame_GetVersion());
+        FString vtapi_version = FString(RSGame_GetVTAPIVersion());
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Initialized succesfully. RSGame version=%s, VTAPI version=%s"), *rsgame_version, *vtapi_version);
+    }
+    return ret;
+#endif
+}
+
+void FReadSpeakerTTSModule::ClearLastSession() {
+#if PLATFORM_ANDROID
+    return;
+#else
+    RSGame_Exit();
+#endif
+}
+
+int FReadSpeakerTTSModule::Init() {
+
+
+    FReadSpeakerTTSModule::RefreshVoiceEngineInstallations();
+
+#if PLATFORM_ANDROID
+
+    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+    {
+        extern FString GFilePathBase;
+        FString BaseDir = GFilePathBase;
+
+#if ENGINE_MAJOR_VERSION == 4
+        BaseDir += FString("/UE4Game/")
+#else
+        BaseDir += FString("/UnrealGame/");
+#endif
+
+        FString iniPath = VTAPI_ANDROID_DB(BaseDir);
+        FString licPath = VTAPI_ANDROID_LICDIR(BaseDir);
+        
+		UE_LOG(LogReadSpeakerTTS, Display, TEXT("Initializing for android using paths: %s, %s"), *iniPath, *licPath);
+
+        jstring iniPathFinal = Env->NewStringUTF(TCHAR_TO_UTF8(*iniPath));
+        jstring licPathFinal = Env->NewStringUTF(TCHAR_TO_UTF8(*licPath));
+
+        static jmethodID Method = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_InitReadSpeaker", "(Ljava/lang/String;Ljava/lang/String;Z)V", false);
+
+        FJavaWrapper::CallVoidMethod(Env, FJavaWrapper::GameActivityThis, Method, iniPathFinal, licPathFinal, true);
+
+        Engines = TArray<UTTSEngine*>();
+        FReadSpeakerTTSModule::GetEngines(&Engines);
+
+        return 0;
+    }
+    else {
+        return -1;
+    }
+#else
+
+    FString BaseDir = IPluginManager::Get().FindPlugin("ReadSpeakerTTS")->GetBaseDir();
+    int ret = -1;
+
+    FString LibraryPath;
+    FString DbPath;
+
+#if PLATFORM_WINDOWS
+    LibraryPath = VTAPI_WIN64_LIBDIR;
+    DbPath = VTAPI_WIN64_DB;
+#elif PLATFORM_LINUX
+    LibraryPath = VTAPI_LINUX_LIBDIR;
+    DbPath = VTAPI_LINUX_DB;
+#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
+    LibraryPath = VTAPI_PS4_LIBDIR;
+    DbPath = VTAPI_PS4_DB;
+#elif defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
+    LibraryPath = VTAPI_PS5_LIBDIR;
+    DbPath = VTAPI_PS5_DB;
+#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
+    LibraryPath = VTAPI_XSX_LIBDIR;
+    DbPath = VTAPI_XSX_DB;
+#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+    LibraryPath = VTAPI_SWITCH_LIBDIR;
+    DbPath = VTAPI_SWITCH_DB;
+#endif
+
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("Loading TTS with path: %s and %s"), *LibraryPath, *DbPath);
+
+    ret = LoadTTS(LibraryPath, DbPath);
+
+    Engines = TArray<UTTSEngine*>();
+    FReadSpeakerTTSModule::GetEngines(&Engines);
+
+    return ret;
+#endif
+}
+
+void FReadSpeakerTTSModule::PauseAll() {
+    FOnPauseAllDelegate.Broadcast();
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----PAUSING ALL----"));
+}
+
+void FReadSpeakerTTSModule::ResumeAll() {
+    FOnResumeAllDelegate.Broadcast();
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----RESUMING ALL----"));
+}
+
+void FReadSpeakerTTSModule::InterruptAll() {
+    FOnInterruptAllDelegate.Broadcast();
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("----INTERRUPTING ALL----"));
+}
+
+UTTSConverter* FReadSpeakerTTSModule::AcquireConverter()
+{
+    {
+        FScopeLock ScopeLock(&ConverterPoolMutex);
+        for (int32 i = ConverterPool.Num() - 1; i >= 0; i--) {
+            UTTSConverter* converter = ConverterPool[i];
+            // A converter whose sound is still playing is skipped, reusing it would swap its audio under the renderer.
+            if (!converter->IsConverting() && !converter->IsPlaying()) {
+                ConverterPool.RemoveAtSwap(i, 1, false);
+                converter->ResetForReuse();
+                return converter;
+            }
+        }
+    }
+
+    UTTSConverter* converter = NewObject<UTTSConverter>();
+    converter->AddToRoot();
+    converter->bPooled = true;
+    CountBufferAllocation();
+    INC_DWORD_STAT(STAT_TTSPooledConverters);
+    return converter;
+}
+
+void FReadSpeakerTTSModule::ReleaseConverter(UTTSConverter* converter)
+{
+    if (converter == nullptr || !converter->bPooled) {
+        return;
+    }
+    FScopeLock ScopeLock(&ConverterPoolMutex);
+    ConverterPool.AddUnique(converter);
+}
+
+void FReadSpeakerTTSModule::CountBufferAllocation()
+{
+    BufferAllocationCount.Increment();
+    INC_DWORD_STAT(STAT_TTSBufferAllocations);
+}
+
+int32 FReadSpeakerTTSModule::GetBufferAllocationCount()
+{
+    return BufferAllocationCount.GetValue();
+}
+
+void FReadSpeakerTTSModule::ResetBufferAllocationCount()
+{
+    BufferAllocationCount.Reset();
+}
+
+void FReadSpeakerTTSModule::QueueConversionFinished(UTTSConverter* converter)
+{
+    // Both lists keep their allocations, unlike a game thread task per conversion.
+    FScopeLock ScopeLock(&FinishedConvertersMutex);
+    ReserveTracked(FinishedConverters, FinishedConverters.Num() + 1);
+    FinishedConverters.Add(converter);
+}
+
+bool FReadSpeakerTTSModule::DispatchConversionFinished(float deltaTime)
+{
+    {
+        FScopeLock ScopeLock(&FinishedConvertersMutex);
+        if (FinishedConverters.Num() == 0) {
+            return true;
+        }
+        Swap(FinishedConverters, DispatchingConverters);
+    }
+
+    for (UTTSConverter* converter : DispatchingConverters) {
+        converter->OnConversionFinished.Broadcast();
+    }
+    DispatchingConverters.Reset();
+    return true;
+}
+
+void FReadSpeakerTTSModule::RecordUnderruns(const FString& speaker, const FString& engineID, int32 count, double seconds, float preRollSeconds)
+{
+    INC_DWORD_STAT_BY(STAT_TTSUnderruns, count);
+    INC_DWORD_STAT_BY(STAT_TTSUnderrunMs, FMath::RoundToInt(seconds * 1000.0));
+
+    FScopeLock ScopeLock(&UnderrunRecordsMutex);
+    FTTSUnderrunRecord* Record = UnderrunRecords.FindByPredicate([&](const FTTSUnderrunRecord& Existing) {
+        return Existing.Speaker == speaker && Existing.EngineID == engineID;
+    });
+    if (Record == nullptr) {
+        Record = &UnderrunRecords.Add_GetRef({ speaker, engineID, 0, 0.0, 0.0f });
+    }
+    Record->Count += count;
+    Record->Seconds += seconds;
+    Record->PreRollSeconds = preRollSeconds;
+}
+
+TArray<FTTSUnderrunRecord> FReadSpeakerTTSModule::GetUnderrunRecords()
+{
+    FScopeLock ScopeLock(&UnderrunRecordsMutex);
+    return UnderrunRecords;
+}
+
+void FReadSpeakerTTSModule::ResetUnderrunRecords()
+{
+    FScopeLock ScopeLock(&UnderrunRecordsMutex);
+    UnderrunRecords.Reset();
+}
+
+void FReadSpeakerTTSModule::CacheLoudness(const FString& engineID, int32 volume, int32 sampleRate, const FTTSDspSettings& processing, float loudness)
+{
+    FScopeLock ScopeLock(&LoudnessCacheMutex);
+    LoudnessCache.Add(MakeTuple(engineID, volume, sampleRate, GetTypeHash(processing)), loudness);
+}
+
+bool FReadSpeakerTTSModule::GetCachedLoudness(const FString& engineID, int32 volume, int32 sampleRate, const FTTSDspSettings& processing, float& outLoudness)
+{
+    FScopeLock ScopeLock(&LoudnessCacheMutex);
+    const float* Loudness = LoudnessCache.Find(MakeTuple(engineID, volume, sampleRate, GetTypeHash(processing)));
+    if (Loudness == nullptr) {
+        return false;
+    }
+    outLoudness = *Loudness;
+    return true;
+}
+
+void FReadSpeakerTTSModule::RegisterDspStage(FName name, FTTSDspStageFactory factory)
+{
+    FScopeLock ScopeLock(&DspStageFactoriesMutex);
+    DspStageFactories.Add(name, MoveTemp(factory));
+    DspStageRegistryVersion.Increment();
+}
+
+void FReadSpeakerTTSModule::UnregisterDspStage(FName name)
+{
+    FScopeLock ScopeLock(&DspStageFactoriesMutex);
+    if (DspStageFactories.Remove(name) > 0) {
+        DspStageRegistryVersion.Increment();
+    }
+}
+
+int32 FReadSpeakerTTSModule::GetDspStageRegistryVersion()
+{
+    return DspStageRegistryVersion.GetValue();
+}
+
+TUniquePtr<ITTSDspStage> FReadSpeakerTTSModule::CreateDspStage(FName name)
+{
+    FScopeLock ScopeLock(&DspStageFactoriesMutex);
+    const FTTSDspStageFactory* Factory = DspStageFactories.Find(name);
+    if (Factory == nullptr || !*Factory) {
+        return nullptr;
+    }
+    return (*Factory)();
+}
+
+void FReadSpeakerTTSModule::BindSpeaker(UTTSSpeaker *speaker)
+{
+    FOnPauseAllDelegate.AddUObject(speaker, &UTTSSpeaker::PauseSpeaking);
+    FOnResumeAllDelegate.AddUObject(speaker, &UTTSSpeaker::ResumeSpeaking);
+    FOnInterruptAllDelegate.AddUObject(speaker, &UTTSSpeaker::InterruptSpeaking);
+}
+
+void FReadSpeakerTTSModule::UnbindSpeaker(UTTSSpeaker* speaker) {
+    FOnPauseAllDelegate.RemoveAll(speaker);
+    FOnResumeAllDelegate.RemoveAll(speaker);
+    FOnInterruptAllDelegate.RemoveAll(speaker);
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FReadSpeakerTTSModule, ReadSpeakerTTS)
+
+UTTSEngine::UTTSEngine(const FObjectInitializer& ObjectInitializer) : UObject(ObjectInitializer) {
+    if (UseLicenseFile()) {
+        const FString LicensePath = GetLicensePath();
+        const auto LicensePathConv = StringCast<ANSICHAR>(*LicensePath);
+        LicensePathAnsi.Append(LicensePathConv.Get(), LicensePathConv.Length() + 1);
+    }
+}
+
+bool UTTSEngine::UseLicenseFile() {
+#if defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
+    return true;
+#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
+    return true;
+#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
+    return true;
+#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+    return true;
+#elif PLATFORM_WINDOWS
+    FILE* file;
+    if (errno_t err = fopen_s(&file, (char*)VTAPI_WIN64_LIC, "r") == 0) {
+        fclose(file);
+        return true;
+    }
+    else {
+        return false;
+    }
+#elif PLATFORM_LINUX
+    if (FILE* file = fopen((char*)VTAPI_WIN64_LIC, "r")) {
+        fclose(file);
+        return true;
+    }
+    else {
+        return false;
+    }
+#elif defined(PLATFORM_ANDROID) && PLATFORM_ANDROID == 1
+    return false;
+#else
+    return false;
+#endif
+}
+
+FString UTTSEngine::GetLicensePath() {
+#if defined(PLATFORM_PS5) && PLATFORM_PS5 == 1
+    return VTAPI_PS5_LIC;
+#elif defined(PLATFORM_PS4) && PLATFORM_PS4 == 1
+    return VTAPI_PS4_LIC;
+#elif defined(PLATFORM_XSX) && PLATFORM_XSX == 1
+    return VTAPI_XSX_LIC;
+#elif defined(PLATFORM_SWITCH) && PLATFORM_SWITCH == 1
+    return VTAPI_SWITCH_LIC;
+#elif PLATFORM_WINDOWS
+    return VTAPI_WIN64_LIC;
+#elif PLATFORM_LINUX
+    return VTAPI_LINUX_LIC;
+#else
+    return "";
+#endif
+}
+
+int UTTSEngine::Acquire()
+{
+#if PLATFORM_ANDROID
+    return -1;
+#else
+    int ret = 0;
+    if (ReferenceCount == 0 && !KeepInMemory) {
+
+        if (UseLicenseFile()) {
+            ret = RSGame_LoadEngine_LicFile(NameUTF8.GetData(), TypeUTF8.GetData(), LicensePathAnsi.GetData());
+        }
+        else
+        {
+            ret = RSGame_LoadEngine(NameUTF8.GetData(), TypeUTF8.GetData());
+        }
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to be acquired, return code %d"), *Name, ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was acquired"), *Name);
+        }
+    }
+    ReferenceCount++;
+    return ret;
+#endif
+}
+
+int UTTSEngine::Release()
+{
+#if PLATFORM_ANDROID
+    return -1;
+#else
+    int ret = 0;
+    ReferenceCount--;
+
+    if (ReferenceCount == 0 && !KeepInMemory) {
+        ret = RSGame_UnloadEngine(NameUTF8.GetData(), TypeUTF8.GetData());
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to unload, return code %d"), *Name, ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was released"), *Name);
+        }
+    }
+    return ret;
+#endif
+}
+
+int UTTSEngine::LoadEngine()
+{
+#if PLATFORM_ANDROID
+    return -1;
+#else
+    {
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
+        FScopeLock ScopeLock = FScopeLock(&(this->EngineMutex));
+#else
+        FScopeLock(&(this->EngineMutex));
+#endif
+
+        int ret = -1;
+        if (ReferenceCount == 0) {
+
+            if (UseLicenseFile()) {
+                ret = RSGame_LoadEngine_LicFile(NameUTF8.GetData(), TypeUTF8.GetData(), LicensePathAnsi.GetData());
+            }
+            else
+            {
+                ret = RSGame_LoadEngine(NameUTF8.GetData(), TypeUTF8.GetData());
+            }
+
+            if (ret != 0) {
+                UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed load, return code %d"), *Name, ret);
+            }
+            else {
+                UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was loaded"), *Name);
+            }
+        }
+        KeepInMemory = true;
+
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
+        ScopeLock.Unlock();
+#endif
+        return ret;
+    }
+#endif
+}
+
+int UTTSEngine::UnloadEngine()
+{
+#if PLATFORM_ANDROID
+    return -1;
+#else
+    {
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
+        FScopeLock ScopeLock = FScopeLock(&(this->EngineMutex));
+#else
+        FScopeLock(&(this->EngineMutex));
+#endif
+
+        int ret = -1;
+        if (ReferenceCount == 0) {
+            ret = RSGame_UnloadEngine(NameUTF8.GetData(), TypeUTF8.GetData());
+            if (ret != 0) {
+                UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine %s failed to unload, return code %d"), *Name, ret);
+            }
+            else {
+                UE_LOG(LogReadSpeakerTTS, Display, TEXT("Engine %s was unloaded"), *Name);
+            }
+        }
+        KeepInMemory = false;
+
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
+        ScopeLock.Unlock();
+#endif
+        return 0;
+    }
+#endif
+}
+
+READSPEAKERTTS_API FString UTTSEngine::GetID() {
+    return ID;
+}
+
+USoundWaveProceduralTTS::USoundWaveProceduralTTS(const FObjectInitializer& ObjectInitializer) : USoundWaveProcedural(ObjectInitializer)
+{
+    NumChannels = 1;
+    bCanProcessAsync = true;
+    bLooping = false;
+    SampleRate = 22050;
+    NumSamplesToGeneratePerCallback = 1024;
+    bProcedural = true;
+}
+
+void USoundWaveProceduralTTS::SetAudioData(TArray<int16>& data) {
+    {
+        FScopeLock ScopeLock(&DataMutex);
+        Swap(TTSData, data);
+        ReadCursor.Set(0);
+    }
+    data.Reset();
+    FillAudioQueue(TTSData.Num());
+    Length = CalculateAudioDuration();
+}
+
+double USoundWaveProceduralTTS::CalculateAudioDuration() {
+    // TTSData always holds int16 frames, whatever format RSGame produced.
+    if (TTSSampleRate <= 0 || NumChannels <= 0) {
+        return 0.0;
+    }
+    return (double)(TTSData.Num() / NumChannels) / (double)TTSSampleRate;
+}
+
+void USoundWaveProceduralTTS::FillAudioQueue(int32 SamplesRequested)
+{
+    ResetAudio();
+    ReadCursor.Set(0);
+}
+
+int32 USoundWaveProceduralTTS::OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples)
+{
+    // Serve TTSData in place instead of copying the whole utterance into the audio queue up front.
+    FScopeLock ScopeLock(&DataMutex);
+    const int32 Cursor = ReadCursor.GetValue();
+    const int32 SamplesToCopy = FMath::Min(NumSamples, TTSData.Num() - Cursor);
+    if (SamplesToCopy <= 0) {
+        return 0;
+    }
+
+    OutAudio.Append((const uint8*)(TTSData.GetData() + Cursor), SamplesToCopy * sizeof(int16));
+    ReadCursor.Add(SamplesToCopy);
+    return SamplesToCopy;
+}
+
+void USoundWaveProceduralTTS::SetSampleRate(int32 Sampling) {
+    SampleRate = Sampling;
+}
+
+int32 USoundWaveProceduralTTS::GetPlayedFrames() const {
+    return NumChannels > 0 ? ReadCursor.GetValue() / NumChannels : 0;
+}
+
+int32 USoundWaveProceduralTTS::GetNumFrames() const {
+    return NumChannels > 0 ? TTSData.Num() / NumChannels : 0;
+}
+
+UTTSConverter::UTTSConverter(const FObjectInitializer& ObjectInitializer) : UObject(ObjectInitializer) {
+    bApplyVolumeAsGain = false;
+    ConversionGain = 1.0f;
+    SynthesisFormat = TTSOutputFormat::PCM16;
+    OutputSampleRate = 0;
+    PageLength = 0;
+    CurrentPage = INDEX_NONE;
+    PageTimeOffset = 0.0f;
+    ScheduledStartTime = -1.0;
+    QuartzClock = NULL;
+    bTrimSilence = false;
+    SilenceThreshold = 0.002f;
+    SilencePadding = 0.05f;
+    LeadingTrimSeconds = 0.0f;
+    bNormalizeLoudness = false;
+    StreamGain = 1.0f;
+    TargetLoudness = -18.0f;
+    IntegratedLoudness = FTTSLoudnessMeter::MinLoudness;
+    ResamplerQuality = ETTSResamplerQuality::Medium;
+    SoundWave = NewObject<USoundWaveProceduralTTS>();
+    SoundWave->AddToRoot();
+}
+
+void UTTSConverter::BeginDestroy() {
+    if (Task != NULL) {
+        Task->EnsureCompletion();
+        delete Task;
+        Task = NULL;
+    }
+    Super::BeginDestroy();
+}
+
+void UTTSConverter::ResetForReuse() {
+    AudioData.Reset();
+    Timeline.Reset();
+    PageLength = 0;
+    bTrimSilence = false;
+    // The stages are kept, every request builds the chain and Build() only recreates them if its settings changed.
+    bNormalizeLoudness = false;
+    StreamGain = 1.0f;
+    IntegratedLoudness = FTTSLoudnessMeter::MinLoudness;
+    QuartzClock = NULL;
+    QuantizationBoundary = FQuartzQuantizationBoundary();
+    QuartzCommandEvent.Unbind();
+    ScheduledStartTime = -1.0;
+    FinishedConverting = false;
+    Stream.Reset();
+    OnConversionFinished.Clear();
+    OnWord.Clear();
+    OnViseme.Clear();
+    OnMark.Clear();
+    OnScheduledStart.Clear();
+}
+
+bool UTTSConverter::IsConverting() {
+    return Task != NULL && !Task->IsDone();
+}
+
+bool UTTSConverter::IsPlaying() const {
+    return IsValid(AudioComponent) && AudioComponent->Sound == SoundWave && AudioComponent->IsPlaying();
+}
+
+void UTTSConverter::ConvertLocked(bool SyncInfo) {
+    {
+#if PLATFORM_ANDROID
+        FScopeLock ScopeLock(&(FReadSpeakerTTSModule::AndroidMutex));
+#else
+        FScopeLock ScopeLock(&(Engine->EngineMutex));
+#endif
+        if (SyncInfo) {
+            ConvertToBuffer_SyncInfo();
+        }
+        else {
+            ConvertToBuffer();
+        }
+    }
+
+    // Waiting for playback to make room happens only now, so other speakers aren't kept from the engine meanwhile.
+    if (Stream.IsValid()) {
+        DrainStreamBacklog();
+    }
+}
+
+bool UTTSConverter::IsPaged() const {
+    // SSML can't be cut at arbitrary sentences without breaking its tags, so it is always synthesized whole.
+    return Stream.IsValid() && PageLength > 0 && TextType == TTSTextType::Normal;
+}
+
+void UTTSConverter::SplitIntoPages() {
+    Pages.Reset();
+    const int32 TextLen = Text.Len();
+    int32 Start = 0;
+    while (Start < TextLen) {
+        int32 End = FMath::Min(Start + PageLength, TextLen);
+        if (End < TextLen) {
+            // Prefer ending the page after a sentence, then after a word, and only cut a word if there is no space at all.
+            int32 SentenceBreak = INDEX_NONE;
+            int32 WordBreak = INDEX_NONE;
+            for (int32 Index = End; Index > Start && SentenceBreak == INDEX_NONE; Index--) {
+                if (!FChar::IsWhitespace(Text[Index])) {
+                    continue;
+                }
+                const TCHAR Previous = Text[Index - 1];
+                if (Text[Index] == TEXT('\n') || Previous == TEXT('.') || Previous == TEXT('!') || Previous == TEXT('?') || Previous == TEXT(';')) {
+                    SentenceBreak = Index;
+                }
+                else if (WordBreak == INDEX_NONE) {
+                    WordBreak = Index;
+                }
+            }
+            End = SentenceBreak != INDEX_NONE ? SentenceBreak : (WordBreak != INDEX_NONE ? WordBreak : End);
+        }
+
+        if (Pages.Num() == Pages.Max()) {
+            FReadSpeakerTTSModule::CountBufferAllocation();
+        }
+        Pages.Add({ Start, End - Start });
+
+        Start = End;
+        while (Start < TextLen && FChar::IsWhitespace(Text[Start])) {
+            Start++;
+        }
+    }
+}
+
+void UTTSConverter::ConvertPages(bool SyncInfo) {
+    SplitIntoPages();
+
+    const int32 Rate = GetOutputSampleRate();
+    const int32 NumChannels = Stream->GetNumChannels();
+    for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++) {
+        // Wait for playback before taking the engine, so a page isn't synthesized while its audio has nowhere to go
+        // and other speakers can use the engine in the meantime.
+        if (!Stream->WaitForRoom(StreamUtteranceId)) {
+            break;
+        }
+
+        // Each page is written out before the next starts, so everything written so far is exactly where this page starts.
+        CurrentPage = PageIndex;
+        const int64 WrittenFrames = (Stream->GetSamplesWritten() - StreamStartSample.load()) / NumChannels;
+        PageTimeOffset = Rate > 0 ? (float)((double)WrittenFrames / Rate) : 0.0f;
+
+        // The engine is taken per page so other speakers sharing the voice can interleave with a long document.
+        ConvertLocked(SyncInfo);
+
+        // Events which have been played are no longer needed, this keeps the timeline from growing with the document.
+        Timeline.Compact();
+    }
+
+    CurrentPage = INDEX_NONE;
+    PageTimeOffset = 0.0f;
+    NotifyConversionFinished();
+}
+
+void UTTSConverter::NotifyConversionFinished() {
+    // When converting in pages this is reported once, by ConvertPages(), after the last page.
+    if (CurrentPage != INDEX_NONE) {
+        return;
+    }
+
+    IntegratedLoudness = LoudnessMeter.GetIntegratedLoudness();
+    if (Engine != NULL && IntegratedLoudness > FTTSLoudnessMeter::MinLoudness) {
+        FReadSpeakerTTSModule::CacheLoudness(Engine->ID, Volume, GetOutputSampleRate(), DspChain.GetSettings(), IntegratedLoudness);
+    }
+
+    FinishedConverting = true;
+
+    // Report back to gamethread when done.
+    FReadSpeakerTTSModule::QueueConversionFinished(this);
+}
+
+void UTTSConverter::StartTask(bool SyncInfo) {
+    // The task is kept and restarted for each conversion instead of being allocated per utterance.
+    if (Task == NULL) {
+        Task = new FAsyncTask<FTTSSynthesizeTask>(TWeakObjectPtr<UTTSConverter>(this), SyncInfo);
+    }
+    else {
+        Task->EnsureCompletion();
+        Task->GetTask().SetSyncInfo(SyncInfo);
+    }
+    // Reset here on the game thread rather than by the task, which would undo an interrupt's Skip() made before it ran.
+    Timeline.Reset();
+    Task->StartBackgroundTask();
+}
+
+int32 UTTSConverter::GetSynthesisVolume() {
+    // Only attenuation is folded into sample conversion. Above 100 the gain would clip the int16 output,
+    // while RSGame can raise the level of its own signal path.
+    if (bApplyVolumeAsGain && Volume <= 100) {
+        ConversionGain = Volume / 100.0f;
+        return 100;
+    }
+    ConversionGain = 1.0f;
+    return Volume;
+}
+
+FStringView UTTSConverter::GetSynthesisText() const {
+    if (CurrentPage != INDEX_NONE) {
+        return FStringView(*Text + Pages[CurrentPage].Start, Pages[CurrentPage].Len);
+    }
+    return FStringView(Text);
+}
+
+const char* UTTSConverter::GetTextUTF8() {
+    const FStringView Source = GetSynthesisText();
+    const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(Source.GetData(), Source.Len());
+    ReserveTracked(TextUTF8, Length + 1);
+    TextUTF8.SetNumUninitialized(Length + 1, false);
+    FPlatformString::Convert((UTF8CHAR*)TextUTF8.GetData(), Length, Source.GetData(), Source.Len());
+    TextUTF8[Length] = '\0';
+    return TextUTF8.GetData();
+}
+
+void UTTSConverter::audio_callback(void* context, char* data, int* length)
+{
+    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
+    converter->RecieveAudioCallback(data, length);
+}
+
+void UTTSConverter::word_callback(void* context, int* startPos, int* endPos, float* time, int* length) {
+    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
+    converter->RecieveWordCallback(startPos, endPos, time, length);
+}
+
+void UTTSConverter::viseme_callback(void* context, short* visemeId, float* time, int* length) {
+    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
+    converter->RecieveVisemeCallback(visemeId, time, length);
+}
+
+void UTTSConverter::mark_callback(void* context, char* markName, float* time, int* length) {
+    UTTSConverter* converter = reinterpret_cast<UTTSConverter*>(context);
+    converter->RecieveMarkCallback(markName, time, length);
+}
+
+void UTTSConverter::ConvertToBufferAsync() {
+    StartTask(false);
+}
+
+void UTTSConverter::ConvertToBufferAsync_SyncInfo() {
+    StartTask(true);
+}
+
+void UTTSConverter::ConvertToStreamAsync(TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> InStream, bool SyncInfo) {
+    Stream = InStream;
+    StreamUtteranceId = InStream->BeginUtterance();
+    StreamStartSample.store(INDEX_NONE);
+    StreamEndSample.store(INDEX_NONE);
+    StartTask(SyncInfo);
+}
+
+bool UTTSConverter::BeginStreamWriting() {
+    // Where this utterance starts playing is only known once the one ahead of it has been written completely.
+    if (!Stream->WaitForTurn(StreamUtteranceId)) {
+        return false;
+    }
+    StreamStartSample.store(Stream->GetSamplesWritten());
+    return true;
+}
+
+void UTTSConverter::EndStreamWriting() {
+    StreamEndSample.store(Stream->GetSamplesWritten());
+    Stream->EndUtterance(StreamUtteranceId);
+}
+
+bool UTTSConverter::HasStreamPlayed() const {
+    if (!Stream.IsValid() || Stream->IsCancelled(StreamUtteranceId)) {
+        return true;
+    }
+    const int64 EndSample = StreamEndSample.load();
+    return EndSample >= 0 && Stream->GetSamplesRead() >= EndSample;
+}
+
+void UTTSConverter::ConvertToBuffer()
+{
+    int ret = -1;
+
+#if PLATFORM_ANDROID
+    if (Engine == NULL) {
+		UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
+        return;
+    }
+
+    BeginConversion();
+
+    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+    {
+        jmethodID TextToBufferMethod = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_TextToBufferReadSpeaker", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;IIIIII)[B", false);
+
+        jstring text = Env->NewStringUTF(TCHAR_TO_UTF8(*FString(GetSynthesisText())));
+        jstring engName = Env->NewStringUTF(TCHAR_TO_UTF8(*(Engine->Name)));
+        jstring engType = Env->NewStringUTF(TCHAR_TO_UTF8(*(Engine->Type)));
+        
+        jbyteArray arr = (jbyteArray)FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, TextToBufferMethod, text, engName, engType, Volume, Pitch, Speed, Pause, CommaPause, (int)TextType);
+        
+        int count = Env->GetArrayLength(arr);
+        
+        jbyte* b = Env->GetByteArrayElements(arr, 0);
+        // The Java side always produces 16-bit audio at the requested volume, whatever OutputFormat asks for.
+        SynthesisFormat = TTSOutputFormat::PCM16;
+        ConversionGain = 1.0f;
+        RecieveAudioCallback((char*)b, &count);
+    }
+#else
+    if (Engine == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
+        return;
+    }
+    else {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Synthesizing with voice %s"), *(Engine->ID));
+
+        ret = Engine->Acquire();
+
+        BeginConversion();
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Acquiring Engine %s failed, return code: %d"), *(Engine->ID), ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Acquiring Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
+        }
+
+        ret = RSGame_TextToBuffer(GetTextUTF8(), Engine->NameUTF8.GetData(), Engine->TypeUTF8.GetData(), &audio_callback, GetSynthesisVolume(), Pitch, Speed, Pause, CommaPause, (int)TextType, (int)OutputFormat, (void*)this);
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("TextToBuffer failed Engine=%s, Text=%s, return code: %d"), *(Engine->ID), *Text, ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("TextToBuffer success"));
+        }
+
+        ret = Engine->Release();
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Release Engine %s failed, return code: %d"), *(Engine->ID), ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Releasing Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
+        }
+    }
+#endif
+
+    EndConversion();
+    NotifyConversionFinished();
+}
+
+void UTTSConverter::ConvertToBuffer_SyncInfo()
+{
+#if PLATFORM_ANDROID
+    UE_LOG(LogReadSpeakerTTS, Error, TEXT("SyncInfo not supported on Android."));
+    return;
+#else
+    int ret = -1;
+    if (Engine == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("TTSEngine undefined"));
+        return;
+    }
+    else {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Synthesizing with voice %s"), *(Engine->ID));
+
+        ret = Engine->Acquire();
+
+        BeginConversion();
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Acquiring Engine %s failed, return code: %d"), *(Engine->ID), ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Acquiring Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
+        }
+
+        ret = RSGame_TextToBuffer_SyncInfo(GetTextUTF8(), Engine->NameUTF8.GetData(), Engine->TypeUTF8.GetData(), &audio_callback, &word_callback, &viseme_callback, &mark_callback, GetSynthesisVolume(), Pitch, Speed, Pause, CommaPause, (int)TextType, (int)OutputFormat, (void*)this);
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("TextToBuffer_SyncInfo failed Engine=%s, Text=%s, return code: %d"), *(Engine->ID), *Text, ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("TextToBuffer success"));
+        }
+
+        ret = Engine->Release();
+
+        if (ret != 0) {
+            UE_LOG(LogReadSpeakerTTS, Error, TEXT("Release Engine %s failed, return code: %d"), *(Engine->ID), ret);
+        }
+        else {
+            UE_LOG(LogReadSpeakerTTS, Display, TEXT("Releasing Engine %s succeeded, current reference count: %d"), *(Engine->ID), Engine->ReferenceCount);
+        }
+
+        EndConversion();
+        NotifyConversionFinished();
+    }
+#endif
+}
+
+void UTTSConverter::RecieveAudioCallback(char* data, int* length) {
+    const bool bIs8Bit = SynthesisFormat == TTSOutputFormat::PCM8;
+    const int32 SrcChannels = (Engine != NULL && Engine->Channels > 0) ? Engine->Channels : 1;
+    const int32 NumFrames = *length / ((bIs8Bit ? sizeof(uint8) : sizeof(int16)) * SrcChannels);
+
+    if (Resampler.IsActive()) {
+        // Resample in float once here, so neither the mixer nor lip sync has to convert the rate again.
+        const int32 DstChannels = Stream.IsValid() ? Stream->GetNumChannels() : 1;
+        ReserveTracked(ResampleInput, NumFrames * DstChannels);
+        ResampleInput.SetNumUninitialized(NumFrames * DstChannels, false);
+        if (!ConvertSamples(data, SrcChannels, ResampleInput.GetData(), DstChannels, NumFrames)) {
+            return;
+        }
+        ResampleOutput.Reset();
+        ReserveTracked(ResampleOutput, Resampler.GetMaxOutputFrames(NumFrames) * DstChannels);
+        Resampler.Process(ResampleInput.GetData(), NumFrames, ResampleOutput);
+        EmitResampled();
+        return;
+    }
+
+    if (Stream.IsValid()) {
+        // Streaming conversion, hand the chunk to the render thread as float instead of buffering it.
+        const int32 DstChannels = Stream->GetNumChannels();
+        ReserveTracked(StreamScratch, NumFrames * DstChannels);
+        StreamScratch.SetNumUninitialized(NumFrames * DstChannels, false);
+        if (!ConvertSamples(data, SrcChannels, StreamScratch.GetData(), DstChannels, NumFrames)) {
+            return;
+        }
+        DspChain.Process(StreamScratch.GetData(), NumFrames);
+        LoudnessMeter.Process(StreamScratch.GetData(), NumFrames);
+        ApplyStreamGain(StreamScratch.GetData(), StreamScratch.Num());
+        WriteStream(StreamScratch.GetData(), StreamScratch.Num());
+        return;
+    }
+
+    // The sound wave and the audio data consumers are mono int16.
+    if (!DspChain.IsEmpty()) {
+        // Processing needs float, so go through the scratch buffer instead of converting straight to int16.
+        ReserveTracked(StreamScratch, NumFrames);
+        StreamScratch.SetNumUninitialized(NumFrames, false);
+        if (!ConvertSamples(data, SrcChannels, StreamScratch.GetData(), 1, NumFrames)) {
+            return;
+        }
+        DspChain.Process(StreamScratch.GetData(), NumFrames);
+        LoudnessMeter.Process(StreamScratch.GetData(), NumFrames);
+        AppendAudioData(StreamScratch.GetData(), NumFrames);
+        return;
+    }
+
+    const int32 Offset = AudioData.Num();
+    ReserveTracked(AudioData, Offset + NumFrames);
+    AudioData.AddUninitialized(NumFrames);
+    if (!ConvertSamples(data, SrcChannels, AudioData.GetData() + Offset, 1, NumFrames)) {
+        AudioData.SetNum(Offset, false);
+        return;
+    }
+    LoudnessMeter.Process(AudioData.GetData() + Offset, NumFrames);
+}
+
+void UTTSConverter::EmitResampled() {
+    const int32 DstChannels = Stream.IsValid() ? Stream->GetNumChannels() : 1;
+    DspChain.Process(ResampleOutput.GetData(), ResampleOutput.Num() / DstChannels);
+    LoudnessMeter.Process(ResampleOutput.GetData(), ResampleOutput.Num() / DstChannels);
+
+    if (Stream.IsValid()) {
+        ApplyStreamGain(ResampleOutput.GetData(), ResampleOutput.Num());
+        WriteStream(ResampleOutput.GetData(), ResampleOutput.Num());
+        return;
+    }
+
+    AppendAudioData(ResampleOutput.GetData(), ResampleOutput.Num());
+}
+
+void UTTSConverter::AppendAudioData(const float* Samples, int32 NumSamples) {
+    const int32 Offset = AudioData.Num();
+    ReserveTracked(AudioData, Offset + NumSamples);
+    AudioData.AddUninitialized(NumSamples);
+    TTSSampleConversion::Convert<TTSSampleConversion::FFloat32, int16, 1, 1>(Samples, AudioData.GetData() + Offset, NumSamples, 1.0f);
+}
+
+void UTTSConverter::BeginConversion() {
+    // A task's timeline was reset when it was started, and pages add to the timeline of the whole text.
+    if (CurrentPage == INDEX_NONE && !IsConverting()) {
+        Timeline.Reset();
+    }
+    const int32 DstChannels = Stream.IsValid() ? Stream->GetNumChannels() : 1;
+    Resampler.Configure(Engine->Sampling, GetOutputSampleRate(), DstChannels, ResamplerQuality);
+    // Filter and envelope state carries over between pages of the same text.
+    if (CurrentPage <= 0) {
+        DspChain.Prepare(GetOutputSampleRate(), DstChannels);
+        LoudnessMeter.Prepare(GetOutputSampleRate(), DstChannels);
+    }
+    SoundWave->SetSampleRate(GetOutputSampleRate());
+    SynthesisFormat = OutputFormat;
+
+    ConversionStart = AudioData.Num();
+    bFoundAudio = false;
+    LeadingTrimSeconds = 0.0f;
+    DroppedLeadingSamples = 0;
+    HeldSilence.Reset();
+}
+
+void UTTSConverter::EndConversion() {
+    // Drain the samples the resampler holds back for its filter.
+    if (Resampler.IsActive()) {
+        const int32 DstChannels = Stream.IsValid() ? Stream->GetNumChannels() : 1;
+        ResampleOutput.Reset();
+        ReserveTracked(ResampleOutput, Resampler.GetMaxOutputFrames(0) * DstChannels);
+        Resampler.Flush(ResampleOutput);
+        EmitResampled();
+    }
+
+    if (bTrimSilence) {
+        if (Stream.IsValid()) {
+            // Only the padding of the silence held back at the end is kept.
+            if (bFoundAudio) {
+                const int32 PaddingSamples = GetSilencePaddingFrames() * Stream->GetNumChannels();
+                PushStream(HeldSilence.GetData(), FMath::Min(PaddingSamples, HeldSilence.Num()));
+            }
+            HeldSilence.Reset();
+        }
+        else {
+            TrimBufferedSilence();
+        }
+    }
+}
+
+int32 UTTSConverter::GetSilencePaddingFrames() const {
+    return FMath::Max(FMath::RoundToInt(SilencePadding * GetOutputSampleRate()), 0);
+}
+
+void UTTSConverter::TrimLeadingSilence(int32 NumFrames) {
+    const int32 Rate = GetOutputSampleRate();
+    if (NumFrames <= 0 || Rate <= 0) {
+        return;
+    }
+    // Events already reported for this conversion move back with the audio, later ones are adjusted as they arrive.
+    LeadingTrimSeconds = (float)NumFrames / (float)Rate;
+    Timeline.Shift(PageTimeOffset, -LeadingTrimSeconds);
+}
+
+void UTTSConverter::TrimBufferedSilence() {
+    // AudioData is mono, and may still hold earlier conversions which have not been taken.
+    int16* Samples = AudioData.GetData() + ConversionStart;
+    const int32 NumFrames = AudioData.Num() - ConversionStart;
+    const int32 First = TTSSilenceDetection::FindFirstAbove(Samples, NumFrames, SilenceThreshold);
+    if (First == INDEX_NONE) {
+        return;
+    }
+    const int32 Last = TTSSilenceDetection::FindLastAbove(Samples, NumFrames, SilenceThreshold);
+
+    const int32 Padding = GetSilencePaddingFrames();
+    const int32 Start = FMath::Max(First - Padding, 0);
+    const int32 End = FMath::Min(Last + 1 + Padding, NumFrames);
+    AudioData.SetNum(ConversionStart + End, false);
+    AudioData.RemoveAt(ConversionStart, Start, false);
+    TrimLeadingSilence(Start);
+}
+
+void UTTSConverter::HoldSilence(const float* Samples, int32 NumSamples, int32 MaxHeld) {
+    if (NumSamples <= 0) {
+        return;
+    }
+    ReserveTracked(HeldSilence, HeldSilence.Num() + NumSamples);
+    HeldSilence.Append(Samples, NumSamples);
+
+    // Before the audio starts the oldest silence is dropped, after that it is a pause in the text and is written out.
+    const int32 Excess = HeldSilence.Num() - MaxHeld;
+    if (Excess > 0) {
+        if (bFoundAudio) {
+            PushStream(HeldSilence.GetData(), Excess);
+        }
+        else {
+            DroppedLeadingSamples += Excess;
+        }
+        HeldSilence.RemoveAt(0, Excess, false);
+    }
+}
+
+void UTTSConverter::ApplyStreamGain(float* Samples, int32 NumSamples) {
+    // Applied after measuring, so the loudness cached for the voice stays that of the unnormalized audio.
+    if (StreamGain == 1.0f) {
+        return;
+    }
+    for (int32 Index = 0; Index < NumSamples; Index++) {
+        Samples[Index] *= StreamGain;
+    }
+}
+
+void UTTSConverter::PushStream(const float* Samples, int32 NumSamples) {
+    // This runs inside the engine lock, so audio which doesn't fit is kept for DrainStreamBacklog() instead of
+    // waiting for playback here.
+    if (NumSamples <= 0) {
+        return;
+    }
+    int32 Written = 0;
+    if (StreamBacklog.Num() == 0) {
+        Written = Stream->TryWrite(StreamUtteranceId, Samples, NumSamples);
+        if (Written == INDEX_NONE) {
+            return;
+        }
+    }
+    if (Written < NumSamples) {
+        ReserveTracked(StreamBacklog, StreamBacklog.Num() + NumSamples - Written);
+        StreamBacklog.Append(Samples + Written, NumSamples - Written);
+    }
+}
+
+void UTTSConverter::DrainStreamBacklog() {
+    if (StreamBacklog.Num() > 0) {
+        Stream->Write(StreamUtteranceId, StreamBacklog.GetData(), StreamBacklog.Num());
+        StreamBacklog.Reset();
+    }
+}
+
+void UTTSConverter::WriteStream(const float* Samples, int32 NumSamples) {
+    if (!bTrimSilence) {
+        PushStream(Samples, NumSamples);
+        return;
+    }
+
+    const int32 NumChannels = Stream->GetNumChannels();
+    const int32 PaddingSamples = GetSilencePaddingFrames() * NumChannels;
+
+    if (!bFoundAudio) {
+        const int32 First = TTSSilenceDetection::FindFirstAbove(Samples, NumSamples, SilenceThreshold);
+        if (First == INDEX_NONE) {
+            HoldSilence(Samples, NumSamples, PaddingSamples);
+            return;
+        }
+
+        // Keep the padding right before the first audible frame, from the held silence and this chunk.
+        const int32 FirstFrameSample = First - First % NumChannels;
+        HoldSilence(Samples, FirstFrameSample, PaddingSamples);
+        bFoundAudio = true;
+        TrimLeadingSilence(DroppedLeadingSamples / NumChannels);
+        Samples += FirstFrameSample;
+        NumSamples -= FirstFrameSample;
+    }
+
+    // A silent tail may turn out to be the trailing silence, so it is held back until more audio arrives.
+    const int32 Last = TTSSilenceDetection::FindLastAbove(Samples, NumSamples, SilenceThreshold);
+    if (Last == INDEX_NONE) {
+        HoldSilence(Samples, NumSamples, FMath::Max(PaddingSamples, FMath::RoundToInt(MaxHeldSilenceSeconds * GetOutputSampleRate()) * NumChannels));
+        return;
+    }
+
+    if (HeldSilence.Num() > 0) {
+        PushStream(HeldSilence.GetData(), HeldSilence.Num());
+        HeldSilence.Reset();
+    }
+    const int32 AudibleEnd = Last - Last % NumChannels + NumChannels;
+    PushStream(Samples, AudibleEnd);
+    HoldSilence(Samples + AudibleEnd, NumSamples - AudibleEnd, TNumericLimits<int32>::Max());
+}
+
+double UTTSConverter::GetPlaybackTime() {
+    const int32 Rate = GetOutputSampleRate();
+    if (Rate <= 0) {
+        return 0.0;
+    }
+
+    int64 PlayedFrames;
+    if (Stream.IsValid()) {
+        // The stream may still be playing earlier utterances, count from where this one was written.
+        const int64 StartSample = StreamStartSample.load();
+        PlayedFrames = StartSample >= 0 ? FMath::Max<int64>(Stream->GetSamplesRead() - StartSample, 0) / Stream->GetNumChannels() : 0;
+    }
+    else {
+        PlayedFrames = SoundWave->GetPlayedFrames();
+    }
+    const double CursorTime = (double)PlayedFrames / (double)Rate;
+
+    if (QuartzClock != NULL) {
+        // The renderer may start reading a quantized sound before its boundary, so time counts on the Quartz clock,
+        // which runs on rendered audio, from the boundary it started on. The cursor only keeps events from getting
+        // ahead of the audio actually rendered.
+        UWorld* World = AudioComponent != NULL ? AudioComponent->GetWorld() : NULL;
+        if (ScheduledStartTime < 0.0 || World == NULL) {
+            return 0.0;
+        }
+        return FMath::Clamp((double)QuartzClock->GetEstimatedRunTime(World) - ScheduledStartTime, 0.0, CursorTime);
+    }
+    return CursorTime;
+}
+
+int32 UTTSConverter::GetOutputSampleRate() const {
+    if (OutputSampleRate > 0) {
+        return OutputSampleRate;
+    }
+    return Engine != NULL ? Engine->Sampling : 0;
+}
+
+template<typename DstType>
+bool UTTSConverter::ConvertSamples(const char* data, int32 SrcChannels, DstType* Dst, int32 DstChannels, int32 NumFrames) {
+    using namespace TTSSampleConversion;
+
+    const bool bConverted = SynthesisFormat == TTSOutputFormat::PCM8
+        ? ConvertInterleaved<FPCM8, DstType>((const uint8*)data, SrcChannels, Dst, DstChannels, NumFrames, ConversionGain)
+        : ConvertInterleaved<FPCM16, DstType>((const int16*)data, SrcChannels, Dst, DstChannels, NumFrames, ConversionGain);
+
+    if (!bConverted) {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("Unsupported channel conversion %d -> %d, dropping audio."), SrcChannels, DstChannels);
+    }
+    return bConverted;
+}
+
+float UTTSConverter::GetEventTime(float SynthesisTime) const {
+    // Offset to the page, then moved back by the silence trimmed from the start of the page.
+    return FMath::Max(SynthesisTime + PageTimeOffset - LeadingTrimSeconds, PageTimeOffset);
+}
+
+void UTTSConverter::RecieveWordCallback(int* startPos, int* endPos, float* time, int* length) {
+    // Positions and times are reported relative to the page, make them relative to the whole text.
+    const int32 TextOffset = CurrentPage != INDEX_NONE ? Pages[CurrentPage].Start : 0;
+    const float Time = GetEventTime(*time);
+    Timeline.AddWord(*startPos + TextOffset, *endPos + TextOffset, Time);
+    OnWord.Broadcast(*startPos + TextOffset, *endPos + TextOffset, Time);
+}
+
+void UTTSConverter::RecieveVisemeCallback(short* visemeId, float* time, int* length) {
+    const float Time = GetEventTime(*time);
+    Timeline.AddViseme(*visemeId, Time);
+    OnViseme.Broadcast(*visemeId, Time);
+}
+
+void UTTSConverter::RecieveMarkCallback(char* markName, float* time, int* length) {
+    // A mark carries its name to the delegates as an FString, so each one costs a string allocation.
+    const float Time = GetEventTime(*time);
+    FReadSpeakerTTSModule::CountBufferAllocation();
+    Timeline.AddMark(FString(markName), Time);
+    if (OnMark.IsBound()) {
+        FReadSpeakerTTSModule::CountBufferAllocation();
+        OnMark.Broadcast(FString(markName), Time);
+    }
+}
+
+void UTTSConverter::ClearAudioData() {
+    AudioData.Empty();
+}
+void UTTSConverter::TakeAudioData(TArray<int16>& OutData)
+{
+    OutData.Reset();
+    if (FinishedConverting) {
+        Swap(OutData, AudioData);
+    }
+}
+
+TArray<int16> UTTSConverter::GetAudioData()
+{
+    if (FinishedConverting) {
+        return AudioData;
+    }
+    else {
+        return TArray<int16>();
+    }
+}
+
+void UTTSConverter::OnQuartzCommandEvent(EQuartzCommandDelegateSubType EventType, FName Name) {
+    // The clock keeps its own copy of the delegate, so events of a start made before ResetForReuse() still arrive.
+    if (!QuartzCommandEvent.IsBound()) {
+        return;
+    }
+    UWorld* World = AudioComponent != NULL ? AudioComponent->GetWorld() : NULL;
+    switch (EventType) {
+    case EQuartzCommandDelegateSubType::CommandOnStarted:
+        QuartzCommandEvent.Unbind();
+        if (World != NULL && QuartzClock != NULL) {
+            ScheduledStartTime = GetQuantizedStartTime(World);
+            OnScheduledStart.Broadcast((float)ScheduledStartTime);
+        }
+        break;
+    case EQuartzCommandDelegateSubType::CommandOnFailedToQueue:
+        // Better late than silent, play unquantized and follow the render cursor instead.
+        UE_LOG(LogReadSpeakerTTS, Warning, TEXT("Quantized start failed to queue, playing immediately."));
+        QuartzCommandEvent.Unbind();
+        QuartzClock = NULL;
+        if (AudioComponent->IsValidLowLevel()) {
+            AudioComponent->Play(0.0f);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+double UTTSConverter::GetQuantizedStartTime(UWorld* World) const {
+    // The event reaches the game thread up to a frame after the start, so the clock has moved on since. Boundaries
+    // fall on whole periods of the quantization type from the start of the clock, so the start is the last one
+    // passed, as long as the event arrives within a period.
+    const double Now = QuartzClock->GetEstimatedRunTime(World);
+    const double Period = QuartzClock->GetDurationOfQuantizationTypeInSeconds(World, QuantizationBoundary.Quantization, 1.0f);
+    if (Period <= 0.0) {
+        return Now;
+    }
+    return FMath::FloorToDouble(Now / Period) * Period;
+}
+
+float UTTSConverter::GetLoudnessGain() const {
+    if (!bNormalizeLoudness) {
+        return 1.0f;
+    }
+    return FTTSLoudnessMeter::GetNormalizationGain(IntegratedLoudness, TargetLoudness, MaxLoudnessCorrectionDb);
+}
+
+void UTTSConverter::Play()
+{
+    SoundWave->TTSSampleRate = GetOutputSampleRate();
+    SoundWave->TTSBitDepth = 16;
+    SoundWave->SetAudioData(AudioData);
+    if (AudioComponent->IsValidLowLevel()) {
+        AudioComponent->AdjustAttenuation(*SoundAttenuationSettings);
+        // Normalized through the wave's own volume, which leaves the component's multiplier to the user.
+        SoundWave->Volume = GetLoudnessGain();
+        AudioComponent->Sound = SoundWave;
+        if (QuartzClock != NULL) {
+            QuartzCommandEvent.BindDynamic(this, &UTTSConverter::OnQuartzCommandEvent);
+            ScheduledStartTime = -1.0;
+            AudioComponent->PlayQuantized(AudioComponent, QuartzClock, QuantizationBoundary, QuartzCommandEvent);
+        }
+        else {
+            AudioComponent->Play(0.0f);
+        }
+    }
+    else {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("No audio component set, set AudioComponent on UTTSConverter first."));
+    }
+    if (!bPooled) {
+        this->RemoveFromRoot();
+        SoundWave->RemoveFromRoot();
+    }
+}
+
+UTTSSpeaker::UTTSSpeaker(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer) {
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void UTTSSpeaker::BeginPlay() {
+    FReadSpeakerTTSModule::BindSpeaker(this);
+    Super::BeginPlay();
+}
+
+void UTTSSpeaker::BeginDestroy() {
+    FReadSpeakerTTSModule::UnbindSpeaker(this);
+    for (UTTSConverter* Playing : PlayingConverters) {
+        FReadSpeakerTTSModule::ReleaseConverter(Playing);
+    }
+    PlayingConverters.Reset();
+    FReadSpeakerTTSModule::ReleaseConverter(Converter);
+    Converter = NULL;
+    Super::BeginDestroy();
+}
+
+void UTTSSpeaker::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+    // Streamed speech is finished once everything has been synthesized and played.
+    if (bIsStreaming) {
+        ReportUnderruns();
+        if (ThisSynthComponent == NULL || !ThisSynthComponent->IsStreaming()) {
+            DispatchPlayingConverters(true);
+            DispatchEvents(Converter, TNumericLimits<double>::Max());
+            FinishedSpeaking();
+        }
+        else {
+            DispatchPlayingConverters(false);
+            if (Converter != NULL) {
+                DispatchEvents(Converter, Converter->GetPlaybackTime());
+            }
+        }
+        return;
+    }
+
+    // Follow the frames the audio renderer has consumed rather than DeltaTime, so events stay in sync with
+    // what is heard through hitches and pauses. If finished playing, broadcast it.
+    if (ThisAudioComponent != NULL && ThisAudioComponent->GetPlayState() == EAudioComponentPlayState::Playing) {
+
+        USoundWaveProceduralTTS* CurrentSound = Cast<USoundWaveProceduralTTS>(ThisAudioComponent->Sound);
+        if (CurrentSound == NULL) {
+            return;
+        }
+
+        if (CurrentSound->GetPlayedFrames() >= CurrentSound->GetNumFrames()) {
+            DispatchEvents(Converter, TNumericLimits<double>::Max());
+            FinishedSpeaking();
+        }
+        else if (Converter != NULL && Converter->SoundWave == CurrentSound) {
+            DispatchEvents(Converter, Converter->GetPlaybackTime());
+        }
+    }
+}
+
+void UTTSSpeaker::ReportUnderruns() {
+    TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> Stream = ThisSynthComponent != NULL ? ThisSynthComponent->GetCurrentStream() : nullptr;
+    if (!Stream.IsValid()) {
+        return;
+    }
+
+    const double SamplesPerSecond = (double)Stream->GetSampleRate() * Stream->GetNumChannels();
+    if (SamplesPerSecond <= 0.0) {
+        return;
+    }
+
+    const float PreRollSeconds = (float)(Stream->GetPreRollSamples() / SamplesPerSecond);
+    SET_DWORD_STAT(STAT_TTSPreRollMs, FMath::RoundToInt(PreRollSeconds * 1000.0f));
+
+    int32 Count;
+    int64 Samples;
+    Stream->TakeUnderruns(Count, Samples);
+    if (Count > 0 || Samples > 0) {
+        const double Seconds = Samples / SamplesPerSecond;
+        const FString SpeakerName = GetOwner() != NULL ? GetOwner()->GetName() : GetName();
+        UE_LOG(LogReadSpeakerTTS, Verbose, TEXT("%s underran %d times, %.3f s of silence, pre-roll now %.0f ms"), *SpeakerName, Count, Seconds, PreRollSeconds * 1000.0f);
+        FReadSpeakerTTSModule::RecordUnderruns(SpeakerName, EngineID, Count, Seconds, PreRollSeconds);
+    }
+}
+
+void UTTSSpeaker::DispatchPlayingConverters(bool bFinished) {
+    // Oldest first, so events keep their order across utterances. Each is given back once all of it has been heard.
+    for (int32 Index = 0; Index < PlayingConverters.Num();) {
+        UTTSConverter* Playing = PlayingConverters[Index];
+        const bool bPlayed = bFinished || Playing == NULL || Playing->HasStreamPlayed();
+        DispatchEvents(Playing, bPlayed ? TNumericLimits<double>::Max() : Playing->GetPlaybackTime());
+        if (bPlayed) {
+            FReadSpeakerTTSModule::ReleaseConverter(Playing);
+            PlayingConverters.RemoveAt(Index, 1, false);
+        }
+        else {
+            Index++;
+        }
+    }
+}
+
+void UTTSSpeaker::DispatchEvents(UTTSConverter* Source, double PlaybackTime) {
+    if (Source == NULL || !Source->Timeline.Advance(PlaybackTime, DueEvents)) {
+        return;
+    }
+
+    // All events due this tick are sent, however many there are, so a slow frame rate never falls behind.
+    for (const FTTSVisemeCue& Viseme : DueEvents.Visemes) {
+        CurrentVisemeID = Viseme.VisemeId;
+        OnViseme.Broadcast(Viseme.VisemeId, Viseme.Time);
+    }
+    for (const FTTSWordCue& Word : DueEvents.Words) {
+        OnWord.Broadcast(Word.StartPos, Word.EndPos, Word.Time);
+    }
+    for (const FTTSMarkCue& Mark : DueEvents.Marks) {
+        // The delegate takes the name by value.
+        if (OnMark.IsBound()) {
+            FReadSpeakerTTSModule::CountBufferAllocation();
+            OnMark.Broadcast(Mark.Name, Mark.Time);
+        }
+    }
+}
+
+void UTTSSpeaker::SetEngine(UTTSEngine* NewEngine) {
+    if (NewEngine != nullptr) {
+        Engine = NewEngine;
+        EngineID = NewEngine->ID;
+    }
+    else {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine was null"));
+    }
+}
+
+UTTSEngine* UTTSSpeaker::GetEngine()
+{
+    if (Engine == NULL || Engine->ID != EngineID) {
+        Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
+    }
+    return Engine;
+}
+
+void UTTSSpeaker::SetAudioComponent(UAudioComponent* AudioComponent) {
+    ThisAudioComponent = AudioComponent;
+}
+
+UAudioComponent* UTTSSpeaker::GetAudioComponent() {
+    return ThisAudioComponent;
+}
+
+int32 UTTSSpeaker::GetDeviceSampleRate() {
+    // Resampling to the mixer rate once up front saves the mixer resampling every voice.
+    if (UWorld* World = GetWorld()) {
+        if (FAudioDeviceHandle AudioDevice = World->GetAudioDevice()) {
+            return (int32)AudioDevice->GetSampleRate();
+        }
+    }
+    return 0;
+}
+
+void UTTSSpeaker::SetSynthComponent(UTTSSynthComponent* SynthComponent) {
+    ThisSynthComponent = SynthComponent;
+}
+
+UTTSSynthComponent* UTTSSpeaker::GetSynthComponent() {
+    return ThisSynthComponent;
+}
+
+void UTTSSpeaker::SetVolume(int NewVolume)
+{
+    Volume = NewVolume;
+}
+
+int UTTSSpeaker::GetVolume()
+{
+    return Volume;
+}
+
+void UTTSSpeaker::SetPitch(int NewPitch)
+{
+    Pitch = NewPitch;
+}
+
+int UTTSSpeaker::GetPitch()
+{
+    return Pitch;
+}
+
+void UTTSSpeaker::SetSpeed(int NewSpeed)
+{
+    Speed = NewSpeed;
+}
+
+int UTTSSpeaker::GetSpeed()
+{
+    return Speed;
+}
+
+void UTTSSpeaker::SetPause(int NewPause)
+{
+    Pause = NewPause;
+}
+
+int UTTSSpeaker::GetPause()
+{
+    return Pause;
+}
+
+void UTTSSpeaker::SetCommaPause(int NewCommaPause)
+{
+    CommaPause = NewCommaPause;
+}
+
+int UTTSSpeaker::GetCommaPause()
+{
+    return CommaPause;
+}
+
+int UTTSSpeaker::GetCurrentViseme() {
+    return CurrentVisemeID;
+}
+
+bool UTTSSpeaker::IsSpeaking() {
+    if (bIsStreaming) {
+        return true;
+    }
+    return ThisAudioComponent != NULL && ThisAudioComponent->Sound != NULL && ThisAudioComponent->GetPlayState() == EAudioComponentPlayState::Playing;
+}
+
+void UTTSSpeaker::StartedSpeaking() {
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("%s started speaking"), *(GetOwner()->GetName()));
+    FString SpokenText = Converter->Text;
+    TTSTextType Type = Converter->TextType;
+    OnSpeakingStarted.Broadcast(SpokenText, Type);
+}
+
+void UTTSSpeaker::FinishedSpeaking() {
+    UE_LOG(LogReadSpeakerTTS, Display, TEXT("%s finished speaking"), *(GetOwner()->GetName()));
+    
+    FString SpokenText;
+    TTSTextType Type = TTSTextType::Normal;
+    
+    if (Converter != NULL && Converter->IsValidLowLevel()) {
+        SpokenText = Converter->Text;
+        Type = Converter->TextType;
+        FReadSpeakerTTSModule::ReleaseConverter(Converter);
+        Converter = NULL;
+    }
+    for (UTTSConverter* Playing : PlayingConverters) {
+        FReadSpeakerTTSModule::ReleaseConverter(Playing);
+    }
+    PlayingConverters.Reset();
+
+    if (ThisAudioComponent != NULL && !bIsStreaming) {
+        ThisAudioComponent->Sound = NULL;
+    }
+
+    bIsStreaming = false;
+
+    OnSpeakingFinished.Broadcast(SpokenText, Type);
+}
+
+void UTTSSpeaker::Say(FString text, TTSTextType textType)
+{
+    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
+
+    if (Engine == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Could not find requested engine: %s"), *EngineID);
+        return;
+    }
+
+    FReadSpeakerTTSModule::ReleaseConverter(Converter);
+    Converter = FReadSpeakerTTSModule::AcquireConverter();
+    Converter->Text = text;
+    Converter->Engine = Engine;
+    Converter->Volume = Volume;
+    Converter->Pitch = Pitch;
+    Converter->Speed = Speed;
+    Converter->Pause = Pause;
+    Converter->CommaPause = CommaPause;
+    Converter->TextType = textType;
+    Converter->OutputFormat = OutputFormat;
+    Converter->bApplyVolumeAsGain = bApplyVolumeAsGain;
+    Converter->bTrimSilence = bTrimSilence;
+    Converter->SilenceThreshold = SilenceThreshold;
+    Converter->SilencePadding = SilencePadding;
+    Converter->DspChain.Build(Processing);
+    Converter->bNormalizeLoudness = bNormalizeLoudness;
+    Converter->TargetLoudness = TargetLoudness;
+    Converter->AudioComponent = ThisAudioComponent;
+    Converter->SoundAttenuationSettings = &SoundAttenuation;
+    Converter->OutputSampleRate = GetDeviceSampleRate();
+
+#if PLATFORM_ANDROID
+    Converter->ConvertToBuffer();
+#else
+    Converter->ConvertToBuffer_SyncInfo();
+#endif
+
+    Converter->Play();
+    StartedSpeaking();
+}
+
+void UTTSSpeaker::SayAsync(FString text, TTSTextType textType)
+{
+    StartAsync(text, textType, NULL, FQuartzQuantizationBoundary());
+}
+
+void UTTSSpeaker::SayQuantized(UQuartzClockHandle* clock, FQuartzQuantizationBoundary boundary, FString text, TTSTextType textType)
+{
+    if (clock == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Warning, TEXT("SayQuantized called without a Quartz clock, starting as soon as conversion finishes."));
+    }
+    StartAsync(text, textType, clock, boundary);
+}
+
+void UTTSSpeaker::ScheduledStart(float startTime)
+{
+    OnScheduledStart.Broadcast(startTime);
+}
+
+void UTTSSpeaker::StartAsync(FString text, TTSTextType textType, UQuartzClockHandle* clock, const FQuartzQuantizationBoundary& boundary)
+{
+    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
+
+    if (Engine == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Could not find requested engine: %s"), *EngineID);
+        return;
+    }
+
+    FReadSpeakerTTSModule::ReleaseConverter(Converter);
+    Converter = FReadSpeakerTTSModule::AcquireConverter();
+
+    Converter->Text = text;
+    Converter->Engine = Engine;
+    Converter->Volume = Volume;
+    Converter->Pitch = Pitch;
+    Converter->Speed = Speed;
+    Converter->Pause = Pause;
+    Converter->CommaPause = CommaPause;
+    Converter->TextType = textType;
+    Converter->OutputFormat = OutputFormat;
+    Converter->bApplyVolumeAsGain = bApplyVolumeAsGain;
+    Converter->bTrimSilence = bTrimSilence;
+    Converter->SilenceThreshold = SilenceThreshold;
+    Converter->SilencePadding = SilencePadding;
+    Converter->DspChain.Build(Processing);
+    Converter->bNormalizeLoudness = bNormalizeLoudness;
+    Converter->TargetLoudness = TargetLoudness;
+    Converter->AudioComponent = ThisAudioComponent;
+    Converter->SoundAttenuationSettings = &SoundAttenuation;
+    Converter->OutputSampleRate = GetDeviceSampleRate();
+    
+    Converter->QuartzClock = clock;
+    Converter->QuantizationBoundary = boundary;
+    Converter->OnScheduledStart.AddDynamic(this, &UTTSSpeaker::ScheduledStart);
+    
+    Converter->OnConversionFinished.AddDynamic(Converter, &UTTSConverter::Play);
+    Converter->OnConversionFinished.AddDynamic(this, &UTTSSpeaker::StartedSpeaking);
+
+#if PLATFORM_ANDROID
+    Converter->ConvertToBufferAsync();
+#else
+    Converter->ConvertToBufferAsync_SyncInfo();
+#endif
+}
+
+void UTTSSpeaker::SayStreaming(FString text, TTSTextType textType)
+{
+    StartStreaming(text, textType, 0);
+}
+
+void UTTSSpeaker::ReadDocument(FString text, TTSTextType textType)
+{
+    if (textType == TTSTextType::SSML) {
+        UE_LOG(LogReadSpeakerTTS, Warning, TEXT("ReadDocument can't split SSML into pages, synthesizing it in one go."));
+    }
+    StartStreaming(text, textType, DocumentPageLength);
+}
+
+void UTTSSpeaker::StartStreaming(FString text, TTSTextType textType, int32 PageLength)
+{
+    Engine = FReadSpeakerTTSModule::GetEngineByID(EngineID);
+
+    if (Engine == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Display, TEXT("Could not find requested engine: %s"), *EngineID);
+        return;
+    }
+
+    if (ThisSynthComponent == NULL) {
+        UE_LOG(LogReadSpeakerTTS, Error, TEXT("No synth component set, call SetSynthComponent on UTTSSpeaker first."));
+        return;
+    }
+
+    // An utterance still queued on the stream keeps its converter until it has been heard, so its events aren't lost.
+    if (bIsStreaming && Converter != NULL) {
+        PlayingConverters.Add(Converter);
+    }
+    else {
+        FReadSpeakerTTSModule::ReleaseConverter(Converter);
+    }
+    Converter = FReadSpeakerTTSModule::AcquireConverter();
+
+    Converter->Text = text;
+    Converter->Engine = Engine;
+    Converter->Volume = Volume;
+    Converter->Pitch = Pitch;
+    Converter->Speed = Speed;
+    Converter->Pause = Pause;
+    Converter->CommaPause = CommaPause;
+    Converter->TextType = textType;
+    Converter->OutputFormat = OutputFormat;
+    Converter->bApplyVolumeAsGain = bApplyVolumeAsGain;
+    Converter->bTrimSilence = bTrimSilence;
+    Converter->SilenceThreshold = SilenceThreshold;
+    Converter->SilencePadding = SilencePadding;
+    Converter->DspChain.Build(Processing);
+    Converter->bNormalizeLoudness = bNormalizeLoudness;
+    Converter->TargetLoudness = TargetLoudness;
+    Converter->PageLength = PageLength;
+
+    Converter->OutputSampleRate = GetDeviceSampleRate();
+
+    TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> Stream = ThisSynthComponent->GetStream(Converter->GetOutputSampleRate(), 1);
+
+    // A stream starts playing before it has been measured, so it is normalized by the last utterance of the same voice.
+    // The gain goes into the samples, the synth component may still be playing an earlier utterance.
+    if (bNormalizeLoudness) {
+        float Loudness = FTTSLoudnessMeter::MinLoudness;
+        FReadSpeakerTTSModule::GetCachedLoudness(EngineID, Volume, Converter->GetOutputSampleRate(), Processing, Loudness);
+        Converter->StreamGain = FTTSLoudnessMeter::GetNormalizationGain(Loudness, TargetLoudness, MaxLoudnessCorrectionDb);
+    }
+    if (!ThisSynthComponent->IsPlaying()) {
+        ThisSynthComponent->Start();
+    }
+
+    bIsStreaming = true;
+    StartedSpeaking();
+
+#if PLATFORM_ANDROID
+    Converter->ConvertToStreamAsync(Stream, false);
+#else
+    Converter->ConvertToStreamAsync(Stream, true);
+#endif
+}
+
+void UTTSSpeaker::PauseSpeaking() {
+    if (ThisAudioComponent != NULL && !ThisAudioComponent->bIsPaused) {
+        ThisAudioComponent->SetPaused(true);
+    }
+}
+
+void UTTSSpeaker::ResumeSpeaking() {
+    if (ThisAudioComponent != NULL && ThisAudioComponent->bIsPaused) {
+        ThisAudioComponent->SetPaused(false);
+    }
+}
+
+void UTTSSpeaker::InterruptSpeaking() {
+    // Whatever has not been heard yet will not be, so don't report it.
+    if (Converter != NULL) {
+        Converter->Timeline.Skip();
+    }
+    for (UTTSConverter* Playing : PlayingConverters) {
+        if (Playing != NULL) {
+            Playing->Timeline.Skip();
+        }
+    }
+    if (bIsStreaming && ThisSynthComponent != NULL) {
+        ThisSynthComponent->CancelStream();
+    }
+    if (ThisAudioComponent != NULL && ThisAudioComponent->IsPlaying()) {
+        ThisAudioComponent->Stop();
+    }
+}
+
+void UTTSObject::Init() {
+    FReadSpeakerTTSModule::Init();
+}
+
+UTTSEngine *UTTSObject::FindEngine(FString name, FString type) {
+    return FReadSpeakerTTSModule::GetEngine(name, type);
+}
+
+void UTTSObject::PauseAll() {
+    FReadSpeakerTTSModule::PauseAll();
+}
+
+void UTTSObject::ResumeAll() {
+    FReadSpeakerTTSModule::ResumeAll();
+}
+
+void UTTSObject::InterruptAll() {
+    FReadSpeakerTTSModule::InterruptAll();
+}
+
+#if WITH_EDITOR
+
+#define LOCTEXT_NAMESPACE "STTSVoiceCombo"
+
+void STTSVoiceCombo::Construct(const FArguments& InArgs)
+{
+    SpeechCharacteristics = InArgs._SpeechCharacteristics;
+    OnStateChanged = InArgs._OnStateChanged;
+    if (GEditor && !GEditor->PlayWorld) {
+        FReadSpeakerTTSModule::Init();
+    }
+    int current = 0;
+    if (SpeechCharacteristics == NULL)
+        return;
+
+    if (Engines.Num() > 0) {
+        for (int i = 0; i < Engines.Num(); i++) {
+            if (Engines[i]->ID == SpeechCharacteristics->EngineID) {
+                current = i;
+            }
+            Options.Add(MakeShareable(new FString(Engines[i]->ID)));
+        }
+
+
+        CurrentItem = Options[current];
+        SpeechCharacteristics->EngineID = *CurrentItem.Get();
+    }
+    else {
+        Options.Add(MakeShareable(new FString("No voices available")));
+        CurrentItem = Options[0];
+    }
+
+    ChildSlot
+        [
+            SNew(SComboBox<FComboItemType>)
+            .OptionsSource(&Options)
+            .OnSelectionChanged(this, &STTSVoiceCombo::OnSelectionChanged)
+            .OnGenerateWidget(this, &STTSVoiceCombo::MakeWidgetForOption)
+            .InitiallySelectedItem(CurrentItem)
+        [
+            SNew(STextBlock)
+            .Text(this, &STTSVoiceCombo::GetCurrentItemLabel)
+        ]
+        ];
+}
+
+TSharedRef<SWidget> STTSVoiceCombo::MakeWidgetForOption(FComboItemType InOption)
+{
+    return SNew(STextBlock).Text(FText::FromString(*InOption));
+}
+
+void STTSVoiceCombo::OnSelectionChanged(FComboItemType NewValue, ESelectInfo::Type)
+{
+    CurrentItem = NewValue;
+    TSharedPtr<FString> TheName = (TSharedPtr<FString>)CurrentItem;
+    FString IDString = *(TheName).Get();
+    if (SpeechCharacteristics != NULL) {
+        UTTSEngine* Engine = FReadSpeakerTTSModule::GetEngineByID(IDString);
+        SpeechCharacteristics->SetEngine(Engine);
+    }
+    else {
+        UE_LOG(LogTemp, Warning, TEXT("TTSSpeaker is NULL"));
+    }
+
+    OnStateChanged.ExecuteIfBound();
+}
+
+FText STTSVoiceCombo::GetCurrentItemLabel() const
+{
+    if (CurrentItem.IsValid())
+    {
+        return FText::FromString(*CurrentItem);
+    }
+
+    return LOCTEXT("InvalidComboEntryText", "<<Invalid option>>");
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSAudioStream.h"
+#include "ReadSpeakerTTS.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+// How long a producer waits for the render thread to make room before it gives up on the utterance.
+static constexpr double MaxWriteStallSeconds = 2.0;
+
+FTTSAudioStream::FTTSAudioStream(int32 InCapacitySamples, int32 InSampleRate, int32 InNumChannels)
+	: RingBuffer(InCapacitySamples)
+	, SampleRate(InSampleRate)
+	, NumChannels(InNumChannels)
+{
+}
+
+uint32 FTTSAudioStream::BeginUtterance()
+{
+	FScopeLock Lock(&UtteranceMutex);
+	OpenUtterances.fetch_add(1);
+	return NextUtterance++;
+}
+
+bool FTTSAudioStream::WaitForTurn(uint32 UtteranceId)
+{
+	// The producer ahead is either synthesizing or throttled by playback, so polling at the throttle's pace is enough.
+	while (UtteranceId != WritingUtterance.load())
+	{
+		if (IsCancelled(UtteranceId))
+		{
+			return false;
+		}
+		FPlatformProcess::SleepNoStats(0.005f);
+	}
+	return true;
+}
+
+void FTTSAudioStream::SetWatermarks(int32 InHighWatermark, int32 InLowWatermark)
+{
+	HighWatermark = FMath::Clamp(InHighWatermark, 0, RingBuffer.Capacity());
+	LowWatermark = FMath::Clamp(InLowWatermark, 0, HighWatermark);
+}
+
+int32 FTTSAudioStream::GetRoom()
+{
+	const int32 Buffered = RingBuffer.NumAvailable();
+	if (HighWatermark <= 0)
+	{
+		return RingBuffer.Capacity() - Buffered;
+	}
+	if (bThrottled && Buffered > LowWatermark)
+	{
+		return 0;
+	}
+	const int32 Room = FMath::Max(HighWatermark - Buffered, 0);
+	bThrottled = Room == 0;
+	return Room;
+}
+
+int32 FTTSAudioStream::Push(uint32 UtteranceId, const float* Samples, int32 NumSamples)
+{
+	// Checked under the lock Cancel() takes, so samples of a cancelled utterance can't land after its flush.
+	FScopeLock Lock(&UtteranceMutex);
+	if (IsCancelled(UtteranceId))
+	{
+		return INDEX_NONE;
+	}
+	const int32 Written = NumSamples > 0 ? RingBuffer.Push(Samples, NumSamples) : 0;
+	SamplesWritten.fetch_add(Written, std::memory_order_release);
+	return Written;
+}
+
+int32 FTTSAudioStream::TryWrite(uint32 UtteranceId, const float* Samples, int32 NumSamples)
+{
+	if (UtteranceId != WritingUtterance.load())
+	{
+		ensureMsgf(IsCancelled(UtteranceId), TEXT("FTTSAudioStream: utterance %u wrote before its turn."), UtteranceId);
+		return INDEX_NONE;
+	}
+	return Push(UtteranceId, Samples, FMath::Min(NumSamples, GetRoom()));
+}
+
+bool FTTSAudioStream::Write(uint32 UtteranceId, const float* Samples, int32 NumSamples)
+{
+	if (!WaitForTurn(UtteranceId))
+	{
+		return false;
+	}
+
+	double StallStart = 0.0;
+	int64 LastSamplesRead = SamplesRead.load(std::memory_order_acquire);
+	while (NumSamples > 0)
+	{
+		const int32 Written = TryWrite(UtteranceId, Samples, NumSamples);
+		if (Written == INDEX_NONE)
+		{
+			return false;
+		}
+		Samples += Written;
+		NumSamples -= Written;
+		if (Written == 0 && !WaitForPlayback(StallStart, LastSamplesRead))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FTTSAudioStream::WaitForRoom(uint32 UtteranceId)
+{
+	if (!WaitForTurn(UtteranceId))
+	{
+		return false;
+	}
+
+	double StallStart = 0.0;
+	int64 LastSamplesRead = SamplesRead.load(std::memory_order_acquire);
+	while (GetRoom() == 0)
+	{
+		if (IsCancelled(UtteranceId) || !WaitForPlayback(StallStart, LastSamplesRead))
+		{
+			return false;
+		}
+	}
+	return !IsCancelled(UtteranceId);
+}
+
+bool FTTSAudioStream::WaitForPlayback(double& StallStart, int64& LastSamplesRead)
+{
+	// Waiting is only a stall if playback isn't consuming either, e.g. the synth component was stopped.
+	// A stream waiting to be handed to playback isn't stalled, the component attaches it once the previous one drained.
+	const int64 CurrentSamplesRead = SamplesRead.load(std::memory_order_acquire);
+	if (CurrentSamplesRead != LastSamplesRead || !bAttached.load(std::memory_order_acquire))
+	{
+		LastSamplesRead = CurrentSamplesRead;
+		StallStart = 0.0;
+	}
+	else if (StallStart == 0.0)
+	{
+		StallStart = FPlatformTime::Seconds();
+	}
+	else if (FPlatformTime::Seconds() - StallStart > MaxWriteStallSeconds)
+	{
+		UE_LOG(LogReadSpeakerTTS, Warning, TEXT("FTTSAudioStream: playback stalled, dropping the rest of the utterance."));
+		return false;
+	}
+
+	// Sleep roughly until playback has drained to the low watermark, but stay responsive to cancellation.
+	const int32 ToDrain = FMath::Max(RingBuffer.NumAvailable() - LowWatermark, 1) / FMath::Max(NumChannels, 1);
+	FPlatformProcess::SleepNoStats(FMath::Clamp((float)ToDrain / (float)FMath::Max(SampleRate, 1), 0.001f, 0.02f));
+	return true;
+}
+
+void FTTSAudioStream::EndUtterance(uint32 UtteranceId)
+{
+	WaitForTurn(UtteranceId);
+
+	FScopeLock Lock(&UtteranceMutex);
+	if (!IsCancelled(UtteranceId))
+	{
+		OpenUtterances.fetch_sub(1);
+		WritingUtterance.store(UtteranceId + 1);
+	}
+}
+
+void FTTSAudioStream::Cancel()
+{
+	FScopeLock Lock(&UtteranceMutex);
+	FirstLiveUtterance.store(NextUtterance);
+	WritingUtterance.store(NextUtterance);
+	OpenUtterances.store(0);
+	bFlushRequested.store(true);
+}
+
+void FTTSAudioStream::SetPreRoll(int32 InMinPreRoll, int32 InMaxPreRoll, int64 InStableSamples)
+{
+	MinPreRoll = FMath::Clamp(InMinPreRoll, 0, RingBuffer.Capacity());
+	MaxPreRoll = FMath::Clamp(InMaxPreRoll, MinPreRoll, RingBuffer.Capacity());
+	StableSamplesToShrink = FMath::Max<int64>(InStableSamples, 0);
+	PreRollSamples.store(MinPreRoll, std::memory_order_relaxed);
+}
+
+int32 FTTSAudioStream::Read(float* OutSamples, int32 NumSamples)
+{
+	int32 NumConsumed = 0;
+	if (bFlushRequested.exchange(false))
+	{
+		NumConsumed += RingBuffer.Discard();
+		bPrimed = false;
+		bRebuffering = false;
+	}
+
+	const bool bProducing = OpenUtterances.load() > 0;
+	int32 NumRead = 0;
+	if (!bPrimed)
+	{
+		// Hold playback back until the pre-roll is buffered, unless everything has been written already.
+		// The pre-roll must stay reachable for a producer throttled at the high watermark.
+		const int32 Limit = HighWatermark > 0 ? HighWatermark : RingBuffer.Capacity();
+		const int32 PreRoll = FMath::Min(PreRollSamples.load(std::memory_order_relaxed), Limit);
+		bPrimed = !bProducing || RingBuffer.NumAvailable() >= PreRoll;
+	}
+
+	if (bPrimed)
+	{
+		bRebuffering = false;
+		NumRead = RingBuffer.Pop(OutSamples, NumSamples);
+		NumConsumed += NumRead;
+
+		if (NumRead < NumSamples)
+		{
+			// Running dry is expected at the end of the audio, but while an utterance is still being written it is a gap.
+			bPrimed = false;
+			if (bProducing)
+			{
+				bRebuffering = true;
+				UnderrunCount.fetch_add(1, std::memory_order_relaxed);
+				// Grow by at least 10 ms so a zero minimum still gets somewhere.
+				const int32 PreRoll = PreRollSamples.load(std::memory_order_relaxed);
+				const int32 Grown = FMath::Max(PreRoll * 2, PreRoll + SampleRate * NumChannels / 100);
+				PreRollSamples.store(FMath::Clamp(Grown, MinPreRoll, MaxPreRoll), std::memory_order_relaxed);
+				StableSamples = 0;
+			}
+		}
+		else if (StableSamplesToShrink > 0 && (StableSamples += NumRead) >= StableSamplesToShrink)
+		{
+			PreRollSamples.store(FMath::Max(PreRollSamples.load(std::memory_order_relaxed) * 3 / 4, MinPreRoll), std::memory_order_relaxed);
+			StableSamples = 0;
+		}
+	}
+
+	if (bRebuffering)
+	{
+		UnderrunSamples.fetch_add(NumSamples - NumRead, std::memory_order_relaxed);
+	}
+
+	if (NumConsumed > 0)
+	{
+		SamplesRead.fetch_add(NumConsumed, std::memory_order_release);
+	}
+	return NumRead;
+}
+
+void FTTSAudioStream::TakeUnderruns(int32& OutCount, int64& OutSamples)
+{
+	OutCount = UnderrunCount.exchange(0, std::memory_order_relaxed);
+	OutSamples = UnderrunSamples.exchange(0, std::memory_order_relaxed);
+}
+
+bool FTTSAudioStream::IsFinished() const
+{
+	return OpenUtterances.load() <= 0 && RingBuffer.NumAvailable() == 0;
+}
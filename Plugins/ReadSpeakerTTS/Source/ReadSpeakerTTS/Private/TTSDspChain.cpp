@@ -0,0 +1,382 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSDspChain.h"
+#include "ReadSpeakerTTS.h"
+#include "Math/VectorRegister.h"
+
+// The number of frames gain is computed for at once by the dynamics stages, about 0.7 ms at 48 kHz.
+static constexpr int32 DynamicsBlockFrames = 32;
+
+namespace
+{
+	FORCEINLINE float DbToGain(float Db)
+	{
+		return FMath::Pow(10.0f, Db / 20.0f);
+	}
+
+	/** Multiplies samples by a constant gain. */
+	void ScaleSamples(float* Samples, int32 Num, float Gain)
+	{
+		const VectorRegister4Float GainVector = VectorSetFloat1(Gain);
+		int32 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			VectorStore(VectorMultiply(VectorLoad(Samples + Index), GainVector), Samples + Index);
+		}
+		for (; Index < Num; ++Index)
+		{
+			Samples[Index] *= Gain;
+		}
+	}
+
+	/** Multiplies interleaved frames by a gain moving linearly from one value towards another, one step per frame. */
+	void ApplyGainRamp(float* Samples, int32 NumFrames, int32 NumChannels, float From, float To)
+	{
+		if (From == To)
+		{
+			if (From != 1.0f)
+			{
+				ScaleSamples(Samples, NumFrames * NumChannels, From);
+			}
+			return;
+		}
+
+		const float Step = (To - From) / NumFrames;
+		const int32 Num = NumFrames * NumChannels;
+		int32 Index = 0;
+		// A vector covers whole frames only for 1, 2 and 4 channels, other layouts take the scalar loop.
+		if (4 % NumChannels == 0)
+		{
+			const int32 FramesPerVector = 4 / NumChannels;
+			VectorRegister4Float Gains = MakeVectorRegisterFloat(
+				From,
+				From + Step * (1 / NumChannels),
+				From + Step * (2 / NumChannels),
+				From + Step * (3 / NumChannels));
+			const VectorRegister4Float Increment = VectorSetFloat1(Step * FramesPerVector);
+			for (; Index + 4 <= Num; Index += 4)
+			{
+				VectorStore(VectorMultiply(VectorLoad(Samples + Index), Gains), Samples + Index);
+				Gains = VectorAdd(Gains, Increment);
+			}
+		}
+		for (; Index < Num; ++Index)
+		{
+			Samples[Index] *= From + Step * (Index / NumChannels);
+		}
+	}
+
+	/** Gets the largest magnitude among samples. */
+	float PeakMagnitude(const float* Samples, int32 Num)
+	{
+		VectorRegister4Float Peak = VectorZeroFloat();
+		int32 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			Peak = VectorMax(Peak, VectorAbs(VectorLoad(Samples + Index)));
+		}
+		float Lanes[4];
+		VectorStore(Peak, Lanes);
+		float Result = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+		for (; Index < Num; ++Index)
+		{
+			Result = FMath::Max(Result, FMath::Abs(Samples[Index]));
+		}
+		return Result;
+	}
+
+	/** A second order Butterworth high-pass section. Recursive, so it runs a sample at a time. */
+	struct FHighPassBiquad
+	{
+		float B0 = 1.0f, B1 = 0.0f, B2 = 0.0f, A1 = 0.0f, A2 = 0.0f;
+
+		void SetCutoff(float Frequency, int32 SampleRate)
+		{
+			const float Omega = 2.0f * UE_PI * FMath::Min(Frequency, SampleRate * 0.45f) / SampleRate;
+			const float Cos = FMath::Cos(Omega);
+			const float Alpha = FMath::Sin(Omega) / (2.0f * UE_INV_SQRT_2);
+			const float InvA0 = 1.0f / (1.0f + Alpha);
+			B0 = (1.0f + Cos) * 0.5f * InvA0;
+			B1 = -(1.0f + Cos) * InvA0;
+			B2 = B0;
+			A1 = -2.0f * Cos * InvA0;
+			A2 = (1.0f - Alpha) * InvA0;
+		}
+
+		/** Transposed direct form II, State holds the two delay elements of one channel. */
+		FORCEINLINE float Tick(float X, float* State) const
+		{
+			const float Y = B0 * X + State[0];
+			State[0] = B1 * X - A1 * Y + State[1];
+			State[1] = B2 * X - A2 * Y;
+			return Y;
+		}
+	};
+
+	class FTTSGainStage : public ITTSDspStage
+	{
+	public:
+		explicit FTTSGainStage(float InGain) : Gain(InGain) {}
+
+		virtual void Prepare(int32 SampleRate, int32 InNumChannels) override
+		{
+			NumChannels = InNumChannels;
+		}
+
+		virtual void Process(float* Samples, int32 NumFrames) override
+		{
+			ScaleSamples(Samples, NumFrames * NumChannels, Gain);
+		}
+
+	private:
+		float Gain;
+		int32 NumChannels = 1;
+	};
+
+	class FTTSHighPassStage : public ITTSDspStage
+	{
+	public:
+		explicit FTTSHighPassStage(float InFrequency) : Frequency(InFrequency) {}
+
+		virtual void Prepare(int32 SampleRate, int32 InNumChannels) override
+		{
+			NumChannels = InNumChannels;
+			Filter.SetCutoff(Frequency, SampleRate);
+			State.Reset();
+			State.AddZeroed(NumChannels * 2);
+		}
+
+		virtual void Process(float* Samples, int32 NumFrames) override
+		{
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				float* ChannelState = State.GetData() + Channel * 2;
+				for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+				{
+					float& Sample = Samples[Frame * NumChannels + Channel];
+					Sample = Filter.Tick(Sample, ChannelState);
+				}
+			}
+		}
+
+	private:
+		float Frequency;
+		int32 NumChannels = 1;
+		FHighPassBiquad Filter;
+		TArray<float> State;
+	};
+
+	/**
+	 * Turns the whole signal down while the energy above a frequency is over a threshold.
+	 * The level of a high-passed copy is measured per block and the gain is ramped between blocks.
+	 */
+	class FTTSDeEsserStage : public ITTSDspStage
+	{
+	public:
+		FTTSDeEsserStage(float InFrequency, float InThresholdDb, float InRatio)
+			: Frequency(InFrequency), Threshold(DbToGain(InThresholdDb)), Slope(1.0f / FMath::Max(InRatio, 1.0f) - 1.0f) {}
+
+		virtual void Prepare(int32 SampleRate, int32 InNumChannels) override
+		{
+			NumChannels = InNumChannels;
+			Sidechain.SetCutoff(Frequency, SampleRate);
+			SidechainState.Reset();
+			SidechainState.AddZeroed(NumChannels * 2);
+			// Fast enough to catch the onset of an 's', slow enough not to follow individual cycles.
+			AttackCoefficient = FMath::Exp(-DynamicsBlockFrames / (0.001f * SampleRate));
+			ReleaseCoefficient = FMath::Exp(-DynamicsBlockFrames / (0.05f * SampleRate));
+			Envelope = 0.0f;
+			Gain = 1.0f;
+		}
+
+		virtual void Process(float* Samples, int32 NumFrames) override
+		{
+			for (int32 Start = 0; Start < NumFrames; Start += DynamicsBlockFrames)
+			{
+				const int32 BlockFrames = FMath::Min(DynamicsBlockFrames, NumFrames - Start);
+				float* Block = Samples + Start * NumChannels;
+
+				float SumOfSquares = 0.0f;
+				for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+				{
+					float* ChannelState = SidechainState.GetData() + Channel * 2;
+					for (int32 Frame = 0; Frame < BlockFrames; ++Frame)
+					{
+						const float Sibilance = Sidechain.Tick(Block[Frame * NumChannels + Channel], ChannelState);
+						SumOfSquares += Sibilance * Sibilance;
+					}
+				}
+				const float Level = FMath::Sqrt(SumOfSquares / (BlockFrames * NumChannels));
+				const float Coefficient = Level > Envelope ? AttackCoefficient : ReleaseCoefficient;
+				Envelope = Level + (Envelope - Level) * Coefficient;
+
+				const float Target = Envelope > Threshold ? FMath::Pow(Envelope / Threshold, Slope) : 1.0f;
+				ApplyGainRamp(Block, BlockFrames, NumChannels, Gain, Target);
+				Gain = Target;
+			}
+		}
+
+	private:
+		float Frequency;
+		float Threshold;
+		float Slope; ///< The exponent turning the level above the threshold into gain reduction.
+		int32 NumChannels = 1;
+		FHighPassBiquad Sidechain;
+		TArray<float> SidechainState;
+		float AttackCoefficient = 0.0f;
+		float ReleaseCoefficient = 0.0f;
+		float Envelope = 0.0f;
+		float Gain = 1.0f;
+	};
+
+	/**
+	 * Keeps peaks under a ceiling without lookahead. The gain drops to the required level at the start of a block
+	 * with a peak over the ceiling and recovers exponentially, never rising above what the block allows.
+	 */
+	class FTTSLimiterStage : public ITTSDspStage
+	{
+	public:
+		FTTSLimiterStage(float InCeilingDb, float InRelease)
+			: Ceiling(DbToGain(InCeilingDb)), Release(FMath::Max(InRelease, 0.001f)) {}
+
+		virtual void Prepare(int32 SampleRate, int32 InNumChannels) override
+		{
+			NumChannels = InNumChannels;
+			ReleaseCoefficient = FMath::Exp(-DynamicsBlockFrames / (Release * SampleRate));
+			Gain = 1.0f;
+		}
+
+		virtual void Process(float* Samples, int32 NumFrames) override
+		{
+			for (int32 Start = 0; Start < NumFrames; Start += DynamicsBlockFrames)
+			{
+				const int32 BlockFrames = FMath::Min(DynamicsBlockFrames, NumFrames - Start);
+				float* Block = Samples + Start * NumChannels;
+
+				const float Peak = PeakMagnitude(Block, BlockFrames * NumChannels);
+				const float Allowed = Peak > Ceiling ? Ceiling / Peak : 1.0f;
+				if (Allowed < Gain)
+				{
+					Gain = Allowed;
+					ScaleSamples(Block, BlockFrames * NumChannels, Gain);
+				}
+				else
+				{
+					// Both ends of the ramp are at or below Allowed, so the block stays under the ceiling.
+					const float Target = Allowed + (Gain - Allowed) * ReleaseCoefficient;
+					ApplyGainRamp(Block, BlockFrames, NumChannels, Gain, Target);
+					Gain = Target;
+				}
+			}
+		}
+
+	private:
+		float Ceiling;
+		float Release;
+		int32 NumChannels = 1;
+		float ReleaseCoefficient = 0.0f;
+		float Gain = 1.0f;
+	};
+}
+
+bool FTTSDspSettings::operator==(const FTTSDspSettings& Other) const
+{
+	return GainDb == Other.GainDb
+		&& bHighPass == Other.bHighPass
+		&& HighPassFrequency == Other.HighPassFrequency
+		&& bDeEsser == Other.bDeEsser
+		&& DeEsserFrequency == Other.DeEsserFrequency
+		&& DeEsserThresholdDb == Other.DeEsserThresholdDb
+		&& DeEsserRatio == Other.DeEsserRatio
+		&& bLimiter == Other.bLimiter
+		&& LimiterCeilingDb == Other.LimiterCeilingDb
+		&& LimiterRelease == Other.LimiterRelease
+		&& CustomStages == Other.CustomStages;
+}
+
+uint32 GetTypeHash(const FTTSDspSettings& Settings)
+{
+	uint32 Hash = HashCombine(GetTypeHash(Settings.GainDb), GetTypeHash(Settings.bHighPass));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.HighPassFrequency));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.bDeEsser));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.DeEsserFrequency));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.DeEsserThresholdDb));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.DeEsserRatio));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.bLimiter));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.LimiterCeilingDb));
+	Hash = HashCombine(Hash, GetTypeHash(Settings.LimiterRelease));
+	for (const FName& Name : Settings.CustomStages)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(Name));
+	}
+	return Hash;
+}
+
+void FTTSDspChain::Build(const FTTSDspSettings& Settings)
+{
+	// A custom stage registered or replaced after the last build would otherwise never be created.
+	const int32 RegistryVersion = FReadSpeakerTTSModule::GetDspStageRegistryVersion();
+	if (Settings == BuiltSettings && (Settings.CustomStages.Num() == 0 || RegistryVersion == BuiltRegistryVersion))
+	{
+		return;
+	}
+	BuiltSettings = Settings;
+	BuiltRegistryVersion = RegistryVersion;
+	Stages.Reset();
+
+	if (Settings.GainDb != 0.0f)
+	{
+		Stages.Add(MakeUnique<FTTSGainStage>(DbToGain(Settings.GainDb)));
+	}
+	if (Settings.bHighPass)
+	{
+		Stages.Add(MakeUnique<FTTSHighPassStage>(Settings.HighPassFrequency));
+	}
+	if (Settings.bDeEsser)
+	{
+		Stages.Add(MakeUnique<FTTSDeEsserStage>(Settings.DeEsserFrequency, Settings.DeEsserThresholdDb, Settings.DeEsserRatio));
+	}
+	if (Settings.bLimiter)
+	{
+		Stages.Add(MakeUnique<FTTSLimiterStage>(Settings.LimiterCeilingDb, Settings.LimiterRelease));
+	}
+	for (const FName& Name : Settings.CustomStages)
+	{
+		TUniquePtr<ITTSDspStage> Stage = FReadSpeakerTTSModule::CreateDspStage(Name);
+		if (Stage.IsValid())
+		{
+			Stages.Add(MoveTemp(Stage));
+		}
+		else
+		{
+			UE_LOG(LogReadSpeakerTTS, Warning, TEXT("No DSP stage registered as %s, skipping it."), *Name.ToString());
+		}
+	}
+}
+
+void FTTSDspChain::Clear()
+{
+	Stages.Reset();
+	BuiltSettings = FTTSDspSettings();
+	BuiltRegistryVersion = INDEX_NONE;
+}
+
+void FTTSDspChain::Prepare(int32 SampleRate, int32 NumChannels)
+{
+	for (TUniquePtr<ITTSDspStage>& Stage : Stages)
+	{
+		Stage->Prepare(SampleRate, NumChannels);
+	}
+}
+
+void FTTSDspChain::Process(float* Samples, int32 NumFrames)
+{
+	if (NumFrames <= 0)
+	{
+		return;
+	}
+	for (TUniquePtr<ITTSDspStage>& Stage : Stages)
+	{
+		Stage->Process(Samples, NumFrames);
+	}
+}
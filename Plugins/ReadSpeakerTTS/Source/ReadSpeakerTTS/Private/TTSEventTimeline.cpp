@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSEventTimeline.h"
+#include "ReadSpeakerTTS.h"
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+	template<typename CueType>
+	void InsertSorted(TArray<CueType>& Cues, int32 NextCue, CueType&& Cue)
+	{
+		if (Cues.Num() == Cues.Max())
+		{
+			FReadSpeakerTTSModule::CountBufferAllocation();
+		}
+
+		// RSGame reports events in time order, so this is almost always an append.
+		if (Cues.Num() == 0 || Cues.Last().Time <= Cue.Time)
+		{
+			Cues.Add(MoveTemp(Cue));
+			return;
+		}
+
+		// An event sorting before ones already collected is still collected by the next Advance().
+		const int32 Index = FMath::Max(NextCue, Algo::UpperBoundBy(Cues, Cue.Time, &CueType::Time));
+		Cues.Insert(MoveTemp(Cue), Index);
+	}
+
+	template<typename CueType>
+	void ShiftFrom(TArray<CueType>& Cues, float FromTime, float Delta)
+	{
+		// Clamping to FromTime keeps the array sorted, the moved events are a suffix and stay in order.
+		const int32 First = Algo::LowerBoundBy(Cues, FromTime, &CueType::Time);
+		for (int32 Index = First; Index < Cues.Num(); ++Index)
+		{
+			Cues[Index].Time = FMath::Max(Cues[Index].Time + Delta, FromTime);
+		}
+	}
+
+	template<typename CueType>
+	void CollectDue(TArray<CueType>& Cues, int32& NextCue, double PlaybackTime, TArray<CueType>& OutDue)
+	{
+		const TArrayView<CueType> Pending = MakeArrayView(Cues).RightChop(NextCue);
+		const int32 NumDue = Algo::UpperBoundBy(Pending, PlaybackTime, [](const CueType& Cue) { return (double)Cue.Time; });
+		// Collected cues are never read again, so a mark's name is moved out rather than copied.
+		for (int32 Index = 0; Index < NumDue; ++Index)
+		{
+			OutDue.Add(MoveTemp(Pending[Index]));
+		}
+		NextCue += NumDue;
+	}
+}
+
+void FTTSEventTimeline::Reset()
+{
+	FScopeLock Lock(&Mutex);
+	Visemes.Reset();
+	Words.Reset();
+	Marks.Reset();
+	NextViseme = 0;
+	NextWord = 0;
+	NextMark = 0;
+	bSkipped = false;
+}
+
+void FTTSEventTimeline::AddViseme(int32 VisemeId, float Time)
+{
+	FScopeLock Lock(&Mutex);
+	if (bSkipped)
+	{
+		return;
+	}
+	InsertSorted(Visemes, NextViseme, FTTSVisemeCue{ Time, VisemeId });
+}
+
+void FTTSEventTimeline::AddWord(int32 StartPos, int32 EndPos, float Time)
+{
+	FScopeLock Lock(&Mutex);
+	if (bSkipped)
+	{
+		return;
+	}
+	InsertSorted(Words, NextWord, FTTSWordCue{ Time, StartPos, EndPos });
+}
+
+void FTTSEventTimeline::AddMark(FString&& Name, float Time)
+{
+	FScopeLock Lock(&Mutex);
+	if (bSkipped)
+	{
+		return;
+	}
+	InsertSorted(Marks, NextMark, FTTSMarkCue{ Time, MoveTemp(Name) });
+}
+
+bool FTTSEventTimeline::Advance(double PlaybackTime, FTTSDueEvents& OutDue)
+{
+	OutDue.Reset();
+
+	FScopeLock Lock(&Mutex);
+	CollectDue(Visemes, NextViseme, PlaybackTime, OutDue.Visemes);
+	CollectDue(Words, NextWord, PlaybackTime, OutDue.Words);
+	CollectDue(Marks, NextMark, PlaybackTime, OutDue.Marks);
+	return OutDue.Visemes.Num() > 0 || OutDue.Words.Num() > 0 || OutDue.Marks.Num() > 0;
+}
+
+void FTTSEventTimeline::GetVisemes(TArray<FTTSVisemeCue>& OutVisemes)
+{
+	FScopeLock Lock(&Mutex);
+	OutVisemes.Reset();
+	OutVisemes.Append(Visemes);
+}
+
+void FTTSEventTimeline::Compact()
+{
+	FScopeLock Lock(&Mutex);
+	Visemes.RemoveAt(0, NextViseme, false);
+	Words.RemoveAt(0, NextWord, false);
+	Marks.RemoveAt(0, NextMark, false);
+	NextViseme = 0;
+	NextWord = 0;
+	NextMark = 0;
+}
+
+void FTTSEventTimeline::Shift(float FromTime, float Delta)
+{
+	FScopeLock Lock(&Mutex);
+	ShiftFrom(Visemes, FromTime, Delta);
+	ShiftFrom(Words, FromTime, Delta);
+	ShiftFrom(Marks, FromTime, Delta);
+}
+
+void FTTSEventTimeline::Skip()
+{
+	FScopeLock Lock(&Mutex);
+	NextViseme = Visemes.Num();
+	NextWord = Words.Num();
+	NextMark = Marks.Num();
+	bSkipped = true;
+}
@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSLoudnessMeter.h"
+#include "ReadSpeakerTTS.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	// The offset in the BS.1770 loudness formula, so a full scale 997 Hz sine measures -3.01 LUFS.
+	constexpr double LoudnessOffset = -0.691;
+	// A block must be louder than -70 LUFS to count.
+	const double AbsoluteGateEnergy = FMath::Pow(10.0, (FTTSLoudnessMeter::MinLoudness - LoudnessOffset) / 10.0);
+	// Blocks more than 10 LU below the mean of the blocks passing the absolute gate are dropped.
+	constexpr double RelativeGateFactor = 0.1;
+
+	double EnergyToLoudness(double Energy)
+	{
+		return LoudnessOffset + 10.0 * FMath::LogX(10.0, Energy);
+	}
+
+	/** Gets the sum of squares of samples. */
+	double SumOfSquares(const float* Samples, int32 Num)
+	{
+		VectorRegister4Float Sum = VectorZeroFloat();
+		int32 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			const VectorRegister4Float Value = VectorLoad(Samples + Index);
+			Sum = VectorMultiplyAdd(Value, Value, Sum);
+		}
+		float Lanes[4];
+		VectorStore(Sum, Lanes);
+		double Result = ((double)Lanes[0] + Lanes[1]) + ((double)Lanes[2] + Lanes[3]);
+		for (; Index < Num; ++Index)
+		{
+			Result += (double)Samples[Index] * Samples[Index];
+		}
+		return Result;
+	}
+}
+
+void FTTSLoudnessMeter::Prepare(int32 InSampleRate, int32 InNumChannels)
+{
+	SampleRate = FMath::Max(InSampleRate, 1);
+	NumChannels = FMath::Max(InNumChannels, 1);
+
+	// The K-weighting filters are specified at 48 kHz, these are their analog prototypes mapped to SampleRate.
+	{
+		const double Frequency = 1681.974450955533;
+		const double GainDb = 3.999843853973347;
+		const double Q = 0.7071752369554196;
+		const double K = FMath::Tan(UE_DOUBLE_PI * Frequency / SampleRate);
+		const double Vh = FMath::Pow(10.0, GainDb / 20.0);
+		const double Vb = FMath::Pow(Vh, 0.4996667741545416);
+		const double A0 = 1.0 + K / Q + K * K;
+		Shelf.B0 = (float)((Vh + Vb * K / Q + K * K) / A0);
+		Shelf.B1 = (float)(2.0 * (K * K - Vh) / A0);
+		Shelf.B2 = (float)((Vh - Vb * K / Q + K * K) / A0);
+		Shelf.A1 = (float)(2.0 * (K * K - 1.0) / A0);
+		Shelf.A2 = (float)((1.0 - K / Q + K * K) / A0);
+	}
+	{
+		const double Frequency = 38.13547087602444;
+		const double Q = 0.5003270373238773;
+		const double K = FMath::Tan(UE_DOUBLE_PI * Frequency / SampleRate);
+		const double A0 = 1.0 + K / Q + K * K;
+		HighPass.B0 = 1.0f;
+		HighPass.B1 = -2.0f;
+		HighPass.B2 = 1.0f;
+		HighPass.A1 = (float)(2.0 * (K * K - 1.0) / A0);
+		HighPass.A2 = (float)((1.0 - K / Q + K * K) / A0);
+	}
+
+	FilterState.Reset();
+	FilterState.AddZeroed(NumChannels * 4);
+	StepFrames = FMath::Max(SampleRate / 10, 1);
+	StepPosition = 0;
+	StepEnergy = 0.0;
+	NumSteps = 0;
+	BlockEnergies.Reset();
+}
+
+template<typename SampleType>
+void FTTSLoudnessMeter::Filter(const SampleType* Samples, int32 NumFrames, float Scale)
+{
+	const int32 Num = NumFrames * NumChannels;
+	if (Filtered.Max() < Num)
+	{
+		FReadSpeakerTTSModule::CountBufferAllocation();
+	}
+	Filtered.SetNumUninitialized(Num, false);
+
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		// Transposed direct form II, both stages in one pass.
+		float* State = FilterState.GetData() + Channel * 4;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const int32 Index = Frame * NumChannels + Channel;
+			const float X = (float)Samples[Index] * Scale;
+			const float Y = Shelf.B0 * X + State[0];
+			State[0] = Shelf.B1 * X - Shelf.A1 * Y + State[1];
+			State[1] = Shelf.B2 * X - Shelf.A2 * Y;
+			const float Z = HighPass.B0 * Y + State[2];
+			State[2] = HighPass.B1 * Y - HighPass.A1 * Z + State[3];
+			State[3] = HighPass.B2 * Y - HighPass.A2 * Z;
+			Filtered[Index] = Z;
+		}
+	}
+}
+
+void FTTSLoudnessMeter::Process(const float* Samples, int32 NumFrames)
+{
+	if (NumFrames <= 0 || SampleRate == 0)
+	{
+		return;
+	}
+	Filter(Samples, NumFrames, 1.0f);
+	ProcessFiltered(NumFrames);
+}
+
+void FTTSLoudnessMeter::Process(const int16* Samples, int32 NumFrames)
+{
+	if (NumFrames <= 0 || SampleRate == 0)
+	{
+		return;
+	}
+	Filter(Samples, NumFrames, 1.0f / 32768.0f);
+	ProcessFiltered(NumFrames);
+}
+
+void FTTSLoudnessMeter::ProcessFiltered(int32 NumFrames)
+{
+	int32 Frame = 0;
+	while (Frame < NumFrames)
+	{
+		const int32 SegmentFrames = FMath::Min(StepFrames - StepPosition, NumFrames - Frame);
+		StepEnergy += SumOfSquares(Filtered.GetData() + Frame * NumChannels, SegmentFrames * NumChannels);
+		StepPosition += SegmentFrames;
+		Frame += SegmentFrames;
+
+		if (StepPosition == StepFrames)
+		{
+			RecentSteps[NumSteps % 4] = StepEnergy;
+			NumSteps++;
+			StepPosition = 0;
+			StepEnergy = 0.0;
+
+			// A block is the last four steps, so blocks start every 100 ms and overlap by 75%.
+			if (NumSteps >= 4)
+			{
+				AddBlock((RecentSteps[0] + RecentSteps[1] + RecentSteps[2] + RecentSteps[3]) / (4.0 * StepFrames));
+			}
+		}
+	}
+}
+
+void FTTSLoudnessMeter::AddBlock(double Energy)
+{
+	if (BlockEnergies.Num() == BlockEnergies.Max())
+	{
+		FReadSpeakerTTSModule::CountBufferAllocation();
+	}
+	BlockEnergies.Add(Energy);
+}
+
+float FTTSLoudnessMeter::GetIntegratedLoudness() const
+{
+	if (BlockEnergies.Num() == 0)
+	{
+		// Shorter than a block, so the steps collected so far are all of the audio.
+		const int32 NumFrames = NumSteps * StepFrames + StepPosition;
+		if (NumFrames == 0)
+		{
+			return MinLoudness;
+		}
+		double Energy = StepEnergy;
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			Energy += RecentSteps[Step];
+		}
+		return Energy / NumFrames > AbsoluteGateEnergy ? (float)EnergyToLoudness(Energy / NumFrames) : MinLoudness;
+	}
+
+	double Sum = 0.0;
+	int32 Count = 0;
+	for (double Energy : BlockEnergies)
+	{
+		if (Energy > AbsoluteGateEnergy)
+		{
+			Sum += Energy;
+			Count++;
+		}
+	}
+	if (Count == 0)
+	{
+		return MinLoudness;
+	}
+
+	const double RelativeGateEnergy = Sum / Count * RelativeGateFactor;
+	double GatedSum = 0.0;
+	int32 GatedCount = 0;
+	for (double Energy : BlockEnergies)
+	{
+		if (Energy > AbsoluteGateEnergy && Energy > RelativeGateEnergy)
+		{
+			GatedSum += Energy;
+			GatedCount++;
+		}
+	}
+	return (float)EnergyToLoudness(GatedSum / GatedCount);
+}
+
+float FTTSLoudnessMeter::GetNormalizationGain(float Loudness, float TargetLoudness, float MaxCorrectionDb)
+{
+	if (Loudness <= MinLoudness)
+	{
+		return 1.0f;
+	}
+	const float CorrectionDb = FMath::Clamp(TargetLoudness - Loudness, -MaxCorrectionDb, MaxCorrectionDb);
+	return FMath::Pow(10.0f, CorrectionDb / 20.0f);
+}
@@ -0,0 +1,241 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSResampler.h"
+#include "ReadSpeakerTTS.h"
+#include "Math/VectorRegister.h"
+
+// Upper bound on the filter bank size, rates whose reduced ratio needs more than this are rejected.
+static constexpr int32 MaxFilterBankSize = 1 << 20;
+
+namespace
+{
+	struct FResamplerQualitySettings
+	{
+		int32 NumTaps;
+		double Rolloff; ///< The passband edge as a fraction of the lower Nyquist rate.
+		double KaiserBeta;
+	};
+
+	FResamplerQualitySettings GetQualitySettings(ETTSResamplerQuality Quality)
+	{
+		switch (Quality)
+		{
+		case ETTSResamplerQuality::Low:
+			return { 8, 0.80, 5.0 };
+		case ETTSResamplerQuality::High:
+			return { 32, 0.95, 9.0 };
+		default:
+			return { 16, 0.90, 7.0 };
+		}
+	}
+
+	/** Zeroth order modified Bessel function of the first kind, for the Kaiser window. */
+	double BesselI0(double X)
+	{
+		double Sum = 1.0;
+		double Term = 1.0;
+		const double HalfX = X * 0.5;
+		for (int32 K = 1; K < 32; ++K)
+		{
+			Term *= (HalfX / K) * (HalfX / K);
+			Sum += Term;
+			if (Term < Sum * 1e-12)
+			{
+				break;
+			}
+		}
+		return Sum;
+	}
+
+	FORCEINLINE float DotProduct(const float* RESTRICT Coefficients, const float* RESTRICT Samples, int32 Num)
+	{
+		VectorRegister4Float Sum = VectorZeroFloat();
+		for (int32 Index = 0; Index < Num; Index += 4)
+		{
+			Sum = VectorMultiplyAdd(VectorLoad(Coefficients + Index), VectorLoad(Samples + Index), Sum);
+		}
+		float Lanes[4];
+		VectorStore(Sum, Lanes);
+		return (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+	}
+
+	/** Makes room to append Num samples, growing geometrically and counting the allocation if it had to grow. */
+	void ReserveHistory(TArray<float>& History, int32 Num)
+	{
+		const int32 Needed = History.Num() + Num;
+		if (History.Max() < Needed)
+		{
+			History.Reserve(FMath::Max(Needed, History.Max() * 2));
+			FReadSpeakerTTSModule::CountBufferAllocation();
+		}
+	}
+}
+
+void FTTSResampler::Configure(int32 InInputRate, int32 InOutputRate, int32 InNumChannels, ETTSResamplerQuality InQuality)
+{
+	const bool bUnchanged = InInputRate == InputRate && InOutputRate == OutputRate && InNumChannels == NumChannels && InQuality == Quality;
+	InputRate = InInputRate;
+	OutputRate = InOutputRate;
+	NumChannels = InNumChannels;
+	Quality = InQuality;
+
+	if (!bUnchanged)
+	{
+		bActive = false;
+		if (InputRate > 0 && OutputRate > 0 && NumChannels > 0 && InputRate != OutputRate)
+		{
+			const int32 Divisor = FMath::GreatestCommonDivisor(InputRate, OutputRate);
+			Interpolation = OutputRate / Divisor;
+			Decimation = InputRate / Divisor;
+			NumTaps = GetQualitySettings(Quality).NumTaps;
+
+			if ((int64)Interpolation * NumTaps > MaxFilterBankSize)
+			{
+				UE_LOG(LogReadSpeakerTTS, Error, TEXT("FTTSResampler: ratio %d/%d needs too many filter phases, not resampling."), OutputRate, InputRate);
+			}
+			else
+			{
+				BuildFilter();
+				bActive = true;
+			}
+		}
+	}
+
+	Reset();
+}
+
+void FTTSResampler::BuildFilter()
+{
+	const FResamplerQualitySettings Settings = GetQualitySettings(Quality);
+	const int32 Length = Interpolation * NumTaps;
+	// Centered on a whole tap so output samples land exactly on the input grid, see Reset().
+	const double Center = Length / 2;
+	// Cutoff in cycles per sample at the upsampled rate, below the lower of the two Nyquist rates.
+	const double Cutoff = 0.5 * Settings.Rolloff / FMath::Max(Interpolation, Decimation);
+	const double WindowNorm = 1.0 / BesselI0(Settings.KaiserBeta);
+
+	FilterBank.SetNumUninitialized(Length);
+	for (int32 PhaseIndex = 0; PhaseIndex < Interpolation; ++PhaseIndex)
+	{
+		float* PhaseCoefficients = FilterBank.GetData() + PhaseIndex * NumTaps;
+		double PhaseSum = 0.0;
+		for (int32 Tap = 0; Tap < NumTaps; ++Tap)
+		{
+			const int32 K = PhaseIndex + Tap * Interpolation;
+			const double X = K - Center;
+			const double Sinc = X == 0.0 ? 2.0 * Cutoff : FMath::Sin(2.0 * UE_DOUBLE_PI * Cutoff * X) / (UE_DOUBLE_PI * X);
+			const double Ratio = X / Center;
+			const double Window = BesselI0(Settings.KaiserBeta * FMath::Sqrt(FMath::Max(0.0, 1.0 - Ratio * Ratio))) * WindowNorm;
+			const double Coefficient = Sinc * Window;
+			// Reversed so the newest sample lines up with the last coefficient in the dot product.
+			PhaseCoefficients[NumTaps - 1 - Tap] = (float)Coefficient;
+			PhaseSum += Coefficient;
+		}
+
+		// Normalize every phase to unity DC gain so there is no ripple on steady signals.
+		const float Normalize = PhaseSum != 0.0 ? (float)(1.0 / PhaseSum) : 0.0f;
+		for (int32 Tap = 0; Tap < NumTaps; ++Tap)
+		{
+			PhaseCoefficients[Tap] *= Normalize;
+		}
+	}
+}
+
+void FTTSResampler::Reset()
+{
+	if (ChannelHistory.Num() < NumChannels)
+	{
+		FReadSpeakerTTSModule::CountBufferAllocation();
+	}
+	ChannelHistory.SetNum(FMath::Max(NumChannels, 0), false);
+	for (TArray<float>& History : ChannelHistory)
+	{
+		// Room for the flush padding too, so only chunks longer than any seen before grow the history.
+		History.Reset();
+		ReserveHistory(History, FMath::Max(NumTaps - 1, 0) + NumTaps / 2);
+		History.AddZeroed(FMath::Max(NumTaps - 1, 0));
+	}
+	// Start half a filter ahead so the first output sample is centered on the first input sample.
+	Position = FMath::Max(NumTaps - 1, 0) + NumTaps / 2;
+	Phase = 0;
+}
+
+int32 FTTSResampler::GetMaxOutputFrames(int32 NumInputFrames) const
+{
+	if (!bActive)
+	{
+		return NumInputFrames;
+	}
+	return (int32)(((int64)(NumInputFrames + NumTaps) * Interpolation) / Decimation) + 1;
+}
+
+int32 FTTSResampler::Process(const float* Input, int32 NumInputFrames, TArray<float>& Output)
+{
+	if (!bActive || NumInputFrames <= 0)
+	{
+		return 0;
+	}
+
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		TArray<float>& History = ChannelHistory[Channel];
+		ReserveHistory(History, NumInputFrames);
+		const int32 Offset = History.AddUninitialized(NumInputFrames);
+		float* Dst = History.GetData() + Offset;
+		for (int32 Frame = 0; Frame < NumInputFrames; ++Frame)
+		{
+			Dst[Frame] = Input[Frame * NumChannels + Channel];
+		}
+	}
+
+	return ProduceFrames(Output);
+}
+
+int32 FTTSResampler::Flush(TArray<float>& Output)
+{
+	if (!bActive)
+	{
+		return 0;
+	}
+
+	for (TArray<float>& History : ChannelHistory)
+	{
+		History.AddZeroed(NumTaps / 2);
+	}
+	const int32 NumFrames = ProduceFrames(Output);
+	Reset();
+	return NumFrames;
+}
+
+int32 FTTSResampler::ProduceFrames(TArray<float>& Output)
+{
+	const int32 NumAvailable = ChannelHistory[0].Num();
+	const int32 StartSamples = Output.Num();
+
+	while (Position < NumAvailable)
+	{
+		const float* Coefficients = FilterBank.GetData() + Phase * NumTaps;
+		const int32 Start = Position - NumTaps + 1;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Output.Add(DotProduct(Coefficients, ChannelHistory[Channel].GetData() + Start, NumTaps));
+		}
+
+		Phase += Decimation;
+		Position += Phase / Interpolation;
+		Phase %= Interpolation;
+	}
+
+	// Keep only the samples the next output still needs.
+	const int32 Consumed = FMath::Min(Position - (NumTaps - 1), NumAvailable);
+	if (Consumed > 0)
+	{
+		for (TArray<float>& History : ChannelHistory)
+		{
+			History.RemoveAt(0, Consumed, false);
+		}
+		Position -= Consumed;
+	}
+
+	return (Output.Num() - StartSamples) / NumChannels;
+}
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TTSSynthComponent.h"
+#include "ReadSpeakerTTS.h"
+#include "Sound/SoundGenerator.h"
+
+/**
+ * Pulls TTS audio from an FTTSAudioStream on the audio render thread.
+ */
+class FTTSSoundGenerator : public ISoundGenerator
+{
+public:
+	FTTSSoundGenerator(TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> InStream, int32 InCallbackSize)
+		: Stream(InStream)
+		, CallbackSize(InCallbackSize)
+	{
+		Stream->Attach();
+	}
+
+	virtual int32 OnGenerateAudio(float* OutAudio, int32 NumSamples) override
+	{
+		const int32 NumRead = Stream->Read(OutAudio, NumSamples);
+		if (NumRead < NumSamples)
+		{
+			FMemory::Memzero(OutAudio + NumRead, (NumSamples - NumRead) * sizeof(float));
+		}
+		return NumSamples;
+	}
+
+	virtual int32 GetDesiredNumSamplesToRenderPerCallback() const override
+	{
+		return CallbackSize;
+	}
+
+private:
+	TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> Stream;
+	int32 CallbackSize;
+};
+
+UTTSSynthComponent::UTTSSynthComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	NumChannels = 1;
+	PreferredBufferLength = CallbackSize;
+
+	// Only ticks while a stream replaced by a format change is draining.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> UTTSSynthComponent::GetStream(int32 InSampleRate, int32 InNumChannels)
+{
+	if (Stream.IsValid() && Stream->GetSampleRate() == InSampleRate && Stream->GetNumChannels() == InNumChannels)
+	{
+		return Stream.ToSharedRef();
+	}
+
+	if (Stream.IsValid() && IsPlaying() && !Stream->IsFinished())
+	{
+		// Its producers may still be writing, so it plays to the end and TickComponent() hands over once it drained.
+		DrainingStreams.Add(Stream);
+		SetComponentTickEnabled(true);
+		CreateStream(InSampleRate, InNumChannels);
+		return Stream.ToSharedRef();
+	}
+
+	// Nothing plays the old streams any more, so release their producers instead of letting them stall.
+	for (const TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe>& Draining : DrainingStreams)
+	{
+		Draining->Cancel();
+	}
+	DrainingStreams.Reset();
+	if (Stream.IsValid())
+	{
+		Stream->Cancel();
+	}
+
+	CreateStream(InSampleRate, InNumChannels);
+	if (IsPlaying())
+	{
+		Restart();
+	}
+	return Stream.ToSharedRef();
+}
+
+TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> UTTSSynthComponent::GetPlayingStream() const
+{
+	return DrainingStreams.Num() > 0 ? DrainingStreams[0] : Stream;
+}
+
+void UTTSSynthComponent::Restart()
+{
+	const TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> Playing = GetPlayingStream();
+	NumChannels = Playing.IsValid() ? Playing->GetNumChannels() : NumChannels;
+	Stop();
+	Start();
+}
+
+void UTTSSynthComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (DrainingStreams.Num() > 0 && DrainingStreams[0]->IsFinished())
+	{
+		DrainingStreams.RemoveAt(0);
+		Restart();
+	}
+	if (DrainingStreams.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UTTSSynthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// A stream waiting for its handoff would never be played, don't leave its producers waiting for it.
+	CancelStream();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTTSSynthComponent::CreateStream(int32 InSampleRate, int32 InNumChannels)
+{
+	const int32 CapacitySamples = FMath::CeilToInt(BufferDuration * InSampleRate) * InNumChannels;
+	Stream = MakeShared<FTTSAudioStream, ESPMode::ThreadSafe>(CapacitySamples, InSampleRate, InNumChannels);
+	Stream->SetWatermarks(FMath::CeilToInt(HighWatermarkDuration * InSampleRate) * InNumChannels, FMath::CeilToInt(LowWatermarkDuration * InSampleRate) * InNumChannels);
+	Stream->SetPreRoll(FMath::CeilToInt(MinPreRollDuration * InSampleRate) * InNumChannels, FMath::CeilToInt(MaxPreRollDuration * InSampleRate) * InNumChannels, (int64)FMath::CeilToInt(PreRollShrinkInterval * InSampleRate) * InNumChannels);
+}
+
+bool UTTSSynthComponent::IsStreaming() const
+{
+	return DrainingStreams.Num() > 0 || (Stream.IsValid() && !Stream->IsFinished());
+}
+
+void UTTSSynthComponent::CancelStream()
+{
+	if (Stream.IsValid())
+	{
+		Stream->Cancel();
+	}
+	if (DrainingStreams.Num() > 0)
+	{
+		for (const TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe>& Draining : DrainingStreams)
+		{
+			Draining->Cancel();
+		}
+		DrainingStreams.Reset();
+		SetComponentTickEnabled(false);
+		if (IsPlaying())
+		{
+			Restart();
+		}
+	}
+}
+
+bool UTTSSynthComponent::Init(int32& SampleRate)
+{
+	const TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> Playing = GetPlayingStream();
+	if (Playing.IsValid())
+	{
+		SampleRate = Playing->GetSampleRate();
+		NumChannels = Playing->GetNumChannels();
+	}
+	PreferredBufferLength = CallbackSize;
+	return true;
+}
+
+ISoundGeneratorPtr UTTSSynthComponent::CreateSoundGenerator(const FSoundGeneratorInitParams& InParams)
+{
+	if (!Stream.IsValid())
+	{
+		CreateStream(InParams.SampleRate, InParams.NumChannels);
+	}
+	return MakeShared<FTTSSoundGenerator, ESPMode::ThreadSafe>(GetPlayingStream().ToSharedRef(), CallbackSize);
+}
@@ -1,119 +1,137 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "TTSVoiceComponent.h"
-
-// Sets default values for this component's properties
-UTTSVoiceComponent::UTTSVoiceComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
-{
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
-	PrimaryComponentTick.bStartWithTickEnabled = true;
-}
-
-
-// Called when the game starts
-void UTTSVoiceComponent::BeginPlay()
-{
-	Super::BeginPlay();
-}
-
-void UTTSVoiceComponent::BeginDestroy() {
-	if (Converter != nullptr) {
-		UTTSEngine* engine = Converter->Engine;
-		if(engine != nullptr) {
-			engine->UnloadEngine();
-		}
-	}
-	Super::BeginDestroy();
-}
-
-
-// Called every frame
-void UTTSVoiceComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	if (!Audio.IsEmpty()) {
-		TArray<int16> pcm;
-		if (AudioLock.TryLock()) {
-			while (!Audio.IsEmpty()) {
-				TArray<int16> sound;
-				if (Audio.Dequeue(sound)) {
-					pcm.Append(sound);
-				}
-			}
-			AudioLock.Unlock();
-		}
-		pcm.Shrink();
-		TArray<uint8> data(reinterpret_cast<const uint8*>(pcm.GetData()), pcm.Num() * 2);
-		FAudioFragment audio(data);
-		OnAudio.Broadcast(audio);
-		UE_LOG(LogReadSpeakerTTS, Display, TEXT("UTTSVoiceComponent::TickComponent sent %d bytes of audio."), audio.Audio.Num());
-	}
-}
-
-void UTTSVoiceComponent::SetSpeaker(UTTSSpeaker* NewSpeaker) {
-	if (NewSpeaker != nullptr) {
-		Speaker = NewSpeaker;
-		Converter = NewObject<UTTSConverter>();
-		{
-			UTTSEngine* engine = Speaker->GetEngine();
-			if (engine != nullptr) {
-				engine->LoadEngine();
-				Converter->Engine = engine;
-			}
-			else {
-				UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine was null")); 
-			}
-	    }
-		Converter->Volume = Speaker->GetVolume();
-		Converter->Pitch = Speaker->GetPitch();
-		Converter->Speed = Speaker->GetSpeed();
-		Converter->Pause = Speaker->GetPause();
-		Converter->CommaPause = Speaker->GetCommaPause();
-		Converter->AudioComponent = Speaker->GetAudioComponent();
-		Converter->OutputFormat = TTSOutputFormat::PCM16;
-		Converter->SoundAttenuationSettings = &(Speaker->SoundAttenuation);
-		Converter->OnConversionFinished.AddDynamic(this, &UTTSVoiceComponent::GrabAudio);
-		
-	}
-	else {
-		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Speaker was null"));
-	}
-}
-
-UTTSSpeaker* UTTSVoiceComponent::GetSpeaker()
-{
-	if (Speaker == nullptr) {
-		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Speaker was null"));
-	}
-	return Speaker;
-}
-
-void UTTSVoiceComponent::voice(FString text, TTSTextType textType) {
-	AudioDataLock.WriteLock();
-	Converter->Text = text;
-	Converter->TextType = textType;
-	Converter->ConvertToBuffer();
-	AudioDataLock.WriteUnlock();
-}
-
-void UTTSVoiceComponent::voiceAsync(FString text, TTSTextType textType) {
-	AudioDataLock.WriteLock();
-	Converter->Text = text;
-	Converter->TextType = textType;
-	Converter->ConvertToBufferAsync();
-	AudioDataLock.WriteUnlock();
-}
-
-void UTTSVoiceComponent::GrabAudio() {
-	if (Converter != nullptr) {
-		AudioDataLock.ReadLock();
-		TArray<int16> sound = Converter->GetAudioData();
-		if (!sound.IsEmpty()) {
-			Audio.Enqueue(sound);
-			Converter->ClearAudioData();
-		}
-		AudioDataLock.ReadUnlock();
-	}
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TTSVoiceComponent.h"
+
+// Sets default values for this component's properties
+UTTSVoiceComponent::UTTSVoiceComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
+	// off to improve performance if you don't need them.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+
+// Called when the game starts
+void UTTSVoiceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+}
+
+void UTTSVoiceComponent::BeginDestroy() {
+	if (Converter != nullptr) {
+		UTTSEngine* engine = Converter->Engine;
+		if(engine != nullptr) {
+			engine->UnloadEngine();
+		}
+	}
+	Super::BeginDestroy();
+}
+
+
+// Called every frame
+void UTTSVoiceComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	if (PendingAudio.IsEmpty() || !AudioLock.TryLock()) {
+		return;
+	}
+	const int32 bytes = PendingAudio.Num() * sizeof(int16);
+	Fragment.Audio.SetNumUninitialized(bytes, false);
+	FMemory::Memcpy(Fragment.Audio.GetData(), PendingAudio.GetData(), bytes);
+	Fragment.VisemeIds.Reset();
+	Fragment.VisemeIds.Append(PendingVisemeIds);
+	Fragment.VisemeTimes.Reset();
+	Fragment.VisemeTimes.Append(PendingVisemeTimes);
+	PendingAudio.Reset();
+	PendingVisemeIds.Reset();
+	PendingVisemeTimes.Reset();
+	AudioLock.Unlock();
+
+	OnAudio.Broadcast(Fragment);
+	UE_LOG(LogReadSpeakerTTS, Display, TEXT("UTTSVoiceComponent::TickComponent sent %d bytes of audio."), Fragment.Audio.Num());
+}
+
+void UTTSVoiceComponent::SetSpeaker(UTTSSpeaker* NewSpeaker) {
+	if (NewSpeaker != nullptr) {
+		Speaker = NewSpeaker;
+		Converter = NewObject<UTTSConverter>();
+		{
+			UTTSEngine* engine = Speaker->GetEngine();
+			if (engine != nullptr) {
+				engine->LoadEngine();
+				Converter->Engine = engine;
+			}
+			else {
+				UE_LOG(LogReadSpeakerTTS, Error, TEXT("Engine was null")); 
+			}
+	    }
+		Converter->Volume = Speaker->GetVolume();
+		Converter->Pitch = Speaker->GetPitch();
+		Converter->Speed = Speaker->GetSpeed();
+		Converter->Pause = Speaker->GetPause();
+		Converter->CommaPause = Speaker->GetCommaPause();
+		Converter->AudioComponent = Speaker->GetAudioComponent();
+		Converter->OutputFormat = Speaker->OutputFormat;
+		Converter->bApplyVolumeAsGain = Speaker->bApplyVolumeAsGain;
+		Converter->bTrimSilence = Speaker->bTrimSilence;
+		Converter->SilenceThreshold = Speaker->SilenceThreshold;
+		Converter->SilencePadding = Speaker->SilencePadding;
+		Converter->DspChain.Build(Speaker->Processing);
+		Converter->OutputSampleRate = OutputSampleRate;
+		Converter->ResamplerQuality = ResamplerQuality;
+		Converter->SoundAttenuationSettings = &(Speaker->SoundAttenuation);
+		Converter->OnConversionFinished.AddDynamic(this, &UTTSVoiceComponent::GrabAudio);
+		
+	}
+	else {
+		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Speaker was null"));
+	}
+}
+
+UTTSSpeaker* UTTSVoiceComponent::GetSpeaker()
+{
+	if (Speaker == nullptr) {
+		UE_LOG(LogReadSpeakerTTS, Error, TEXT("Speaker was null"));
+	}
+	return Speaker;
+}
+
+void UTTSVoiceComponent::voice(FString text, TTSTextType textType) {
+	AudioDataLock.WriteLock();
+	Converter->Text = text;
+	Converter->TextType = textType;
+	Converter->ConvertToBuffer();
+	AudioDataLock.WriteUnlock();
+}
+
+void UTTSVoiceComponent::voiceAsync(FString text, TTSTextType textType) {
+	AudioDataLock.WriteLock();
+	Converter->Text = text;
+	Converter->TextType = textType;
+	Converter->ConvertToBufferAsync();
+	AudioDataLock.WriteUnlock();
+}
+
+void UTTSVoiceComponent::GrabAudio() {
+	if (Converter != nullptr) {
+		AudioDataLock.ReadLock();
+		// Emptied first, so the converter gets an empty buffer with capacity back in the swap.
+		TakenAudio.Reset();
+		Converter->TakeAudioData(TakenAudio);
+		if (!TakenAudio.IsEmpty()) {
+			Converter->Timeline.GetVisemes(TakenVisemes);
+			const float sampleRate = (float)Converter->GetOutputSampleRate();
+			AudioLock.Lock();
+			// Utterances are joined, so their visemes move to where their audio starts.
+			const float start = PendingAudio.Num() / sampleRate;
+			for (const FTTSVisemeCue& cue : TakenVisemes) {
+				PendingVisemeIds.Add(cue.VisemeId);
+				PendingVisemeTimes.Add(start + cue.Time);
+			}
+			PendingAudio.Append(TakenAudio);
+			AudioLock.Unlock();
+		}
+		AudioDataLock.ReadUnlock();
+	}
+}
@@ -1,722 +1,1129 @@
-// Copyright 2022 ReadSpeaker AB. All Rights Reserved.
-
-#pragma once
-
-#include "Modules/ModuleManager.h"
-#include "CoreMinimal.h"
-#include "Sound/SoundWaveProcedural.h"
-#include "UObject/NoExportTypes.h"
-#if WITH_EDITOR
-#include "DetailLayoutBuilder.h"
-#include "IDetailCustomization.h"
-#include "Styling/SlateStyle.h"
-#endif
-#include "ReadSpeakerTTS.generated.h"
-
-DECLARE_LOG_CATEGORY_EXTERN(LogReadSpeakerTTS, Log, All);
-
-
-	class FToolBarBuilder;
-	class FMenuBuilder;
-
-	DECLARE_MULTICAST_DELEGATE(FOnPauseAll);
-	DECLARE_MULTICAST_DELEGATE(FOnResumeAll);
-	DECLARE_MULTICAST_DELEGATE(FOnInterruptAll);
-	DECLARE_EVENT_TwoParams(UTTSSpeaker, FOnSpeakingStarted, FString, TTSTextType);
-	DECLARE_EVENT_TwoParams(UTTSSpeaker, FOnSpeakingFinished, FString, TTSTextType);
-	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnConversionFinished);
-	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnWordEvent, int, startPos, int, endPos, float, time);
-	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnVisemeEvent, int, visemeId, float, time);
-	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMarkEvent, FString, markName, float, time);
-
-	UENUM(BlueprintType)
-	enum class TTSTextType : uint8 {
-		Normal = 0, ///< SSML tags won't be processed.
-		SSML = 128 ///< SSML tags will be processed.
-	};
-
-	UENUM(BlueprintType)
-	enum class TTSOutputFormat : uint8 {
-		PCM16 = 0, ///< Linear 16-bit PCM format.
-		PCM8 = 1 ///< Linear 8-bit PCM format.
-	};
-
-	class FReadSpeakerTTSModule : public IModuleInterface
-	{
-	public:
-
-		/**
-		 * Called when module loads.
-		 */
-		virtual void StartupModule() override;
-
-		/**
-		 * Called when module unloads.
-		 */
-		virtual void ShutdownModule() override;
-
-		/**
-		 * Updates the list of TTS Engines.
-		 */
-		READSPEAKERTTS_API static void GetEngines(TArray<UTTSEngine*> *EngineArr);
-
-		/**
-		 * Gets the TTS Engine with the specified name and type.
-		 * @param {FString} name The name which is queried.
-		 * @param {FString} type The type which is queried.
-		 */
-		READSPEAKERTTS_API static UTTSEngine* GetEngine(FString name, FString type);
-
-		/**
-		 * Gets the TTS Engine with the specified id.
-		 * @param {FString} id The id which is queried.
-		 * @returns {UTTSEngine*} A TTS engine with name name and type type. null if none exists.
-		 */
-		READSPEAKERTTS_API static UTTSEngine* GetEngineByID(FString id);
-
-		/**
-		 * Gets a TTS engine with a specified language.
-		 * @param {FString} lang The language which is queried.
-		 * @returns {UTTSEngine*} The TTS engine with ID id. null if none exists.
-		 */
-		READSPEAKERTTS_API static UTTSEngine* GetEngineWithLanguage(FString lang);
-
-		/**
-		 * Gets a TTS engine with a specified gender.
-		 * @param {FString} gender The gender which is queried.
-		 * @returns {UTTSEngine*} A TTS engine with language lang. null if none exists.
-		 */
-		READSPEAKERTTS_API static UTTSEngine* GetEngineWithGender(FString gender);
-
-		/**
-		 * Gets a TTS engine with a specified language and gender.
-		 * @param {FString} lang The language which is queried.
-		 * @param {FString} gender The gender which is queried.
-		 * @returns {UTTSEngine*} A TTS engine with language lang and gender gender. null if none exists.
-		 */
-		READSPEAKERTTS_API static UTTSEngine* GetEngineWithLanguageAndGender(FString lang, FString gender);
-
-		/**
-		 * Gets all of the installed TTS engines.
-		 * @returns {TArray<UTTSEngine*>} The currently installed TTS engines. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<UTTSEngine*> GetInstalledEngines();
-
-		/**
-		 * Gets the TTS engines with a specified language.
-		 * @param {FString} lang The language which is queried.
-		 * @returns {TArray<UTTSEngine*>} All TTS engines with language lang. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithLanguage(FString lang);
-
-		/**
-		 * Gets the TTS engines with a specified gender.
-		 * @param {FString} gender The gender which is queried.
-		 * @returns {TArray<UTTSEngine*>} All TTS engines with gender gender. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithGender(FString gender);
-
-		/**
-		 * Gets the TTS engines with a specified language and gender.
-		 * @param {FString} lang The language which is queried
-		 * @param {FString} gender The gender which is queried.
-		 * @returns {TArray<UTTSEngine*>} All TTS engines with language lang and gender gender. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithLanguageAndGender(FString lang, FString gender);
-
-		/**
-		 * Gets the available languages in the currently installed TTS engines.
-		 * @returns {TArray<FString>} All available languages. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<FString> GetAvailableLanguages();
-
-		/**
-		 * Gets the available genders for a specified language.
-		 * @param {FString} lang The language which is queried.
-		 * @returns {TArray<FString>} The available genders for language lang. Empty if none.
-		 */
-		READSPEAKERTTS_API static TArray<FString> GetAvailableGendersForLanguage(FString lang);
-
-		/**
-		 * Updates configuration files based on currently installed voices.
-		 * Has to be called before a newly installed voice engine can be used.
-		 */
-		READSPEAKERTTS_API static void RefreshVoiceEngineInstallations();
-
-		/**
-		 * Initializes the text to speech system. Has to be called before any calls to associated functions.
-		 * TODO Throw exception if platform not supported
-		 * @throws not_supported The current platform is not supported.
-		 */
-		READSPEAKERTTS_API static int Init();
-
-		/**
-		 * Pauses playback of all active TTS speakers.
-		 */
-		READSPEAKERTTS_API static void PauseAll();
-
-		/**
-		 * Resumes playback of all active TTS speakers.
-		 */
-		READSPEAKERTTS_API static void ResumeAll();
-
-		/**
-		 * Interrupts playback of all active TTS speakers.
-		 */
-		READSPEAKERTTS_API static void InterruptAll();
-
-
-		/**
-		 * Binds playback functions to a TTS speaker.
-		 */
-		static void BindSpeaker(UTTSSpeaker* speaker);
-
-		/**
-		 * Unbinds playback functions from a TTS speaker.
-		 */
-		static void UnbindSpeaker(UTTSSpeaker* speaker);
-
-		/**
-		* Mutex to ensure thread safety on Android.
-		*/
-		static FCriticalSection AndroidMutex;
-
-#if PLATFORM_ANDROID
-		static void RefreshVoiceEngineInstallations_Android();
-#endif
-
-	private:
-		void* VTAPILibraryHandle;
-		void* RSGameLibraryHandle;
-		static FOnPauseAll FOnPauseAllDelegate;
-		static FOnResumeAll FOnResumeAllDelegate;
-		static FOnInterruptAll FOnInterruptAllDelegate;
-		static void ClearLastSession();
-		static void RecieveEngineCallback(void* context, char* speaker, char* type, char* language, char* gender, char* dbPath, char* version, int sampling, int channels);
-		static int LoadTTS(FString libPath, FString iniPath);
-#if WITH_EDITOR
-		TSharedRef<FSlateStyleSet> StyleSet = MakeShareable(new FSlateStyleSet("MyStyleSet"));
-#endif	
-};
-
-	class READSPEAKERTTS_API VisemeEvent {
-	public:
-		float timestamp;
-		int viseme_id;
-	};
-
-	UCLASS(ClassGroup = ReadSpeakerTTS, DefaultToInstanced)
-	class READSPEAKERTTS_API USoundWaveProceduralTTS : public USoundWaveProcedural
-	{
-		GENERATED_BODY()
-	public:
-
-		USoundWaveProceduralTTS(const FObjectInitializer& ObjectInitializer);
-		
-		int TTSSampleRate; ///< The sample rate of the produced TTS audio.
-		int TTSBitDepth; ///<  The bit depth of the produced TTS audio.
-		double Length; ///< The length in seconds of the current audiodata.
-		double RemainingDuration; ///< The remaining playback duration of the current audio in seconds.
-		TArray<int16> SampleData; ///< The buffer which is fetched from when pushing data into the audio queue.
-		TArray<int16> TTSData; ///< The buffer which is fetched from when pushing data into the audio queue.
-		TQueue<VisemeEvent> VisemeEvents; ///< The queue of viseme events of the produced speech.
-
-		/**
-		 * Sets the data this soundwave will contain.
-		 * @param data The audio data.
-		 */
-		void SetAudioData(TArray<int16> data);
-
-		/**
-		 * Pushes data from the TTSData buffer into the audio queue.
-		 * @param InProceduralWave The sound wave to push data to
-		 * @param SamplesRequired The number of samples to push.
-		 */
-		void FillAudioQueue(int32 SamplesRequired);
-
-		/**
-		 * Sets the sample rate of this SoundWave
-		 * @param Sampling the sampling rate to set
-		 */
-		void SetSampleRate(int32 Sampling);
-	private:
-		double CalculateAudioDuration();
-	};
-
-	/**
-	 * Represents a voice engine.
-	 */
-	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent))
-		class READSPEAKERTTS_API UTTSEngine : public UObject {
-		GENERATED_BODY()
-		private:
-			int32 ReferenceCount;
-			bool KeepInMemory;
-
-			bool UseLicenseFile();
-			FString GetLicensePath();
-			bool IsLicensed();
-
-			friend class UTTSConverter;
-		        int Acquire();
-		        int Release();
-		        FCriticalSection EngineMutex;
-		public:
-			FString ID; ///< The ID of the engine.
-			FString Name; ///< The name of the engine.
-			FString Type; ///< The type of the engine.
-			FString Language; ///< The language of the engine.
-			FString Gender; ///< The gender of the engine.
-			FString Version; ///< The voice engine version.
-			int Sampling; ///< The samplerate of the voice engine.
-			int Channels; ///< The number of channels of the voice engine.
-
-			/**
-			 * Constructor
-			 */
-			UTTSEngine(const FObjectInitializer& ObjectInitializer);
-
-			/**
-			 * Loads this engine into memory. No-op if already loaded.
-			 */
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "LoadEngine"))
-				int LoadEngine();
-
-			/**
-			 * Unloads the engine from memory. No-op if not loaded.
-			 */
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "UnloadEngine"))
-				int UnloadEngine();
-
-			/**
-			 * Gets the ID of this engine.
-			 */
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "GetID"))
-				FString GetID();
-	};
-
-	/**
-	 * Blueprint wrapper for accessing static module functions.
-	 */
-	UCLASS(ClassGroup = ReadSpeakerTTS)
-		class READSPEAKERTTS_API UTTSObject : public UObject
-	{
-		GENERATED_BODY()
-	public:
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "Init"))
-			static void Init();
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "FindEngine"))
-			static UTTSEngine* FindEngine(FString name, FString type);
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "PauseAll"))
-			static void PauseAll();
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "ResumeAll"))
-			static void ResumeAll();
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "InterruptAll"))
-			static void InterruptAll();
-	};
-
-	/**
-	 * Encapsulates the text-to-speech conversion process.
-	 */
-	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent), DefaultToInstanced)
-		class READSPEAKERTTS_API UTTSConverter : public UObject {
-		GENERATED_BODY()
-		public:
-
-			UPROPERTY(Transient)
-			UTTSEngine* Engine; ///< The voice engine to be used in synthesis.
-			
-			UPROPERTY(Transient)
-			USoundWaveProceduralTTS* SoundWave; ///< Reference to the soundwave which the audio is output to.
-
-			UPROPERTY(Transient)
-			UAudioComponent* AudioComponent; ///< The audio component which should play the audio.
-
-			FString Text; ///< The text to be converted.
-			int32 Volume; ///< The volume to be used in synthesis.
-			int32 Pitch; ///< The pitch to be used in synthesis.
-			int32 Speed; ///< The speed to be used in synthesis.
-			int32 Pause; ///< The time in milliseconds to pause when encountering a delimiter in synthesis.
-			int32 CommaPause; ///< The time in millieseconds to pause when encountering a ',' in synthesis.
-			TTSTextType TextType; ///< Determines how the text should be processed in synthesis.
-			TTSOutputFormat OutputFormat; ///< Gets or sets the format of the audio output.
-			FSoundAttenuationSettings *SoundAttenuationSettings;  ///< The sound attenuation to use during playback.
-			bool FinishedConverting; ///<  true if conversion has both been started and finished, false otherwise.
-
-			UTTSConverter(const FObjectInitializer& ObjectInitializer);
-
-			/**
-			 * Converts text to speech using the current handle values and stores the result in an audio buffer.
-			 * \code
-			 void SayHello(){
-				 FReadSpeakerTTSModule::Init();
-				 UTTSEngine *Engine = FReadSpeakerTTSModule::GetEngine("ashley", "d16");
-				 UTTSConverter converter;
-				 converter.Text = "Hello";
-				 converter.Engine = Engine;
-				 converter.Volume = 225;
-				 converter.Pitch = 125;
-				 converter.Speed = 125;
-				 converter.Pause = 0;
-				 converter.CommaPause = 0;
-				 converter.EmphasisFactor = 0;
-				 converter.ConvertToBuffer();
-				 TArray<int16> result = converter.GetAudioData();
-			 }
-			 * \endcode
-			 * Will result in the array result being filled with linear PCM data obtained from synthesizing the text
-			 * "Hello" using the specified handle values.
-			 */
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBuffer"))
-			void ConvertToBuffer();
-
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBuffer_SyncInfo"))
-			void ConvertToBuffer_SyncInfo();
-			
-			/**
-			 * Converts text to speech using the current handle values and stores the result in an audio buffer.
-			 * \code
-			 void SayHello(){
-				 FReadSpeakerTTSModule::Init();
-				 UTTSEngine *Engine = FReadSpeakerTTSModule::GetEngine("ashley", "d16");
-				 UTTSConverter converter;
-				 converter.Text = "Hello";
-				 converter.Engine = Engine;
-				 converter.Volume = 225;
-				 converter.Pitch = 125;
-				 converter.Speed = 125;
-				 converter.Pause = 0;
-				 converter.CommaPause = 0;
-				 converter.EmphasisFactor = 0;
-				 converter.ConvertToBufferAsync();
-			 }
-			 * \endcode
-			 * Will begin synthesizing the text "Hello" using the specified handle values. The resulting linear PCM
-			 * data can be fetched with GetAudioData() once FinishedConverting() returns true.
-			 */
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBufferAsync"))
-			void ConvertToBufferAsync();
-
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBufferAsync_SyncInfo"))
-			void ConvertToBufferAsync_SyncInfo();
-
-			/**
-			 * Gets the audio data that has been converted by ConverToBuffer() or ConvertToBufferAsync().
-			 * @returns The audio data which has been converted. The complete data set if FinishedConverting() returns true, an incomplete data set otherwise.
-			 */
-			TArray<int16> GetAudioData();
-
-			void ClearAudioData();
-
-			/**
-			 * Plays the audio produced by this converter on the given AudioComponent using the given SoundAttenuationSettings.
-			*/
-			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "PlayAudioFromConverter"))
-			void Play();
-
-			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
-			FOnConversionFinished OnConversionFinished;
-
-			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
-			FOnWordEvent OnWord;
-
-			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
-			FOnVisemeEvent OnViseme;
-
-			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
-			FOnMarkEvent OnMark;
-
-		private:
-			class FTTSSynthesizeTask : public FNonAbandonableTask {
-			public:
-				FTTSSynthesizeTask(TWeakObjectPtr<UTTSConverter> Converter, bool SyncInfo) {
-					this->Converter = Converter;
-					this->SyncInfo = SyncInfo;
-				}
-
-				FORCEINLINE TStatId GetStatId() const
-				{
-					RETURN_QUICK_DECLARE_CYCLE_STAT(FTTSSynthesizeTask, STATGROUP_ThreadPoolAsyncTasks);
-				}
-
-				void DoWork() {
-					{
-						{
-#if PLATFORM_ANDROID
-							FScopeLock ScopeLock(&(FReadSpeakerTTSModule::AndroidMutex));
-#else
-							FScopeLock ScopeLock(&(Converter->Engine->EngineMutex));
-#endif
-							if (SyncInfo) {
-								Converter->ConvertToBuffer_SyncInfo();
-							}
-							else {
-								Converter->ConvertToBuffer();
-							}
-						}
-					}
-				}
-
-			private:
-				TWeakObjectPtr<UTTSConverter> Converter;
-				bool SyncInfo;
-			};
-
-			TArray<int16> AudioData;
-			FAsyncTask<FTTSSynthesizeTask>* Task;
-
-			static void audio_callback(void* context, char* data, int* length);
-			static void word_callback(void* context, int* startPos, int* endPos, float* time, int* length);
-			static void viseme_callback(void* context, short* visemeId, float* time, int* length);
-			static void mark_callback(void* context, char* markName, float* time, int* length);
-			void AddVisemeToQueue(int visemeId, float timestamp);
-			void RecieveAudioCallback(char* data, int* length);
-			void RecieveWordCallback(int* startPos, int* endPos, float* time, int* length);
-			void RecieveVisemeCallback(short* visemeId, float* time, int* length);
-			void RecieveMarkCallback(char* markName, float* time, int* length);
-			void BeginDestroy() override;
-	};
-
-	/**
-	 * An Actor Component which enables an Actor to speak using TTS.
-	 */
-	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent), DefaultToInstanced)
-		class READSPEAKERTTS_API UTTSSpeaker : public UActorComponent
-	{
-		GENERATED_BODY()
-	public:
-
-		UTTSSpeaker(const FObjectInitializer& ObjectInitializer);
-
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics)
-			FString EngineID; ///< The ID of the currently set voice engine.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "500", UIMin = "0", UIMax = "500"))
-			int32 Volume; ///< The volume this speaker should use during synthesis.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "50", ClampMax = "200", UIMin = "50", UIMax = "200"))
-			int32 Pitch; ///< The pitch this speaker should use during synthesis.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "50", ClampMax = "400", UIMin = "50", UIMax = "400"))
-			int32 Speed; ///< The speed this speaker should use during synthesis.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "65535", UIMin = "0", UIMax = "65535"))
-			int32 Pause; ///< The time in milliseconds which this speaker should pause when encountering a delimiter during synthesis.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "65535", UIMin = "0", UIMax = "65535"))
-			int32 CommaPause; ///< The time in milliseconds which this speaker should pause when encountering a ',' during synthesis.
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attenuation)
-			FSoundAttenuationSettings SoundAttenuation; ///< The sound attenuation settings to be used by this speaker.
-
-		/**
-		* Delegate which is invoked when this speaker starts speaking.
-		*/
-		FOnSpeakingStarted OnSpeakingStarted;
-
-		/**
-		* Delegate which is invoked when this speaker finishes speaking.
-		*/
-		FOnSpeakingFinished OnSpeakingFinished;
-
-		/**
-		 * Previews how this speaker sounds in the Editor. No-op if not in Editor.
-		 */
-		void Preview();
-
-		/**
-		 * Sets the Audio Component used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetAudioComponent", DefaultToSelf))
-		void SetAudioComponent(UAudioComponent* AudioComponent);
-
-		/**
-		 * Gets the Audio Component used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetAudioComponent", DefaultToSelf))
-		UAudioComponent* GetAudioComponent();
-
-		/**
-		* Blueprint wrapper function to get the current viseme ID of this speaker.
-		*/
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetCurrentViseme", DefaultToSelf))
-		int GetCurrentViseme();
-
-		/**
-		 * Sets the Voluume used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetVolume", DefaultToSelf))
-		void SetVolume(int NewVolume);
-
-		/**
-		 * Gets the Volume used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetVolume", DefaultToSelf))
-		int GetVolume();
-
-		/**
-		 * Sets the Pitch used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetPitch", DefaultToSelf))
-		void SetPitch(int NewPitch);
-		
-		/**
-		 * Gets the Pitch used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetPitch", DefaultToSelf))
-		int GetPitch();
-
-		/**
-		 * Sets the Speed used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetSpeed", DefaultToSelf))
-		void SetSpeed(int NewSpeed);
-
-		/**
-		 * Gets the Speed used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetSpeed", DefaultToSelf))
-		int GetSpeed();
-
-		/**
-		 * Sets the Pause time in ms used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetPause", DefaultToSelf))
-		void SetPause(int NewPause);
-		
-		/**
-		 * Gets the Pause time in ms used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetPause", DefaultToSelf))
-		int GetPause();
-
-		/**
-		 * Sets the CommaPause time in ms used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetCommaPause", DefaultToSelf))
-		void SetCommaPause(int NewCommaPause);
-
-		/**
-		 * Gets the CommaPause time in ms used by the Speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetCommaPause", DefaultToSelf))
-		int GetCommaPause();
-
-		/**
-		 * Sets the engine to be used by this speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetEngine", DefaultToSelf))
-		void SetEngine(UTTSEngine* Engine);
-
-		/**
-		 * Gets the Engine currently used by this speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetEngine", DefaultToSelf))
-		UTTSEngine* GetEngine();
-
-		/**
-		 * Checks whether this speaker is currently speaking.
-		 * @returns true if this speaker is currently speaking, false otherwise.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "IsSpeaking", DefaultToSelf))
-		bool IsSpeaking();
-
-		/**
-		 * Reads a text aloud using the settings of this speaker.
-		 * @param {UAudioComponent*} AudioComponent The audio component which should play the resulting speech.
-		 * @param {FString} text The text to be read.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "Say", DefaultToSelf))
-		void Say(FString text = "", TTSTextType textType = TTSTextType::Normal);
-
-		/**
-		 * Reads a text aloud using the settings of this speaker. Conversion happens asynchronously and plays
-		 * the result upon completion.
-		 * @param {UAudioComponent*} AudioComponent The audio component which should play the resulting speech.
-		 * @param {FString} text The text to be read.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SayAsync", DefaultToSelf))
-		void SayAsync(FString text = "", TTSTextType textType = TTSTextType::Normal);
-
-		/**
-		 * Pauses playback of this speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "PauseSpeaking", DefaultToSelf))
-		void PauseSpeaking();
-
-		/**
-		 * Resumes playback of this speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "ResumeSpeaking", DefaultToSelf))
-		void ResumeSpeaking();
-
-		/**
-		 * Interrupts playback of this speaker.
-		 */
-		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "InterruptSpeaking", DefaultToSelf))
-		void InterruptSpeaking();
-
-		/**
-		 * Called when Speaking the current query is finished. Do not call manually.
-		 */
-		UFUNCTION()
-		void FinishedSpeaking();
-		
-		/**
-		* Called when Speaking the current query is started. Do not call manually.
-		*/
-		UFUNCTION()
-		void StartedSpeaking();
-
-	private:
-		UPROPERTY(Transient)
-		UTTSEngine* Engine;
-
-		UPROPERTY(Transient)
-		UTTSConverter* Converter;
-
-		UPROPERTY(Transient)
-		UAudioComponent* ThisAudioComponent;
-
-		int CurrentVisemeID;
-		void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-		void BeginPlay() override;
-		void BeginDestroy() override;
-	};
-
-#if WITH_EDITOR
-	class FTTSSpeakerCustomization : public IDetailCustomization {
-	public:
-		virtual void CustomizeDetails(IDetailLayoutBuilder& DetailBuilder) override;
-		static TSharedRef<IDetailCustomization> MakeInstance();
-	};
-
-	DECLARE_DELEGATE(OnValueChangedDelegate);
-
-	/** Delegate that is executed when the check box state changes */
-	DECLARE_DELEGATE(FOnStateChanged);
-
-	class STTSVoiceCombo : public SCompoundWidget
-	{
-	public:
-		SLATE_BEGIN_ARGS(STTSVoiceCombo) 
-			: _SpeechCharacteristics()
-			, _OnStateChanged()
-		{
-		}
-
-		SLATE_ARGUMENT(TWeakObjectPtr<class UTTSSpeaker>, SpeechCharacteristics);
-
-		/** Called when the checked state has changed */
-		SLATE_EVENT(FOnStateChanged, OnStateChanged)
-
-		SLATE_END_ARGS()
-
-		typedef TSharedPtr<FString> FComboItemType;
-		void Construct(const FArguments& InArgs);
-		TSharedRef<SWidget> MakeWidgetForOption(FComboItemType InOption);
-		void OnSelectionChanged(FComboItemType NewValue, ESelectInfo::Type);
-		FText GetCurrentItemLabel() const;
-
-		FComboItemType CurrentItem;
-		TArray<FComboItemType> Options;
-		TWeakObjectPtr<class UTTSSpeaker> SpeechCharacteristics;
-		/** Delegate called when the check box changes state */
-		FOnStateChanged OnStateChanged;
-	};
-#undef LOCTEXT_NAMESPACE
-#endif
+// Copyright 2022 ReadSpeaker AB. All Rights Reserved.
+
+#pragma once
+
+#include "Modules/ModuleManager.h"
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "Sound/QuartzQuantizationUtilities.h"
+#include "UObject/NoExportTypes.h"
+#include "TTSAudioStream.h"
+#include "TTSDspChain.h"
+#include "TTSLoudnessMeter.h"
+#include "TTSEventTimeline.h"
+#include "TTSResampler.h"
+#if WITH_EDITOR
+#include "DetailLayoutBuilder.h"
+#include "IDetailCustomization.h"
+#include "Styling/SlateStyle.h"
+#endif
+#include "ReadSpeakerTTS.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogReadSpeakerTTS, Log, All);
+DECLARE_STATS_GROUP(TEXT("ReadSpeakerTTS"), STATGROUP_ReadSpeakerTTS, STATCAT_Advanced);
+
+
+	class FToolBarBuilder;
+	class FMenuBuilder;
+	class UTTSSynthComponent;
+	class UQuartzClockHandle;
+
+	DECLARE_MULTICAST_DELEGATE(FOnPauseAll);
+	DECLARE_MULTICAST_DELEGATE(FOnResumeAll);
+	DECLARE_MULTICAST_DELEGATE(FOnInterruptAll);
+	DECLARE_EVENT_TwoParams(UTTSSpeaker, FOnSpeakingStarted, FString, TTSTextType);
+	DECLARE_EVENT_TwoParams(UTTSSpeaker, FOnSpeakingFinished, FString, TTSTextType);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnConversionFinished);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnWordEvent, int, startPos, int, endPos, float, time);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnVisemeEvent, int, visemeId, float, time);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMarkEvent, FString, markName, float, time);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnScheduledStartEvent, float, startTime);
+
+	UENUM(BlueprintType)
+	enum class TTSTextType : uint8 {
+		Normal = 0, ///< SSML tags won't be processed.
+		SSML = 128 ///< SSML tags will be processed.
+	};
+
+	UENUM(BlueprintType)
+	enum class TTSOutputFormat : uint8 {
+		PCM16 = 0, ///< Linear 16-bit PCM format.
+		PCM8 = 1 ///< Linear 8-bit PCM format.
+	};
+
+	/**
+	 * Underruns of streamed TTS playback, accumulated per speaker and voice.
+	 */
+	struct FTTSUnderrunRecord {
+		FString Speaker; ///< The name of the actor which was speaking.
+		FString EngineID; ///< The voice which was speaking.
+		int32 Count; ///< The number of times playback ran dry while synthesis was still running.
+		double Seconds; ///< The total duration of the resulting silence.
+		float PreRollSeconds; ///< The adaptive pre-roll of the speaker's stream when last reported.
+	};
+
+	class FReadSpeakerTTSModule : public IModuleInterface
+	{
+	public:
+
+		/**
+		 * Called when module loads.
+		 */
+		virtual void StartupModule() override;
+
+		/**
+		 * Called when module unloads.
+		 */
+		virtual void ShutdownModule() override;
+
+		/**
+		 * Updates the list of TTS Engines.
+		 */
+		READSPEAKERTTS_API static void GetEngines(TArray<UTTSEngine*> *EngineArr);
+
+		/**
+		 * Gets the TTS Engine with the specified name and type.
+		 * @param {FString} name The name which is queried.
+		 * @param {FString} type The type which is queried.
+		 */
+		READSPEAKERTTS_API static UTTSEngine* GetEngine(FString name, FString type);
+
+		/**
+		 * Gets the TTS Engine with the specified id.
+		 * @param {FString} id The id which is queried.
+		 * @returns {UTTSEngine*} A TTS engine with name name and type type. null if none exists.
+		 */
+		READSPEAKERTTS_API static UTTSEngine* GetEngineByID(FString id);
+
+		/**
+		 * Gets a TTS engine with a specified language.
+		 * @param {FString} lang The language which is queried.
+		 * @returns {UTTSEngine*} The TTS engine with ID id. null if none exists.
+		 */
+		READSPEAKERTTS_API static UTTSEngine* GetEngineWithLanguage(FString lang);
+
+		/**
+		 * Gets a TTS engine with a specified gender.
+		 * @param {FString} gender The gender which is queried.
+		 * @returns {UTTSEngine*} A TTS engine with language lang. null if none exists.
+		 */
+		READSPEAKERTTS_API static UTTSEngine* GetEngineWithGender(FString gender);
+
+		/**
+		 * Gets a TTS engine with a specified language and gender.
+		 * @param {FString} lang The language which is queried.
+		 * @param {FString} gender The gender which is queried.
+		 * @returns {UTTSEngine*} A TTS engine with language lang and gender gender. null if none exists.
+		 */
+		READSPEAKERTTS_API static UTTSEngine* GetEngineWithLanguageAndGender(FString lang, FString gender);
+
+		/**
+		 * Gets all of the installed TTS engines.
+		 * @returns {TArray<UTTSEngine*>} The currently installed TTS engines. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<UTTSEngine*> GetInstalledEngines();
+
+		/**
+		 * Gets the TTS engines with a specified language.
+		 * @param {FString} lang The language which is queried.
+		 * @returns {TArray<UTTSEngine*>} All TTS engines with language lang. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithLanguage(FString lang);
+
+		/**
+		 * Gets the TTS engines with a specified gender.
+		 * @param {FString} gender The gender which is queried.
+		 * @returns {TArray<UTTSEngine*>} All TTS engines with gender gender. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithGender(FString gender);
+
+		/**
+		 * Gets the TTS engines with a specified language and gender.
+		 * @param {FString} lang The language which is queried
+		 * @param {FString} gender The gender which is queried.
+		 * @returns {TArray<UTTSEngine*>} All TTS engines with language lang and gender gender. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<UTTSEngine*> GetEnginesWithLanguageAndGender(FString lang, FString gender);
+
+		/**
+		 * Gets the available languages in the currently installed TTS engines.
+		 * @returns {TArray<FString>} All available languages. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<FString> GetAvailableLanguages();
+
+		/**
+		 * Gets the available genders for a specified language.
+		 * @param {FString} lang The language which is queried.
+		 * @returns {TArray<FString>} The available genders for language lang. Empty if none.
+		 */
+		READSPEAKERTTS_API static TArray<FString> GetAvailableGendersForLanguage(FString lang);
+
+		/**
+		 * Updates configuration files based on currently installed voices.
+		 * Has to be called before a newly installed voice engine can be used.
+		 */
+		READSPEAKERTTS_API static void RefreshVoiceEngineInstallations();
+
+		/**
+		 * Initializes the text to speech system. Has to be called before any calls to associated functions.
+		 * TODO Throw exception if platform not supported
+		 * @throws not_supported The current platform is not supported.
+		 */
+		READSPEAKERTTS_API static int Init();
+
+		/**
+		 * Pauses playback of all active TTS speakers.
+		 */
+		READSPEAKERTTS_API static void PauseAll();
+
+		/**
+		 * Resumes playback of all active TTS speakers.
+		 */
+		READSPEAKERTTS_API static void ResumeAll();
+
+		/**
+		 * Interrupts playback of all active TTS speakers.
+		 */
+		READSPEAKERTTS_API static void InterruptAll();
+
+
+		/**
+		 * Takes an idle converter from the pool, creating one if none is available.
+		 * Pooled converters and their sound waves are kept rooted and reuse their buffers between utterances.
+		 * @returns {UTTSConverter*} A converter with its per-utterance state reset.
+		 */
+		READSPEAKERTTS_API static UTTSConverter* AcquireConverter();
+
+		/**
+		 * Returns a converter taken with AcquireConverter() to the pool.
+		 * @param {UTTSConverter*} converter The converter to return. No-op if null.
+		 */
+		READSPEAKERTTS_API static void ReleaseConverter(UTTSConverter* converter);
+
+		/**
+		 * Records that a TTS audio or text buffer had to grow. In steady state this should stop increasing after warmup,
+		 * apart from the name strings of SSML marks.
+		 */
+		READSPEAKERTTS_API static void CountBufferAllocation();
+
+		/**
+		 * Gets the number of buffer allocations made by the synthesis path since startup or the last reset.
+		 */
+		READSPEAKERTTS_API static int32 GetBufferAllocationCount();
+
+		/**
+		 * Resets the buffer allocation counter.
+		 */
+		READSPEAKERTTS_API static void ResetBufferAllocationCount();
+
+		/**
+		 * Broadcasts a converter's OnConversionFinished on the game thread with the next tick. Callable from any thread.
+		 * @param {UTTSConverter*} converter The converter which finished converting.
+		 */
+		static void QueueConversionFinished(UTTSConverter* converter);
+
+		/**
+		 * Adds underruns of a speaker's stream to the totals for that speaker and voice.
+		 * @param {FString} speaker The name of the actor which was speaking.
+		 * @param {FString} engineID The voice which was speaking.
+		 * @param {int32} count The number of underruns.
+		 * @param {double} seconds The duration of the silence they caused.
+		 * @param {float} preRollSeconds The current pre-roll of the stream.
+		 */
+		READSPEAKERTTS_API static void RecordUnderruns(const FString& speaker, const FString& engineID, int32 count, double seconds, float preRollSeconds);
+
+		/**
+		 * Gets the underrun totals recorded since startup or the last reset, one entry per speaker and voice.
+		 */
+		READSPEAKERTTS_API static TArray<FTTSUnderrunRecord> GetUnderrunRecords();
+
+		/**
+		 * Clears the underrun totals.
+		 */
+		READSPEAKERTTS_API static void ResetUnderrunRecords();
+
+		/**
+		 * Stores the loudness measured for an utterance of a voice at a volume, so later utterances can be
+		 * normalized before they have been measured.
+		 * @param {FString} engineID The voice which was synthesized.
+		 * @param {int32} volume The synthesis volume.
+		 * @param {int32} sampleRate The sample rate the audio was measured at.
+		 * @param {FTTSDspSettings} processing The processing applied before measuring.
+		 * @param {float} loudness The integrated loudness in LUFS.
+		 */
+		READSPEAKERTTS_API static void CacheLoudness(const FString& engineID, int32 volume, int32 sampleRate, const FTTSDspSettings& processing, float loudness);
+
+		/**
+		 * Gets the loudness last measured for a voice at a volume, sample rate and processing.
+		 * @param {FString} engineID The voice.
+		 * @param {int32} volume The synthesis volume.
+		 * @param {int32} sampleRate The sample rate of the audio.
+		 * @param {FTTSDspSettings} processing The processing applied to the audio.
+		 * @param {float&} outLoudness Receives the integrated loudness in LUFS.
+		 * @returns {bool} true if the voice has been measured with those settings.
+		 */
+		READSPEAKERTTS_API static bool GetCachedLoudness(const FString& engineID, int32 volume, int32 sampleRate, const FTTSDspSettings& processing, float& outLoudness);
+
+		/**
+		 * Registers a custom stage which speakers can add to their processing by name, see FTTSDspSettings::CustomStages.
+		 * Replaces a stage previously registered under the same name.
+		 * @param {FName} name The name the stage is listed under.
+		 * @param {FTTSDspStageFactory} factory Creates an instance of the stage for each converter using it.
+		 */
+		READSPEAKERTTS_API static void RegisterDspStage(FName name, FTTSDspStageFactory factory);
+
+		/**
+		 * Removes a custom stage. Converters which already created it keep their instance until their chain is next built.
+		 * @param {FName} name The name the stage was registered under.
+		 */
+		READSPEAKERTTS_API static void UnregisterDspStage(FName name);
+
+		/**
+		 * Gets a number which changes whenever a custom stage is registered or removed, so a chain can tell
+		 * whether building it again would create different stages.
+		 */
+		READSPEAKERTTS_API static int32 GetDspStageRegistryVersion();
+
+		/**
+		 * Creates an instance of a custom stage.
+		 * @param {FName} name The name the stage was registered under.
+		 * @returns {TUniquePtr<ITTSDspStage>} The new stage. Invalid if no stage is registered as name.
+		 */
+		READSPEAKERTTS_API static TUniquePtr<ITTSDspStage> CreateDspStage(FName name);
+
+		/**
+		 * Binds playback functions to a TTS speaker.
+		 */
+		static void BindSpeaker(UTTSSpeaker* speaker);
+
+		/**
+		 * Unbinds playback functions from a TTS speaker.
+		 */
+		static void UnbindSpeaker(UTTSSpeaker* speaker);
+
+		/**
+		* Mutex to ensure thread safety on Android.
+		*/
+		static FCriticalSection AndroidMutex;
+
+#if PLATFORM_ANDROID
+		static void RefreshVoiceEngineInstallations_Android();
+#endif
+
+	private:
+		void* VTAPILibraryHandle;
+		void* RSGameLibraryHandle;
+		static FOnPauseAll FOnPauseAllDelegate;
+		static FOnResumeAll FOnResumeAllDelegate;
+		static FOnInterruptAll FOnInterruptAllDelegate;
+		static TArray<UTTSConverter*> ConverterPool;
+		static FCriticalSection ConverterPoolMutex;
+		static FThreadSafeCounter BufferAllocationCount;
+		static TArray<UTTSConverter*> FinishedConverters; ///< Converters whose OnConversionFinished is due on the game thread.
+		static TArray<UTTSConverter*> DispatchingConverters; ///< Swapped with FinishedConverters so the delegates run unlocked.
+		static FCriticalSection FinishedConvertersMutex;
+		static bool DispatchConversionFinished(float deltaTime);
+		FTSTicker::FDelegateHandle DispatchTickerHandle;
+		static TArray<FTTSUnderrunRecord> UnderrunRecords;
+		static FCriticalSection UnderrunRecordsMutex;
+		static TMap<FName, FTTSDspStageFactory> DspStageFactories;
+		static FCriticalSection DspStageFactoriesMutex;
+		static FThreadSafeCounter DspStageRegistryVersion;
+		static TMap<TTuple<FString, int32, int32, uint32>, float> LoudnessCache; ///< Keyed by voice, volume, sample rate and the hash of the processing.
+		static FCriticalSection LoudnessCacheMutex;
+		static void ClearLastSession();
+		static void RecieveEngineCallback(void* context, char* speaker, char* type, char* language, char* gender, char* dbPath, char* version, int sampling, int channels);
+		static int LoadTTS(FString libPath, FString iniPath);
+#if WITH_EDITOR
+		TSharedRef<FSlateStyleSet> StyleSet = MakeShareable(new FSlateStyleSet("MyStyleSet"));
+#endif	
+};
+
+	UCLASS(ClassGroup = ReadSpeakerTTS, DefaultToInstanced)
+	class READSPEAKERTTS_API USoundWaveProceduralTTS : public USoundWaveProcedural
+	{
+		GENERATED_BODY()
+	public:
+
+		USoundWaveProceduralTTS(const FObjectInitializer& ObjectInitializer);
+		
+		int TTSSampleRate; ///< The sample rate of the produced TTS audio.
+		int TTSBitDepth; ///<  The bit depth of the produced TTS audio.
+		double Length; ///< The length in seconds of the current audiodata.
+		TArray<int16> TTSData; ///< The buffer which is read from when the audio renderer requests data.
+
+		/**
+		 * Sets the data this soundwave will contain, without copying it.
+		 * The previously held buffer is handed back in data, emptied, so that it can be reused for the next utterance.
+		 * @param data The audio data.
+		 */
+		void SetAudioData(TArray<int16>& data);
+
+		/**
+		 * Rewinds playback to the start of TTSData.
+		 * @param SamplesRequired Unused, audio is now pulled by the renderer in OnGeneratePCMAudio.
+		 */
+		void FillAudioQueue(int32 SamplesRequired);
+
+		/**
+		 * Sets the sample rate of this SoundWave
+		 * @param Sampling the sampling rate to set
+		 */
+		void SetSampleRate(int32 Sampling);
+
+		/**
+		 * Gets the number of frames of TTSData the audio renderer has consumed, published from the render thread.
+		 * Unlike a clock advanced by the game thread this stops while playback is paused or starved.
+		 */
+		int32 GetPlayedFrames() const;
+
+		/**
+		 * Gets the number of frames in TTSData.
+		 */
+		int32 GetNumFrames() const;
+
+	protected:
+		virtual int32 OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) override;
+
+	private:
+		double CalculateAudioDuration();
+		FThreadSafeCounter ReadCursor; ///< The index into TTSData of the next sample to be rendered.
+		FCriticalSection DataMutex; ///< Held by the render thread while it reads TTSData, and by SetAudioData() while it swaps it.
+	};
+
+	/**
+	 * Represents a voice engine.
+	 */
+	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent))
+		class READSPEAKERTTS_API UTTSEngine : public UObject {
+		GENERATED_BODY()
+		private:
+			int32 ReferenceCount;
+			bool KeepInMemory;
+
+			bool UseLicenseFile();
+			FString GetLicensePath();
+			TArray<ANSICHAR> LicensePathAnsi; ///< Null terminated copy of GetLicensePath(), converted once instead of per acquire.
+			bool IsLicensed();
+
+			friend class UTTSConverter;
+		        int Acquire();
+		        int Release();
+		        FCriticalSection EngineMutex;
+		public:
+			FString ID; ///< The ID of the engine.
+			FString Name; ///< The name of the engine.
+			FString Type; ///< The type of the engine.
+			FString Language; ///< The language of the engine.
+			FString Gender; ///< The gender of the engine.
+			FString Version; ///< The voice engine version.
+			int Sampling; ///< The samplerate of the voice engine.
+			int Channels; ///< The number of channels of the voice engine.
+			TArray<ANSICHAR> NameUTF8; ///< Null terminated UTF-8 copy of Name, handed to RSGame without re-encoding.
+			TArray<ANSICHAR> TypeUTF8; ///< Null terminated UTF-8 copy of Type, handed to RSGame without re-encoding.
+
+			/**
+			 * Constructor
+			 */
+			UTTSEngine(const FObjectInitializer& ObjectInitializer);
+
+			/**
+			 * Loads this engine into memory. No-op if already loaded.
+			 */
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "LoadEngine"))
+				int LoadEngine();
+
+			/**
+			 * Unloads the engine from memory. No-op if not loaded.
+			 */
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "UnloadEngine"))
+				int UnloadEngine();
+
+			/**
+			 * Gets the ID of this engine.
+			 */
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Engine", meta = (Keywords = "GetID"))
+				FString GetID();
+	};
+
+	/**
+	 * Blueprint wrapper for accessing static module functions.
+	 */
+	UCLASS(ClassGroup = ReadSpeakerTTS)
+		class READSPEAKERTTS_API UTTSObject : public UObject
+	{
+		GENERATED_BODY()
+	public:
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "Init"))
+			static void Init();
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "FindEngine"))
+			static UTTSEngine* FindEngine(FString name, FString type);
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "PauseAll"))
+			static void PauseAll();
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "ResumeAll"))
+			static void ResumeAll();
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Global", meta = (Keywords = "InterruptAll"))
+			static void InterruptAll();
+	};
+
+	/**
+	 * Encapsulates the text-to-speech conversion process.
+	 */
+	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent), DefaultToInstanced)
+		class READSPEAKERTTS_API UTTSConverter : public UObject {
+		GENERATED_BODY()
+		public:
+
+			UPROPERTY(Transient)
+			UTTSEngine* Engine; ///< The voice engine to be used in synthesis.
+			
+			UPROPERTY(Transient)
+			USoundWaveProceduralTTS* SoundWave; ///< Reference to the soundwave which the audio is output to.
+
+			UPROPERTY(Transient)
+			UAudioComponent* AudioComponent; ///< The audio component which should play the audio.
+
+			UPROPERTY(Transient)
+			UQuartzClockHandle* QuartzClock; ///< If set, Play() starts the audio on QuantizationBoundary of this clock instead of immediately.
+
+			FQuartzQuantizationBoundary QuantizationBoundary; ///< The boundary of QuartzClock on which Play() starts the audio.
+
+			FString Text; ///< The text to be converted.
+			int32 Volume; ///< The volume to be used in synthesis.
+			int32 Pitch; ///< The pitch to be used in synthesis.
+			int32 Speed; ///< The speed to be used in synthesis.
+			int32 Pause; ///< The time in milliseconds to pause when encountering a delimiter in synthesis.
+			int32 CommaPause; ///< The time in millieseconds to pause when encountering a ',' in synthesis.
+			TTSTextType TextType; ///< Determines how the text should be processed in synthesis.
+			TTSOutputFormat OutputFormat; ///< Gets or sets the format of the audio output.
+			FSoundAttenuationSettings *SoundAttenuationSettings;  ///< The sound attenuation to use during playback.
+			bool bApplyVolumeAsGain; ///< true to synthesize at volume 100 and apply a Volume below it while converting the samples, false to let RSGame apply it. Assumes RSGame's volume is linear with 100 as unity.
+			int32 OutputSampleRate; ///< The sample rate the converted audio is resampled to. 0 keeps the sample rate of the engine.
+			int32 PageLength; ///< The maximum number of characters synthesized at a time when converting to a stream. 0 synthesizes the whole text at once.
+			bool bTrimSilence; ///< true to trim the silence RSGame produces before and after speech down to SilencePadding.
+			float SilenceThreshold; ///< The normalized amplitude at or below which a sample counts as silence when trimming.
+			float SilencePadding; ///< The seconds of silence kept before and after speech when trimming.
+			ETTSResamplerQuality ResamplerQuality; ///< The filter quality used when resampling.
+			FTTSDspChain DspChain; ///< The processing applied to each chunk of audio on the synthesis thread, see FTTSDspChain::Build().
+			bool bNormalizeLoudness; ///< true to have Play() set the volume of SoundWave so the audio plays at TargetLoudness.
+			float StreamGain; ///< The gain applied to the audio written to a stream, so normalizing it leaves other utterances on the stream alone.
+			float TargetLoudness; ///< The integrated loudness in LUFS audio is normalized to.
+			float IntegratedLoudness; ///< The integrated loudness in LUFS of the last conversion, measured as it was synthesized. Valid once FinishedConverting is true.
+			bool FinishedConverting; ///<  true if conversion has both been started and finished, false otherwise.
+			FTTSEventTimeline Timeline; ///< The word, viseme and mark events of the current conversion, for dispatch at playback time.
+
+			UTTSConverter(const FObjectInitializer& ObjectInitializer);
+
+			/**
+			 * Converts text to speech using the current handle values and stores the result in an audio buffer.
+			 * \code
+			 void SayHello(){
+				 FReadSpeakerTTSModule::Init();
+				 UTTSEngine *Engine = FReadSpeakerTTSModule::GetEngine("ashley", "d16");
+				 UTTSConverter converter;
+				 converter.Text = "Hello";
+				 converter.Engine = Engine;
+				 converter.Volume = 225;
+				 converter.Pitch = 125;
+				 converter.Speed = 125;
+				 converter.Pause = 0;
+				 converter.CommaPause = 0;
+				 converter.EmphasisFactor = 0;
+				 converter.ConvertToBuffer();
+				 TArray<int16> result = converter.GetAudioData();
+			 }
+			 * \endcode
+			 * Will result in the array result being filled with linear PCM data obtained from synthesizing the text
+			 * "Hello" using the specified handle values.
+			 */
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBuffer"))
+			void ConvertToBuffer();
+
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBuffer_SyncInfo"))
+			void ConvertToBuffer_SyncInfo();
+			
+			/**
+			 * Converts text to speech using the current handle values and stores the result in an audio buffer.
+			 * \code
+			 void SayHello(){
+				 FReadSpeakerTTSModule::Init();
+				 UTTSEngine *Engine = FReadSpeakerTTSModule::GetEngine("ashley", "d16");
+				 UTTSConverter converter;
+				 converter.Text = "Hello";
+				 converter.Engine = Engine;
+				 converter.Volume = 225;
+				 converter.Pitch = 125;
+				 converter.Speed = 125;
+				 converter.Pause = 0;
+				 converter.CommaPause = 0;
+				 converter.EmphasisFactor = 0;
+				 converter.ConvertToBufferAsync();
+			 }
+			 * \endcode
+			 * Will begin synthesizing the text "Hello" using the specified handle values. The resulting linear PCM
+			 * data can be fetched with GetAudioData() once FinishedConverting() returns true.
+			 */
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBufferAsync"))
+			void ConvertToBufferAsync();
+
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "ConvertToBufferAsync_SyncInfo"))
+			void ConvertToBufferAsync_SyncInfo();
+
+			/**
+			 * Converts text to speech on a background thread and writes the audio to a stream as it is synthesized,
+			 * instead of storing it in the audio buffer. Playback can start as soon as the first chunk arrives.
+			 * @param {TSharedRef<FTTSAudioStream>} InStream The stream the audio is written to.
+			 * @param {bool} SyncInfo Whether word, viseme and mark events should be reported.
+			 */
+			void ConvertToStreamAsync(TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> InStream, bool SyncInfo);
+
+			/**
+			 * Gets the audio data that has been converted by ConverToBuffer() or ConvertToBufferAsync().
+			 * @returns The audio data which has been converted. The complete data set if FinishedConverting() returns true, an incomplete data set otherwise.
+			 */
+			TArray<int16> GetAudioData();
+
+			/**
+			 * Moves the converted audio data out of this converter without copying it.
+			 * The buffer previously held by OutData is kept by the converter and reused for the next conversion.
+			 * @param OutData Receives the converted audio data. Left empty if conversion has not finished.
+			 */
+			void TakeAudioData(TArray<int16>& OutData);
+
+			void ClearAudioData();
+
+			/**
+			 * Gets the sample rate of the audio this converter produces.
+			 * @returns OutputSampleRate if set, the sample rate of the engine otherwise.
+			 */
+			int32 GetOutputSampleRate() const;
+
+			/**
+			 * Gets how far playback of the converted audio has progressed, from the frames consumed by the audio
+			 * render thread on either the sound wave or the stream.
+			 * @returns The number of seconds of this conversion played so far.
+			 */
+			double GetPlaybackTime();
+
+			/**
+			 * Checks whether all the audio this converter wrote to its stream has been played, or was cancelled.
+			 */
+			bool HasStreamPlayed() const;
+
+			/**
+			 * Gets the volume multiplier which plays the last conversion at TargetLoudness.
+			 * @returns The linear gain, 1 if bNormalizeLoudness is false or the audio was silent.
+			 */
+			float GetLoudnessGain() const;
+
+			/**
+			 * Resets the per-utterance state of this converter so it can be reused, keeping its buffers allocated.
+			 */
+			void ResetForReuse();
+
+			/**
+			 * Checks whether a background conversion started by this converter is still running.
+			 */
+			bool IsConverting();
+
+			/**
+			 * Checks whether SoundWave is still the sound of a playing audio component, in which case the render
+			 * thread may still read it and the converter must not be reused.
+			 */
+			bool IsPlaying() const;
+
+			/**
+			 * Plays the audio produced by this converter on the given AudioComponent using the given SoundAttenuationSettings.
+			*/
+			UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Converter", meta = (Keywords = "PlayAudioFromConverter"))
+			void Play();
+
+			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
+			FOnConversionFinished OnConversionFinished;
+
+			/**
+			 * Invoked on the game thread once a quantized start on QuartzClock has started playing,
+			 * with the run time in seconds of QuartzClock at the boundary it started on.
+			 */
+			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
+			FOnScheduledStartEvent OnScheduledStart;
+
+			/**
+			 * Invoked from the synthesis thread as words are synthesized, ahead of playback.
+			 * Use the events of UTTSSpeaker to follow what is being heard.
+			 */
+			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
+			FOnWordEvent OnWord;
+
+			/**
+			 * Invoked from the synthesis thread as visemes are synthesized, ahead of playback.
+			 */
+			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
+			FOnVisemeEvent OnViseme;
+
+			/**
+			 * Invoked from the synthesis thread as marks are synthesized, ahead of playback.
+			 */
+			UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Converter")
+			FOnMarkEvent OnMark;
+
+		private:
+			class FTTSSynthesizeTask : public FNonAbandonableTask {
+			public:
+				FTTSSynthesizeTask(TWeakObjectPtr<UTTSConverter> Converter, bool SyncInfo) {
+					this->Converter = Converter;
+					this->SyncInfo = SyncInfo;
+				}
+
+				void SetSyncInfo(bool InSyncInfo) {
+					SyncInfo = InSyncInfo;
+				}
+
+				FORCEINLINE TStatId GetStatId() const
+				{
+					RETURN_QUICK_DECLARE_CYCLE_STAT(FTTSSynthesizeTask, STATGROUP_ThreadPoolAsyncTasks);
+				}
+
+				void DoWork() {
+					{
+						// Utterances sharing a stream are written one after another, a cancelled one isn't synthesized.
+						if (!Converter->Stream.IsValid() || Converter->BeginStreamWriting()) {
+							if (Converter->IsPaged()) {
+								Converter->ConvertPages(SyncInfo);
+							}
+							else {
+								Converter->ConvertLocked(SyncInfo);
+							}
+						}
+						if (Converter->Stream.IsValid()) {
+							Converter->EndStreamWriting();
+						}
+					}
+				}
+
+			private:
+				TWeakObjectPtr<UTTSConverter> Converter;
+				bool SyncInfo;
+			};
+
+			TArray<int16> AudioData;
+			TArray<ANSICHAR> TextUTF8; ///< Reused buffer holding Text encoded as null terminated UTF-8.
+			float ConversionGain; ///< The gain applied to the samples of the current conversion.
+			TTSOutputFormat SynthesisFormat; ///< The format RSGame delivers the audio of the current conversion in, OutputFormat unless the platform overrides it.
+			FTTSResampler Resampler; ///< Converts from the engine rate to OutputSampleRate, keeping filter state across callbacks.
+			TArray<float> ResampleInput; ///< Reused buffer of float samples fed to the resampler.
+			TArray<float> ResampleOutput; ///< Reused buffer of resampled float samples.
+			FAsyncTask<FTTSSynthesizeTask>* Task;
+			bool bPooled; ///< true if this converter is owned by the module pool and must stay rooted.
+
+			TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> Stream; ///< The stream audio is written to instead of AudioData, if set.
+			uint32 StreamUtteranceId; ///< The utterance this converter writes to Stream.
+			std::atomic<int64> StreamStartSample{ INDEX_NONE }; ///< The sample count of Stream at which this utterance starts playing, INDEX_NONE until it gets to write.
+			std::atomic<int64> StreamEndSample{ INDEX_NONE }; ///< The sample count of Stream at which this utterance stops playing, INDEX_NONE until it has been written.
+			FTTSLoudnessMeter LoudnessMeter; ///< Measures the audio of the current conversion as it is produced.
+			TArray<float> StreamScratch; ///< Reused buffer for converting callback audio to float before writing it to Stream or running DspChain.
+			TArray<float> StreamBacklog; ///< Audio synthesized while holding the engine which did not fit in Stream, written once the engine is released.
+
+			struct FTextPage {
+				int32 Start; ///< The index in Text of the first character of the page.
+				int32 Len; ///< The number of characters in the page.
+			};
+			TArray<FTextPage> Pages; ///< The pages Text is split into when converting in pages.
+			int32 CurrentPage; ///< The index in Pages being synthesized, INDEX_NONE when not converting in pages.
+			float PageTimeOffset; ///< The playback time at which the current page starts, added to its event timestamps.
+
+			double ScheduledStartTime; ///< The QuartzClock run time of the boundary a quantized start played on, negative until it has started.
+			FOnQuartzCommandEventBP QuartzCommandEvent; ///< Bound from Play() until a quantized start has started or failed.
+
+			int32 ConversionStart; ///< The index in AudioData where the current conversion starts.
+			bool bFoundAudio; ///< true once the current conversion has produced a sample above SilenceThreshold.
+			float LeadingTrimSeconds; ///< The silence trimmed from the start of the current conversion, subtracted from its event timestamps.
+			int32 DroppedLeadingSamples; ///< The samples of leading silence dropped from the stream so far.
+			TArray<float> HeldSilence; ///< Silence held back from the stream until it is known whether it is leading, trailing or a pause.
+
+			static void audio_callback(void* context, char* data, int* length);
+			static void word_callback(void* context, int* startPos, int* endPos, float* time, int* length);
+			static void viseme_callback(void* context, short* visemeId, float* time, int* length);
+			static void mark_callback(void* context, char* markName, float* time, int* length);
+			void RecieveAudioCallback(char* data, int* length);
+			template<typename DstType>
+			bool ConvertSamples(const char* data, int32 SrcChannels, DstType* Dst, int32 DstChannels, int32 NumFrames);
+			void RecieveWordCallback(int* startPos, int* endPos, float* time, int* length);
+			void RecieveVisemeCallback(short* visemeId, float* time, int* length);
+			void RecieveMarkCallback(char* markName, float* time, int* length);
+			void StartTask(bool SyncInfo);
+			void ConvertLocked(bool SyncInfo);
+			bool IsPaged() const;
+			void ConvertPages(bool SyncInfo);
+			void NotifyConversionFinished();
+			void SplitIntoPages();
+			FStringView GetSynthesisText() const;
+			int32 GetSynthesisVolume();
+			void BeginConversion();
+			void EndConversion();
+			void EmitResampled();
+			void AppendAudioData(const float* Samples, int32 NumSamples);
+			void WriteStream(const float* Samples, int32 NumSamples);
+			void ApplyStreamGain(float* Samples, int32 NumSamples);
+			void PushStream(const float* Samples, int32 NumSamples);
+			void DrainStreamBacklog();
+			bool BeginStreamWriting();
+			void EndStreamWriting();
+			void HoldSilence(const float* Samples, int32 NumSamples, int32 MaxHeld);
+			void TrimBufferedSilence();
+			void TrimLeadingSilence(int32 NumFrames);
+			int32 GetSilencePaddingFrames() const;
+			float GetEventTime(float SynthesisTime) const;
+			const char* GetTextUTF8();
+			UFUNCTION()
+			void OnQuartzCommandEvent(EQuartzCommandDelegateSubType EventType, FName Name);
+			double GetQuantizedStartTime(UWorld* World) const;
+			void BeginDestroy() override;
+
+			friend class FReadSpeakerTTSModule;
+	};
+
+	/**
+	 * An Actor Component which enables an Actor to speak using TTS.
+	 */
+	UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent), DefaultToInstanced)
+		class READSPEAKERTTS_API UTTSSpeaker : public UActorComponent
+	{
+		GENERATED_BODY()
+	public:
+
+		UTTSSpeaker(const FObjectInitializer& ObjectInitializer);
+
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics)
+			FString EngineID; ///< The ID of the currently set voice engine.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "500", UIMin = "0", UIMax = "500"))
+			int32 Volume; ///< The volume this speaker should use during synthesis.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "50", ClampMax = "200", UIMin = "50", UIMax = "200"))
+			int32 Pitch; ///< The pitch this speaker should use during synthesis.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "50", ClampMax = "400", UIMin = "50", UIMax = "400"))
+			int32 Speed; ///< The speed this speaker should use during synthesis.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "65535", UIMin = "0", UIMax = "65535"))
+			int32 Pause; ///< The time in milliseconds which this speaker should pause when encountering a delimiter during synthesis.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics, meta = (ClampMin = "0", ClampMax = "65535", UIMin = "0", UIMax = "65535"))
+			int32 CommaPause; ///< The time in milliseconds which this speaker should pause when encountering a ',' during synthesis.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics)
+			TTSOutputFormat OutputFormat = TTSOutputFormat::PCM16; ///< The format RSGame synthesizes in. PCM8 halves what RSGame writes and is widened to 16 bits while converting, at the cost of precision.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Characteristics)
+			bool bApplyVolumeAsGain = false; ///< Whether a Volume below 100 is applied while converting the samples rather than by RSGame. Assumes RSGame's volume is linear with 100 as unity.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Attenuation)
+			FSoundAttenuationSettings SoundAttenuation; ///< The sound attenuation settings to be used by this speaker.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (ClampMin = "50", ClampMax = "10000", UIMin = "50", UIMax = "10000"))
+			int32 DocumentPageLength = 500; ///< The maximum number of characters synthesized at a time by ReadDocument.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback)
+			bool bTrimSilence = false; ///< Whether the silence before and after each utterance is trimmed down to SilencePadding, so speech starts sooner. Changes the timing of existing audio.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback, meta = (ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "0.1"))
+			float SilenceThreshold = 0.002f; ///< The normalized amplitude at or below which audio counts as silence.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Playback, meta = (ClampMin = "0.0", ClampMax = "2.0", UIMin = "0.0", UIMax = "2.0"))
+			float SilencePadding = 0.05f; ///< The seconds of silence kept before and after speech when trimming.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+			FTTSDspSettings Processing; ///< The processing applied to this speaker's audio once at synthesis time.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+			bool bNormalizeLoudness = false; ///< Whether playback volume is set so every voice and Volume setting plays at TargetLoudness.
+		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "-40.0", ClampMax = "0.0", UIMin = "-36.0", UIMax = "-10.0", EditCondition = "bNormalizeLoudness"))
+			float TargetLoudness = -18.0f; ///< The integrated loudness in LUFS utterances are played at.
+
+		/**
+		* Delegate which is invoked when this speaker starts speaking.
+		*/
+		FOnSpeakingStarted OnSpeakingStarted;
+
+		/**
+		* Delegate which is invoked when this speaker finishes speaking.
+		*/
+		FOnSpeakingFinished OnSpeakingFinished;
+
+		/**
+		 * Invoked on the game thread when a word starts playing.
+		 */
+		UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Speaker")
+		FOnWordEvent OnWord;
+
+		/**
+		 * Invoked on the game thread when a viseme starts playing.
+		 */
+		UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Speaker")
+		FOnVisemeEvent OnViseme;
+
+		/**
+		 * Invoked on the game thread when playback reaches a mark.
+		 */
+		UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Speaker")
+		FOnMarkEvent OnMark;
+
+		/**
+		 * Invoked on the game thread when an utterance started with SayQuantized() starts playing on its
+		 * boundary, with the run time in seconds of the Quartz clock at that boundary. Word, viseme and mark
+		 * events are dispatched relative to this time, counted on the clock.
+		 */
+		UPROPERTY(BlueprintAssignable, Category = "ReadSpeaker|Speaker")
+		FOnScheduledStartEvent OnScheduledStart;
+
+		/**
+		 * Previews how this speaker sounds in the Editor. No-op if not in Editor.
+		 */
+		void Preview();
+
+		/**
+		 * Sets the Audio Component used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetAudioComponent", DefaultToSelf))
+		void SetAudioComponent(UAudioComponent* AudioComponent);
+
+		/**
+		 * Gets the Audio Component used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetAudioComponent", DefaultToSelf))
+		UAudioComponent* GetAudioComponent();
+
+		/**
+		 * Sets the Synth Component used by the Speaker for streaming playback.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetSynthComponent", DefaultToSelf))
+		void SetSynthComponent(UTTSSynthComponent* SynthComponent);
+
+		/**
+		 * Gets the Synth Component used by the Speaker for streaming playback.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetSynthComponent", DefaultToSelf))
+		UTTSSynthComponent* GetSynthComponent();
+
+		/**
+		* Blueprint wrapper function to get the current viseme ID of this speaker.
+		*/
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetCurrentViseme", DefaultToSelf))
+		int GetCurrentViseme();
+
+		/**
+		 * Sets the Voluume used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetVolume", DefaultToSelf))
+		void SetVolume(int NewVolume);
+
+		/**
+		 * Gets the Volume used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetVolume", DefaultToSelf))
+		int GetVolume();
+
+		/**
+		 * Sets the Pitch used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetPitch", DefaultToSelf))
+		void SetPitch(int NewPitch);
+		
+		/**
+		 * Gets the Pitch used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetPitch", DefaultToSelf))
+		int GetPitch();
+
+		/**
+		 * Sets the Speed used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetSpeed", DefaultToSelf))
+		void SetSpeed(int NewSpeed);
+
+		/**
+		 * Gets the Speed used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetSpeed", DefaultToSelf))
+		int GetSpeed();
+
+		/**
+		 * Sets the Pause time in ms used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetPause", DefaultToSelf))
+		void SetPause(int NewPause);
+		
+		/**
+		 * Gets the Pause time in ms used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetPause", DefaultToSelf))
+		int GetPause();
+
+		/**
+		 * Sets the CommaPause time in ms used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetCommaPause", DefaultToSelf))
+		void SetCommaPause(int NewCommaPause);
+
+		/**
+		 * Gets the CommaPause time in ms used by the Speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetCommaPause", DefaultToSelf))
+		int GetCommaPause();
+
+		/**
+		 * Sets the engine to be used by this speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SetEngine", DefaultToSelf))
+		void SetEngine(UTTSEngine* Engine);
+
+		/**
+		 * Gets the Engine currently used by this speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "GetEngine", DefaultToSelf))
+		UTTSEngine* GetEngine();
+
+		/**
+		 * Checks whether this speaker is currently speaking.
+		 * @returns true if this speaker is currently speaking, false otherwise.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "IsSpeaking", DefaultToSelf))
+		bool IsSpeaking();
+
+		/**
+		 * Reads a text aloud using the settings of this speaker.
+		 * @param {UAudioComponent*} AudioComponent The audio component which should play the resulting speech.
+		 * @param {FString} text The text to be read.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "Say", DefaultToSelf))
+		void Say(FString text = "", TTSTextType textType = TTSTextType::Normal);
+
+		/**
+		 * Reads a text aloud using the settings of this speaker. Conversion happens asynchronously and plays
+		 * the result upon completion.
+		 * @param {UAudioComponent*} AudioComponent The audio component which should play the resulting speech.
+		 * @param {FString} text The text to be read.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SayAsync", DefaultToSelf))
+		void SayAsync(FString text = "", TTSTextType textType = TTSTextType::Normal);
+
+		/**
+		 * Reads a text aloud like SayAsync(), but starts playback on a boundary of a Quartz clock once conversion
+		 * is done, so the first sample lands at a known time. OnScheduledStart reports that time.
+		 * @param {FString} text The text to be read.
+		 * @param {UQuartzClockHandle*} clock The clock to start on.
+		 * @param {FQuartzQuantizationBoundary} boundary The boundary of the clock to start on.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SayQuantized", DefaultToSelf))
+		void SayQuantized(UQuartzClockHandle* clock, FQuartzQuantizationBoundary boundary, FString text = "", TTSTextType textType = TTSTextType::Normal);
+
+		/**
+		 * Reads a text aloud using the settings of this speaker through the Synth Component. Playback starts with
+		 * the first synthesized chunk instead of waiting for the whole text to be converted.
+		 * @param {FString} text The text to be read.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "SayStreaming", DefaultToSelf))
+		void SayStreaming(FString text = "", TTSTextType textType = TTSTextType::Normal);
+
+		/**
+		 * Reads a long text aloud through the Synth Component with bounded memory use. The text is synthesized a
+		 * page of DocumentPageLength characters at a time, and synthesis pauses whenever the synth component's
+		 * buffer reaches its high watermark, so memory use does not depend on the length of the text.
+		 * SSML text is synthesized as a single page.
+		 * @param {FString} text The text to be read.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "ReadDocument", DefaultToSelf))
+		void ReadDocument(FString text = "", TTSTextType textType = TTSTextType::Normal);
+
+		/**
+		 * Pauses playback of this speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "PauseSpeaking", DefaultToSelf))
+		void PauseSpeaking();
+
+		/**
+		 * Resumes playback of this speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "ResumeSpeaking", DefaultToSelf))
+		void ResumeSpeaking();
+
+		/**
+		 * Interrupts playback of this speaker.
+		 */
+		UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Speaker", meta = (Keywords = "InterruptSpeaking", DefaultToSelf))
+		void InterruptSpeaking();
+
+		/**
+		 * Called when Speaking the current query is finished. Do not call manually.
+		 */
+		UFUNCTION()
+		void FinishedSpeaking();
+		
+		/**
+		* Called when Speaking the current query is started. Do not call manually.
+		*/
+		UFUNCTION()
+		void StartedSpeaking();
+
+	private:
+		UPROPERTY(Transient)
+		UTTSEngine* Engine;
+
+		UPROPERTY(Transient)
+		UTTSConverter* Converter;
+
+		UPROPERTY(Transient)
+		TArray<UTTSConverter*> PlayingConverters; ///< Streamed utterances queued ahead of Converter, kept until heard so their events are still dispatched.
+
+		UPROPERTY(Transient)
+		UAudioComponent* ThisAudioComponent;
+
+		UPROPERTY(Transient)
+		UTTSSynthComponent* ThisSynthComponent;
+
+		bool bIsStreaming;
+		int CurrentVisemeID;
+		FTTSDueEvents DueEvents; ///< Reused buffer for the events dispatched each tick.
+		int32 GetDeviceSampleRate();
+		void DispatchEvents(UTTSConverter* Source, double PlaybackTime);
+		void DispatchPlayingConverters(bool bFinished);
+		void StartStreaming(FString text, TTSTextType textType, int32 PageLength);
+		void StartAsync(FString text, TTSTextType textType, UQuartzClockHandle* clock, const FQuartzQuantizationBoundary& boundary);
+		UFUNCTION()
+		void ScheduledStart(float startTime);
+		void ReportUnderruns();
+		void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+		void BeginPlay() override;
+		void BeginDestroy() override;
+	};
+
+#if WITH_EDITOR
+	class FTTSSpeakerCustomization : public IDetailCustomization {
+	public:
+		virtual void CustomizeDetails(IDetailLayoutBuilder& DetailBuilder) override;
+		static TSharedRef<IDetailCustomization> MakeInstance();
+	};
+
+	DECLARE_DELEGATE(OnValueChangedDelegate);
+
+	/** Delegate that is executed when the check box state changes */
+	DECLARE_DELEGATE(FOnStateChanged);
+
+	class STTSVoiceCombo : public SCompoundWidget
+	{
+	public:
+		SLATE_BEGIN_ARGS(STTSVoiceCombo) 
+			: _SpeechCharacteristics()
+			, _OnStateChanged()
+		{
+		}
+
+		SLATE_ARGUMENT(TWeakObjectPtr<class UTTSSpeaker>, SpeechCharacteristics);
+
+		/** Called when the checked state has changed */
+		SLATE_EVENT(FOnStateChanged, OnStateChanged)
+
+		SLATE_END_ARGS()
+
+		typedef TSharedPtr<FString> FComboItemType;
+		void Construct(const FArguments& InArgs);
+		TSharedRef<SWidget> MakeWidgetForOption(FComboItemType InOption);
+		void OnSelectionChanged(FComboItemType NewValue, ESelectInfo::Type);
+		FText GetCurrentItemLabel() const;
+
+		FComboItemType CurrentItem;
+		TArray<FComboItemType> Options;
+		TWeakObjectPtr<class UTTSSpeaker> SpeechCharacteristics;
+		/** Delegate called when the check box changes state */
+		FOnStateChanged OnStateChanged;
+	};
+#undef LOCTEXT_NAMESPACE
+#endif
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Single-producer/single-consumer lock-free ring buffer of audio samples.
+ * Only the producer advances the write index and only the consumer advances the read index,
+ * so pushing from the RSGame callback and popping from the audio render thread never takes a lock.
+ * The capacity is rounded up to a power of two and allocated once in Reset().
+ */
+template<typename SampleType>
+class TTTSAudioRingBuffer
+{
+public:
+	explicit TTTSAudioRingBuffer(int32 InCapacity = 0)
+	{
+		Reset(InCapacity);
+	}
+
+	/**
+	 * Reallocates the buffer and discards its contents. Not thread safe, only call while neither side is active.
+	 * @param InCapacity The minimum number of samples the buffer should hold.
+	 */
+	void Reset(int32 InCapacity)
+	{
+		const uint32 RoundedCapacity = InCapacity > 0 ? FMath::RoundUpToPowerOfTwo((uint32)InCapacity) : 0;
+		Buffer.SetNumZeroed(RoundedCapacity);
+		Mask = RoundedCapacity > 0 ? RoundedCapacity - 1 : 0;
+		ReadIndex.store(0, std::memory_order_relaxed);
+		WriteIndex.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Copies samples into the buffer. Producer side only.
+	 * @returns The number of samples written, less than Num if the buffer is full.
+	 */
+	int32 Push(const SampleType* Data, int32 Num)
+	{
+		const uint32 Write = WriteIndex.load(std::memory_order_relaxed);
+		const uint32 Read = ReadIndex.load(std::memory_order_acquire);
+		const int32 ToWrite = FMath::Min(Num, (int32)(Buffer.Num() - (Write - Read)));
+		if (ToWrite <= 0)
+		{
+			return 0;
+		}
+
+		const uint32 Start = Write & Mask;
+		const int32 FirstPart = FMath::Min(ToWrite, (int32)(Buffer.Num() - Start));
+		FMemory::Memcpy(Buffer.GetData() + Start, Data, FirstPart * sizeof(SampleType));
+		FMemory::Memcpy(Buffer.GetData(), Data + FirstPart, (ToWrite - FirstPart) * sizeof(SampleType));
+
+		WriteIndex.store(Write + ToWrite, std::memory_order_release);
+		return ToWrite;
+	}
+
+	/**
+	 * Copies samples out of the buffer. Consumer side only.
+	 * @returns The number of samples read, less than Num if the buffer ran dry.
+	 */
+	int32 Pop(SampleType* Data, int32 Num)
+	{
+		const uint32 Read = ReadIndex.load(std::memory_order_relaxed);
+		const uint32 Write = WriteIndex.load(std::memory_order_acquire);
+		const int32 ToRead = FMath::Min(Num, (int32)(Write - Read));
+		if (ToRead <= 0)
+		{
+			return 0;
+		}
+
+		const uint32 Start = Read & Mask;
+		const int32 FirstPart = FMath::Min(ToRead, (int32)(Buffer.Num() - Start));
+		FMemory::Memcpy(Data, Buffer.GetData() + Start, FirstPart * sizeof(SampleType));
+		FMemory::Memcpy(Data + FirstPart, Buffer.GetData(), (ToRead - FirstPart) * sizeof(SampleType));
+
+		ReadIndex.store(Read + ToRead, std::memory_order_release);
+		return ToRead;
+	}
+
+	/**
+	 * Drops everything currently in the buffer. Consumer side only.
+	 * @returns The number of samples dropped.
+	 */
+	int32 Discard()
+	{
+		const uint32 Read = ReadIndex.load(std::memory_order_relaxed);
+		const uint32 Write = WriteIndex.load(std::memory_order_acquire);
+		ReadIndex.store(Write, std::memory_order_release);
+		return (int32)(Write - Read);
+	}
+
+	/** @returns The number of samples that can currently be popped. */
+	int32 NumAvailable() const
+	{
+		return (int32)(WriteIndex.load(std::memory_order_acquire) - ReadIndex.load(std::memory_order_acquire));
+	}
+
+	/** @returns The number of samples that can currently be pushed. */
+	int32 NumFree() const
+	{
+		return Buffer.Num() - NumAvailable();
+	}
+
+	/** @returns The total number of samples the buffer holds. */
+	int32 Capacity() const
+	{
+		return Buffer.Num();
+	}
+
+private:
+	TArray<SampleType> Buffer;
+	uint32 Mask = 0;
+
+	// Kept on separate cache lines so the producer and consumer cores don't bounce a shared line.
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> ReadIndex{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> WriteIndex{ 0 };
+};
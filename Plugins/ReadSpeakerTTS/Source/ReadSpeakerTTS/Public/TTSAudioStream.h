@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TTSAudioRingBuffer.h"
+#include <atomic>
+
+/**
+ * Audio handed from a TTS synthesis task straight to the audio render thread.
+ * The synthesis task writes float samples as RSGame delivers them and the render thread pulls them
+ * through the sound generator of a UTTSSynthComponent, so the game thread is never involved in between.
+ */
+class READSPEAKERTTS_API FTTSAudioStream
+{
+public:
+	/**
+	 * @param InCapacitySamples The number of samples the stream can buffer ahead of playback.
+	 * @param InSampleRate The sample rate of the audio written to the stream.
+	 * @param InNumChannels The number of interleaved channels of the audio written to the stream.
+	 */
+	FTTSAudioStream(int32 InCapacitySamples, int32 InSampleRate, int32 InNumChannels);
+
+	/**
+	 * Sets the buffer levels between which the producer is throttled. Once the buffered audio reaches the high
+	 * watermark Write() waits until playback has drained it to the low watermark, so a producer which is much
+	 * faster than real time wakes up once per refill instead of once per callback.
+	 * @param InHighWatermark The number of buffered samples at which writing pauses. 0 writes whenever there is room.
+	 * @param InLowWatermark The number of buffered samples at which writing resumes.
+	 */
+	void SetWatermarks(int32 InHighWatermark, int32 InLowWatermark);
+
+	/**
+	 * Sets how much audio an utterance buffers before playback starts. The pre-roll starts at its minimum,
+	 * at least doubles after every underrun and shrinks by a quarter after every stable period, trading latency for
+	 * glitch rate according to how the host actually keeps up. It never exceeds the high watermark.
+	 * @param InMinPreRoll The smallest number of samples buffered before playback starts.
+	 * @param InMaxPreRoll The largest number of samples buffered before playback starts.
+	 * @param InStableSamples The number of samples played without an underrun after which the pre-roll shrinks.
+	 */
+	void SetPreRoll(int32 InMinPreRoll, int32 InMaxPreRoll, int64 InStableSamples);
+
+	/**
+	 * Opens a new utterance for writing. Utterances are written one at a time in the order they were opened, so the
+	 * ring buffer only ever has a single producer and utterances never interleave.
+	 * @returns The id to pass to Write() and EndUtterance().
+	 */
+	uint32 BeginUtterance();
+
+	/**
+	 * Waits until every utterance opened before this one has ended, after which its producer is the only one.
+	 * Write() and EndUtterance() wait for this themselves. Producer side only.
+	 * @returns false if the utterance was cancelled while waiting.
+	 */
+	bool WaitForTurn(uint32 UtteranceId);
+
+	/**
+	 * Writes samples to the stream, waiting for the utterance's turn and for the render thread to make room while the
+	 * buffer is full. This can block for as long as playback takes to drain, so never call it while holding a lock
+	 * other producers need. Producer side only.
+	 * @returns false if the utterance was cancelled or playback stalled, in which case the samples were dropped.
+	 */
+	bool Write(uint32 UtteranceId, const float* Samples, int32 NumSamples);
+
+	/**
+	 * Waits until the throttled producer may write again, without writing anything. Lets a producer wait for playback
+	 * before taking a lock it would otherwise hold while its audio has nowhere to go. Producer side only.
+	 * @returns false if the utterance was cancelled or playback stalled.
+	 */
+	bool WaitForRoom(uint32 UtteranceId);
+
+	/**
+	 * Writes as many samples as fit below the high watermark without waiting. Only the producer whose turn it is may
+	 * call this, see WaitForTurn().
+	 * @returns The number of samples written, or INDEX_NONE if the utterance was cancelled or it isn't its turn.
+	 */
+	int32 TryWrite(uint32 UtteranceId, const float* Samples, int32 NumSamples);
+
+	/**
+	 * Checks whether an utterance was cancelled, so the producer can stop synthesizing it.
+	 */
+	bool IsCancelled(uint32 UtteranceId) const { return UtteranceId < FirstLiveUtterance.load(); }
+
+	/**
+	 * Signals that no more audio will be written for an utterance, handing the stream to the next one.
+	 */
+	void EndUtterance(uint32 UtteranceId);
+
+	/**
+	 * Cancels all open utterances and drops any audio which has not been played yet.
+	 */
+	void Cancel();
+
+	/**
+	 * Marks the stream as played by a sound generator. Until then a producer waiting for room waits for the stream to
+	 * be handed to playback instead of treating the missing playback as a stall.
+	 */
+	void Attach() { bAttached.store(true, std::memory_order_release); }
+
+	/**
+	 * Reads samples for playback. Render thread only.
+	 * @returns The number of samples read, less than NumSamples if the stream ran dry.
+	 */
+	int32 Read(float* OutSamples, int32 NumSamples);
+
+	/**
+	 * @returns true if every utterance has been written and played back completely.
+	 */
+	bool IsFinished() const;
+
+	/**
+	 * Gets the number of samples written since the stream was created.
+	 * Sampled before writing an utterance, it is the position at which that utterance starts playing.
+	 */
+	int64 GetSamplesWritten() const { return SamplesWritten.load(std::memory_order_acquire); }
+
+	/**
+	 * Gets the number of samples the render thread has consumed since the stream was created, published after
+	 * every Read(). Audio dropped by Cancel() counts as consumed so the count stays aligned with GetSamplesWritten().
+	 */
+	int64 GetSamplesRead() const { return SamplesRead.load(std::memory_order_acquire); }
+
+	/**
+	 * Moves the underruns counted since the last call to the caller. An underrun is playback running dry while an
+	 * utterance is still being written, and lasts until the pre-roll has been buffered again.
+	 * @param OutCount Receives the number of underruns.
+	 * @param OutSamples Receives the number of samples of silence they caused.
+	 */
+	void TakeUnderruns(int32& OutCount, int64& OutSamples);
+
+	/**
+	 * Gets the current adaptive pre-roll, see SetPreRoll().
+	 */
+	int32 GetPreRollSamples() const { return PreRollSamples.load(std::memory_order_relaxed); }
+
+	int32 GetSampleRate() const { return SampleRate; }
+	int32 GetNumChannels() const { return NumChannels; }
+
+private:
+	/** Gets the number of samples the producer may push now, applying the watermarks. */
+	int32 GetRoom();
+
+	/**
+	 * Sleeps for part of the time playback needs to drain the buffer.
+	 * @returns false once playback has consumed nothing for too long.
+	 */
+	bool WaitForPlayback(double& StallStart, int64& LastSamplesRead);
+
+	/** Pushes samples unless the utterance was cancelled, under UtteranceMutex so a flush never misses them. */
+	int32 Push(uint32 UtteranceId, const float* Samples, int32 NumSamples);
+
+	TTTSAudioRingBuffer<float> RingBuffer;
+	int32 SampleRate;
+	int32 NumChannels;
+	int32 HighWatermark = 0;
+	int32 LowWatermark = 0;
+	bool bThrottled = false; ///< Producer side only, true while waiting for playback to drain to LowWatermark.
+
+	// Guards opening, closing and cancelling utterances and pushing to RingBuffer, so a cancel flushes everything
+	// written before it and nothing after. The render thread only reads the atomics below.
+	FCriticalSection UtteranceMutex;
+	uint32 NextUtterance = 0; ///< The id BeginUtterance() hands out next.
+	std::atomic<uint32> FirstLiveUtterance{ 0 }; ///< Every utterance opened before this one was cancelled.
+	std::atomic<uint32> WritingUtterance{ 0 }; ///< The only utterance allowed to write.
+	std::atomic<int32> OpenUtterances{ 0 };
+	std::atomic<bool> bFlushRequested{ false };
+	std::atomic<bool> bAttached{ false };
+	std::atomic<int64> SamplesWritten{ 0 };
+	std::atomic<int64> SamplesRead{ 0 };
+
+	// Adaptive pre-roll, the non-atomic state is only touched by the render thread.
+	int32 MinPreRoll = 0;
+	int32 MaxPreRoll = 0;
+	int64 StableSamplesToShrink = 0;
+	int64 StableSamples = 0; ///< Samples played since the last underrun or pre-roll change.
+	bool bPrimed = false; ///< true once the current utterance has buffered its pre-roll.
+	bool bRebuffering = false; ///< true while refilling the pre-roll after an underrun.
+	std::atomic<int32> PreRollSamples{ 0 };
+	std::atomic<int32> UnderrunCount{ 0 };
+	std::atomic<int64> UnderrunSamples{ 0 };
+};
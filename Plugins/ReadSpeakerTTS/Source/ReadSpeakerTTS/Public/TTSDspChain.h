@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+#include "TTSDspChain.generated.h"
+
+/**
+ * The processing applied to TTS audio on the synthesis thread, before it is buffered or streamed.
+ * Built-in stages run in the order of the fields below, followed by the registered stages in CustomStages.
+ */
+USTRUCT(BlueprintType)
+struct READSPEAKERTTS_API FTTSDspSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "-24.0", ClampMax = "24.0", UIMin = "-24.0", UIMax = "24.0"))
+	float GainDb = 0.0f; ///< Gain in decibels applied first, 0 to skip.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+	bool bHighPass = false; ///< Whether rumble below HighPassFrequency is removed.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "10.0", ClampMax = "1000.0", UIMin = "20.0", UIMax = "300.0", EditCondition = "bHighPass"))
+	float HighPassFrequency = 80.0f; ///< The cutoff of the high-pass filter in Hz.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+	bool bDeEsser = false; ///< Whether sibilance above DeEsserThresholdDb is turned down.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "1000.0", ClampMax = "16000.0", UIMin = "3000.0", UIMax = "10000.0", EditCondition = "bDeEsser"))
+	float DeEsserFrequency = 5500.0f; ///< The frequency in Hz above which energy counts as sibilance.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "-60.0", ClampMax = "0.0", UIMin = "-60.0", UIMax = "0.0", EditCondition = "bDeEsser"))
+	float DeEsserThresholdDb = -30.0f; ///< The sibilance level in dBFS above which the de-esser reduces gain.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "1.0", ClampMax = "20.0", UIMin = "1.0", UIMax = "10.0", EditCondition = "bDeEsser"))
+	float DeEsserRatio = 4.0f; ///< The compression ratio applied to sibilance above the threshold.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+	bool bLimiter = false; ///< Whether peaks are limited to LimiterCeilingDb.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "-24.0", ClampMax = "0.0", UIMin = "-12.0", UIMax = "0.0", EditCondition = "bLimiter"))
+	float LimiterCeilingDb = -1.0f; ///< The peak level in dBFS the output never exceeds.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing, meta = (ClampMin = "0.001", ClampMax = "2.0", UIMin = "0.01", UIMax = "1.0", EditCondition = "bLimiter"))
+	float LimiterRelease = 0.1f; ///< The seconds the limiter takes to recover after a peak.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Processing)
+	TArray<FName> CustomStages; ///< Stages registered with FReadSpeakerTTSModule::RegisterDspStage(), run after the built-in ones.
+
+	bool operator==(const FTTSDspSettings& Other) const;
+	bool operator!=(const FTTSDspSettings& Other) const { return !(*this == Other); }
+};
+
+READSPEAKERTTS_API uint32 GetTypeHash(const FTTSDspSettings& Settings);
+
+/**
+ * A processing step in an FTTSDspChain. Runs on the synthesis thread, one instance per converter,
+ * so implementations can keep filter state without locking.
+ */
+class READSPEAKERTTS_API ITTSDspStage
+{
+public:
+	virtual ~ITTSDspStage() {}
+
+	/**
+	 * Called before the first chunk of an utterance. Clears any state left from the previous one.
+	 * @param SampleRate The sample rate of the audio passed to Process().
+	 * @param NumChannels The number of interleaved channels.
+	 */
+	virtual void Prepare(int32 SampleRate, int32 NumChannels) = 0;
+
+	/**
+	 * Processes a chunk of interleaved float frames in place.
+	 * @param Samples The frames, need not be aligned.
+	 * @param NumFrames The number of frames.
+	 */
+	virtual void Process(float* Samples, int32 NumFrames) = 0;
+};
+
+/** Creates a new instance of a custom stage. */
+typedef TFunction<TUniquePtr<ITTSDspStage>()> FTTSDspStageFactory;
+
+/**
+ * The stages a converter runs on each chunk of audio between RSGame and its output buffer or stream,
+ * so processing costs once per synthesis instead of once per voice on the audio render thread.
+ */
+class READSPEAKERTTS_API FTTSDspChain
+{
+public:
+	/**
+	 * Creates the stages for a set of settings. Keeps the current stages if neither the settings nor, for settings
+	 * with custom stages, the registered stages changed since. Call from the game thread before starting a conversion.
+	 * @param Settings The stages to create and their parameters.
+	 */
+	void Build(const FTTSDspSettings& Settings);
+
+	/**
+	 * Removes all stages.
+	 */
+	void Clear();
+
+	/**
+	 * Prepares every stage for a new utterance.
+	 */
+	void Prepare(int32 SampleRate, int32 NumChannels);
+
+	/**
+	 * Runs every stage on a chunk of interleaved frames in place.
+	 */
+	void Process(float* Samples, int32 NumFrames);
+
+	bool IsEmpty() const { return Stages.Num() == 0; }
+
+	/** Gets the settings the current stages were built from. */
+	const FTTSDspSettings& GetSettings() const { return BuiltSettings; }
+
+private:
+	TArray<TUniquePtr<ITTSDspStage>> Stages;
+	FTTSDspSettings BuiltSettings; ///< The settings Stages were created from.
+	int32 BuiltRegistryVersion = INDEX_NONE; ///< The FReadSpeakerTTSModule::GetDspStageRegistryVersion() Stages were created at.
+};
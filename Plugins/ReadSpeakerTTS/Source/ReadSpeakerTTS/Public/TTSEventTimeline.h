@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A viseme reported during synthesis. */
+struct FTTSVisemeCue
+{
+	float Time; ///< Seconds from the start of the utterance.
+	int32 VisemeId;
+};
+
+/** A word boundary reported during synthesis. */
+struct FTTSWordCue
+{
+	float Time; ///< Seconds from the start of the utterance.
+	int32 StartPos; ///< The index of the first character of the word in the synthesized text.
+	int32 EndPos; ///< The index of the last character of the word in the synthesized text.
+};
+
+/** An SSML mark reported during synthesis. */
+struct FTTSMarkCue
+{
+	float Time; ///< Seconds from the start of the utterance.
+	FString Name;
+};
+
+/**
+ * The events which became due in one FTTSEventTimeline::Advance() call, in time order.
+ * Meant to be kept and reused between ticks so it stops allocating after warmup.
+ */
+struct FTTSDueEvents
+{
+	TArray<FTTSVisemeCue> Visemes;
+	TArray<FTTSWordCue> Words;
+	TArray<FTTSMarkCue> Marks;
+
+	void Reset()
+	{
+		Visemes.Reset();
+		Words.Reset();
+		Marks.Reset();
+	}
+};
+
+/**
+ * The viseme, word and mark events of one utterance, kept sorted by time so they can be dispatched
+ * when the audio is actually played rather than when it is synthesized.
+ * The synthesis task adds events while the game thread advances through them, so both sides take a short lock.
+ */
+class READSPEAKERTTS_API FTTSEventTimeline
+{
+public:
+	/**
+	 * Removes all events, keeping the allocations for the next utterance.
+	 */
+	void Reset();
+
+	void AddViseme(int32 VisemeId, float Time);
+	void AddWord(int32 StartPos, int32 EndPos, float Time);
+	void AddMark(FString&& Name, float Time);
+
+	/**
+	 * Collects every event at or before a playback position which has not been collected yet.
+	 * @param PlaybackTime The number of seconds of the utterance played so far.
+	 * @param OutDue Reset, then receives the due events.
+	 * @returns true if any event became due.
+	 */
+	bool Advance(double PlaybackTime, FTTSDueEvents& OutDue);
+
+	/**
+	 * Copies every viseme of the utterance, whether collected by Advance() or not.
+	 * @param OutVisemes Reset, then receives the visemes in time order.
+	 */
+	void GetVisemes(TArray<FTTSVisemeCue>& OutVisemes);
+
+	/**
+	 * Drops the events which have not been collected yet, and any added until the next Reset(), so an interrupted
+	 * utterance stops reporting even while it is still being synthesized.
+	 */
+	void Skip();
+
+	/**
+	 * Moves the events at or after a time by an offset, keeping them at or after that time.
+	 * @param FromTime The earliest event time which is moved.
+	 * @param Delta The number of seconds to add to the events.
+	 */
+	void Shift(float FromTime, float Delta);
+
+	/**
+	 * Removes the events already collected by Advance(), so a long utterance only keeps the events still ahead of playback.
+	 */
+	void Compact();
+
+private:
+	FCriticalSection Mutex;
+	TArray<FTTSVisemeCue> Visemes;
+	TArray<FTTSWordCue> Words;
+	TArray<FTTSMarkCue> Marks;
+	int32 NextViseme = 0; ///< The index of the first viseme not collected by Advance().
+	int32 NextWord = 0; ///< The index of the first word not collected by Advance().
+	int32 NextMark = 0; ///< The index of the first mark not collected by Advance().
+	bool bSkipped = false; ///< Set by Skip(), drops the events added until Reset().
+};
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Measures the integrated loudness of an utterance as it is synthesized, following ITU-R BS.1770 / EBU R128:
+ * K-weighting, 400 ms blocks overlapping by 75%, an absolute gate at -70 LUFS and a relative gate 10 LU below
+ * the ungated mean. The K-weighting filters are recursive and run a sample at a time, the block energies are
+ * summed four samples at a time.
+ */
+class READSPEAKERTTS_API FTTSLoudnessMeter
+{
+public:
+	/** The loudness reported when nothing passed the absolute gate. */
+	static constexpr float MinLoudness = -70.0f;
+
+	/**
+	 * Designs the filters for a sample rate and clears the measurement.
+	 * @param InSampleRate The sample rate of the audio passed to Process().
+	 * @param InNumChannels The number of interleaved channels, all weighted equally.
+	 */
+	void Prepare(int32 InSampleRate, int32 InNumChannels);
+
+	/**
+	 * Adds a chunk of interleaved frames to the measurement.
+	 * @param Samples The frames, need not be aligned.
+	 * @param NumFrames The number of frames.
+	 */
+	void Process(const float* Samples, int32 NumFrames);
+	void Process(const int16* Samples, int32 NumFrames);
+
+	/**
+	 * Gets the integrated loudness of everything processed since Prepare().
+	 * Audio shorter than one block is measured as a single block.
+	 * @returns The loudness in LUFS, MinLoudness if the audio is silent.
+	 */
+	float GetIntegratedLoudness() const;
+
+	/**
+	 * Gets the gain which brings audio of one loudness to another.
+	 * @param Loudness The measured loudness in LUFS.
+	 * @param TargetLoudness The desired loudness in LUFS.
+	 * @param MaxCorrectionDb The largest boost or cut applied, in decibels.
+	 * @returns The linear gain, 1 if Loudness is MinLoudness or below.
+	 */
+	static float GetNormalizationGain(float Loudness, float TargetLoudness, float MaxCorrectionDb);
+
+private:
+	struct FBiquad
+	{
+		float B0 = 1.0f, B1 = 0.0f, B2 = 0.0f, A1 = 0.0f, A2 = 0.0f;
+	};
+
+	template<typename SampleType>
+	void Filter(const SampleType* Samples, int32 NumFrames, float Scale);
+	void ProcessFiltered(int32 NumFrames);
+	void AddBlock(double Energy);
+
+	int32 SampleRate = 0;
+	int32 NumChannels = 1;
+	FBiquad Shelf; ///< The first K-weighting stage, a high shelf modelling the head.
+	FBiquad HighPass; ///< The second K-weighting stage, the RLB high-pass.
+	TArray<float> FilterState; ///< Four delay elements per channel, two for each stage.
+	TArray<float> Filtered; ///< Reused buffer of K-weighted samples of the current chunk.
+
+	int32 StepFrames = 0; ///< The frames in 100 ms, a quarter of a block.
+	int32 StepPosition = 0; ///< The frames of the current step processed so far.
+	double StepEnergy = 0.0; ///< The sum of squares of the current step.
+	double RecentSteps[4] = {}; ///< The energies of the last four completed steps, which make up a block.
+	int32 NumSteps = 0; ///< The number of completed steps.
+	TArray<double> BlockEnergies; ///< The mean square of every block, for gating at the end.
+};
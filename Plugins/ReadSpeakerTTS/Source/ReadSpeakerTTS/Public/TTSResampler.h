@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TTSResampler.generated.h"
+
+UENUM(BlueprintType)
+enum class ETTSResamplerQuality : uint8 {
+	Low = 0, ///< 8 taps per phase, cheapest, audible roll-off above ~80% of the lower Nyquist rate.
+	Medium = 1, ///< 16 taps per phase.
+	High = 2 ///< 32 taps per phase, flat to ~95% of the lower Nyquist rate.
+};
+
+/**
+ * Streaming polyphase resampler converting TTS audio between two fixed sample rates.
+ * The rate ratio is reduced to L/M and a Kaiser windowed sinc is split into L phases, so every output sample
+ * is a single vectorized dot product. Filter history is kept between Process() calls so chunks can be fed
+ * as they arrive from RSGame, and the filter delay is compensated so output stays aligned with event timestamps.
+ */
+class READSPEAKERTTS_API FTTSResampler
+{
+public:
+	/**
+	 * Builds the filter for a conversion and resets the stream state. Cheap if nothing changed.
+	 * The resampler is inactive, and must not be used, if both rates are equal or invalid.
+	 * @param InInputRate The sample rate of the audio passed to Process().
+	 * @param InOutputRate The sample rate of the audio produced.
+	 * @param InNumChannels The number of interleaved channels.
+	 * @param InQuality The length of the filter.
+	 */
+	void Configure(int32 InInputRate, int32 InOutputRate, int32 InNumChannels, ETTSResamplerQuality InQuality);
+
+	/**
+	 * Clears the filter history so the next Process() call starts a new stream.
+	 */
+	void Reset();
+
+	/**
+	 * Resamples a chunk of interleaved frames.
+	 * @param Input The input frames.
+	 * @param NumInputFrames The number of input frames.
+	 * @param Output Resampled interleaved frames are appended to this array.
+	 * @returns The number of frames appended.
+	 */
+	int32 Process(const float* Input, int32 NumInputFrames, TArray<float>& Output);
+
+	/**
+	 * Drains the audio held back by the filter at the end of a stream, then resets.
+	 * @param Output Resampled interleaved frames are appended to this array.
+	 * @returns The number of frames appended.
+	 */
+	int32 Flush(TArray<float>& Output);
+
+	/**
+	 * Gets an upper bound on the number of frames Process() or Flush() appends for a number of input frames.
+	 */
+	int32 GetMaxOutputFrames(int32 NumInputFrames) const;
+
+	bool IsActive() const { return bActive; }
+	int32 GetInputRate() const { return InputRate; }
+	int32 GetOutputRate() const { return OutputRate; }
+
+private:
+	void BuildFilter();
+	int32 ProduceFrames(TArray<float>& Output);
+
+	int32 InputRate = 0;
+	int32 OutputRate = 0;
+	int32 NumChannels = 0;
+	ETTSResamplerQuality Quality = ETTSResamplerQuality::Medium;
+	bool bActive = false;
+
+	int32 Interpolation = 1; ///< L, the number of filter phases.
+	int32 Decimation = 1; ///< M, input samples advanced per L output samples.
+	int32 NumTaps = 0; ///< Taps per phase, a multiple of four.
+	TArray<float> FilterBank; ///< Interpolation phases of NumTaps coefficients each, stored reversed.
+
+	TArray<TArray<float>> ChannelHistory; ///< Deinterleaved input not yet fully consumed by the filter.
+	int32 Position = 0; ///< Index in ChannelHistory of the newest input sample used by the next output sample.
+	int32 Phase = 0; ///< The filter phase of the next output sample.
+};
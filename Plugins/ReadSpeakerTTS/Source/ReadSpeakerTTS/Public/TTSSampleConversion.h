@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#define TTS_CONVERSION_NEON 1
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#define TTS_CONVERSION_SSE 1
+#if PLATFORM_ALWAYS_HAS_AVX_2
+#include <immintrin.h>
+#define TTS_CONVERSION_AVX2 1
+#endif
+#endif
+
+#ifndef TTS_CONVERSION_NEON
+#define TTS_CONVERSION_NEON 0
+#endif
+#ifndef TTS_CONVERSION_SSE
+#define TTS_CONVERSION_SSE 0
+#endif
+#ifndef TTS_CONVERSION_AVX2
+#define TTS_CONVERSION_AVX2 0
+#endif
+
+/**
+ * Sample conversion kernels between the RSGame output formats and the formats consumed by the plugin.
+ * Kernels are specialized at compile time on source format, destination sample type and channel layout,
+ * apply a gain in the same pass and use SSE, AVX2 or NEON where available with a scalar fallback.
+ * Float output is normalized to [-1, 1], int16 output is saturated.
+ */
+namespace TTSSampleConversion
+{
+	/** Unsigned 8-bit PCM, silence at 128. */
+	struct FPCM8
+	{
+		typedef uint8 SampleType;
+		static constexpr float Scale = 1.0f / 128.0f;
+		static FORCEINLINE float ToFloat(SampleType Sample) { return (float)Sample - 128.0f; }
+	};
+
+	/** Signed 16-bit PCM. */
+	struct FPCM16
+	{
+		typedef int16 SampleType;
+		static constexpr float Scale = 1.0f / 32768.0f;
+		static FORCEINLINE float ToFloat(SampleType Sample) { return (float)Sample; }
+	};
+
+	/** Normalized float, as produced by the resampler. */
+	struct FFloat32
+	{
+		typedef float SampleType;
+		static constexpr float Scale = 1.0f;
+		static FORCEINLINE float ToFloat(SampleType Sample) { return Sample; }
+	};
+
+	namespace Private
+	{
+		/** The factor which takes a raw source sample to the destination range. */
+		template<typename SrcFormat, typename DstType>
+		FORCEINLINE float OutputScale(float Gain)
+		{
+			return std::is_same_v<DstType, float> ? Gain * SrcFormat::Scale : Gain * SrcFormat::Scale * 32768.0f;
+		}
+
+		FORCEINLINE void StoreScalar(float* Dst, float Value)
+		{
+			*Dst = Value;
+		}
+
+		FORCEINLINE void StoreScalar(int16* Dst, float Value)
+		{
+			// Rounds half to even like the vector conversions, so the output doesn't depend on the frame count.
+			*Dst = (int16)FMath::RoundHalfToEven(FMath::Clamp(Value, -32768.0f, 32767.0f));
+		}
+
+		template<typename SrcFormat, typename DstType, int32 SrcChannels, int32 DstChannels>
+		FORCEINLINE void ConvertFrameScalar(const typename SrcFormat::SampleType* Src, DstType* Dst, float Scale)
+		{
+			if constexpr (SrcChannels == DstChannels)
+			{
+				for (int32 Channel = 0; Channel < SrcChannels; ++Channel)
+				{
+					StoreScalar(Dst + Channel, SrcFormat::ToFloat(Src[Channel]) * Scale);
+				}
+			}
+			else if constexpr (SrcChannels == 1)
+			{
+				const float Value = SrcFormat::ToFloat(Src[0]) * Scale;
+				StoreScalar(Dst, Value);
+				StoreScalar(Dst + 1, Value);
+			}
+			else
+			{
+				StoreScalar(Dst, (SrcFormat::ToFloat(Src[0]) + SrcFormat::ToFloat(Src[1])) * 0.5f * Scale);
+			}
+		}
+
+#if TTS_CONVERSION_SSE
+		typedef __m128 FFloat4;
+
+		FORCEINLINE FFloat4 Load4(const FPCM16::SampleType* Src)
+		{
+			const __m128i Raw = _mm_loadl_epi64((const __m128i*)Src);
+			return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(Raw, Raw), 16));
+		}
+
+		FORCEINLINE FFloat4 Load4(const FPCM8::SampleType* Src)
+		{
+			int32 Packed;
+			FMemory::Memcpy(&Packed, Src, sizeof(Packed));
+			const __m128i Zero = _mm_setzero_si128();
+			const __m128i Wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(Packed), Zero), Zero);
+			return _mm_sub_ps(_mm_cvtepi32_ps(Wide), _mm_set1_ps(128.0f));
+		}
+
+		FORCEINLINE FFloat4 Load4(const FFloat32::SampleType* Src)
+		{
+			return _mm_loadu_ps(Src);
+		}
+
+		FORCEINLINE FFloat4 Splat(float Value) { return _mm_set1_ps(Value); }
+		FORCEINLINE FFloat4 Mul(FFloat4 A, FFloat4 B) { return _mm_mul_ps(A, B); }
+		FORCEINLINE FFloat4 Add(FFloat4 A, FFloat4 B) { return _mm_add_ps(A, B); }
+		FORCEINLINE FFloat4 InterleaveLow(FFloat4 A) { return _mm_unpacklo_ps(A, A); }
+		FORCEINLINE FFloat4 InterleaveHigh(FFloat4 A) { return _mm_unpackhi_ps(A, A); }
+		FORCEINLINE FFloat4 Evens(FFloat4 A, FFloat4 B) { return _mm_shuffle_ps(A, B, _MM_SHUFFLE(2, 0, 2, 0)); }
+		FORCEINLINE FFloat4 Odds(FFloat4 A, FFloat4 B) { return _mm_shuffle_ps(A, B, _MM_SHUFFLE(3, 1, 3, 1)); }
+
+		FORCEINLINE void Store4(float* Dst, FFloat4 Value)
+		{
+			_mm_storeu_ps(Dst, Value);
+		}
+
+		FORCEINLINE void Store4(int16* Dst, FFloat4 Value)
+		{
+			// Out of range floats convert to INT_MIN, so clamp before rounding.
+			const __m128 Clamped = _mm_min_ps(_mm_max_ps(Value, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+			const __m128i Rounded = _mm_cvtps_epi32(Clamped);
+			_mm_storel_epi64((__m128i*)Dst, _mm_packs_epi32(Rounded, Rounded));
+		}
+#elif TTS_CONVERSION_NEON
+		typedef float32x4_t FFloat4;
+
+		FORCEINLINE FFloat4 Load4(const FPCM16::SampleType* Src)
+		{
+			return vcvtq_f32_s32(vmovl_s16(vld1_s16(Src)));
+		}
+
+		FORCEINLINE FFloat4 Load4(const FPCM8::SampleType* Src)
+		{
+			uint32 Packed;
+			FMemory::Memcpy(&Packed, Src, sizeof(Packed));
+			const uint16x4_t Wide = vget_low_u16(vmovl_u8(vcreate_u8((uint64)Packed)));
+			return vsubq_f32(vcvtq_f32_u32(vmovl_u16(Wide)), vdupq_n_f32(128.0f));
+		}
+
+		FORCEINLINE FFloat4 Load4(const FFloat32::SampleType* Src)
+		{
+			return vld1q_f32(Src);
+		}
+
+		FORCEINLINE FFloat4 Splat(float Value) { return vdupq_n_f32(Value); }
+		FORCEINLINE FFloat4 Mul(FFloat4 A, FFloat4 B) { return vmulq_f32(A, B); }
+		FORCEINLINE FFloat4 Add(FFloat4 A, FFloat4 B) { return vaddq_f32(A, B); }
+		FORCEINLINE FFloat4 InterleaveLow(FFloat4 A) { return vzipq_f32(A, A).val[0]; }
+		FORCEINLINE FFloat4 InterleaveHigh(FFloat4 A) { return vzipq_f32(A, A).val[1]; }
+		FORCEINLINE FFloat4 Evens(FFloat4 A, FFloat4 B) { return vuzpq_f32(A, B).val[0]; }
+		FORCEINLINE FFloat4 Odds(FFloat4 A, FFloat4 B) { return vuzpq_f32(A, B).val[1]; }
+
+		FORCEINLINE void Store4(float* Dst, FFloat4 Value)
+		{
+			vst1q_f32(Dst, Value);
+		}
+
+		FORCEINLINE void Store4(int16* Dst, FFloat4 Value)
+		{
+			vst1_s16(Dst, vqmovn_s32(vcvtnq_s32_f32(Value)));
+		}
+#endif
+
+#if TTS_CONVERSION_SSE || TTS_CONVERSION_NEON
+		/**
+		 * Converts four frames.
+		 */
+		template<typename SrcFormat, typename DstType, int32 SrcChannels, int32 DstChannels>
+		FORCEINLINE void ConvertFrames4(const typename SrcFormat::SampleType* Src, DstType* Dst, FFloat4 Scale)
+		{
+			if constexpr (SrcChannels == DstChannels)
+			{
+				for (int32 Channel = 0; Channel < SrcChannels; ++Channel)
+				{
+					Store4(Dst + Channel * 4, Mul(Load4(Src + Channel * 4), Scale));
+				}
+			}
+			else if constexpr (SrcChannels == 1)
+			{
+				const FFloat4 Mono = Mul(Load4(Src), Scale);
+				Store4(Dst, InterleaveLow(Mono));
+				Store4(Dst + 4, InterleaveHigh(Mono));
+			}
+			else
+			{
+				const FFloat4 A = Load4(Src);
+				const FFloat4 B = Load4(Src + 4);
+				Store4(Dst, Mul(Add(Evens(A, B), Odds(A, B)), Mul(Scale, Splat(0.5f))));
+			}
+		}
+#endif
+
+#if TTS_CONVERSION_AVX2
+		FORCEINLINE __m256 Load8(const FPCM16::SampleType* Src)
+		{
+			return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)Src)));
+		}
+
+		FORCEINLINE __m256 Load8(const FPCM8::SampleType* Src)
+		{
+			const __m256 Unsigned = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)Src)));
+			return _mm256_sub_ps(Unsigned, _mm256_set1_ps(128.0f));
+		}
+
+		FORCEINLINE __m256 Load8(const FFloat32::SampleType* Src)
+		{
+			return _mm256_loadu_ps(Src);
+		}
+
+		FORCEINLINE void Store8(float* Dst, __m256 Value)
+		{
+			_mm256_storeu_ps(Dst, Value);
+		}
+
+		FORCEINLINE void Store8(int16* Dst, __m256 Value)
+		{
+			const __m256 Clamped = _mm256_min_ps(_mm256_max_ps(Value, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+			const __m256i Rounded = _mm256_cvtps_epi32(Clamped);
+			const __m128i Packed = _mm_packs_epi32(_mm256_castsi256_si128(Rounded), _mm256_extracti128_si256(Rounded, 1));
+			_mm_storeu_si128((__m128i*)Dst, Packed);
+		}
+#endif
+	}
+
+	/**
+	 * Converts interleaved frames from one sample format and channel layout to another, applying a gain.
+	 * Supported layouts are 1->1, 2->2, 1->2 (duplicated) and 2->1 (averaged).
+	 * @param Src The source samples, NumFrames * SrcChannels of them. Need not be aligned.
+	 * @param Dst The destination samples, room for NumFrames * DstChannels of them. Need not be aligned.
+	 * @param NumFrames The number of frames to convert.
+	 * @param Gain The linear gain to apply.
+	 */
+	template<typename SrcFormat, typename DstType, int32 SrcChannels, int32 DstChannels>
+	void Convert(const typename SrcFormat::SampleType* Src, DstType* Dst, int32 NumFrames, float Gain)
+	{
+		static_assert(std::is_same_v<DstType, float> || std::is_same_v<DstType, int16>, "Destination must be float or int16.");
+		static_assert((SrcChannels == 1 || SrcChannels == 2) && (DstChannels == 1 || DstChannels == 2), "Only mono and stereo layouts are supported.");
+
+		const float Scale = Private::OutputScale<SrcFormat, DstType>(Gain);
+		int32 Frame = 0;
+
+#if TTS_CONVERSION_AVX2
+		// Equal layouts are a flat sample stream, so those take eight samples per step.
+		if constexpr (SrcChannels == DstChannels)
+		{
+			const __m256 Scale8 = _mm256_set1_ps(Scale);
+			const int32 NumSamples = NumFrames * SrcChannels;
+			int32 Sample = 0;
+			for (; Sample + 8 <= NumSamples; Sample += 8)
+			{
+				Private::Store8(Dst + Sample, _mm256_mul_ps(Private::Load8(Src + Sample), Scale8));
+			}
+			Frame = Sample / SrcChannels;
+		}
+#endif
+
+#if TTS_CONVERSION_SSE || TTS_CONVERSION_NEON
+		const Private::FFloat4 Scale4 = Private::Splat(Scale);
+		for (; Frame + 4 <= NumFrames; Frame += 4)
+		{
+			Private::ConvertFrames4<SrcFormat, DstType, SrcChannels, DstChannels>(Src + Frame * SrcChannels, Dst + Frame * DstChannels, Scale4);
+		}
+#endif
+
+		for (; Frame < NumFrames; ++Frame)
+		{
+			Private::ConvertFrameScalar<SrcFormat, DstType, SrcChannels, DstChannels>(Src + Frame * SrcChannels, Dst + Frame * DstChannels, Scale);
+		}
+	}
+
+	/**
+	 * Picks the Convert() specialization for a channel layout known only at runtime.
+	 * @returns false if the layout is not supported, in which case nothing is written.
+	 */
+	template<typename SrcFormat, typename DstType>
+	bool ConvertInterleaved(const typename SrcFormat::SampleType* Src, int32 SrcChannels, DstType* Dst, int32 DstChannels, int32 NumFrames, float Gain)
+	{
+		switch (SrcChannels * 4 + DstChannels)
+		{
+		case 1 * 4 + 1: Convert<SrcFormat, DstType, 1, 1>(Src, Dst, NumFrames, Gain); return true;
+		case 2 * 4 + 2: Convert<SrcFormat, DstType, 2, 2>(Src, Dst, NumFrames, Gain); return true;
+		case 1 * 4 + 2: Convert<SrcFormat, DstType, 1, 2>(Src, Dst, NumFrames, Gain); return true;
+		case 2 * 4 + 1: Convert<SrcFormat, DstType, 2, 1>(Src, Dst, NumFrames, Gain); return true;
+		default: return false;
+		}
+	}
+}
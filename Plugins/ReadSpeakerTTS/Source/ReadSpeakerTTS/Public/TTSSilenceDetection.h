@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TTSSampleConversion.h"
+
+/**
+ * Kernels locating the audible part of a TTS buffer, used to trim the silence RSGame puts around utterances.
+ * Whole vectors are tested against the threshold at once and only the first vector with an audible sample
+ * is searched sample by sample, so a silent buffer costs one compare per four or eight samples.
+ */
+namespace TTSSilenceDetection
+{
+	namespace Private
+	{
+		FORCEINLINE int16 ToInt16Threshold(float Threshold)
+		{
+			return (int16)FMath::Clamp(FMath::RoundToInt(Threshold * 32768.0f), 0, 32767);
+		}
+
+		FORCEINLINE bool IsAbove(float Sample, float Threshold)
+		{
+			return FMath::Abs(Sample) > Threshold;
+		}
+
+		FORCEINLINE bool IsAbove(int16 Sample, int16 Threshold)
+		{
+			return FMath::Abs((int32)Sample) > Threshold;
+		}
+
+		/** The number of samples AnyAbove() tests at once. */
+		template<typename SampleType>
+		constexpr int32 BlockSize()
+		{
+			return std::is_same_v<SampleType, int16> ? 8 : 4;
+		}
+
+#if TTS_CONVERSION_SSE
+		FORCEINLINE bool AnyAbove(const float* Samples, float Threshold)
+		{
+			const __m128 Magnitude = _mm_and_ps(_mm_loadu_ps(Samples), _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+			return _mm_movemask_ps(_mm_cmpgt_ps(Magnitude, _mm_set1_ps(Threshold))) != 0;
+		}
+
+		FORCEINLINE bool AnyAbove(const int16* Samples, int16 Threshold)
+		{
+			// Compare against both bounds instead of taking the absolute value, which overflows for -32768.
+			const __m128i Value = _mm_loadu_si128((const __m128i*)Samples);
+			const __m128i Above = _mm_or_si128(_mm_cmpgt_epi16(Value, _mm_set1_epi16(Threshold)), _mm_cmplt_epi16(Value, _mm_set1_epi16(-Threshold)));
+			return _mm_movemask_epi8(Above) != 0;
+		}
+#elif TTS_CONVERSION_NEON
+		FORCEINLINE bool AnyAbove(const float* Samples, float Threshold)
+		{
+			return vmaxvq_u32(vcagtq_f32(vld1q_f32(Samples), vdupq_n_f32(Threshold))) != 0;
+		}
+
+		FORCEINLINE bool AnyAbove(const int16* Samples, int16 Threshold)
+		{
+			return vmaxvq_u16(vcgtq_s16(vqabsq_s16(vld1q_s16(Samples)), vdupq_n_s16(Threshold))) != 0;
+		}
+#else
+		template<typename SampleType, typename ThresholdType>
+		FORCEINLINE bool AnyAbove(const SampleType* Samples, ThresholdType Threshold)
+		{
+			for (int32 Index = 0; Index < BlockSize<SampleType>(); ++Index)
+			{
+				if (IsAbove(Samples[Index], Threshold))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+#endif
+
+		template<typename SampleType, typename ThresholdType>
+		int32 FindFirstAbove(const SampleType* Samples, int32 Num, ThresholdType Threshold)
+		{
+			constexpr int32 Block = BlockSize<SampleType>();
+			int32 Index = 0;
+			for (; Index + Block <= Num; Index += Block)
+			{
+				if (AnyAbove(Samples + Index, Threshold))
+				{
+					break;
+				}
+			}
+			for (; Index < Num; ++Index)
+			{
+				if (IsAbove(Samples[Index], Threshold))
+				{
+					return Index;
+				}
+			}
+			return INDEX_NONE;
+		}
+
+		template<typename SampleType, typename ThresholdType>
+		int32 FindLastAbove(const SampleType* Samples, int32 Num, ThresholdType Threshold)
+		{
+			constexpr int32 Block = BlockSize<SampleType>();
+			// Blocks are aligned to the end of the buffer so the remainder is at the start.
+			int32 End = Num;
+			for (; End - Block >= 0; End -= Block)
+			{
+				if (AnyAbove(Samples + End - Block, Threshold))
+				{
+					break;
+				}
+			}
+			for (int32 Index = End - 1; Index >= 0; --Index)
+			{
+				if (IsAbove(Samples[Index], Threshold))
+				{
+					return Index;
+				}
+			}
+			return INDEX_NONE;
+		}
+	}
+
+	/**
+	 * Finds the first sample louder than a threshold.
+	 * @param Samples The samples to search, need not be aligned.
+	 * @param Num The number of samples.
+	 * @param Threshold The normalized magnitude, between 0 and 1, at or below which a sample counts as silent.
+	 * @returns The index of the sample, or INDEX_NONE if all samples are silent.
+	 */
+	FORCEINLINE int32 FindFirstAbove(const float* Samples, int32 Num, float Threshold)
+	{
+		return Private::FindFirstAbove(Samples, Num, Threshold);
+	}
+
+	FORCEINLINE int32 FindFirstAbove(const int16* Samples, int32 Num, float Threshold)
+	{
+		return Private::FindFirstAbove(Samples, Num, Private::ToInt16Threshold(Threshold));
+	}
+
+	/**
+	 * Finds the last sample louder than a threshold.
+	 * @param Samples The samples to search, need not be aligned.
+	 * @param Num The number of samples.
+	 * @param Threshold The normalized magnitude, between 0 and 1, at or below which a sample counts as silent.
+	 * @returns The index of the sample, or INDEX_NONE if all samples are silent.
+	 */
+	FORCEINLINE int32 FindLastAbove(const float* Samples, int32 Num, float Threshold)
+	{
+		return Private::FindLastAbove(Samples, Num, Threshold);
+	}
+
+	FORCEINLINE int32 FindLastAbove(const int16* Samples, int32 Num, float Threshold)
+	{
+		return Private::FindLastAbove(Samples, Num, Private::ToInt16Threshold(Threshold));
+	}
+}
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SynthComponent.h"
+#include "TTSAudioStream.h"
+#include "TTSSynthComponent.generated.h"
+
+/**
+ * A synth component which plays TTS audio while it is being synthesized.
+ * The audio render thread pulls samples from an FTTSAudioStream written by the synthesis task, so
+ * playback starts with the first synthesized chunk instead of after the whole utterance.
+ */
+UCLASS(ClassGroup = ReadSpeakerTTS, meta = (BlueprintSpawnableComponent))
+class READSPEAKERTTS_API UTTSSynthComponent : public USynthComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTTSSynthComponent(const FObjectInitializer& ObjectInitializer);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "32", ClampMax = "8192", UIMin = "32", UIMax = "8192"))
+	int32 CallbackSize = 256; ///< The number of samples the audio render thread pulls per callback.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.05", ClampMax = "30.0", UIMin = "0.05", UIMax = "30.0"))
+	float BufferDuration = 2.0f; ///< The number of seconds of audio which can be buffered ahead of playback.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.0", ClampMax = "30.0", UIMin = "0.0", UIMax = "30.0"))
+	float HighWatermarkDuration = 1.5f; ///< Synthesis pauses once this many seconds are buffered ahead of playback. 0 only pauses when the buffer is full.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.0", ClampMax = "30.0", UIMin = "0.0", UIMax = "30.0"))
+	float LowWatermarkDuration = 0.5f; ///< Paused synthesis resumes once playback has drained the buffer to this many seconds.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.0", ClampMax = "30.0", UIMin = "0.0", UIMax = "30.0"))
+	float MinPreRollDuration = 0.05f; ///< The seconds of audio buffered before an utterance starts playing on a host which keeps up.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.0", ClampMax = "30.0", UIMin = "0.0", UIMax = "30.0"))
+	float MaxPreRollDuration = 1.0f; ///< The most the pre-roll grows to after underruns, capped by HighWatermarkDuration.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReadSpeaker|Streaming", meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float PreRollShrinkInterval = 30.0f; ///< The seconds of playback without an underrun after which the pre-roll shrinks. 0 never shrinks it.
+
+	/**
+	 * Gets the stream played by this component, recreating it if the audio format changed.
+	 * A stream which is still being written or played when the format changes keeps playing until it has drained,
+	 * then playback restarts with the new stream, so producers of either stream never stall on the other.
+	 * @param InSampleRate The sample rate of the audio which will be written.
+	 * @param InNumChannels The number of channels of the audio which will be written.
+	 */
+	TSharedRef<FTTSAudioStream, ESPMode::ThreadSafe> GetStream(int32 InSampleRate, int32 InNumChannels);
+
+	/**
+	 * Gets the stream new audio is written to without changing its format.
+	 * @returns The stream, or null if none has been created yet.
+	 */
+	TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> GetCurrentStream() const { return Stream; }
+
+	/**
+	 * Checks whether the stream still has audio to write or play.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Streaming", meta = (Keywords = "IsStreaming"))
+	bool IsStreaming() const;
+
+	/**
+	 * Drops all audio which has not been played yet, including streams still waiting for a format change.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ReadSpeaker|Streaming", meta = (Keywords = "CancelStream"))
+	void CancelStream();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+	virtual bool Init(int32& SampleRate) override;
+	virtual ISoundGeneratorPtr CreateSoundGenerator(const FSoundGeneratorInitParams& InParams) override;
+
+private:
+	void CreateStream(int32 InSampleRate, int32 InNumChannels);
+
+	/** Gets the stream the sound generator plays, the oldest one which hasn't drained yet. */
+	TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> GetPlayingStream() const;
+
+	/** Restarts playback so the sound generator plays the next stream. */
+	void Restart();
+
+	TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe> Stream;
+
+	/** Streams replaced by a format change, oldest first, played before Stream once their producers are done. */
+	TArray<TSharedPtr<FTTSAudioStream, ESPMode::ThreadSafe>> DrainingStreams;
+};
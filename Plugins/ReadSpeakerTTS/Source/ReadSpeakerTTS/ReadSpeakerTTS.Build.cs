@@ -21,6 +21,7 @@ public class ReadSpeakerTTS : ModuleRules
 				"AudioExtensions",
                 "Projects",
                 "SignalProcessing",
+                "AudioMixer",
                 "RSEnabledPlatforms",
                 "RSGameInterface",
             }